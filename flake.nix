@@ -68,6 +68,7 @@
             librsvg
             gdk-pixbuf
             glib
+            pipewire
           ];
 
           buildScript = pkgs.writeShellApplication {
@@ -128,6 +129,7 @@
               pkgs.librsvg
               pkgs.gdk-pixbuf
               pkgs.glib
+              pkgs.pipewire
             ];
 
             makeFlags = [ "PKG_CONFIG=${pkgs.pkg-config}/bin/pkg-config" ];
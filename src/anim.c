@@ -1152,6 +1152,21 @@ anim_spawn_close(Monitor *m, struct wlr_buffer *buffer, struct wlr_box geom)
 	}
 }
 
+/* Finish every close fade now, freeing the snapshot buffers they hold
+ * (memory pressure). */
+void
+closing_anims_drop(void)
+{
+	ClosingAnim *a, *tmp;
+
+	wl_list_for_each_safe(a, tmp, &closing_anims, link) {
+		wl_list_remove(&a->link);
+		if (a->tree)
+			wlr_scene_node_destroy(&a->tree->node);
+		free(a);
+	}
+}
+
 void
 closing_anims_tick(Monitor *m, double dt, int *still)
 {
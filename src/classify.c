@@ -0,0 +1,294 @@
+/*
+ * classify.c — pid-based client verdicts off the compositor thread.
+ *
+ * looks_like_game(), is_steam_game() and is_retro_emulator_client() fall
+ * back to the client's process when protocol hints and app-id say
+ * nothing: Wine/Proton exe or argv[0], Steam or launcher ancestry, an
+ * emulator somewhere up the tree.  Those probes read /proc (exe, cmdline,
+ * stat) and used to run on first use, which is mapnotify, applyrules or
+ * the first configurex11 of the window — the compositor stalled on
+ * procfs while the window was being placed.
+ *
+ * A client is queued here as soon as its pid is known (xdg create, X11
+ * create/associate).  The worker computes every verdict for the pid and
+ * the compositor thread publishes them together, so callers never see a
+ * half-classified client.  Until then the verdicts read as unknown and
+ * the callers treat the client as not (yet) a game.  If the verdicts
+ * land after the window mapped and turn it into a game or emulator, the
+ * client gets the placement mapnotify would have given it and game mode
+ * is re-evaluated.
+ */
+#include "nixlytile.h"
+#include "client.h"
+
+#include <sys/eventfd.h>
+
+typedef struct ClassifyJob {
+	struct ClassifyJob *next;
+	Client *c;                 /* NULL once the client is destroyed */
+	pid_t pid;
+	/* results, 1=yes -1=no */
+	int wine;
+	int launcher_child;
+	int game_runtime;
+	int retro;
+} ClassifyJob;
+
+static pthread_t cl_thread;
+static int cl_thread_running;
+static int cl_thread_stop;
+static pthread_mutex_t cl_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cl_cond = PTHREAD_COND_INITIALIZER;
+static ClassifyJob *cl_todo, *cl_done;
+static int cl_wake_fd = -1;
+static struct wl_event_source *cl_wake_src;
+
+/* Worker side: only /proc and the (locked) process table. */
+static void
+cl_compute(ClassifyJob *job)
+{
+	job->wine = is_wine_or_proton_process(job->pid) ? 1 : -1;
+	job->launcher_child = is_game_launcher_child(job->pid) ? 1 : -1;
+	job->game_runtime = is_game_runtime_child(job->pid) ? 1 : -1;
+	job->retro = is_retro_emulator_pid(job->pid) ? 1 : -1;
+}
+
+static void *
+cl_worker(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&cl_lock);
+	for (;;) {
+		ClassifyJob *job, **tail;
+		uint64_t one = 1;
+
+		while (!cl_todo && !cl_thread_stop)
+			pthread_cond_wait(&cl_cond, &cl_lock);
+		if (cl_thread_stop)
+			break;
+		job = cl_todo;
+		cl_todo = job->next;
+		if (job->c) {
+			pthread_mutex_unlock(&cl_lock);
+			cl_compute(job);
+			pthread_mutex_lock(&cl_lock);
+		}
+
+		job->next = NULL;
+		for (tail = &cl_done; *tail; tail = &(*tail)->next)
+			;
+		*tail = job;
+		if (write(cl_wake_fd, &one, sizeof(one)) < 0) {
+			/* counter saturated: the main loop is already woken */
+		}
+	}
+	pthread_mutex_unlock(&cl_lock);
+	return NULL;
+}
+
+/* Store every verdict in one go.  A verdict a caller already filled in
+ * (it is never recomputed) is kept. */
+static void
+cl_store(Client *c, const ClassifyJob *job)
+{
+	if (c->wine_verdict == 0)
+		c->wine_verdict = job->wine;
+	if (c->launcher_child_verdict == 0)
+		c->launcher_child_verdict = job->launcher_child;
+	if (c->game_runtime_verdict == 0)
+		c->game_runtime_verdict = job->game_runtime;
+	if (c->retro_verdict == 0)
+		c->retro_verdict = job->retro;
+	c->classify_state = 2;
+	c->classify_job = NULL;
+}
+
+static int
+cl_mapped(Client *c)
+{
+	struct wlr_surface *surf = client_surface(c);
+
+	return c->mon && surf && surf->mapped;
+}
+
+static void
+cl_finish(ClassifyJob *job)
+{
+	Client *c = job->c;
+	int was_game, was_retro, now_game;
+
+	if (!c) {
+		free(job);
+		return;
+	}
+	if (!cl_mapped(c)) {
+		/* mapnotify will see the verdicts */
+		cl_store(c, job);
+		free(job);
+		return;
+	}
+
+	was_game = looks_like_game(c);
+	was_retro = is_retro_emulator_client(c);
+	cl_store(c, job);
+	free(job);
+	now_game = looks_like_game(c);
+
+	if (now_game == was_game && is_retro_emulator_client(c) == was_retro)
+		return;
+
+	wlr_log(WLR_INFO, "classify: late verdict for '%s' (pid %d): game %d→%d",
+		client_get_appid(c) ? client_get_appid(c) : "(null)",
+		(int)client_get_pid(c), was_game, now_game);
+
+	if (now_game && !was_game && !c->isfloating && !c->isfullscreen
+			&& !client_is_unmanaged(c) && !client_get_parent(c))
+		game_place_mapped(c, c->map_w, c->map_h);
+	arrange(c->mon);
+	schedule_game_mode_update();
+}
+
+static int
+cl_wake_cb(int fd, uint32_t mask, void *data)
+{
+	ClassifyJob *done, *next;
+	uint64_t count;
+
+	(void)mask;
+	(void)data;
+
+	if (read(fd, &count, sizeof(count)) < 0) {
+		/* spurious wakeup; drain whatever is queued anyway */
+	}
+
+	pthread_mutex_lock(&cl_lock);
+	done = cl_done;
+	cl_done = NULL;
+	pthread_mutex_unlock(&cl_lock);
+
+	/* cl_finish can arrange and refocus; a client destroyed by that
+	 * clears job->c of any later job through classify_client_forget. */
+	for (; done; done = next) {
+		next = done->next;
+		cl_finish(done);
+	}
+	return 0;
+}
+
+static int
+cl_start_worker(void)
+{
+	if (cl_thread_running)
+		return 0;
+	if (cl_wake_fd < 0) {
+		cl_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (cl_wake_fd < 0)
+			return -1;
+	}
+	if (!cl_wake_src)
+		cl_wake_src = wl_event_loop_add_fd(event_loop, cl_wake_fd,
+				WL_EVENT_READABLE, cl_wake_cb, NULL);
+	if (!cl_wake_src)
+		return -1;
+	cl_thread_stop = 0;
+	if (pthread_create(&cl_thread, NULL, cl_worker, NULL) != 0)
+		return -1;
+	cl_thread_running = 1;
+	return 0;
+}
+
+/* Start classifying c if its pid is known and nobody has yet.  Cheap
+ * and idempotent: call it wherever the pid may have become known. */
+void
+classify_client(Client *c)
+{
+	ClassifyJob *job, **tail;
+	pid_t pid;
+
+	if (!c || c->classify_state != 0)
+		return;
+	pid = client_get_pid(c);
+	if (pid <= 1)
+		return;
+
+	job = ecalloc(1, sizeof(*job));
+	job->c = c;
+	job->pid = pid;
+
+	if (cl_start_worker() != 0) {
+		/* No worker: classify inline rather than never. */
+		cl_compute(job);
+		cl_store(c, job);
+		free(job);
+		return;
+	}
+
+	c->classify_state = 1;
+	c->classify_job = job;
+	pthread_mutex_lock(&cl_lock);
+	for (tail = &cl_todo; *tail; tail = &(*tail)->next)
+		;
+	*tail = job;
+	pthread_cond_signal(&cl_cond);
+	pthread_mutex_unlock(&cl_lock);
+}
+
+/* Have c's pid verdicts been published?  Queues c if not. */
+int
+classify_client_ready(Client *c)
+{
+	if (!c)
+		return 0;
+	if (c->classify_state == 0)
+		classify_client(c);
+	return c->classify_state == 2;
+}
+
+/* c is being freed: drop its result when it arrives. */
+void
+classify_client_forget(Client *c)
+{
+	if (!c || !c->classify_job)
+		return;
+	pthread_mutex_lock(&cl_lock);
+	c->classify_job->c = NULL;
+	pthread_mutex_unlock(&cl_lock);
+	c->classify_job = NULL;
+}
+
+static void
+cl_free_list(ClassifyJob *job)
+{
+	ClassifyJob *next;
+
+	for (; job; job = next) {
+		next = job->next;
+		if (job->c)
+			job->c->classify_job = NULL;
+		free(job);
+	}
+}
+
+void
+classify_cleanup(void)
+{
+	if (cl_thread_running) {
+		pthread_mutex_lock(&cl_lock);
+		cl_thread_stop = 1;
+		pthread_cond_signal(&cl_cond);
+		pthread_mutex_unlock(&cl_lock);
+		pthread_join(cl_thread, NULL);
+		cl_thread_running = 0;
+	}
+	cl_free_list(cl_todo);
+	cl_free_list(cl_done);
+	cl_todo = cl_done = NULL;
+
+	if (cl_wake_src)
+		wl_event_source_remove(cl_wake_src);
+	cl_wake_src = NULL;
+	if (cl_wake_fd >= 0)
+		close(cl_wake_fd);
+	cl_wake_fd = -1;
+}
@@ -20,37 +20,6 @@ typedef struct {
 static PendingLaunchEntry pending_launches[MAX_PENDING_LAUNCHES];
 static int pending_launch_count;
 
-/* Walk /proc parent chain: return 1 if child is a descendant of ancestor */
-static int
-is_pid_descendant_of(pid_t child, pid_t ancestor)
-{
-	pid_t cur = child;
-	char path[64], line[256];
-	FILE *f;
-	pid_t ppid;
-
-	for (int depth = 0; depth < 32 && cur > 1; depth++) {
-		if (cur == ancestor)
-			return 1;
-		snprintf(path, sizeof(path), "/proc/%d/status", (int)cur);
-		f = fopen(path, "r");
-		if (!f)
-			return 0;
-		ppid = 0;
-		while (fgets(line, sizeof(line), f)) {
-			if (strncmp(line, "PPid:\t", 6) == 0) {
-				ppid = (pid_t)atoi(line + 6);
-				break;
-			}
-		}
-		fclose(f);
-		if (ppid <= 1)
-			return 0;
-		cur = ppid;
-	}
-	return 0;
-}
-
 void
 pending_launch_add(pid_t pid, uint32_t tags, const char *output_name)
 {
@@ -96,7 +65,7 @@ pending_launch_find(pid_t client_pid, uint32_t *out_tags,
 			continue;
 
 		if (client_pid == pl->pid ||
-		    is_pid_descendant_of(client_pid, pl->pid)) {
+		    proctable_is_descendant(client_pid, pl->pid)) {
 			*out_tags = pl->tags;
 			if (out_output && out_output_sz > 0)
 				snprintf(out_output, out_output_sz, "%s", pl->output);
@@ -466,6 +435,9 @@ createnotify(struct wl_listener *listener, void *data)
 	LISTEN(&toplevel->events.request_fullscreen, &c->fullscreen, fullscreennotify);
 	LISTEN(&toplevel->events.request_maximize, &c->maximize, maximizenotify);
 	LISTEN(&toplevel->events.set_title, &c->set_title, updatetitle);
+
+	/* The pid is known now; have the process probes done by map. */
+	classify_client(c);
 }
 
 void
@@ -529,6 +501,7 @@ destroynotify(struct wl_listener *listener, void *data)
 		game_mode_pid = 0;
 		game_mode_client = NULL;
 	}
+	classify_client_forget(c);
 	/* Safety net: classify_cache_client stores a raw Client* used only
 	 * for pointer-equality cache invalidation. Unmap normally clears it
 	 * (see unmapnotify), but rapid xdg_toplevel destroy without an unmap
@@ -893,6 +866,57 @@ killclient(const Arg *arg)
 	client_send_close(sel);
 }
 
+/*
+ * A tiled game window just mapped (or classify.c decided, after the map,
+ * that it is one): small ones are splash/logo windows and float centered,
+ * the main window goes straight to true fullscreen.  initial_w/h is the
+ * size the client mapped with, before tiling.
+ */
+void
+game_place_mapped(Client *c, int initial_w, int initial_h)
+{
+	int mon_w = c->mon->m.width;
+	int mon_h = c->mon->m.height;
+	int small_w = initial_w > 0 && initial_w < (mon_w * 3) / 4;
+	int small_h = initial_h > 0 && initial_h < (mon_h * 3) / 4;
+
+	wlr_log(WLR_INFO,
+		"GAME_TRACE: game detected appid='%s' c->mon='%s' mon=%dx%d@%d,%d "
+		"initial=%dx%d small=%d,%d",
+		client_get_appid(c) ? client_get_appid(c) : "(null)",
+		c->mon && c->mon->wlr_output ? c->mon->wlr_output->name : "(null)",
+		mon_w, mon_h, c->mon->m.x, c->mon->m.y,
+		initial_w, initial_h, small_w, small_h);
+
+	if (small_w && small_h) {
+		wlr_log(WLR_INFO, "Game splash/logo detected: '%s' %dx%d, centering",
+			client_get_appid(c) ? client_get_appid(c) : "(unknown)",
+			initial_w, initial_h);
+		c->isfloating = 1;
+		c->geom.width = initial_w;
+		c->geom.height = initial_h;
+		c->geom.x = (mon_w - initial_w) / 2 + c->mon->m.x;
+		c->geom.y = (mon_h - initial_h) / 2 + c->mon->m.y;
+		wlr_scene_node_reparent(&c->scene->node, layers[LyrFloat]);
+		resize(c, c->geom, 1);
+		focusclient(c, 1);
+		printstatus();
+		return;
+	}
+
+	/* Main game window → direct true fullscreen, no delay. */
+	wlr_log(WLR_INFO, "Game main window detected: '%s' %dx%d — true fullscreen",
+		client_get_appid(c) ? client_get_appid(c) : "(unknown)",
+		initial_w, initial_h);
+	setfullscreen(c, 1);
+	wlr_log(WLR_INFO,
+		"GAME_TRACE: after setfullscreen c->mon='%s' geom=%dx%d@%d,%d",
+		c->mon && c->mon->wlr_output ? c->mon->wlr_output->name : "(null)",
+		c->geom.width, c->geom.height, c->geom.x, c->geom.y);
+	focusclient(c, 1);
+	printstatus();
+}
+
 void
 mapnotify(struct wl_listener *listener, void *data)
 {
@@ -975,6 +999,10 @@ mapnotify(struct wl_listener *listener, void *data)
 	 * the client's original preferred size. Used later for splash detection. */
 	int initial_w = c->geom.width;
 	int initial_h = c->geom.height;
+	c->map_w = initial_w;
+	c->map_h = initial_h;
+	/* Normally queued at create; X11 pids can arrive later. */
+	classify_client(c);
 
 	/* Handle unmanaged clients first so we can return prior create borders */
 	if (client_is_unmanaged(c)) {
@@ -1142,8 +1170,8 @@ notif_placed:
 			/* Native Wayland games won't have X11 atoms or
 			 * steam_app_ class — check process ancestry */
 			if (!is_confirmed_steam_game) {
-				pid_t pid = client_get_pid(c);
-				if (pid > 1 && is_game_launcher_child(pid))
+				if (classify_client_ready(c)
+						&& c->launcher_child_verdict > 0)
 					is_confirmed_steam_game = 1;
 			}
 
@@ -1427,46 +1455,7 @@ notif_placed:
 	}
 
 	if (!c->isfloating && !c->isfullscreen && looks_like_game(c)) {
-		int mon_w = c->mon->m.width;
-		int mon_h = c->mon->m.height;
-		int small_w = initial_w > 0 && initial_w < (mon_w * 3) / 4;
-		int small_h = initial_h > 0 && initial_h < (mon_h * 3) / 4;
-
-		wlr_log(WLR_INFO,
-			"GAME_TRACE: game detected appid='%s' c->mon='%s' mon=%dx%d@%d,%d "
-			"initial=%dx%d small=%d,%d",
-			client_get_appid(c) ? client_get_appid(c) : "(null)",
-			c->mon && c->mon->wlr_output ? c->mon->wlr_output->name : "(null)",
-			mon_w, mon_h, c->mon->m.x, c->mon->m.y,
-			initial_w, initial_h, small_w, small_h);
-
-		if (small_w && small_h) {
-			wlr_log(WLR_INFO, "Game splash/logo detected: '%s' %dx%d, centering",
-				client_get_appid(c) ? client_get_appid(c) : "(unknown)",
-				initial_w, initial_h);
-			c->isfloating = 1;
-			c->geom.width = initial_w;
-			c->geom.height = initial_h;
-			c->geom.x = (mon_w - initial_w) / 2 + c->mon->m.x;
-			c->geom.y = (mon_h - initial_h) / 2 + c->mon->m.y;
-			wlr_scene_node_reparent(&c->scene->node, layers[LyrFloat]);
-			resize(c, c->geom, 1);
-			focusclient(c, 1);
-			printstatus();
-			return;
-		}
-
-		/* Main game window → direct true fullscreen, no delay. */
-		wlr_log(WLR_INFO, "Game main window detected: '%s' %dx%d — true fullscreen",
-			client_get_appid(c) ? client_get_appid(c) : "(unknown)",
-			initial_w, initial_h);
-		setfullscreen(c, 1);
-		wlr_log(WLR_INFO,
-			"GAME_TRACE: after setfullscreen c->mon='%s' geom=%dx%d@%d,%d",
-			c->mon && c->mon->wlr_output ? c->mon->wlr_output->name : "(null)",
-			c->geom.width, c->geom.height, c->geom.x, c->geom.y);
-		focusclient(c, 1);
-		printstatus();
+		game_place_mapped(c, initial_w, initial_h);
 		return;
 	}
 
@@ -2155,13 +2144,17 @@ setfullscreen(Client *c, int fullscreen)
 	}
 
 	if (fullscreen) {
-		struct wlr_box fsgeom = client_fullscreen_geom(c);
+		struct wlr_box fsgeom;
 		/* Cover the screen HERE, on the transition into fullscreen:
 		 * the game has not been configured to the output rect yet, so
 		 * nothing of its fullscreen frame has reached the screen and
-		 * the animation lands right before the game comes up. */
-		if (!was)
+		 * the animation lands right before the game comes up.  The
+		 * learned profile may span it, so before the geometry. */
+		if (!was) {
 			launchfx_fullscreen_starting(c);
+			gameprofile_begin(c);
+		}
+		fsgeom = client_fullscreen_geom(c);
 		wlr_log(WLR_INFO,
 			"GAME_TRACE: setfullscreen resize mon='%s' target=%dx%d@%d,%d "
 			"(c->mon->m=%dx%d@%d,%d)",
@@ -2264,6 +2257,9 @@ setfullscreen(Client *c, int fullscreen)
 		 * if the output cannot do 4K@60+. */
 		if (client_wants_console_mode(c))
 			apply_console_mode(c->mon, c);
+		/* Learned mode, lock and scanout state, still under the cover */
+		if (!was)
+			gameprofile_apply(c);
 		if (!_is_retro)
 			schedule_video_check(200);
 	} else {
@@ -2287,6 +2283,8 @@ setfullscreen(Client *c, int fullscreen)
 				"direct scanout on next commit",
 				c->mon->wlr_output ? c->mon->wlr_output->name : "(null)");
 		}
+		/* Record what the game settled on before it is undone */
+		gameprofile_learn(c);
 		set_adaptive_sync(c->mon, 0);
 		/* Disable game VRR when exiting fullscreen */
 		disable_game_vrr(c->mon);
@@ -2621,6 +2619,7 @@ unmapnotify(struct wl_listener *listener, void *data)
 	/* Toggle adaptive sync off and restore refresh rate when fullscreen client is unmapped */
 	if (c->isfullscreen) {
 		Monitor *m = c->mon ? c->mon : selmon;
+		gameprofile_learn(c);
 		set_adaptive_sync(m, 0);
 		restore_max_refresh_rate(m);
 		restore_console_mode(m);
@@ -2922,21 +2921,11 @@ static PendingAutoKill pending_autokills[MAX_PENDING_AUTOKILLS];
 static void
 read_proc_comm(pid_t pid, char *buf, size_t sz)
 {
-	char path[64];
-	FILE *f;
-	size_t len;
+	ProcInfo pi;
 
 	buf[0] = '\0';
-	snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
-	f = fopen(path, "r");
-	if (!f)
-		return;
-	if (fgets(buf, (int)sz, f)) {
-		len = strlen(buf);
-		if (len > 0 && buf[len - 1] == '\n')
-			buf[len - 1] = '\0';
-	}
-	fclose(f);
+	if (proctable_get(pid, &pi) == 0)
+		snprintf(buf, sz, "%s", pi.comm);
 }
 
 static int
@@ -3013,8 +3002,8 @@ autokill_timer_cb(void *data)
 	PendingAutoKill *ak = data;
 	Client *c;
 	char comm[64];
-	DIR *d;
-	struct dirent *de;
+	ProcInfo *procs;
+	int n;
 
 	/* Check if any client still has this process name */
 	wl_list_for_each(c, &clients, link) {
@@ -3030,22 +3019,19 @@ autokill_timer_cb(void *data)
 	}
 
 	/* No windows remain — SIGTERM all processes with this name */
-	d = opendir("/proc");
-	if (d) {
-		while ((de = readdir(d)) != NULL) {
-			pid_t pid;
-			if (de->d_name[0] < '1' || de->d_name[0] > '9')
-				continue;
-			pid = (pid_t)atoi(de->d_name);
-			if (pid <= 1)
+	if (!proctable_running(ak->name, 0))
+		goto cleanup;
+	if ((n = proctable_snapshot(&procs)) > 0) {
+		for (int i = 0; i < n; i++) {
+			if (procs[i].pid <= 1)
 				continue;
-			read_proc_comm(pid, comm, sizeof(comm));
+			snprintf(comm, sizeof(comm), "%s", procs[i].comm);
 			normalize_proc_name(comm);
 			if (strcasecmp(comm, ak->name) == 0)
-				kill(pid, SIGTERM);
+				kill(procs[i].pid, SIGTERM);
 		}
-		closedir(d);
 	}
+	free(procs);
 
 cleanup:
 	wl_event_source_remove(ak->timer);
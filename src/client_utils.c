@@ -1,49 +1,11 @@
 #include "nixlytile.h"
 #include "client.h"
 
+/* Case-insensitive comm match; a substring counts too. */
 int
 is_process_running(const char *name)
 {
-	DIR *dir;
-	struct dirent *ent;
-	char path[PATH_MAX];
-	char comm[256];
-	FILE *fp;
-	int found = 0;
-
-	if (!name || !name[0])
-		return 0;
-
-	dir = opendir("/proc");
-	if (!dir)
-		return 0;
-
-	while ((ent = readdir(dir))) {
-		/* Skip non-numeric entries */
-		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
-			continue;
-
-		snprintf(path, sizeof(path), "/proc/%s/comm", ent->d_name);
-		fp = fopen(path, "r");
-		if (!fp)
-			continue;
-
-		if (fgets(comm, sizeof(comm), fp)) {
-			/* Remove trailing newline */
-			char *nl = strchr(comm, '\n');
-			if (nl)
-				*nl = '\0';
-			if (strcasecmp(comm, name) == 0 || strcasestr(comm, name)) {
-				found = 1;
-				fclose(fp);
-				break;
-			}
-		}
-		fclose(fp);
-	}
-
-	closedir(dir);
-	return found;
+	return proctable_running(name, 1);
 }
 
 Client *
@@ -419,20 +381,15 @@ is_steam_popup(Client *c)
 	return 0;
 }
 
-static int
+int
 is_wine_or_proton_process(pid_t pid)
 {
 	char path[64], target[512];
-	ssize_t len;
 
 	if (pid <= 1)
 		return 0;
 
-	snprintf(path, sizeof(path), "/proc/%d/exe", pid);
-	len = readlink(path, target, sizeof(target) - 1);
-	if (len > 0) {
-		target[len] = '\0';
-
+	if (proctable_exe(pid, target, sizeof(target)) == 0) {
 		if (strstr(target, "wine-preloader") ||
 		    strstr(target, "wine64-preloader") ||
 		    strstr(target, "wineserver") ||
@@ -500,50 +457,9 @@ is_known_game_app(const char *app)
 static int
 ancestry_comm_matches(pid_t pid, const char *const *needles, int exact)
 {
-	char path[64], comm[64];
-	FILE *f;
-	pid_t ppid;
-	int depth = 0;
-	const int max_depth = 10; /* Prevent infinite loops */
-	int i;
-
 	if (pid <= 1)
 		return 0;
-
-	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-	f = fopen(path, "r");
-	if (!f)
-		return 0;
-	if (fscanf(f, "%*d (%63[^)]) %*c %d", comm, &ppid) != 2) {
-		fclose(f);
-		return 0;
-	}
-	fclose(f);
-
-	pid = ppid;
-	while (pid > 1 && depth < max_depth) {
-		snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-		f = fopen(path, "r");
-		if (!f)
-			return 0;
-
-		/* Format: pid (comm) state ppid ... */
-		if (fscanf(f, "%*d (%63[^)]) %*c %d", comm, &ppid) != 2) {
-			fclose(f);
-			return 0;
-		}
-		fclose(f);
-
-		for (i = 0; needles[i]; i++) {
-			if (exact ? strcasecmp(comm, needles[i]) == 0
-				  : strcasestr(comm, needles[i]) != NULL)
-				return 1;
-		}
-
-		pid = ppid;
-		depth++;
-	}
-	return 0;
+	return proctable_ancestry_matches(pid, needles, exact, 0);
 }
 
 /* Any game launcher or Windows runtime, not just Steam. Used by
@@ -613,18 +529,13 @@ is_steam_game(Client *c)
 	if (c->isfloating)
 		return 0;
 
-	/* Check if it's a child of Steam.  Memoized: the ancestry walk
-	 * opens up to ~20 /proc files and the pid never changes. */
+	/* Check if it's a child of Steam.  The verdict comes from
+	 * classify.c; unknown until it lands. */
 	pid = client_get_pid(c);
-	if (pid > 1) {
-		if (c->launcher_child_verdict == 0)
-			c->launcher_child_verdict =
-				is_game_launcher_child(pid) ? 1 : -1;
-		if (c->launcher_child_verdict > 0) {
-			wlr_log(WLR_INFO, "Detected Steam game: app_id='%s', pid=%d",
-				app_id ? app_id : "(null)", pid);
-			return 1;
-		}
+	if (pid > 1 && classify_client_ready(c) && c->launcher_child_verdict > 0) {
+		wlr_log(WLR_INFO, "Detected Steam game: app_id='%s', pid=%d",
+			app_id ? app_id : "(null)", pid);
+		return 1;
 	}
 
 	return 0;
@@ -736,26 +647,15 @@ looks_like_game(Client *c)
 	if (app && is_known_game_app(app))
 		return 1;
 
-	/* Process-based detection — memoized, pid can't change */
+	/* Process-based detection — computed once per client by
+	 * classify.c, unknown (not a game) until it lands. */
 	pid = client_get_pid(c);
-	if (pid > 1) {
-		if (c->wine_verdict == 0)
-			c->wine_verdict =
-				is_wine_or_proton_process(pid) ? 1 : -1;
+	if (pid > 1 && classify_client_ready(c)) {
 		if (c->wine_verdict > 0)
 			return 1;
 		/* Any launcher, not just Steam: a native Wayland title from
 		 * Lutris/Heroic/Bottles/gamescope carries no protocol hint and
 		 * no steam_app_ app-id, so ancestry is the only signal. */
-		if (c->game_runtime_verdict == 0) {
-			c->game_runtime_verdict =
-				is_game_runtime_child(pid) ? 1 : -1;
-			if (c->game_runtime_verdict > 0)
-				wlr_log(WLR_INFO,
-					"Detected game via launcher ancestry: "
-					"app_id='%s', pid=%d",
-					app ? app : "(null)", pid);
-		}
 		if (c->game_runtime_verdict > 0)
 			return 1;
 	}
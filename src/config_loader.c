@@ -924,6 +924,14 @@ apply_doc(const KdlDoc *doc, int initial)
 			/* Lock games to their sustained low fps and match the
 			 * display refresh to it (default on; see autolock.c). */
 			int b; if (kdl_arg_bool(n, 0, &b)) game_auto_fps_lock_enabled = b;
+		} else if (!strcmp(n->name, "statusbar-flat")) {
+			/* Composite the bar modules into one buffer per monitor
+			 * with per-module damage (default off; statusbar_flat.c). */
+			int b; if (kdl_arg_bool(n, 0, &b)) statusbar_flat_enabled = b;
+		} else if (!strcmp(n->name, "gpu-stats-interval-ms")) {
+			/* GPU telemetry sampling period while a game runs
+			 * (default 500; 0 = off; see gpustat.c). */
+			if (kdl_arg_int(n, 0, &li)) gpustat_set_interval((int)li);
 		} else if (!strcmp(n->name, "workspaces")) {
 			(void)li; /* TAGCOUNT is compile-time; informational only */
 		}
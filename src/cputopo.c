@@ -0,0 +1,385 @@
+/*
+ * cputopo.c — CPU topology from sysfs and game-mode placement policies.
+ *
+ * Game mode used to know one fact about the CPU: which logical CPUs are
+ * cpu0's SMT siblings.  That is enough on a monolithic part, but not on
+ * the ones where placement matters most:
+ *
+ *  - dual-CCD Ryzen, where each CCD has its own L3 and a cross-CCD
+ *    access costs a trip over the fabric, and the X3D variants where
+ *    only one CCD carries the stacked V-cache;
+ *  - Intel hybrid parts, where E-cores share a cluster L2, run at a
+ *    fraction of a P-core's throughput and are where a frame-time
+ *    critical thread least wants to land.
+ *
+ * The model is a small tree: L3 domains (one per CCX/CCD, or the whole
+ * package) hold physical cores, which hold their SMT threads.  Each CPU
+ * also carries a core type — big/little from the hybrid PMU cpu lists,
+ * else from cpu_capacity — and the domain records its L3 size and the
+ * largest capacity in it.
+ *
+ * Everything is read relative to a sysfs root so cputopo_load() can be
+ * pointed at a copied /sys tree from another machine; cputopo_get()
+ * loads the live system once.
+ */
+#include "nixlytile.h"
+
+static CpuTopo cputopo_sys;
+static pthread_once_t cputopo_once = PTHREAD_ONCE_INIT;
+
+/* Parse a kernel cpulist ("0-7,16-23", "3", "") into set. */
+static int
+cputopo_parse_list(const char *s, cpu_set_t *set)
+{
+	char *end;
+	long a, b;
+
+	CPU_ZERO(set);
+	while (*s && *s != '\n') {
+		a = strtol(s, &end, 10);
+		if (end == s || a < 0)
+			return -1;
+		b = a;
+		s = end;
+		if (*s == '-') {
+			b = strtol(s + 1, &end, 10);
+			if (end == s + 1 || b < a)
+				return -1;
+			s = end;
+		}
+		for (; a <= b && a < CPU_SETSIZE; a++)
+			CPU_SET(a, set);
+		if (*s == ',')
+			s++;
+	}
+	return 0;
+}
+
+static int
+cputopo_read(const char *root, const char *rel, char *buf, size_t len)
+{
+	char path[PATH_MAX];
+	ssize_t n;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", root, rel);
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, len - 1);
+	close(fd);
+	if (n < 0)
+		return -1;
+	buf[n] = '\0';
+	return 0;
+}
+
+static int
+cputopo_read_list(const char *root, const char *rel, cpu_set_t *set)
+{
+	char buf[1024];
+
+	if (cputopo_read(root, rel, buf, sizeof(buf)) < 0)
+		return -1;
+	return cputopo_parse_list(buf, set);
+}
+
+/* CPUs sharing cpu's L3 and its size in KiB.  Parts that describe no
+ * L3 (some ARM SoCs, VMs) get their package as the domain, size 0. */
+static int
+cputopo_l3(const char *root, int cpu, cpu_set_t *shared, unsigned *kb)
+{
+	char rel[128], buf[64];
+
+	for (int idx = 0; idx < 8; idx++) {
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index%d/level", cpu, idx);
+		if (cputopo_read(root, rel, buf, sizeof(buf)) < 0 || atoi(buf) != 3)
+			continue;
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, idx);
+		if (cputopo_read_list(root, rel, shared) < 0)
+			break;
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index%d/size", cpu, idx);
+		*kb = cputopo_read(root, rel, buf, sizeof(buf)) == 0 ? (unsigned)strtoul(buf, NULL, 10) : 0;
+		return 0;
+	}
+
+	*kb = 0;
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/package_cpus_list", cpu);
+	if (cputopo_read_list(root, rel, shared) == 0)
+		return 0;
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/core_siblings_list", cpu);
+	return cputopo_read_list(root, rel, shared);
+}
+
+/*
+ * Load the topology under sysfs root (normally "/sys").  Returns 0 on
+ * success; on failure t describes every online CPU as one domain of
+ * single-thread cores, which makes every policy below a no-op.
+ */
+int
+cputopo_load(CpuTopo *t, const char *root)
+{
+	char rel[128], buf[64];
+	cpu_set_t shared, big, little;
+	unsigned kb;
+	int cpu, d, cap, maxcap = 0, mincap = INT_MAX, hybrid;
+
+	memset(t, 0, sizeof(*t));
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		t->dom_of[cpu] = t->core_of[cpu] = -1;
+
+	if (cputopo_read_list(root, "devices/system/cpu/online", &t->online) < 0
+			|| CPU_COUNT(&t->online) == 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		CPU_ZERO(&t->online);
+		for (cpu = 0; cpu < n && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, &t->online);
+	}
+
+	/* Intel hybrid: the core and atom PMUs list their CPUs. */
+	hybrid = cputopo_read_list(root, "devices/cpu_core/cpus", &big) == 0
+		&& cputopo_read_list(root, "devices/cpu_atom/cpus", &little) == 0
+		&& CPU_COUNT(&big) && CPU_COUNT(&little);
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &t->online))
+			continue;
+		t->ncpus = cpu + 1;
+
+		/* core: lowest-numbered SMT sibling */
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+		if (cputopo_read_list(root, rel, &shared) == 0 && CPU_COUNT(&shared)) {
+			for (int s = 0; s < CPU_SETSIZE; s++)
+				if (CPU_ISSET(s, &shared)) {
+					t->core_of[cpu] = s;
+					break;
+				}
+		} else {
+			t->core_of[cpu] = cpu;
+		}
+
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cpu_capacity", cpu);
+		cap = cputopo_read(root, rel, buf, sizeof(buf)) == 0 ? atoi(buf) : 1024;
+		t->capacity[cpu] = cap;
+		maxcap = MAX(maxcap, cap);
+		mincap = MIN(mincap, cap);
+
+		/* domain: CPUs sharing this CPU's L3 */
+		if (cputopo_l3(root, cpu, &shared, &kb) < 0 || !CPU_ISSET(cpu, &shared)) {
+			CPU_ZERO(&shared);
+			CPU_SET(cpu, &shared);
+		}
+		CPU_AND(&shared, &shared, &t->online);
+		for (d = 0; d < t->ndomains; d++)
+			if (CPU_EQUAL(&t->dom[d].cpus, &shared))
+				break;
+		if (d == t->ndomains) {
+			if (t->ndomains == CPUTOPO_MAX_DOMAINS)
+				d = t->ndomains - 1;    /* lump the rest into the last */
+			else
+				t->dom[t->ndomains++].cpus = shared;
+			t->dom[d].l3_kb = kb;
+		}
+		CPU_SET(cpu, &t->dom[d].cpus);
+		t->dom_of[cpu] = d;
+		t->dom[d].capacity = MAX(t->dom[d].capacity, cap);
+	}
+
+	/* Big/little: the hybrid PMU lists, else asymmetric capacities. */
+	CPU_ZERO(&t->pcores);
+	CPU_ZERO(&t->ecores);
+	if (hybrid) {
+		CPU_AND(&t->pcores, &big, &t->online);
+		CPU_AND(&t->ecores, &little, &t->online);
+	} else if (maxcap > mincap) {
+		for (cpu = 0; cpu < t->ncpus; cpu++) {
+			if (!CPU_ISSET(cpu, &t->online))
+				continue;
+			if (t->capacity[cpu] == maxcap)
+				CPU_SET(cpu, &t->pcores);
+			else
+				CPU_SET(cpu, &t->ecores);
+		}
+	}
+	if (!CPU_COUNT(&t->ecores))
+		CPU_ZERO(&t->pcores);
+
+	return t->ncpus > 0 ? 0 : -1;
+}
+
+static void
+cputopo_load_sys(void)
+{
+	char buf[512];
+
+	cputopo_load(&cputopo_sys, "/sys");
+	cputopo_describe(&cputopo_sys, buf, sizeof(buf));
+	wlr_log(WLR_INFO, "cputopo: %s", buf);
+}
+
+/* The running system's topology, read on first use.  Thread-safe. */
+const CpuTopo *
+cputopo_get(void)
+{
+	pthread_once(&cputopo_once, cputopo_load_sys);
+	return &cputopo_sys;
+}
+
+/* All online CPUs of the physical cores that have a thread in set. */
+static void
+cputopo_whole_cores(const CpuTopo *t, cpu_set_t *set)
+{
+	cpu_set_t out;
+
+	CPU_ZERO(&out);
+	for (int cpu = 0; cpu < t->ncpus; cpu++) {
+		if (!CPU_ISSET(cpu, &t->online))
+			continue;
+		if (CPU_ISSET(t->core_of[cpu], set) || CPU_ISSET(cpu, set))
+			for (int s = 0; s < t->ncpus; s++)
+				if (t->core_of[s] == t->core_of[cpu])
+					CPU_SET(s, &out);
+	}
+	*set = out;
+}
+
+/*
+ * Where a game should run.  Returns 1 with out set when the topology has
+ * a clear best place, 0 when the game is best left on every CPU.
+ *
+ *  - Several L3 domains of different size (X3D): the largest L3.
+ *  - Hybrid cores: the P-cores.
+ *  - Otherwise nothing: on a symmetric dual-CCD part the second CCD is
+ *    worth more to a CPU-bound game than the cross-CCD latency costs it.
+ */
+int
+cputopo_game_set(const CpuTopo *t, cpu_set_t *out)
+{
+	int best = -1, uneven = 0;
+
+	for (int d = 0; d < t->ndomains; d++) {
+		if (best >= 0 && t->dom[d].l3_kb != t->dom[best].l3_kb)
+			uneven = 1;
+		if (best < 0 || t->dom[d].l3_kb > t->dom[best].l3_kb)
+			best = d;
+	}
+	if (uneven && best >= 0 && t->dom[best].l3_kb > 0) {
+		*out = t->dom[best].cpus;
+		return 1;
+	}
+	if (CPU_COUNT(&t->pcores) && CPU_COUNT(&t->ecores)) {
+		*out = t->pcores;
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Where the compositor thread should run, given the game's CPUs (NULL or
+ * empty when the game has all of them).  Returns 0 when the machine is
+ * too small to give anything away.
+ *
+ * Always one whole physical core — all its SMT threads — so the
+ * compositor never shares a core with a game thread.  With several L3
+ * domains it is the first core outside the game's domain, keeping the
+ * compositor's working set out of the game's L3.  Otherwise it is cpu0's
+ * core, which is also where IRQBALANCE_BANNED_CPUS keeps every hardware
+ * interrupt.  Never fewer than two logical CPUs: with every IRQ on the
+ * same core and SCHED_RR on, a one-CPU pin made tight retry loops
+ * un-preemptable (the retroarch 10-bit scanout freeze).
+ */
+int
+cputopo_compositor_set(const CpuTopo *t, const cpu_set_t *game, cpu_set_t *out)
+{
+	int first = -1;
+
+	/* Under 8 logical CPUs, giving one core away costs more than the
+	 * isolation buys — leave the scheduler alone. */
+	if (CPU_COUNT(&t->online) < 8)
+		return 0;
+
+	if (t->ndomains > 1 && game && CPU_COUNT(game)) {
+		for (int cpu = 0; cpu < t->ncpus && first < 0; cpu++)
+			if (CPU_ISSET(cpu, &t->online) && !CPU_ISSET(cpu, game)
+					&& !CPU_ISSET(cpu, &t->ecores))
+				first = cpu;
+	}
+	for (int cpu = 0; cpu < t->ncpus && first < 0; cpu++)
+		if (CPU_ISSET(cpu, &t->online))
+			first = cpu;
+	if (first < 0)
+		return 0;
+
+	CPU_ZERO(out);
+	CPU_SET(first, out);
+	cputopo_whole_cores(t, out);
+
+	if (CPU_COUNT(out) < 2) {
+		for (int cpu = first + 1; cpu < t->ncpus; cpu++)
+			if (CPU_ISSET(cpu, &t->online) && t->dom_of[cpu] == t->dom_of[first]) {
+				CPU_SET(cpu, out);
+				break;
+			}
+	}
+	return CPU_COUNT(out) > 0;
+}
+
+/*
+ * Where background processes should be kept while a game runs.  Returns
+ * 1 with out set, 0 to leave them where they are.
+ *
+ *  - Hybrid cores: the E-cores.
+ *  - A game confined to one L3 domain: everything outside it.
+ */
+int
+cputopo_background_set(const CpuTopo *t, const cpu_set_t *game, cpu_set_t *out)
+{
+	if (CPU_COUNT(&t->ecores)) {
+		*out = t->ecores;
+		return 1;
+	}
+	if (t->ndomains > 1 && game && CPU_COUNT(game)) {
+		CPU_XOR(out, &t->online, game);
+		CPU_AND(out, out, &t->online);
+		return CPU_COUNT(out) > 0;
+	}
+	return 0;
+}
+
+/* Format set as a kernel cpulist. */
+void
+cputopo_format(const cpu_set_t *set, char *buf, size_t len)
+{
+	size_t off = 0;
+	int a, b;
+
+	buf[0] = '\0';
+	for (a = 0; a < CPU_SETSIZE && off < len; a++) {
+		if (!CPU_ISSET(a, set))
+			continue;
+		for (b = a; b + 1 < CPU_SETSIZE && CPU_ISSET(b + 1, set); b++)
+			;
+		off += snprintf(buf + off, len - off, a == b ? "%s%d" : "%s%d-%d",
+			off ? "," : "", a, b);
+		a = b;
+	}
+}
+
+/* One-line summary for the log: "16 cpus, 2 L3 domains [0-7,16-23 96M]
+ * [8-15,24-31 32M], no hybrid". */
+void
+cputopo_describe(const CpuTopo *t, char *buf, size_t len)
+{
+	char list[128];
+	size_t off;
+
+	off = (size_t)snprintf(buf, len, "%d cpus, %d L3 domain%s", CPU_COUNT(&t->online),
+		t->ndomains, t->ndomains == 1 ? "" : "s");
+	for (int d = 0; d < t->ndomains && off < len; d++) {
+		cputopo_format(&t->dom[d].cpus, list, sizeof(list));
+		off += (size_t)snprintf(buf + off, len - off, " [%s %uK]", list, t->dom[d].l3_kb);
+	}
+	if (off < len && CPU_COUNT(&t->ecores)) {
+		cputopo_format(&t->ecores, list, sizeof(list));
+		snprintf(buf + off, len - off, ", E-cores %s", list);
+	}
+}
@@ -38,9 +38,12 @@ diag_logf(const char *cat, const char *fmt, ...)
 	localtime_r(&ts.tv_sec, &tm);
 	strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm);
 
+	/* One line at a time: the game-mode worker logs too. */
+	flockfile(diag_fp);
 	fprintf(diag_fp, "%s.%03ld %-10s ", stamp, ts.tv_nsec / 1000000, cat);
 	va_start(ap, fmt);
 	vfprintf(diag_fp, fmt, ap);
 	va_end(ap);
 	fputc('\n', diag_fp);
+	funlockfile(diag_fp);
 }
@@ -1,5 +1,6 @@
 #include "nixlytile.h"
 #include "client.h"
+#include "diag.h"
 #include "spawn.h"
 #include <pthread.h>
 #include <poll.h>
@@ -218,11 +219,11 @@ apply_game_priority(pid_t pid)
 	 * Linux nice and ioprio are PER-TASK: the calls above only hit the
 	 * thread-group leader, so a game's render/RHI/audio threads (spawned
 	 * before game mode engaged) would keep nice 0 / default ioprio.
-	 * Walk /proc/PID/task so every thread gets the boost — same pattern
-	 * as set_process_affinity_all_threads.
+	 * gamethreads walks /proc/PID/task and gives each thread the policy
+	 * of its class — boosted render/audio, SCHED_IDLE compile workers —
+	 * and the gm-bg worker rescans for threads started later.
 	 */
-	game_priority_all_threads(pid, -10,
-		IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 0));
+	gamethreads_apply(pid);
 
 	/* OOM protection goes through the root helper: lowering oom_score_adj
 	 * needs CAP_SYS_RESOURCE, so writing it from here always failed with
@@ -254,7 +255,9 @@ restore_game_priority(pid_t pid)
 		wlr_log(WLR_INFO, "Game priority: restored ioprio BE/4 for PID %d", pid);
 	}
 
-	/* Per-thread restore, mirroring the per-thread apply */
+	/* Per-thread restore, mirroring the per-thread apply; the walk also
+	 * covers threads gamethreads never saw. */
+	gamethreads_restore();
 	game_priority_all_threads(pid, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 4));
 
 	game_oom_unprotect(pid);
@@ -357,20 +360,24 @@ restore_power_profile(void)
 #define MAX_LOWERED_PIDS 4096
 static pid_t lowered_pids[MAX_LOWERED_PIDS];
 static int   lowered_pid_count = 0;
+static int   lowered_affinity = 0;   /* lowered pids were also moved */
+
+/* Busy share (DRM fdinfo, gpuclients.c) at which a lowered process also
+ * loses GPU priority. */
+#define GPU_COMPETE_PCT 5
+
+static void set_process_affinity_all_threads(pid_t pid, const cpu_set_t *set);
+static int gpu_sched_lower(pid_t pid);
+static void gpu_sched_restore_lowered(void);
 
 void
 lower_competing_processes(pid_t game_pid)
 {
-	DIR *dir;
-	struct dirent *ent;
-	char path[128];
-	char comm[64];
-	char uid_line[256];
-	FILE *fp;
+	ProcInfo *procs;
 	uid_t our_uid = getuid();
 	pid_t our_pid = getpid();
 	pid_t pid;
-	int i;
+	int i, n;
 
 	static const char *whitelist[] = {
 		"nixlytile", "Xwayland", "xwayland",
@@ -384,55 +391,36 @@ lower_competing_processes(pid_t game_pid)
 		NULL
 	};
 
+	const CpuTopo *t = cputopo_get();
+	cpu_set_t game_set, bg_set;
+	int has_game = cputopo_game_set(t, &game_set);
+	int gpu_idx = discrete_gpu_idx >= 0 ? discrete_gpu_idx : 0;
+	int gpu_lower = gpu_idx < detected_gpu_count
+		&& detected_gpus[gpu_idx].vendor == GPU_VENDOR_AMD;
+	int gpu_lowered = 0;
+
 	lowered_pid_count = 0;
+	/* Also keep them off the game's cores where the topology has cores
+	 * that suit them better: E-cores, or the other CCD of an X3D part. */
+	lowered_affinity = cputopo_background_set(t, has_game ? &game_set : NULL, &bg_set);
 
-	dir = opendir("/proc");
-	if (!dir)
+	proctable_refresh();
+	if ((n = proctable_snapshot(&procs)) < 0)
 		return;
 
-	while ((ent = readdir(dir))) {
-		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
-			continue;
-
-		pid = (pid_t)atoi(ent->d_name);
+	for (int p = 0; p < n; p++) {
+		pid = procs[p].pid;
 		if (pid <= 1 || pid == our_pid || pid == game_pid)
 			continue;
 
 		/* User-owned only */
-		snprintf(path, sizeof(path), "/proc/%d/status", pid);
-		fp = fopen(path, "r");
-		if (!fp)
-			continue;
-
-		int is_our_uid = 0;
-		while (fgets(uid_line, sizeof(uid_line), fp)) {
-			if (strncmp(uid_line, "Uid:", 4) == 0) {
-				uid_t real_uid;
-				if (sscanf(uid_line + 4, "%u", &real_uid) == 1
-				    && real_uid == our_uid)
-					is_our_uid = 1;
-				break;
-			}
-		}
-		fclose(fp);
-		if (!is_our_uid)
+		if (procs[p].uid != our_uid)
 			continue;
 
 		/* Comm whitelist */
-		snprintf(path, sizeof(path), "/proc/%d/comm", pid);
-		fp = fopen(path, "r");
-		if (!fp)
-			continue;
-		comm[0] = '\0';
-		if (fgets(comm, sizeof(comm), fp)) {
-			char *nl = strchr(comm, '\n');
-			if (nl) *nl = '\0';
-		}
-		fclose(fp);
-
 		int whitelisted = 0;
 		for (i = 0; whitelist[i]; i++) {
-			if (strcmp(comm, whitelist[i]) == 0) {
+			if (strcmp(procs[p].comm, whitelist[i]) == 0) {
 				whitelisted = 1;
 				break;
 			}
@@ -450,12 +438,26 @@ lower_competing_processes(pid_t game_pid)
 		if (sched_setscheduler(pid, SCHED_IDLE, &sp) == 0) {
 			if (lowered_pid_count < MAX_LOWERED_PIDS)
 				lowered_pids[lowered_pid_count++] = pid;
-		}
+			if (lowered_affinity)
+				set_process_affinity_all_threads(pid, &bg_set);
+			if (gpu_lower && gpuclients_busy(pid) >= GPU_COMPETE_PCT)
+				gpu_lowered += gpu_sched_lower(pid) == 0;
+		}
+	}
+	free(procs);
+	if (gpu_lowered)
+		wlr_log(WLR_INFO, "GPU sched: %d busy background processes → LOW",
+			gpu_lowered);
+
+	if (lowered_affinity) {
+		char list[256];
+		cputopo_format(&bg_set, list, sizeof(list));
+		wlr_log(WLR_INFO, "CPU isolate: SCHED_IDLE applied to %d processes, kept on CPUs %s",
+			lowered_pid_count, list);
+	} else {
+		wlr_log(WLR_INFO, "CPU isolate: SCHED_IDLE applied to %d processes",
+			lowered_pid_count);
 	}
-	closedir(dir);
-
-	wlr_log(WLR_INFO, "CPU isolate: SCHED_IDLE applied to %d processes",
-		lowered_pid_count);
 }
 
 void
@@ -464,11 +466,17 @@ restore_competing_processes(void)
 	struct sched_param sp = {0};
 	int i;
 
+	gpu_sched_restore_lowered();
+
 	if (lowered_pid_count == 0)
 		return;
 
-	for (i = 0; i < lowered_pid_count; i++)
+	for (i = 0; i < lowered_pid_count; i++) {
 		sched_setscheduler(lowered_pids[i], SCHED_OTHER, &sp);
+		if (lowered_affinity)
+			set_process_affinity_all_threads(lowered_pids[i], &cputopo_get()->online);
+	}
+	lowered_affinity = 0;
 
 	wlr_log(WLR_INFO, "CPU isolate: restored %d processes to SCHED_OTHER",
 		lowered_pid_count);
@@ -485,12 +493,23 @@ restore_competing_processes(void)
  * lock or touch stdio: only raw syscalls, and only on state that was already
  * written down before the crash.
  */
+static int frozen_cg_fds[256];      /* cgroup.freeze of each unit we froze */
+static int frozen_cg_count;
+static pid_t *frozen_cg_pids;       /* their processes, for reclaim */
+static int frozen_cg_pid_count;
+
 void
 gm_emergency_restore(void)
 {
 	struct sched_param sp = {0};
 	int i;
 
+	for (i = 0; i < frozen_cg_count; i++)
+		if (pwrite(frozen_cg_fds[i], "0", 1, 0) < 0) {
+			/* nothing more we can do from a signal handler */
+		}
+	frozen_cg_count = 0;
+
 	for (i = 0; i < frozen_pid_count; i++)
 		kill(frozen_pids[i], SIGCONT);
 	frozen_pid_count = 0;
@@ -536,40 +555,7 @@ get_memory_pressure(void)
 static int
 is_child_of(pid_t pid, pid_t parent)
 {
-	char path[64];
-	FILE *fp;
-	char line[256];
-	pid_t ppid;
-	int depth = 0;
-
-	if (pid == parent)
-		return 1;
-
-	ppid = pid;
-	while (ppid > 1 && depth < 32) {
-		snprintf(path, sizeof(path), "/proc/%d/stat", ppid);
-		fp = fopen(path, "r");
-		if (!fp)
-			return 0;
-		/* stat format: pid (comm) state ppid ... */
-		if (!fgets(line, sizeof(line), fp)) {
-			fclose(fp);
-			return 0;
-		}
-		fclose(fp);
-		/* Find the closing ')' to skip comm field (may contain spaces) */
-		char *cp = strrchr(line, ')');
-		if (!cp)
-			return 0;
-		/* After ') ' comes state, then ppid */
-		int scanned = sscanf(cp + 2, "%*c %d", &ppid);
-		if (scanned != 1)
-			return 0;
-		if (ppid == parent)
-			return 1;
-		depth++;
-	}
-	return 0;
+	return proctable_is_descendant(pid, parent);
 }
 
 /*
@@ -585,59 +571,12 @@ static const char *tree_protect[] = {
 };
 
 /*
- * Check if a PID has an ancestor whose comm matches a tree_protect entry.
- * Walks up the ppid chain reading /proc/<pid>/stat.
+ * Check if a PID (or an ancestor) has a comm matching a tree_protect entry.
  */
 static int
 has_protected_ancestor(pid_t pid)
 {
-	char path[64];
-	char comm[64];
-	FILE *fp;
-	char line[256];
-	pid_t cur;
-	int depth = 0;
-	int i;
-
-	cur = pid;
-	while (cur > 1 && depth < 32) {
-		/* Read comm of current pid */
-		snprintf(path, sizeof(path), "/proc/%d/comm", cur);
-		fp = fopen(path, "r");
-		if (!fp)
-			return 0;
-		comm[0] = '\0';
-		if (fgets(comm, sizeof(comm), fp)) {
-			char *nl = strchr(comm, '\n');
-			if (nl) *nl = '\0';
-		}
-		fclose(fp);
-
-		for (i = 0; tree_protect[i]; i++) {
-			if (strcmp(comm, tree_protect[i]) == 0)
-				return 1;
-		}
-
-		/* Walk to parent */
-		snprintf(path, sizeof(path), "/proc/%d/stat", cur);
-		fp = fopen(path, "r");
-		if (!fp)
-			return 0;
-		if (!fgets(line, sizeof(line), fp)) {
-			fclose(fp);
-			return 0;
-		}
-		fclose(fp);
-		char *cp = strrchr(line, ')');
-		if (!cp)
-			return 0;
-		pid_t ppid;
-		if (sscanf(cp + 2, "%*c %d", &ppid) != 1)
-			return 0;
-		cur = ppid;
-		depth++;
-	}
-	return 0;
+	return proctable_ancestry_matches(pid, tree_protect, 1, 1);
 }
 
 #ifndef MADV_PAGEOUT
@@ -655,7 +594,7 @@ has_protected_ancestor(pid_t pid)
  * This frees physical RAM that SIGSTOP alone leaves resident.
  */
 static void
-reclaim_frozen_memory(void)
+reclaim_frozen_memory(const pid_t *pids, int n)
 {
 	struct iovec iov;
 	int pidfd;
@@ -663,157 +602,296 @@ reclaim_frozen_memory(void)
 	iov.iov_base = 0;
 	iov.iov_len = (size_t)-1;  /* entire address space */
 
-	for (int i = 0; i < frozen_pid_count; i++) {
-		pidfd = syscall(__NR_pidfd_open, frozen_pids[i], 0);
+	for (int i = 0; i < n; i++) {
+		pidfd = syscall(__NR_pidfd_open, pids[i], 0);
 		if (pidfd < 0)
 			continue;
 		syscall(__NR_process_madvise, pidfd, &iov, (size_t)1, MADV_PAGEOUT, (unsigned int)0);
 		close(pidfd);
 	}
-	wlr_log(WLR_INFO, "Reclaimed memory from %d frozen processes", frozen_pid_count);
+	wlr_log(WLR_INFO, "Reclaimed memory from %d frozen processes", n);
+}
+
+/* Whitelist of process comm names that should never be frozen.
+ * Steam/Discord subtrees are protected by has_protected_ancestor().
+ * Must match lower_competing_processes(): SIGSTOPping the user
+ * systemd manager, sshd session processes or interactive shells
+ * freezes SSH sessions and stalls user-unit management for the
+ * whole game. */
+static const char *freeze_whitelist[] = {
+	"nixlytile", "Xwayland", "xwayland",
+	"pipewire", "wireplumber", "pulseaudio", "pipewire-pulse",
+	"dbus-daemon", "dbus-broker",
+	"systemd", "systemd-logind", "systemd-userdbd",
+	"sshd",
+	"bash", "zsh", "fish", "sh", "dash",
+	"gnome-keyring", "gcr-ssh-agent", "ssh-agent",
+	"gamemoded",
+	NULL
+};
+
+/* May this process be frozen for game mode? */
+static int
+freeze_allowed(const ProcInfo *p, uid_t our_uid, pid_t our_pid)
+{
+	if (p->pid <= 1 || p->pid == our_pid)
+		return 0;
+
+	/* Check if this process belongs to our user */
+	if (p->uid != our_uid)
+		return 0;
+
+	for (int i = 0; freeze_whitelist[i]; i++)
+		if (strcmp(p->comm, freeze_whitelist[i]) == 0)
+			return 0;
+
+	/* Don't freeze any process in a Steam/Discord subtree */
+	if (has_protected_ancestor(p->pid))
+		return 0;
+
+	/* Don't freeze the game process or its children */
+	if (game_mode_pid > 1 && is_child_of(p->pid, game_mode_pid))
+		return 0;
+
+	/* Don't freeze compositor children */
+	if (is_child_of(p->pid, our_pid))
+		return 0;
+
+	return 1;
 }
 
 /*
- * Freeze background processes during game mode.
- * Sends SIGSTOP to all user-owned processes except whitelisted ones.
- * Safe to call multiple times - clears state on each call.
+ * cgroup v2 freezer backend.
+ *
+ * The user's systemd manager owns a delegated subtree
+ * (user@UID.service) with one cgroup per unit: app scopes, services,
+ * background.slice daemons.  A leaf unit whose every process passes
+ * freeze_allowed() is frozen with a single write to its cgroup.freeze;
+ * anything it forks during the game lands in the same frozen cgroup,
+ * which the SIGSTOP sweep could never catch.  Processes are left in
+ * their units, so the user manager's view of them stays intact.  Units
+ * holding an exempt process, and processes outside the subtree (the
+ * login session scope), go through the SIGSTOP path as before.
  */
-void
-freeze_background_processes(void)
+#define FREEZE_CG_DEPTH 6
+
+typedef struct {
+	pid_t *pids;
+	int n, cap;
+} PidList;
+
+static void
+pidlist_add(PidList *l, pid_t pid)
 {
-	DIR *dir;
-	struct dirent *ent;
-	char path[128];
-	char comm[64];
-	char uid_line[256];
-	FILE *fp;
-	uid_t our_uid = getuid();
-	pid_t our_pid = getpid();
-	pid_t pid;
-	int i;
+	if (l->n == l->cap) {
+		l->cap = l->cap ? l->cap * 2 : 64;
+		l->pids = realloc(l->pids, (size_t)l->cap * sizeof(*l->pids));
+		if (!l->pids)
+			die("realloc:");
+	}
+	l->pids[l->n++] = pid;
+}
 
-	/* Whitelist of process comm names that should never be frozen.
-	 * Steam/Discord subtrees are protected by has_protected_ancestor().
-	 * Must match lower_competing_processes(): SIGSTOPping the user
-	 * systemd manager, sshd session processes or interactive shells
-	 * freezes SSH sessions and stalls user-unit management for the
-	 * whole game. */
-	static const char *whitelist[] = {
-		"nixlytile", "Xwayland", "xwayland",
-		"pipewire", "wireplumber", "pulseaudio", "pipewire-pulse",
-		"dbus-daemon", "dbus-broker",
-		"systemd", "systemd-logind", "systemd-userdbd",
-		"sshd",
-		"bash", "zsh", "fish", "sh", "dash",
-		"gnome-keyring", "gcr-ssh-agent", "ssh-agent",
-		"gamemoded",
-		NULL
-	};
+static int
+pid_cmp(const void *a, const void *b)
+{
+	pid_t x = *(const pid_t *)a, y = *(const pid_t *)b;
 
-	/* Reset state for idempotent re-entry */
-	frozen_pid_count = 0;
+	return (x > y) - (x < y);
+}
 
-	dir = opendir("/proc");
-	if (!dir)
-		return;
+/* Root of our user manager's cgroup subtree, if it has the v2 freezer. */
+static int
+freeze_cg_root(char *out, size_t len)
+{
+	char probe[PATH_MAX];
+	uid_t uid = getuid();
 
-	while ((ent = readdir(dir))) {
-		/* Only look at numeric (PID) entries */
-		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
-			continue;
+	snprintf(out, len, "/sys/fs/cgroup/user.slice/user-%u.slice/user@%u.service",
+		(unsigned)uid, (unsigned)uid);
+	snprintf(probe, sizeof(probe), "%s/cgroup.freeze", out);
+	return access(probe, W_OK) == 0;
+}
 
-		pid = (pid_t)atoi(ent->d_name);
-		if (pid <= 1 || pid == our_pid)
-			continue;
+/* Append the pids in dir/cgroup.procs to l.  Returns how many, -1 on error. */
+static int
+freeze_cg_procs(const char *dir, PidList *l)
+{
+	char path[PATH_MAX];
+	FILE *f;
+	int pid, n = 0;
 
-		/* Check if this process belongs to our user */
-		snprintf(path, sizeof(path), "/proc/%d/status", pid);
-		fp = fopen(path, "r");
-		if (!fp)
-			continue;
+	snprintf(path, sizeof(path), "%s/cgroup.procs", dir);
+	if (!(f = fopen(path, "re")))
+		return -1;
+	while (fscanf(f, "%d", &pid) == 1) {
+		pidlist_add(l, pid);
+		n++;
+	}
+	fclose(f);
+	return n;
+}
 
-		int is_our_uid = 0;
-		while (fgets(uid_line, sizeof(uid_line), fp)) {
-			if (strncmp(uid_line, "Uid:", 4) == 0) {
-				uid_t real_uid;
-				if (sscanf(uid_line + 4, "%u", &real_uid) == 1 && real_uid == our_uid)
-					is_our_uid = 1;
-				break;
-			}
-		}
-		fclose(fp);
+/* Freeze leaf cgroup dir if every process in it may be frozen.  Frozen
+ * processes are appended to covered. */
+static void
+freeze_cg_leaf(const char *dir, uid_t our_uid, pid_t our_pid, PidList *covered)
+{
+	PidList procs = {0};
+	ProcInfo pi;
+	char path[PATH_MAX], cur = '0';
+	int fd, i, n;
 
-		if (!is_our_uid)
-			continue;
+	if (frozen_cg_count >= (int)LENGTH(frozen_cg_fds))
+		return;
+	if ((n = freeze_cg_procs(dir, &procs)) <= 0)
+		goto out;
+	for (i = 0; i < n; i++) {
+		/* unknown to the table: exited, or too new to judge */
+		if (proctable_get(procs.pids[i], &pi) != 0 || !freeze_allowed(&pi, our_uid, our_pid))
+			goto out;
+	}
+
+	snprintf(path, sizeof(path), "%s/cgroup.freeze", dir);
+	if ((fd = open(path, O_RDWR | O_CLOEXEC)) < 0)
+		goto out;
+	/* Already frozen by someone else: not ours to thaw later. */
+	if (pread(fd, &cur, 1, 0) != 1 || cur != '0' || pwrite(fd, "1", 1, 0) != 1) {
+		close(fd);
+		goto out;
+	}
+	frozen_cg_fds[frozen_cg_count++] = fd;
+	for (i = 0; i < n; i++)
+		pidlist_add(covered, procs.pids[i]);
+out:
+	free(procs.pids);
+}
 
-		/* Read the process comm name */
-		snprintf(path, sizeof(path), "/proc/%d/comm", pid);
-		fp = fopen(path, "r");
-		if (!fp)
-			continue;
-		comm[0] = '\0';
-		if (fgets(comm, sizeof(comm), fp)) {
-			char *nl = strchr(comm, '\n');
-			if (nl) *nl = '\0';
-		}
-		fclose(fp);
+static void
+freeze_cg_walk(const char *dir, int depth, uid_t our_uid, pid_t our_pid, PidList *covered)
+{
+	char path[PATH_MAX];
+	struct dirent *de;
+	struct stat st;
+	int children = 0;
+	DIR *d;
 
-		/* Check whitelist */
-		int whitelisted = 0;
-		for (i = 0; whitelist[i]; i++) {
-			if (strcmp(comm, whitelist[i]) == 0) {
-				whitelisted = 1;
-				break;
-			}
-		}
-		if (whitelisted)
+	if (!(d = opendir(dir)))
+		return;
+	while ((de = readdir(d))) {
+		if (de->d_name[0] == '.')
 			continue;
-
-		/* Don't freeze any process in a Steam/Discord subtree */
-		if (has_protected_ancestor(pid))
+		snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+		if (de->d_type != DT_DIR && (de->d_type != DT_UNKNOWN
+				|| stat(path, &st) != 0 || !S_ISDIR(st.st_mode)))
 			continue;
+		children++;
+		if (depth < FREEZE_CG_DEPTH)
+			freeze_cg_walk(path, depth + 1, our_uid, our_pid, covered);
+	}
+	closedir(d);
 
-		/* Don't freeze the game process or its children */
-		if (game_mode_pid > 1 && is_child_of(pid, game_mode_pid))
-			continue;
+	/* Only leaves: freezing a parent would also freeze children whose
+	 * processes were never checked. */
+	if (!children && depth > 0)
+		freeze_cg_leaf(dir, our_uid, our_pid, covered);
+}
 
-		/* Don't freeze compositor children */
-		if (is_child_of(pid, our_pid))
-			continue;
+/*
+ * Freeze background processes during game mode.
+ * Freezes eligible user units through their cgroups, then sends SIGSTOP
+ * to every other user-owned process except whitelisted ones.
+ * Safe to call again while frozen: both mechanisms are thawed first, so
+ * no cgroup fd leaks and a new game (its pid excluded only now) is never
+ * left stopped from the previous pass.
+ */
+void
+freeze_background_processes(void)
+{
+	ProcInfo *procs;
+	PidList covered = {0};
+	uid_t our_uid = getuid();
+	pid_t our_pid = getpid();
+	char root[PATH_MAX];
+	uint64_t t0 = get_time_ns(), t1;
+	int n, units;
 
-		/* Freeze this process */
-		if (frozen_pid_count < 4096) {
-			if (kill(pid, SIGSTOP) == 0) {
-				frozen_pids[frozen_pid_count++] = pid;
+	unfreeze_background_processes();
+	proctable_refresh();
+
+	if (freeze_cg_root(root, sizeof(root)))
+		freeze_cg_walk(root, 0, our_uid, our_pid, &covered);
+	units = frozen_cg_count;
+	if (covered.n > 1)
+		qsort(covered.pids, (size_t)covered.n, sizeof(*covered.pids), pid_cmp);
+
+	if ((n = proctable_snapshot(&procs)) >= 0) {
+		for (int p = 0; p < n; p++) {
+			if (!freeze_allowed(&procs[p], our_uid, our_pid))
+				continue;
+			/* Already held by a frozen unit cgroup */
+			if (covered.n && bsearch(&procs[p].pid, covered.pids, (size_t)covered.n,
+					sizeof(*covered.pids), pid_cmp))
+				continue;
+
+			/* Freeze this process */
+			if (frozen_pid_count < 4096) {
+				if (kill(procs[p].pid, SIGSTOP) == 0) {
+					frozen_pids[frozen_pid_count++] = procs[p].pid;
+				}
 			}
 		}
+		free(procs);
 	}
+	t1 = get_time_ns();
 
-	closedir(dir);
-	wlr_log(WLR_INFO, "Froze %d background processes for game mode", frozen_pid_count);
+	wlr_log(WLR_INFO, "Froze %d background processes for game mode "
+		"(%d in %d cgroups, %d by SIGSTOP) in %.1f ms",
+		covered.n + frozen_pid_count, covered.n, units, frozen_pid_count,
+		(double)(t1 - t0) / 1e6);
+	diag_logf("GAMEMODE", "freeze: %d procs, %d via %d cgroups, %d via SIGSTOP, %.1f ms",
+		covered.n + frozen_pid_count, covered.n, units, frozen_pid_count,
+		(double)(t1 - t0) / 1e6);
 
 	/* Push frozen process pages to swap to free physical RAM */
+	if (covered.n > 0)
+		reclaim_frozen_memory(covered.pids, covered.n);
 	if (frozen_pid_count > 0)
-		reclaim_frozen_memory();
+		reclaim_frozen_memory(frozen_pids, frozen_pid_count);
+	free(frozen_cg_pids);
+	frozen_cg_pids = covered.pids;
+	frozen_cg_pid_count = covered.n;
 }
 
 /*
  * Unfreeze all previously frozen processes.
- * Sends SIGCONT to each stored PID. Harmless if PID has already exited.
+ * Thaws the frozen unit cgroups and sends SIGCONT to each stored PID.
+ * Harmless if a PID has already exited or a unit has gone away.
  */
 void
 unfreeze_background_processes(void)
 {
-	int i;
+	int i, units = frozen_cg_count;
 
-	if (frozen_pid_count == 0)
+	if (frozen_pid_count == 0 && frozen_cg_count == 0)
 		return;
 
+	for (i = 0; i < frozen_cg_count; i++) {
+		if (pwrite(frozen_cg_fds[i], "0", 1, 0) != 1)
+			wlr_log(WLR_ERROR, "cgroup thaw failed: %s", strerror(errno));
+		close(frozen_cg_fds[i]);
+	}
+	frozen_cg_count = 0;
+	free(frozen_cg_pids);
+	frozen_cg_pids = NULL;
+	frozen_cg_pid_count = 0;
+
 	for (i = 0; i < frozen_pid_count; i++) {
 		kill(frozen_pids[i], SIGCONT);  /* ESRCH if exited - harmless */
 	}
 
-	wlr_log(WLR_INFO, "Unfroze %d background processes", frozen_pid_count);
+	wlr_log(WLR_INFO, "Unfroze %d cgroups and %d background processes",
+		units, frozen_pid_count);
 	frozen_pid_count = 0;
 }
 
@@ -850,58 +928,25 @@ set_process_affinity_all_threads(pid_t pid, const cpu_set_t *set)
  * Split the online CPUs into a compositor set and a game set.
  * Returns 0 when the machine is too small to isolate anything.
  *
- * The compositor set is cpu0 plus ALL of its SMT siblings — one physical
- * core — which is also where IRQBALANCE_BANNED_CPUS keeps every hardware
- * interrupt.  Reading thread_siblings_list is the point: cpu0 and cpu1 are
- * two *different* physical cores under both Intel and modern AMD
- * enumeration, so the old fixed "compositor 0-1 / game 2..N-1" split gave
- * the compositor two whole cores and then handed the game their SMT
- * siblings to fight over.  Adapts to any core count and either topology.
+ * The game set is where cputopo wants the game (the V-cache CCD, the
+ * P-cores) or every CPU; the compositor gets one whole physical core —
+ * outside the game's L3 domain when there is more than one, else cpu0's
+ * core.  See cputopo_compositor_set() for why it is a whole core and
+ * never a single logical CPU.
  */
 static int
 gm_core_split(cpu_set_t *comp, cpu_set_t *game)
 {
-	long ncores = sysconf(_SC_NPROCESSORS_ONLN);
-	FILE *fp;
-	char buf[256];
-	long i;
+	const CpuTopo *t = cputopo_get();
+	cpu_set_t pref;
+	int has_pref = cputopo_game_set(t, &pref);
 
-	/* Under 8 logical CPUs, giving one core away costs more than the
-	 * isolation buys — leave the scheduler alone. */
-	if (ncores < 8)
+	if (!cputopo_compositor_set(t, has_pref ? &pref : NULL, comp))
 		return 0;
 
-	CPU_ZERO(comp);
-	fp = fopen("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list", "r");
-	if (fp) {
-		if (fgets(buf, sizeof(buf), fp)) {
-			/* "0,8" (SMT pair), "0-1" (range) or "0" (no SMT) */
-			char *tok = strtok(buf, ",\n");
-			while (tok) {
-				int a = -1, b = -1;
-				if (sscanf(tok, "%d-%d", &a, &b) == 2) {
-					for (i = a; i <= b && i < ncores; i++)
-						CPU_SET(i, comp);
-				} else if (sscanf(tok, "%d", &a) == 1 && a < ncores) {
-					CPU_SET(a, comp);
-				}
-				tok = strtok(NULL, ",\n");
-			}
-		}
-		fclose(fp);
-	}
-	if (CPU_COUNT(comp) == 0)
-		CPU_SET(0, comp);
-
-	/* Never leave the compositor on a single logical CPU: with every IRQ
-	 * pinned to the same core and SCHED_RR on, a one-CPU pin made tight
-	 * retry loops un-preemptable (the retroarch 10-bit scanout freeze). */
-	if (CPU_COUNT(comp) < 2)
-		CPU_SET(1, comp);
-
 	CPU_ZERO(game);
-	for (i = 0; i < ncores; i++)
-		if (!CPU_ISSET(i, comp))
+	for (int i = 0; i < t->ncpus; i++)
+		if (CPU_ISSET(i, has_pref ? &pref : &t->online) && !CPU_ISSET(i, comp))
 			CPU_SET(i, game);
 
 	return CPU_COUNT(game) > 0;
@@ -910,48 +955,46 @@ gm_core_split(cpu_set_t *comp, cpu_set_t *game)
 void
 apply_cpu_affinity(pid_t game_pid)
 {
-	cpu_set_t all_set;
-	long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+	const CpuTopo *t = cputopo_get();
+	cpu_set_t set;
+	char list[256];
 
-	if (game_pid <= 1 || ncores < 1)
+	if (game_pid <= 1)
 		return;
 
 	/*
-	 * The game gets every CPU. An earlier version fenced it off the
-	 * compositor's physical core, which cost a CPU-bound game a full core
-	 * (2 of 16 threads here) to solve a problem the SCHED_RR boost already
-	 * solves: at real-time priority the compositor preempts the game
-	 * whenever it needs to run, so it cannot be starved by a SCHED_OTHER
-	 * process no matter which CPU that process occupies.
+	 * The game gets every CPU unless the topology has a clearly better
+	 * place for it: the V-cache CCD of an X3D part, the P-cores of a
+	 * hybrid one (cputopo_game_set()).  An earlier version fenced it off
+	 * the compositor's physical core, which cost a CPU-bound game a full
+	 * core (2 of 16 threads here) to solve a problem the SCHED_RR boost
+	 * already solves: at real-time priority the compositor preempts the
+	 * game whenever it needs to run, so it cannot be starved by a
+	 * SCHED_OTHER process no matter which CPU that process occupies.
 	 *
-	 * The compositor still pins itself to physical core 0 (see
+	 * The compositor still pins itself to one physical core (see
 	 * update_game_mode) for cache locality — that pin restricts only the
 	 * compositor, not the game.
 	 *
-	 * This also re-applies the full mask over anything a previous game
+	 * This also re-applies the mask over anything a previous game
 	 * session or an external tool left behind.
 	 */
-	CPU_ZERO(&all_set);
-	for (long i = 0; i < ncores; i++)
-		CPU_SET(i, &all_set);
-	set_process_affinity_all_threads(game_pid, &all_set);
+	if (!cputopo_game_set(t, &set))
+		set = t->online;
+	set_process_affinity_all_threads(game_pid, &set);
 
 	game_mode_affinity_applied = 1;
-	wlr_log(WLR_INFO, "CPU affinity: game PID %d → all %ld CPUs", game_pid, ncores);
+	cputopo_format(&set, list, sizeof(list));
+	wlr_log(WLR_INFO, "CPU affinity: game PID %d → CPUs %s", game_pid, list);
 }
 
 void
 restore_cpu_affinity(pid_t game_pid)
 {
 	if (!game_mode_affinity_applied) return;
-	int ncores = sysconf(_SC_NPROCESSORS_ONLN);
 
-	cpu_set_t all_set;
-	CPU_ZERO(&all_set);
-	for (int i = 0; i < ncores; i++)
-		CPU_SET(i, &all_set);
 	if (game_pid > 1)
-		set_process_affinity_all_threads(game_pid, &all_set);
+		set_process_affinity_all_threads(game_pid, &cputopo_get()->online);
 
 	game_mode_affinity_applied = 0;
 	wlr_log(WLR_INFO, "CPU affinity: restored to all cores");
@@ -1057,6 +1100,8 @@ static int nv_clocks_locked = 0;
 static int nv_persistence_was_off = 0;
 static int nv_power_applied = 0;
 static char nv_saved_power_limit[32] = "";
+static unsigned nv_saved_power_mw = 0;  /* NVML path: limit to restore */
+static int nv_use_nvml = 0;   /* applied through NVML; restore the same way */
 static int nv_gpu_index = 0;  /* nvidia-smi GPU index (auto-detected) */
 
 /*
@@ -1135,6 +1180,12 @@ nvidia_detect_smi_index(GpuInfo *gpu)
 		return;
 	detected = 1;
 
+	/* NVML enumerates the way nvidia-smi does and knows the index */
+	if (nvml_open(gpu->pci_slot) == 0) {
+		nv_gpu_index = nvml_index();
+		return;
+	}
+
 	/* Query PCI bus ID for each nvidia-smi GPU and match against our PCI slot */
 	for (i = 0; i < 8; i++) {
 		snprintf(args, sizeof(args),
@@ -1152,31 +1203,29 @@ nvidia_detect_smi_index(GpuInfo *gpu)
 	nv_gpu_index = 0;
 }
 
+/* Step 1 through nvidia-smi: persistence on, noting that it was off. */
 static void
-apply_nvidia_gpu_power(GpuInfo *gpu)
+nvidia_smi_persistence_on(void)
 {
-	char buf[128], args[256];
+	char buf[128], args[64];
 
-	/* Auto-detect correct nvidia-smi GPU index */
-	nvidia_detect_smi_index(gpu);
-
-	/*
-	 * 1. Enable persistence mode — keeps driver loaded between GPU tasks,
-	 *    eliminates ~1-2s initialization delay on each GPU operation.
-	 */
-	if (nvidia_smi_query("persistence_mode", buf, sizeof(buf)) == 0) {
-		if (strstr(buf, "Disabled") || strcmp(buf, "Off") == 0) {
-			nv_persistence_was_off = 1;
-			snprintf(args, sizeof(args), "-i %d -pm 1", nv_gpu_index);
-			nvidia_smi_run(args, NULL, 0);
-			wlr_log(WLR_INFO, "NVIDIA: persistence mode enabled");
-		}
+	if (nvidia_smi_query("persistence_mode", buf, sizeof(buf)) != 0)
+		return;
+	if (strstr(buf, "Disabled") || strcmp(buf, "Off") == 0) {
+		nv_persistence_was_off = 1;
+		snprintf(args, sizeof(args), "-i %d -pm 1", nv_gpu_index);
+		nvidia_smi_run(args, NULL, 0);
+		wlr_log(WLR_INFO, "NVIDIA: persistence mode enabled");
 	}
+}
+
+/* Step 2 through nvidia-smi: power limit to the maximum, saving the
+ * current one for the restore. */
+static void
+nvidia_smi_power_limit_max(void)
+{
+	char buf[128], args[256];
 
-	/*
-	 * 2. Set power limit to maximum allowed TDP.
-	 *    More power = higher sustained boost clocks.
-	 */
 	if (nvidia_smi_query("power.limit", buf, sizeof(buf)) == 0) {
 		strncpy(nv_saved_power_limit, buf, sizeof(nv_saved_power_limit) - 1);
 		nv_saved_power_limit[sizeof(nv_saved_power_limit) - 1] = '\0';
@@ -1188,32 +1237,137 @@ apply_nvidia_gpu_power(GpuInfo *gpu)
 		if (nvidia_smi_run(args, NULL, 0) == 0)
 			wlr_log(WLR_INFO, "NVIDIA: power limit → %s W (was %s)", buf, nv_saved_power_limit);
 	}
+}
+
+/* Steps 3 and 4 through nvidia-smi: lock the graphics (-lgc) or memory
+ * (-lmc) clock at mhz, or at the maximum nvidia-smi reports for 0.
+ * Returns 0 when the lock was set. */
+static int
+nvidia_smi_lock_clocks(int mem, unsigned mhz)
+{
+	char buf[128], args[256];
+
+	if (mhz) {
+		snprintf(buf, sizeof(buf), "%u", mhz);
+	} else {
+		char *dot;
+
+		if (nvidia_smi_query(mem ? "clocks.max.memory" : "clocks.max.graphics",
+				buf, sizeof(buf)) != 0 || !buf[0])
+			return -1;
+		if ((dot = strchr(buf, '.')))
+			*dot = '\0';
+	}
+	snprintf(args, sizeof(args), "-i %d %s %s,%s", nv_gpu_index,
+		mem ? "-lmc" : "-lgc", buf, buf);
+	if (nvidia_smi_run(args, NULL, 0) != 0)
+		return -1;
+	nv_clocks_locked = 1;
+	wlr_log(WLR_INFO, "NVIDIA: %s clocks locked → %s MHz", mem ? "memory" : "GPU", buf);
+	return 0;
+}
+
+/*
+ * Steps 1-4 and 6 of apply_nvidia_gpu_power() through NVML: the same
+ * settings, one library call each instead of an nvidia-smi fork.  A step
+ * whose entry point this driver's NVML lacks (or that it refuses) runs
+ * that step's nvidia-smi command instead.
+ */
+static void
+apply_nvidia_gpu_power_nvml(void)
+{
+	unsigned cur_mw, max_mw, gfx_mhz, mem_mhz;
+	char args[64];
+	int on, ok;
+
+	if (nvml_persistence(&on) != 0) {
+		nvidia_smi_persistence_on();
+	} else if (!on) {
+		if (nvml_set_persistence(1) != 0) {
+			snprintf(args, sizeof(args), "-i %d -pm 1", nv_gpu_index);
+			nvidia_smi_run(args, NULL, 0);
+		}
+		nv_persistence_was_off = 1;
+		wlr_log(WLR_INFO, "NVIDIA: persistence mode enabled");
+	}
+
+	if (nvml_power_limit(&cur_mw, &max_mw) != 0) {
+		nvidia_smi_power_limit_max();
+	} else {
+		nv_saved_power_mw = cur_mw;
+		if (max_mw != cur_mw) {
+			if (!(ok = nvml_set_power_limit(max_mw) == 0)) {
+				snprintf(args, sizeof(args), "-i %d --power-limit=%u",
+					nv_gpu_index, max_mw / 1000);
+				ok = nvidia_smi_run(args, NULL, 0) == 0;
+			}
+			if (ok)
+				wlr_log(WLR_INFO, "NVIDIA: power limit → %u W (was %u W)",
+					max_mw / 1000, cur_mw / 1000);
+		}
+	}
+
+	/* 0 lets nvidia-smi look the maximum up itself */
+	if (nvml_max_clocks(&gfx_mhz, &mem_mhz) != 0)
+		gfx_mhz = mem_mhz = 0;
+	if (gfx_mhz && nvml_lock_gpu_clocks(gfx_mhz) == 0) {
+		nv_clocks_locked = 1;
+		wlr_log(WLR_INFO, "NVIDIA: GPU clocks locked → %u MHz", gfx_mhz);
+	} else {
+		nvidia_smi_lock_clocks(0, gfx_mhz);
+	}
+	if (mem_mhz && nvml_lock_mem_clocks(mem_mhz) == 0) {
+		nv_clocks_locked = 1;
+		wlr_log(WLR_INFO, "NVIDIA: memory clocks locked → %u MHz", mem_mhz);
+	} else {
+		nvidia_smi_lock_clocks(1, mem_mhz);
+	}
+
+	if (nvml_compute_mode_default() != 0) {
+		snprintf(args, sizeof(args), "-i %d -c DEFAULT", nv_gpu_index);
+		nvidia_smi_run(args, NULL, 0);
+	}
+}
+
+static void
+apply_nvidia_gpu_power(GpuInfo *gpu)
+{
+	char args[256];
+	uint64_t t0 = get_time_ns();
+
+	/* Auto-detect correct nvidia-smi GPU index */
+	nvidia_detect_smi_index(gpu);
+
+	nv_use_nvml = nvml_open(gpu->pci_slot) == 0;
+	if (nv_use_nvml) {
+		apply_nvidia_gpu_power_nvml();
+		dgpu_assert_power_on(gpu);
+		goto settings;
+	}
+
+	/*
+	 * 1. Enable persistence mode — keeps driver loaded between GPU tasks,
+	 *    eliminates ~1-2s initialization delay on each GPU operation.
+	 */
+	nvidia_smi_persistence_on();
+
+	/*
+	 * 2. Set power limit to maximum allowed TDP.
+	 *    More power = higher sustained boost clocks.
+	 */
+	nvidia_smi_power_limit_max();
 
 	/*
 	 * 3. Lock GPU clocks to maximum boost frequency.
 	 *    Prevents clock fluctuation and ensures max performance.
 	 */
-	if (nvidia_smi_query("clocks.max.graphics", buf, sizeof(buf)) == 0 && buf[0]) {
-		char *dot = strchr(buf, '.');
-		if (dot) *dot = '\0';
-		snprintf(args, sizeof(args), "-i %d -lgc %s,%s", nv_gpu_index, buf, buf);
-		if (nvidia_smi_run(args, NULL, 0) == 0) {
-			nv_clocks_locked = 1;
-			wlr_log(WLR_INFO, "NVIDIA: GPU clocks locked → %s MHz", buf);
-		}
-	}
+	nvidia_smi_lock_clocks(0, 0);
 
 	/*
 	 * 4. Lock memory clocks to maximum frequency.
 	 *    Prevents VRAM clock downshifting during gameplay.
 	 */
-	if (nvidia_smi_query("clocks.max.memory", buf, sizeof(buf)) == 0 && buf[0]) {
-		char *dot = strchr(buf, '.');
-		if (dot) *dot = '\0';
-		snprintf(args, sizeof(args), "-i %d -lmc %s,%s", nv_gpu_index, buf, buf);
-		if (nvidia_smi_run(args, NULL, 0) == 0)
-			wlr_log(WLR_INFO, "NVIDIA: memory clocks locked → %s MHz", buf);
-	}
+	nvidia_smi_lock_clocks(1, 0);
 
 	/*
 	 * 5. Re-assert PCI runtime PM disabled (also done by watchdog timer).
@@ -1230,6 +1384,7 @@ apply_nvidia_gpu_power(GpuInfo *gpu)
 	snprintf(args, sizeof(args), "-i %d -c DEFAULT", nv_gpu_index);
 	nvidia_smi_run(args, NULL, 0);
 
+settings:
 	/*
 	 * 7. Set GPU performance preference via nvidia-settings (requires XWayland).
 	 *    PowerMizer mode 1 = "Prefer Maximum Performance".
@@ -1274,8 +1429,10 @@ apply_nvidia_gpu_power(GpuInfo *gpu)
 	}
 
 	nv_power_applied = 1;
-	wlr_log(WLR_INFO, "NVIDIA: card%d (%s, smi-idx=%d) — full performance mode active",
-		gpu->card_index, gpu->pci_slot, nv_gpu_index);
+	wlr_log(WLR_INFO, "NVIDIA: card%d (%s, smi-idx=%d) — full performance mode active "
+		"via %s in %llu ms", gpu->card_index, gpu->pci_slot, nv_gpu_index,
+		nv_use_nvml ? "NVML" : "nvidia-smi",
+		(unsigned long long)((get_time_ns() - t0) / 1000000));
 }
 
 static void
@@ -1285,17 +1442,32 @@ restore_nvidia_gpu_power(void)
 
 	if (!nv_power_applied) return;
 
-	/* Reset GPU clock lock */
+	/* Each step is undone through NVML when it was applied that way,
+	 * and through nvidia-smi when NVML was not open or lacks the call. */
 	if (nv_clocks_locked) {
-		snprintf(args, sizeof(args), "-i %d -rgc", nv_gpu_index);
-		nvidia_smi_run(args, NULL, 0);
-		snprintf(args, sizeof(args), "-i %d -rmc", nv_gpu_index);
-		nvidia_smi_run(args, NULL, 0);
+		if (!nv_use_nvml || nvml_lock_gpu_clocks(0) != 0) {
+			snprintf(args, sizeof(args), "-i %d -rgc", nv_gpu_index);
+			nvidia_smi_run(args, NULL, 0);
+		}
+		if (!nv_use_nvml || nvml_lock_mem_clocks(0) != 0) {
+			snprintf(args, sizeof(args), "-i %d -rmc", nv_gpu_index);
+			nvidia_smi_run(args, NULL, 0);
+		}
 		nv_clocks_locked = 0;
 		wlr_log(WLR_INFO, "NVIDIA: GPU/memory clock locks released");
 	}
 
-	/* Restore power limit */
+	/* Restore power limit: read by NVML in mW, or by nvidia-smi in W */
+	if (nv_saved_power_mw) {
+		if (nvml_set_power_limit(nv_saved_power_mw) != 0) {
+			snprintf(args, sizeof(args), "-i %d --power-limit=%u",
+				nv_gpu_index, nv_saved_power_mw / 1000);
+			nvidia_smi_run(args, NULL, 0);
+		}
+		wlr_log(WLR_INFO, "NVIDIA: power limit restored → %u W",
+			nv_saved_power_mw / 1000);
+		nv_saved_power_mw = 0;
+	}
 	if (nv_saved_power_limit[0]) {
 		char pl_copy[32];
 		strncpy(pl_copy, nv_saved_power_limit, sizeof(pl_copy) - 1);
@@ -1310,8 +1482,10 @@ restore_nvidia_gpu_power(void)
 
 	/* Restore persistence mode */
 	if (nv_persistence_was_off) {
-		snprintf(args, sizeof(args), "-i %d -pm 0", nv_gpu_index);
-		nvidia_smi_run(args, NULL, 0);
+		if (!nv_use_nvml || nvml_set_persistence(0) != 0) {
+			snprintf(args, sizeof(args), "-i %d -pm 0", nv_gpu_index);
+			nvidia_smi_run(args, NULL, 0);
+		}
 		nv_persistence_was_off = 0;
 		wlr_log(WLR_INFO, "NVIDIA: persistence mode restored (off)");
 	}
@@ -1509,6 +1683,85 @@ find_process_drm_fd(pid_t pid)
 	return -1;
 }
 
+/*
+ * Duplicate pid's DRM fd into our process via pidfd_getfd().  Returns
+ * the local fd, or -1.
+ */
+static int
+gpu_sched_dup_drm_fd(pid_t pid)
+{
+	int target_fd_num = find_process_drm_fd(pid);
+	if (target_fd_num < 0) {
+		wlr_log(WLR_INFO, "GPU sched: no DRM fd found for PID %d", pid);
+		return -1;
+	}
+
+	int pidfd = syscall(__NR_pidfd_open, pid, 0);
+	if (pidfd < 0) {
+		wlr_log(WLR_INFO, "GPU sched: pidfd_open failed for PID %d: %s",
+			pid, strerror(errno));
+		return -1;
+	}
+
+	int local_fd = syscall(__NR_pidfd_getfd, pidfd, target_fd_num, 0);
+	close(pidfd);
+	if (local_fd < 0)
+		wlr_log(WLR_INFO, "GPU sched: pidfd_getfd failed for PID %d fd %d: %s",
+			pid, target_fd_num, strerror(errno));
+	return local_fd;
+}
+
+/*
+ * amdgpu PROCESS_PRIORITY_OVERRIDE for every context of the DRM file
+ * local_fd refers to, issued on the compositor's DRM master fd.
+ */
+static int
+amdgpu_sched_override(int local_fd, int priority)
+{
+	int drm_master_fd = wlr_renderer_get_drm_fd(drw);
+	union drm_amdgpu_sched sched = {0};
+
+	if (drm_master_fd < 0)
+		return -1;
+	sched.in.op = AMDGPU_SCHED_OP_PROCESS_PRIORITY_OVERRIDE;
+	sched.in.fd = local_fd;
+	sched.in.priority = priority;
+	return drmIoctl(drm_master_fd, DRM_IOCTL_AMDGPU_SCHED, &sched);
+}
+
+/* Background processes that were busy on the GPU just before the game
+ * get their amdgpu contexts dropped to LOW by lower_competing_processes().
+ * Each override lives as long as our duplicate of their DRM fd. */
+static int gpu_lowered_fds[64];
+static int gpu_lowered_count;
+
+static int
+gpu_sched_lower(pid_t pid)
+{
+	int fd;
+
+	if (gpu_lowered_count == (int)LENGTH(gpu_lowered_fds))
+		return -1;
+	if ((fd = gpu_sched_dup_drm_fd(pid)) < 0)
+		return -1;
+	if (amdgpu_sched_override(fd, AMDGPU_CTX_PRIORITY_LOW) != 0) {
+		close(fd);
+		return -1;
+	}
+	gpu_lowered_fds[gpu_lowered_count++] = fd;
+	return 0;
+}
+
+static void
+gpu_sched_restore_lowered(void)
+{
+	for (int i = 0; i < gpu_lowered_count; i++) {
+		amdgpu_sched_override(gpu_lowered_fds[i], AMDGPU_CTX_PRIORITY_NORMAL);
+		close(gpu_lowered_fds[i]);
+	}
+	gpu_lowered_count = 0;
+}
+
 void
 apply_gpu_sched_priority(pid_t pid)
 {
@@ -1526,30 +1779,12 @@ apply_gpu_sched_priority(pid_t pid)
 		 * 2. Duplicate it into our process via pidfd_getfd()
 		 * 3. Issue PROCESS_PRIORITY_OVERRIDE on the compositor's DRM fd
 		 */
-		int target_fd_num = find_process_drm_fd(pid);
-		if (target_fd_num < 0) {
-			wlr_log(WLR_INFO, "GPU sched: no DRM fd found for PID %d", pid);
+		int local_fd = gpu_sched_dup_drm_fd(pid);
+		if (local_fd < 0)
 			return;
-		}
-
-		int pidfd = syscall(__NR_pidfd_open, pid, 0);
-		if (pidfd < 0) {
-			wlr_log(WLR_INFO, "GPU sched: pidfd_open failed for PID %d: %s",
-				pid, strerror(errno));
-			return;
-		}
-
-		int local_fd = syscall(__NR_pidfd_getfd, pidfd, target_fd_num, 0);
-		close(pidfd);
-		if (local_fd < 0) {
-			wlr_log(WLR_INFO, "GPU sched: pidfd_getfd failed for PID %d fd %d: %s",
-				pid, target_fd_num, strerror(errno));
-			return;
-		}
 
 		/* Get compositor's DRM master fd from the renderer */
-		int drm_master_fd = wlr_renderer_get_drm_fd(drw);
-		if (drm_master_fd < 0) {
+		if (wlr_renderer_get_drm_fd(drw) < 0) {
 			wlr_log(WLR_INFO, "GPU sched: cannot get DRM master fd");
 			close(local_fd);
 			return;
@@ -1558,19 +1793,13 @@ apply_gpu_sched_priority(pid_t pid)
 		/* VERY_HIGH gives the game queue precedence AND VRAM eviction
 		 * priority — kernel evicts other clients' BOs to GTT/system RAM
 		 * before the game's, mirroring SteamOS gamescope behavior. */
-		union drm_amdgpu_sched sched = {0};
-		sched.in.op = AMDGPU_SCHED_OP_PROCESS_PRIORITY_OVERRIDE;
-		sched.in.fd = local_fd;
-		sched.in.priority = AMDGPU_CTX_PRIORITY_VERY_HIGH;
-
-		if (drmIoctl(drm_master_fd, DRM_IOCTL_AMDGPU_SCHED, &sched) == 0) {
+		if (amdgpu_sched_override(local_fd, AMDGPU_CTX_PRIORITY_VERY_HIGH) == 0) {
 			gpu_sched_applied = 1;
 			gpu_sched_local_fd = local_fd;  /* keep alive until restore */
 			wlr_log(WLR_INFO, "GPU sched: AMD process priority → VERY_HIGH (VRAM prio) for PID %d", pid);
 		} else {
 			/* VERY_HIGH may require CAP_SYS_NICE; fall back to HIGH */
-			sched.in.priority = AMDGPU_CTX_PRIORITY_HIGH;
-			if (drmIoctl(drm_master_fd, DRM_IOCTL_AMDGPU_SCHED, &sched) == 0) {
+			if (amdgpu_sched_override(local_fd, AMDGPU_CTX_PRIORITY_HIGH) == 0) {
 				gpu_sched_applied = 1;
 				gpu_sched_local_fd = local_fd;
 				wlr_log(WLR_INFO, "GPU sched: AMD process priority → HIGH (VERY_HIGH denied) for PID %d", pid);
@@ -1604,14 +1833,7 @@ restore_gpu_sched_priority(pid_t pid)
 		GpuInfo *gpu = &detected_gpus[gpu_idx];
 
 		if (gpu->vendor == GPU_VENDOR_AMD && gpu_sched_local_fd >= 0) {
-			int drm_master_fd = wlr_renderer_get_drm_fd(drw);
-			if (drm_master_fd >= 0) {
-				union drm_amdgpu_sched sched = {0};
-				sched.in.op = AMDGPU_SCHED_OP_PROCESS_PRIORITY_OVERRIDE;
-				sched.in.fd = gpu_sched_local_fd;
-				sched.in.priority = AMDGPU_CTX_PRIORITY_NORMAL;
-				drmIoctl(drm_master_fd, DRM_IOCTL_AMDGPU_SCHED, &sched);
-			}
+			amdgpu_sched_override(gpu_sched_local_fd, AMDGPU_CTX_PRIORITY_NORMAL);
 			close(gpu_sched_local_fd);
 			gpu_sched_local_fd = -1;
 			wlr_log(WLR_INFO, "GPU sched: AMD process priority → NORMAL for PID %d", pid);
@@ -1621,7 +1843,6 @@ restore_gpu_sched_priority(pid_t pid)
 	gpu_sched_applied = 0;
 }
 
-static int is_wine_or_proton_process(pid_t pid);
 static int is_known_game_app(const char *app);
 
 /*
@@ -1656,38 +1877,20 @@ static int
 retro_check_single_pid(pid_t pid)
 {
 	char path[64], buf[512];
-	FILE *fp;
+	ProcInfo pi;
 	ssize_t n;
 	int fd;
-	size_t len;
 
 	if (pid <= 1)
 		return 0;
 
-	/* /proc/PID/comm — kernel task name (max 15 chars) */
-	snprintf(path, sizeof(path), "/proc/%d/comm", pid);
-	fp = fopen(path, "r");
-	if (fp) {
-		if (fgets(buf, sizeof(buf), fp)) {
-			len = strlen(buf);
-			if (len > 0 && buf[len - 1] == '\n')
-				buf[len - 1] = '\0';
-			if (retro_match_string(buf)) {
-				fclose(fp);
-				return 1;
-			}
-		}
-		fclose(fp);
-	}
+	/* comm — kernel task name (max 15 chars) */
+	if (proctable_get(pid, &pi) == 0 && retro_match_string(pi.comm))
+		return 1;
 
-	/* /proc/PID/exe — real executable path (catches wrappers w/ short comm) */
-	snprintf(path, sizeof(path), "/proc/%d/exe", pid);
-	n = readlink(path, buf, sizeof(buf) - 1);
-	if (n > 0) {
-		buf[n] = '\0';
-		if (retro_match_string(buf))
-			return 1;
-	}
+	/* exe — real executable path (catches wrappers w/ short comm) */
+	if (proctable_exe(pid, buf, sizeof(buf)) == 0 && retro_match_string(buf))
+		return 1;
 
 	/* /proc/PID/cmdline — full argv, NUL-separated */
 	snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
@@ -1709,11 +1912,10 @@ retro_check_single_pid(pid_t pid)
 	return 0;
 }
 
-static int
+int
 is_retro_emulator_pid(pid_t pid)
 {
-	char path[64], stat_comm[64];
-	FILE *fp;
+	ProcInfo pi;
 	pid_t cur = pid;
 	int depth = 0;
 
@@ -1723,17 +1925,9 @@ is_retro_emulator_pid(pid_t pid)
 		if (retro_check_single_pid(cur))
 			return 1;
 
-		snprintf(path, sizeof(path), "/proc/%d/stat", cur);
-		fp = fopen(path, "r");
-		if (!fp)
-			return 0;
-		pid_t ppid = 0;
-		if (fscanf(fp, "%*d (%63[^)]) %*c %d", stat_comm, &ppid) != 2) {
-			fclose(fp);
+		if (proctable_get(cur, &pi) != 0)
 			return 0;
-		}
-		fclose(fp);
-		cur = ppid;
+		cur = pi.ppid;
 		depth++;
 	}
 	return 0;
@@ -1759,7 +1953,7 @@ is_retro_emulator_client(Client *c)
 	}
 
 	pid = client_get_pid(c);
-	if (pid > 1 && is_retro_emulator_pid(pid))
+	if (pid > 1 && classify_client_ready(c) && c->retro_verdict > 0)
 		return 1;
 
 	/* Ancestry check: clients launched under the retroarch session we
@@ -1790,6 +1984,185 @@ static int gm_bg_desired_ultra;
 static int gm_bg_applied_ultra;
 static pid_t gm_bg_pid;
 static int gm_bg_wake;
+static int gm_bg_reclaim;           /* psiwatch: page out frozen memory */
+
+/*
+ * Ultra-mode transitions as a task graph.
+ *
+ * Entering and leaving ultra mode is a list of independent system knobs,
+ * several of them slow: powerprofilesctl and systemctl fork/exec, the
+ * freeze and SCHED_IDLE sweeps walk every process, nvidia-smi takes
+ * hundreds of milliseconds.  Run one after another they kept the game
+ * waiting for its tuning for about a second after it went fullscreen.
+ *
+ * Each step names the steps it must follow; everything else runs
+ * concurrently on a small pool, with the gm-bg worker itself taking steps
+ * too.  Steps touch disjoint state (each knob keeps its own saved value),
+ * so the only ordering that matters is spelled out in `after`.  When the
+ * graph is done, per-step start offsets and durations go to the diag log.
+ */
+#define GM_POOL_THREADS 3          /* plus the thread running the graph */
+#define GM_STEP(i)      (1u << (i))
+
+typedef struct {
+	const char *name;
+	void (*run)(pid_t pid);
+	uint32_t after;            /* GM_STEP() mask that must finish first */
+	int needs_pid;             /* skipped when the game pid is unknown */
+} GmStep;
+
+typedef struct {
+	const GmStep *steps;
+	int n;
+	pid_t pid;
+	uint32_t started, finished;
+	uint64_t begin_ns[32], end_ns[32];
+} GmGraph;
+
+static pthread_t gm_pool[GM_POOL_THREADS];
+static int gm_pool_count;
+static int gm_pool_stop;
+static GmGraph *gm_graph;
+static pthread_mutex_t gm_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gm_pool_cond = PTHREAD_COND_INITIALIZER;
+
+static void gm_step_power(pid_t pid) { (void)pid; fan_boost_activate(); apply_power_profile_performance(); }
+static void gm_step_freeze(pid_t pid) { (void)pid; freeze_background_processes(); }
+static void gm_step_gametune(pid_t pid) { (void)pid; gametune_start(); }
+static void gm_step_raw_input(pid_t pid) { (void)pid; apply_raw_input(); }
+static void gm_step_gpu_power(pid_t pid) { (void)pid; apply_gpu_power_state(); }
+static void gm_step_lower(pid_t pid) { lower_competing_processes(pid); }
+
+static void gm_unstep_power(pid_t pid) { (void)pid; restore_power_profile(); fan_boost_deactivate(); }
+static void gm_unstep_freeze(pid_t pid) { (void)pid; unfreeze_background_processes(); }
+static void gm_unstep_gametune(pid_t pid) { (void)pid; gametune_stop(); }
+static void gm_unstep_raw_input(pid_t pid) { (void)pid; restore_raw_input(); }
+static void gm_unstep_gpu_power(pid_t pid) { (void)pid; restore_gpu_power_state(); }
+static void gm_unstep_lower(pid_t pid) { (void)pid; restore_competing_processes(); }
+
+enum { GmPower, GmFreeze, GmGametune, GmRawInput, GmGpuPower,
+	GmPriority, GmAffinity, GmGpuSched, GmLower, GmStepCount };
+
+/* Root-only knobs (C-state QoS, swappiness, memory compaction) go
+ * through nixly-gametune.service; the rest — THP, watchdog, split_lock,
+ * io scheduler, governor, IRQ affinity — is static system config.  The
+ * game's OOM protection uses the same helper unit, so priority waits for
+ * gametune to have probed and started it.  Priority also follows
+ * affinity: its per-thread pass moves compile workers off the game's
+ * CPUs, which the whole-process affinity mask would otherwise undo. */
+static const GmStep gm_enter_steps[GmStepCount] = {
+	[GmPower]    = { "power",     gm_step_power,     0, 0 },
+	[GmFreeze]   = { "freeze",    gm_step_freeze,    0, 0 },
+	[GmGametune] = { "gametune",  gm_step_gametune,  0, 0 },
+	[GmRawInput] = { "raw-input", gm_step_raw_input, 0, 0 },
+	[GmGpuPower] = { "gpu-power", gm_step_gpu_power, 0, 0 },
+	[GmPriority] = { "priority",  apply_game_priority,
+		GM_STEP(GmGametune) | GM_STEP(GmAffinity), 1 },
+	[GmAffinity] = { "affinity",  apply_cpu_affinity,  0, 1 },
+	[GmGpuSched] = { "gpu-sched", apply_gpu_sched_priority, 0, 1 },
+	[GmLower]    = { "lower",     gm_step_lower,     0, 1 },
+};
+
+/* Exit mirrors enter: the helper unit stops after the OOM protection it
+ * carries has been released. */
+static const GmStep gm_exit_steps[GmStepCount] = {
+	[GmPower]    = { "power",     gm_unstep_power,     0, 0 },
+	[GmFreeze]   = { "unfreeze",  gm_unstep_freeze,    0, 0 },
+	[GmGametune] = { "gametune",  gm_unstep_gametune,  GM_STEP(GmPriority), 0 },
+	[GmRawInput] = { "raw-input", gm_unstep_raw_input, 0, 0 },
+	[GmGpuPower] = { "gpu-power", gm_unstep_gpu_power, 0, 0 },
+	[GmPriority] = { "priority",  restore_game_priority, 0, 1 },
+	[GmAffinity] = { "affinity",  restore_cpu_affinity,  0, 1 },
+	[GmGpuSched] = { "gpu-sched", restore_gpu_sched_priority, 0, 1 },
+	[GmLower]    = { "lower",     gm_unstep_lower,     0, 0 },
+};
+
+/* Claim the next step whose predecessors have finished, or -1.
+ * gm_pool_mutex held. */
+static int
+gm_graph_pick(GmGraph *g)
+{
+	for (int i = 0; i < g->n; i++) {
+		if ((g->started & GM_STEP(i)) || (g->steps[i].after & ~g->finished))
+			continue;
+		g->started |= GM_STEP(i);
+		return i;
+	}
+	return -1;
+}
+
+/* Run step i of g with gm_pool_mutex dropped; held again on return. */
+static void
+gm_graph_run(GmGraph *g, int i)
+{
+	const GmStep *st = &g->steps[i];
+
+	pthread_mutex_unlock(&gm_pool_mutex);
+	g->begin_ns[i] = get_time_ns();
+	if (!st->needs_pid || g->pid > 1)
+		st->run(g->pid);
+	g->end_ns[i] = get_time_ns();
+	pthread_mutex_lock(&gm_pool_mutex);
+	g->finished |= GM_STEP(i);
+	pthread_cond_broadcast(&gm_pool_cond);
+}
+
+static void *
+gm_pool_func(void *arg)
+{
+	int i;
+
+	(void)arg;
+	pthread_mutex_lock(&gm_pool_mutex);
+	while (!gm_pool_stop) {
+		if (!gm_graph || (i = gm_graph_pick(gm_graph)) < 0) {
+			pthread_cond_wait(&gm_pool_cond, &gm_pool_mutex);
+			continue;
+		}
+		gm_graph_run(gm_graph, i);
+	}
+	pthread_mutex_unlock(&gm_pool_mutex);
+	return NULL;
+}
+
+/* Run a whole transition and return when every step has finished.  The
+ * caller takes steps as well, so this also works with no pool threads
+ * (they failed to start, or shutdown already stopped them). */
+static void
+gm_run_graph(const char *what, const GmStep *steps, int n, pid_t pid)
+{
+	GmGraph g = { .steps = steps, .n = n, .pid = pid };
+	uint32_t all = GM_STEP(n) - 1;
+	uint64_t t0 = get_time_ns(), t1;
+	int i;
+
+	pthread_mutex_lock(&gm_pool_mutex);
+	gm_graph = &g;
+	pthread_cond_broadcast(&gm_pool_cond);
+	while (g.finished != all) {
+		if ((i = gm_graph_pick(&g)) >= 0)
+			gm_graph_run(&g, i);
+		else
+			pthread_cond_wait(&gm_pool_cond, &gm_pool_mutex);
+	}
+	gm_graph = NULL;
+	pthread_mutex_unlock(&gm_pool_mutex);
+	t1 = get_time_ns();
+
+	wlr_log(WLR_INFO, "gm-bg: ultra %s complete in %.1f ms (pid=%d)",
+		what, (double)(t1 - t0) / 1e6, pid);
+	diag_logf("GAMEMODE", "ultra %s pid=%d: %.1f ms on %d threads",
+		what, pid, (double)(t1 - t0) / 1e6, gm_pool_count + 1);
+	for (i = 0; i < n; i++) {
+		if (steps[i].needs_pid && pid <= 1) {
+			diag_logf("GAMEMODE", "  %-9s skipped (no pid)", steps[i].name);
+			continue;
+		}
+		diag_logf("GAMEMODE", "  %-9s +%6.1f ms  %7.1f ms", steps[i].name,
+			(double)(g.begin_ns[i] - t0) / 1e6,
+			(double)(g.end_ns[i] - g.begin_ns[i]) / 1e6);
+	}
+}
 
 /* Full ultra-mode teardown.  Called from the worker's exit branch and
  * from gm_bg_cleanup() on compositor shutdown — without the latter,
@@ -1799,32 +2172,55 @@ static void
 gm_ultra_exit(pid_t pid)
 {
 	wlr_log(WLR_INFO, "gm-bg: exiting ultra (pid=%d)", pid);
-	restore_competing_processes();
-	restore_gpu_power_state();
-	restore_raw_input();
-	if (pid > 1) {
-		restore_cpu_affinity(pid);
-		restore_gpu_sched_priority(pid);
-		restore_game_priority(pid);
-	}
-	gametune_stop();
-	unfreeze_background_processes();
-	restore_power_profile();
-	fan_boost_deactivate();
-	wlr_log(WLR_INFO, "gm-bg: ultra exit complete");
+	gm_run_graph("exit", gm_exit_steps, GmStepCount, pid);
 }
 
+#define GM_THREAD_RESCAN_MS 2000
+
 static void *
 gm_bg_worker_func(void *arg)
 {
 	(void)arg;
 	pthread_mutex_lock(&gm_bg_mutex);
 	while (gm_bg_alive) {
-		while (!gm_bg_wake && gm_bg_alive)
-			pthread_cond_wait(&gm_bg_cond, &gm_bg_mutex);
+		while (!gm_bg_wake && !gm_bg_reclaim && gm_bg_alive) {
+			struct timespec ts;
+
+			if (!gm_bg_applied_ultra || gm_bg_pid <= 1) {
+				pthread_cond_wait(&gm_bg_cond, &gm_bg_mutex);
+				continue;
+			}
+			/* Ultra on: rescan the game's threads every
+			 * GM_THREAD_RESCAN_MS for new ones and busy ones. */
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec += GM_THREAD_RESCAN_MS / 1000;
+			ts.tv_nsec += (GM_THREAD_RESCAN_MS % 1000) * 1000000L;
+			if (ts.tv_nsec >= 1000000000L) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000L;
+			}
+			if (pthread_cond_timedwait(&gm_bg_cond, &gm_bg_mutex, &ts) == ETIMEDOUT
+					&& !gm_bg_wake && gm_bg_alive) {
+				pthread_mutex_unlock(&gm_bg_mutex);
+				gamethreads_rescan();
+				pthread_mutex_lock(&gm_bg_mutex);
+			}
+		}
 		if (!gm_bg_alive)
 			break;
 
+		/* Between transitions only: the freeze step owns the lists. */
+		if (gm_bg_reclaim && !gm_bg_wake) {
+			gm_bg_reclaim = 0;
+			pthread_mutex_unlock(&gm_bg_mutex);
+			if (frozen_cg_pid_count > 0)
+				reclaim_frozen_memory(frozen_cg_pids, frozen_cg_pid_count);
+			if (frozen_pid_count > 0)
+				reclaim_frozen_memory(frozen_pids, frozen_pid_count);
+			pthread_mutex_lock(&gm_bg_mutex);
+			continue;
+		}
+
 		gm_bg_wake = 0;
 		int want = gm_bg_desired_ultra;
 		int have = gm_bg_applied_ultra;
@@ -1834,23 +2230,7 @@ gm_bg_worker_func(void *arg)
 		if (want && !have) {
 			/* Entering ultra — heavy system tuning */
 			wlr_log(WLR_INFO, "gm-bg: entering ultra (pid=%d)", pid);
-			fan_boost_activate();
-			apply_power_profile_performance();
-			freeze_background_processes();
-			/* Root-only knobs (C-state QoS, swappiness, memory
-			 * compaction) go through nixly-gametune.service; the
-			 * rest — THP, watchdog, split_lock, io scheduler,
-			 * governor, IRQ affinity — is static system config. */
-			gametune_start();
-			apply_raw_input();
-			apply_gpu_power_state();
-			if (pid > 1) {
-				apply_game_priority(pid);
-				apply_cpu_affinity(pid);
-				apply_gpu_sched_priority(pid);
-				lower_competing_processes(pid);
-			}
-			wlr_log(WLR_INFO, "gm-bg: ultra enter complete");
+			gm_run_graph("enter", gm_enter_steps, GmStepCount, pid);
 		} else if (!want && have) {
 			gm_ultra_exit(pid);
 		}
@@ -1877,12 +2257,31 @@ gm_bg_post(int ultra, pid_t pid)
 	pthread_mutex_unlock(&gm_bg_mutex);
 }
 
+/* Memory is stalling: page the frozen background processes out again
+ * (they were paged out at freeze time, but the game may have pulled
+ * their pages back in through shared mappings since).  Runs on the
+ * gm-bg worker; a no-op when nothing is frozen. */
+void
+gm_reclaim_frozen(void)
+{
+	pthread_mutex_lock(&gm_bg_mutex);
+	gm_bg_reclaim = 1;
+	pthread_cond_signal(&gm_bg_cond);
+	pthread_mutex_unlock(&gm_bg_mutex);
+}
+
 void
 gm_bg_init(void)
 {
 	gm_bg_alive = 1;
 	pthread_create(&gm_bg_thread, NULL, gm_bg_worker_func, NULL);
 	pthread_setname_np(gm_bg_thread, "gm-bg-worker");
+
+	for (gm_pool_count = 0; gm_pool_count < GM_POOL_THREADS; gm_pool_count++) {
+		if (pthread_create(&gm_pool[gm_pool_count], NULL, gm_pool_func, NULL) != 0)
+			break;
+		pthread_setname_np(gm_pool[gm_pool_count], "gm-pool");
+	}
 }
 
 void
@@ -1898,6 +2297,14 @@ gm_bg_cleanup(void)
 	 * been joined, so this runs race-free. */
 	if (gm_bg_applied_ultra)
 		gm_ultra_exit(gm_bg_pid);
+
+	pthread_mutex_lock(&gm_pool_mutex);
+	gm_pool_stop = 1;
+	pthread_cond_broadcast(&gm_pool_cond);
+	pthread_mutex_unlock(&gm_pool_mutex);
+	for (int i = 0; i < gm_pool_count; i++)
+		pthread_join(gm_pool[i], NULL);
+	gm_pool_count = 0;
 }
 
 static struct wl_event_source *game_mode_debounce_timer;
@@ -1982,6 +2389,9 @@ update_game_mode(void)
 	game_mode_active = is_game;
 	game_mode_client = is_game ? c : NULL;
 	game_mode_ultra  = is_game;
+	/* the sampler's cadence only depends on the transition */
+	if (game_mode_active != was_active)
+		gpustat_kick();
 
 	if (game_mode_ultra && !was_ultra) {
 		/*
@@ -2061,8 +2471,8 @@ update_game_mode(void)
 			}
 		}
 
-		/* Pin the compositor thread to physical core 0 (all its SMT
-		 * threads).  Runs HERE (main thread) because
+		/* Pin the compositor thread to one physical core (all its
+		 * SMT threads).  Runs HERE (main thread) because
 		 * sched_setaffinity(0, ...) affects the calling thread — on
 		 * the gm-bg worker it pinned the worker.  Same split the game
 		 * affinity uses; see gm_core_split(). */
@@ -2071,8 +2481,9 @@ update_game_mode(void)
 			if (gm_core_split(&comp_set, &game_set) &&
 			    sched_setaffinity(0, sizeof(comp_set), &comp_set) == 0) {
 				compositor_pin_applied = 1;
-				wlr_log(WLR_INFO, "Compositor pinned to %d CPU(s) of physical core 0",
-					CPU_COUNT(&comp_set));
+				char list[64];
+				cputopo_format(&comp_set, list, sizeof(list));
+				wlr_log(WLR_INFO, "Compositor pinned to CPUs %s", list);
 			}
 		}
 
@@ -2145,12 +2556,8 @@ update_game_mode(void)
 
 			/* Un-pin compositor (main thread, like the pin) */
 			if (compositor_pin_applied) {
-				int ncores = sysconf(_SC_NPROCESSORS_ONLN);
-				cpu_set_t all_set;
-				CPU_ZERO(&all_set);
-				for (int i = 0; i < ncores; i++)
-					CPU_SET(i, &all_set);
-				sched_setaffinity(0, sizeof(all_set), &all_set);
+				const cpu_set_t *all_set = &cputopo_get()->online;
+				sched_setaffinity(0, sizeof(*all_set), all_set);
 				compositor_pin_applied = 0;
 			}
 
@@ -0,0 +1,361 @@
+/*
+ * gameprofile.c — per-title learned display and tuning state.
+ *
+ * gamescan, autolock, span and the 10-bit/HDR handling work out their
+ * answer for a title from scratch on every launch: ~2 s of stable
+ * off-mode buffers before the resolution modeset, 15 s of stable lock
+ * before the refresh modeset, a configure round-trip before the span.
+ * Each of those lands mid-game as a modeset or a re-layout.
+ *
+ * What they settled on is recorded when the game leaves fullscreen,
+ * keyed by Steam AppID (STEAM_GAME, or the AppId on the launching
+ * reaper's command line) or else the app-id, in
+ * $XDG_STATE_HOME/nixlytile/game-profiles.  The next fullscreen
+ * transition — the moment launchfx puts its black cover up, before the
+ * game is configured to the output — replays it:
+ *   - span is decided before the fullscreen geometry is computed,
+ *   - the learned mode is set and handed to gamescan (resolution) or
+ *     autolock (refresh only), whose restore paths undo it on exit,
+ *   - autolock starts at the learned lock instead of warming up,
+ *   - a title whose buffers made KMS fail last time starts on GPU
+ *     composition and re-probes scanout after the normal cooldown,
+ *   - an HDR title keeps the deep render format rather than dropping to
+ *     8-bit for scanout and going back when HDR enters.
+ * The live logic keeps running on top: gamescan replaces a replayed
+ * resolution the game no longer renders at, and only a resolution it
+ * has matched to the game's buffer is learned, so a stale profile
+ * (changed game settings) is corrected in play and re-learned at exit.  VRR is only
+ * recorded: setfullscreen already enables it at the transition, and HDR
+ * itself cannot be entered before the game tags a surface PQ.  A
+ * profile applies only on the output it was learned on.
+ */
+#include "nixlytile.h"
+#include "client.h"
+#include "diag.h"
+
+enum { GpBlockScanout = 1 << 0 };  /* KMS rejected the game's buffers */
+
+typedef struct {
+	char key[96];
+	char output[32];
+	int mode_w, mode_h, mode_mhz;  /* 0 = the desktop mode */
+	int lock_fps;
+	int vrr, hdr, span;
+	unsigned blockers;
+} GameProfile;
+
+static GameProfile *gp;
+static int gp_count, gp_cap, gp_loaded;
+
+/* The fullscreen session being profiled; one game at a time. */
+static struct {
+	Client *c;
+	char key[96];
+	uint32_t scanout_falls0;
+} gp_cur;
+
+static int
+gp_path(char *out, size_t len, int create)
+{
+	const char *xdg = getenv("XDG_STATE_HOME"), *home = getenv("HOME");
+	char base[PATH_MAX];
+
+	if (xdg && *xdg) {
+		snprintf(base, sizeof(base), "%s", xdg);
+	} else if (home && *home) {
+		snprintf(base, sizeof(base), "%s/.local", home);
+		if (create)
+			mkdir(base, 0755);
+		snprintf(base, sizeof(base), "%s/.local/state", home);
+	} else {
+		return -1;
+	}
+	if (create)
+		mkdir(base, 0755);
+	snprintf(out, len, "%s/nixlytile", base);
+	if (create && mkdir(out, 0755) != 0 && errno != EEXIST)
+		return -1;
+	if (strlen(out) + sizeof("/game-profiles") > len)
+		return -1;
+	strcat(out, "/game-profiles");
+	return 0;
+}
+
+static GameProfile *
+gp_find(const char *key)
+{
+	for (int i = 0; i < gp_count; i++)
+		if (!strcmp(gp[i].key, key))
+			return &gp[i];
+	return NULL;
+}
+
+static GameProfile *
+gp_add(const char *key)
+{
+	GameProfile *p;
+
+	if (gp_count == gp_cap) {
+		gp_cap = gp_cap ? gp_cap * 2 : 32;
+		gp = realloc(gp, gp_cap * sizeof(*gp));
+		if (!gp)
+			die("gameprofile: out of memory");
+	}
+	p = &gp[gp_count++];
+	memset(p, 0, sizeof(*p));
+	snprintf(p->key, sizeof(p->key), "%s", key);
+	return p;
+}
+
+static void
+gp_load(void)
+{
+	char file[PATH_MAX], line[256];
+	FILE *f;
+
+	if (gp_loaded)
+		return;
+	gp_loaded = 1;
+	if (gp_path(file, sizeof(file), 0) != 0 || !(f = fopen(file, "re")))
+		return;
+	while (fgets(line, sizeof(line), f)) {
+		GameProfile p = {0};
+
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%95s %31s %dx%d@%d %d %d %d %d %x",
+				p.key, p.output, &p.mode_w, &p.mode_h, &p.mode_mhz,
+				&p.lock_fps, &p.vrr, &p.hdr, &p.span, &p.blockers) != 10)
+			continue;
+		if (!gp_find(p.key))
+			*gp_add(p.key) = p;
+	}
+	fclose(f);
+	wlr_log(WLR_INFO, "gameprofile: %d profiles loaded", gp_count);
+}
+
+static void
+gp_store(void)
+{
+	char file[PATH_MAX], tmp[PATH_MAX + 16];
+	FILE *f;
+	int ok;
+
+	if (gp_path(file, sizeof(file), 1) != 0)
+		return;
+	snprintf(tmp, sizeof(tmp), "%s.%d", file, (int)getpid());
+	if (!(f = fopen(tmp, "we")))
+		return;
+	fprintf(f, "# key output mode lock-fps vrr hdr span blockers\n");
+	for (int i = 0; i < gp_count; i++)
+		fprintf(f, "%s %s %dx%d@%d %d %d %d %d %x\n", gp[i].key,
+			gp[i].output, gp[i].mode_w, gp[i].mode_h, gp[i].mode_mhz,
+			gp[i].lock_fps, gp[i].vrr, gp[i].hdr, gp[i].span,
+			gp[i].blockers);
+	ok = !ferror(f);
+	if (fclose(f) != 0)
+		ok = 0;
+	if (!ok || rename(tmp, file) != 0)
+		unlink(tmp);
+}
+
+/* Steam AppID when there is one (Big Picture, 769, is not a title),
+ * else the app-id with whitespace folded so a line stays parseable. */
+static int
+gp_key(Client *c, char *out, size_t len)
+{
+	uint32_t steam = c->steam_game_id;
+	const char *appid;
+
+	if (!steam || steam == 769)
+		steam = launchfx_appid();
+	if (steam) {
+		snprintf(out, len, "steam:%u", steam);
+		return 0;
+	}
+	appid = client_get_appid(c);
+	if (!appid || !*appid)
+		return -1;
+	snprintf(out, len, "app:%s", appid);
+	for (char *p = out; *p; p++)
+		if (isspace((unsigned char)*p))
+			*p = '_';
+	return 0;
+}
+
+/* The session's profile, if it was learned on c's output. */
+static GameProfile *
+gp_for(Client *c)
+{
+	GameProfile *p;
+
+	if (!c || c != gp_cur.c || !c->mon || !c->mon->wlr_output)
+		return NULL;
+	p = gp_find(gp_cur.key);
+	if (!p || strcmp(p->output, c->mon->wlr_output->name) != 0)
+		return NULL;
+	return p;
+}
+
+/* Set the learned mode now, while the cover hides the modeset.  The mode
+ * is handed to the owner that would have set it mid-game, so that
+ * owner's exit path restores the desktop mode. */
+static void
+gp_set_mode(Monitor *m, const GameProfile *p)
+{
+	struct wlr_output_mode *mode, *target = NULL, *best;
+	struct wlr_output_state state;
+	struct wlr_output_configuration_v1 *config;
+	struct wlr_output_configuration_head_v1 *config_head;
+	RuntimeMonitorConfig *rtcfg;
+
+	if (!m->wlr_output->enabled || m->gamescan_mode_active
+			|| m->console_mode_active)
+		return;
+	/* Respect a user-pinned mode, as gamescan and autolock do. */
+	rtcfg = find_monitor_config(m->wlr_output->name);
+	if (rtcfg && (rtcfg->refresh > 0 || (rtcfg->width > 0 && rtcfg->height > 0)))
+		return;
+	wl_list_for_each(mode, &m->wlr_output->modes, link) {
+		if (mode->width == p->mode_w && mode->height == p->mode_h
+				&& mode->refresh == p->mode_mhz) {
+			target = mode;
+			break;
+		}
+	}
+	if (!target || target == m->wlr_output->current_mode)
+		return;
+	best = bestmode(m->wlr_output);
+
+	wlr_output_state_init(&state);
+	wlr_output_state_set_mode(&state, target);
+	if (wlr_output_test_state(m->wlr_output, &state)
+	    && wlr_output_commit_state(m->wlr_output, &state)) {
+		if (best && best->width == target->width
+				&& best->height == target->height) {
+			m->al_mode_active = 1;
+			m->al_last_modeset_ns = get_time_ns();
+		} else {
+			m->gamescan_original = best;
+			m->gamescan_mode_active = 1;
+			m->gamescan_from_profile = 1;
+		}
+		wlr_log(WLR_INFO, "gameprofile: %s switched to %dx%d@%dmHz",
+			m->wlr_output->name, target->width, target->height,
+			target->refresh);
+		config = wlr_output_configuration_v1_create();
+		config_head = wlr_output_configuration_head_v1_create(
+				config, m->wlr_output);
+		config_head->state.mode = target;
+		wlr_output_manager_v1_set_configuration(output_mgr, config);
+		updatemons(NULL, NULL);
+	}
+	wlr_output_state_finish(&state);
+}
+
+/* setfullscreen, entering, with the cover up and before the fullscreen
+ * geometry is computed: open the session and decide span. */
+void
+gameprofile_begin(Client *c)
+{
+	GameProfile *p;
+
+	if (!c || !c->mon || !c->mon->wlr_output)
+		return;
+	if (!looks_like_game(c) || is_retro_emulator_client(c))
+		return;
+	gp_load();
+	memset(&gp_cur, 0, sizeof(gp_cur));
+	if (gp_key(c, gp_cur.key, sizeof(gp_cur.key)) != 0)
+		return;
+	gp_cur.c = c;
+	gp_cur.scanout_falls0 = c->mon->scanout_falls;
+
+	if (!(p = gp_for(c)) || !p->span || c->isspanned || !span_available())
+		return;
+	c->isspanned = 1;
+	/* Without resolution-driven span nothing would ever end it: make it
+	 * the override togglegamespan releases. */
+	if (!game_span_auto)
+		c->span_manual = 1;
+	wlr_log(WLR_INFO, "gameprofile: %s spans (learned)", gp_cur.key);
+}
+
+/* setfullscreen, entering, after the per-fullscreen state was reset:
+ * replay the rest of the profile. */
+void
+gameprofile_apply(Client *c)
+{
+	GameProfile *p = gp_for(c);
+	Monitor *m;
+
+	if (!p)
+		return;
+	m = c->mon;
+	if (p->mode_w > 0 && !c->isspanned)
+		gp_set_mode(m, p);
+	if (p->lock_fps > 0 && game_auto_fps_lock_enabled && !fps_limit_enabled) {
+		m->al_lock_fps = p->lock_fps;
+		m->al_lock_since_ns = get_time_ns();
+	}
+	if ((p->blockers & GpBlockScanout) && !m->scanout_blacklist) {
+		/* Same fallback output.c engages after the failures, with the
+		 * short cooldown, so a fixed driver gets scanout back. */
+		m->scanout_blacklist = 1;
+		m->scanout_cooldown = 600;
+		scene->WLR_PRIVATE.direct_scanout = false;
+	}
+	m->profile_keep_10bit = p->hdr && m->hdr_capable;
+
+	diag_logf("PROFILE", "%s on %s: mode=%dx%d@%d lock=%d vrr=%d hdr=%d "
+		"span=%d blockers=%x", p->key, p->output, p->mode_w, p->mode_h,
+		p->mode_mhz, p->lock_fps, p->vrr, p->hdr, p->span, p->blockers);
+}
+
+/* The game leaves fullscreen or unmaps: record where the live logic
+ * ended up.  Called before any of it is restored. */
+void
+gameprofile_learn(Client *c)
+{
+	GameProfile np = {0}, *p;
+	Monitor *m, *mon;
+	struct wlr_output_mode *cur;
+
+	if (!c || c != gp_cur.c)
+		return;
+	gp_cur.c = NULL;
+	wl_list_for_each(mon, &mons, link)
+		mon->profile_keep_10bit = 0;
+	m = c->mon;
+	if (!m || !m->wlr_output)
+		return;
+
+	snprintf(np.key, sizeof(np.key), "%s", gp_cur.key);
+	snprintf(np.output, sizeof(np.output), "%s", m->wlr_output->name);
+	/* A resolution counts only once gamescan matched it to the game's
+	 * buffer: a replayed mode the game never rendered at is dropped. */
+	cur = m->wlr_output->current_mode;
+	if (cur && ((m->gamescan_mode_active && !m->gamescan_from_profile
+				&& cur != m->gamescan_original) || m->al_mode_active)) {
+		np.mode_w = cur->width;
+		np.mode_h = cur->height;
+		np.mode_mhz = cur->refresh;
+	}
+	np.lock_fps = m->al_lock_fps;
+	np.vrr = m->game_vrr_active;
+	np.hdr = m->hdr_active;
+	np.span = c->isspanned;
+	if (m->scanout_falls != gp_cur.scanout_falls0)
+		np.blockers |= GpBlockScanout;
+
+	if ((p = gp_find(np.key)) && !memcmp(p, &np, sizeof(np)))
+		return;
+	if (!p)
+		p = gp_add(np.key);
+	*p = np;
+	gp_store();
+	wlr_log(WLR_INFO, "gameprofile: learned %s on %s: %dx%d@%d lock %d "
+		"vrr %d hdr %d span %d blockers %x", np.key, np.output,
+		np.mode_w, np.mode_h, np.mode_mhz, np.lock_fps, np.vrr, np.hdr,
+		np.span, np.blockers);
+}
@@ -22,6 +22,10 @@
  * or whose modeset fails, is remembered and never retried.  No OSD is
  * shown on entry (the OSD scene node would itself block scanout).
  *
+ * A mode replayed from a game profile (gameprofile.c) is held to the
+ * same test: it stands once a game buffer of that size is seen, and a
+ * stable buffer of another size replaces it like any off-mode size.
+ *
  * Restored to bestmode() on fullscreen exit/unmap, same as console
  * mode.
  */
@@ -38,12 +42,10 @@ gamescan_tick(Monitor *m, Client *fc, int is_direct_scanout)
 	struct wlr_surface *surf;
 	int bw, bh;
 
-	if (!m || !fc || m->gamescan_mode_active || m->gamescan_pending)
+	if (!m || !fc || m->gamescan_pending)
 		return;
-	if (is_direct_scanout) {
-		m->gamescan_stable = 0;
+	if (m->gamescan_mode_active && !m->gamescan_from_profile)
 		return;
-	}
 	if (fc->isspanned || m->video_mode_active || m->console_mode_active)
 		return;
 
@@ -56,10 +58,16 @@ gamescan_tick(Monitor *m, Client *fc, int is_direct_scanout)
 		return;
 
 	/* Size matches the mode — scanout is blocked by something else
-	 * (cursor, OSD, format); a modeset cannot help. */
+	 * (cursor, OSD, format); a modeset cannot help.  A mode replayed
+	 * from a game profile is confirmed here and owned from now on. */
 	if (m->wlr_output->current_mode &&
 	    bw == m->wlr_output->current_mode->width &&
 	    bh == m->wlr_output->current_mode->height) {
+		m->gamescan_from_profile = 0;
+		m->gamescan_stable = 0;
+		return;
+	}
+	if (is_direct_scanout) {
 		m->gamescan_stable = 0;
 		return;
 	}
@@ -89,7 +97,8 @@ gamescan_apply(Monitor *m)
 
 	if (!m || !m->wlr_output || !m->wlr_output->enabled)
 		return;
-	if (m->gamescan_mode_active || m->gamescan_w <= 0 || m->gamescan_h <= 0)
+	if ((m->gamescan_mode_active && !m->gamescan_from_profile)
+			|| m->gamescan_w <= 0 || m->gamescan_h <= 0)
 		return;
 
 	/* Respect user-pinned resolution. */
@@ -104,13 +113,16 @@ gamescan_apply(Monitor *m)
 		return;
 	}
 
-	m->gamescan_original = m->wlr_output->current_mode;
+	/* Replacing a profile's stale mode keeps the desktop mode it saved */
+	if (!m->gamescan_mode_active)
+		m->gamescan_original = m->wlr_output->current_mode;
 
 	wlr_output_state_init(&state);
 	wlr_output_state_set_mode(&state, target);
 	if (wlr_output_test_state(m->wlr_output, &state)
 	    && wlr_output_commit_state(m->wlr_output, &state)) {
 		m->gamescan_mode_active = 1;
+		m->gamescan_from_profile = 0;
 		wlr_log(WLR_INFO,
 			"Game scanout mode: %s switched to %dx%d@%dmHz to match game buffer",
 			m->wlr_output->name, target->width, target->height,
@@ -122,7 +134,8 @@ gamescan_apply(Monitor *m)
 		wlr_output_manager_v1_set_configuration(output_mgr, config);
 		updatemons(NULL, NULL);
 	} else {
-		m->gamescan_original = NULL;
+		if (!m->gamescan_mode_active)
+			m->gamescan_original = NULL;
 		m->gamescan_failed_w = m->gamescan_w;
 		m->gamescan_failed_h = m->gamescan_h;
 	}
@@ -143,6 +156,7 @@ gamescan_restore(Monitor *m)
 	m->gamescan_stable = 0;
 	m->gamescan_w = m->gamescan_h = 0;
 	m->gamescan_failed_w = m->gamescan_failed_h = 0;
+	m->gamescan_from_profile = 0;
 	if (!m->gamescan_mode_active)
 		return;
 
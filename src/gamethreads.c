@@ -0,0 +1,325 @@
+/*
+ * gamethreads.c — per-thread scheduling classes for the game process.
+ *
+ * Game mode used to give every thread of the game the same nice -10 and
+ * BE/0 ioprio.  The threads of a game want very different things: the
+ * render/submit and audio threads are on the frame's critical path, the
+ * shader-compile and pipeline workers DXVK, VKD3D and engines spin up
+ * are pure background throughput that competes with them for cores, and
+ * asset loaders want neither a boost nor a penalty.
+ *
+ * Threads are classified by comm (DXVK/VKD3D, Unreal, Unity and Source
+ * naming, wine passes SetThreadDescription names through), and threads
+ * no pattern knows are watched: one that keeps a core busy is treated
+ * as a render thread until it calms down.  Each class has a policy —
+ * nice, ioprio, and SCHED_IDLE plus the background CPUs for compile
+ * workers.  The gm-bg worker rescans while ultra mode is on to pick up
+ * threads the game starts later and to follow the CPU heuristic; every
+ * class change is logged.  All entry points run on game-mode worker
+ * threads and serialise on gt_lock.
+ */
+#include "nixlytile.h"
+#include "diag.h"
+
+#ifndef IOPRIO_CLASS_BE
+#define IOPRIO_CLASS_BE		2
+#define IOPRIO_WHO_PROCESS	1
+#define IOPRIO_PRIO_VALUE(class, data)	(((class) << 13) | (data))
+#endif
+#ifndef IOPRIO_CLASS_IDLE
+#define IOPRIO_CLASS_IDLE	3
+#endif
+#ifndef SCHED_IDLE
+#define SCHED_IDLE 5
+#endif
+
+#define GT_MAX_THREADS   1024
+#define GT_HOT_SHARE     0.60   /* of one CPU: unnamed thread counts as render */
+#define GT_COOL_SHARE    0.20   /* ... until it drops below this */
+
+enum { GtDefault, GtRender, GtAudio, GtLoader, GtCompile, GtClassCount };
+
+static const struct {
+	const char *name;
+	int nice;
+	int ioprio;
+	int idle;                  /* SCHED_IDLE, background CPUs */
+} gt_policy[GtClassCount] = {
+	[GtDefault] = { "default", -10, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 0), 0 },
+	[GtRender]  = { "render",  -12, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 0), 0 },
+	[GtAudio]   = { "audio",   -15, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 0), 0 },
+	[GtLoader]  = { "loader",    0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 4), 0 },
+	[GtCompile] = { "compile",   0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0), 1 },
+};
+
+/* comm patterns, first match wins: prefix, or substring when sub is set.
+ * Matching ignores case — engines are not consistent about it. */
+static const struct {
+	const char *pat;
+	int sub;
+	int cls;
+} gt_rules[] = {
+	/* shader and pipeline compilation */
+	{ "dxvk-shader",     0, GtCompile },
+	{ "vkd3d-shader",    0, GtCompile },
+	{ "ShaderCompil",    0, GtCompile },   /* Unreal ShaderCompilingThread */
+	{ "PSOPrecache",     0, GtCompile },
+	{ "compil",          1, GtCompile },
+	/* render / submit / frame pacing */
+	{ "dxvk-submit",     0, GtRender },
+	{ "dxvk-queue",      0, GtRender },
+	{ "dxvk-frame",      0, GtRender },
+	{ "dxvk-cs",         0, GtRender },
+	{ "vkd3d_queue",     0, GtRender },
+	{ "vkd3d_fence",     0, GtRender },
+	{ "RenderThread",    0, GtRender },    /* Unreal, Source 2 */
+	{ "RHIThread",       0, GtRender },
+	{ "RHISubmission",   0, GtRender },
+	{ "RHIInterrupt",    0, GtRender },
+	{ "GameThread",      0, GtRender },
+	{ "UnityGfxDevice",  0, GtRender },
+	{ "MatQueue",        0, GtRender },    /* Source material system */
+	/* audio */
+	{ "AudioMixer",      0, GtAudio },
+	{ "FAudio",          0, GtAudio },
+	{ "alsoft",          0, GtAudio },
+	{ "pulse",           0, GtAudio },
+	{ "data-loop",       0, GtAudio },     /* PipeWire client stream */
+	{ "audio",           1, GtAudio },
+	/* asset streaming and I/O */
+	{ "AsyncLoading",    0, GtLoader },
+	{ "IoDispatcher",    0, GtLoader },
+	{ "Loading.",        0, GtLoader },    /* Unity Loading.AsyncRead/Preload */
+	{ "FileSystem",      0, GtLoader },
+};
+
+typedef struct {
+	pid_t tid;
+	int cls;                   /* class currently applied */
+	int hot;                   /* unnamed thread over GT_HOT_SHARE */
+	int seen;
+	unsigned long long cpu;    /* utime + stime at the last scan */
+} GtThread;
+
+static pthread_mutex_t gt_lock = PTHREAD_MUTEX_INITIALIZER;
+static GtThread gt_threads[GT_MAX_THREADS];
+static int gt_count;
+static pid_t gt_pid;
+static uint64_t gt_scan_ns;
+
+static int
+gt_match(const char *comm)
+{
+	for (size_t i = 0; i < LENGTH(gt_rules); i++) {
+		if (gt_rules[i].sub ? strcasestr(comm, gt_rules[i].pat) != NULL
+				: strncasecmp(comm, gt_rules[i].pat, strlen(gt_rules[i].pat)) == 0)
+			return gt_rules[i].cls;
+	}
+	return -1;
+}
+
+/* comm and utime+stime of one thread.  Returns 0 on success. */
+static int
+gt_read(pid_t pid, pid_t tid, char *comm, size_t len, unsigned long long *cpu)
+{
+	char path[64], buf[512], *p, *q;
+	unsigned long long ut, st;
+	ssize_t n;
+	size_t l;
+	int fd;
+
+	snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid, tid);
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+
+	/* "tid (comm) S ..." — comm may itself contain ')' */
+	if (!(p = strchr(buf, '(')) || !(q = strrchr(buf, ')')) || q < p)
+		return -1;
+	l = MIN((size_t)(q - p - 1), len - 1);
+	memcpy(comm, p + 1, l);
+	comm[l] = '\0';
+
+	/* utime and stime are fields 14 and 15; q + 2 is the state (3) */
+	if (sscanf(q + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &ut, &st) != 2)
+		return -1;
+	*cpu = ut + st;
+	return 0;
+}
+
+static void
+gt_set(pid_t tid, int cls, const cpu_set_t *bg)
+{
+	struct sched_param sp = {0};
+
+	if (gt_policy[cls].idle) {
+		sched_setscheduler(tid, SCHED_IDLE, &sp);
+		if (bg)
+			sched_setaffinity(tid, sizeof(*bg), bg);
+	} else {
+		/* Leaving SCHED_IDLE (class change) — nice is ignored there. */
+		if (sched_getscheduler(tid) == SCHED_IDLE)
+			sched_setscheduler(tid, SCHED_OTHER, &sp);
+		/* Below -10 can exceed RLIMIT_NICE; fall back to the old boost. */
+		if (setpriority(PRIO_PROCESS, tid, gt_policy[cls].nice) != 0
+				&& gt_policy[cls].nice < -10)
+			setpriority(PRIO_PROCESS, tid, -10);
+	}
+	syscall(__NR_ioprio_set, IOPRIO_WHO_PROCESS, tid, gt_policy[cls].ioprio);
+}
+
+static GtThread *
+gt_find(pid_t tid)
+{
+	for (int i = 0; i < gt_count; i++)
+		if (gt_threads[i].tid == tid)
+			return &gt_threads[i];
+	return NULL;
+}
+
+/* Walk /proc/pid/task, classify every thread and apply class changes.
+ * gt_lock held. */
+static void
+gt_scan(void)
+{
+	static long hz;
+	char dir[64], comm[64];
+	int counts[GtClassCount] = {0};
+	const CpuTopo *t = cputopo_get();
+	cpu_set_t game, bg;
+	const cpu_set_t *bgp = NULL;
+	unsigned long long cpu;
+	struct dirent *ent;
+	uint64_t now = get_time_ns();
+	double secs = gt_scan_ns ? (double)(now - gt_scan_ns) / 1e9 : 0;
+	int i, cls, changed = 0;
+	DIR *d;
+
+	if (!hz)
+		hz = sysconf(_SC_CLK_TCK);
+	if (cputopo_background_set(t, cputopo_game_set(t, &game) ? &game : NULL, &bg))
+		bgp = &bg;
+
+	snprintf(dir, sizeof(dir), "/proc/%d/task", gt_pid);
+	if (!(d = opendir(dir)))
+		return;
+	for (i = 0; i < gt_count; i++)
+		gt_threads[i].seen = 0;
+
+	while ((ent = readdir(d))) {
+		GtThread *th;
+		pid_t tid;
+
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		tid = (pid_t)atoi(ent->d_name);
+		if (gt_read(gt_pid, tid, comm, sizeof(comm), &cpu) != 0)
+			continue;
+
+		if (!(th = gt_find(tid))) {
+			if (gt_count == GT_MAX_THREADS)
+				continue;
+			th = &gt_threads[gt_count++];
+			th->tid = tid;
+			th->cls = -1;
+			th->hot = 0;
+			th->cpu = cpu;
+		} else if (secs > 0 && hz > 0) {
+			double share = (double)(cpu - th->cpu) / (double)hz / secs;
+			if (share >= GT_HOT_SHARE)
+				th->hot = 1;
+			else if (share < GT_COOL_SHARE)
+				th->hot = 0;
+			th->cpu = cpu;
+		}
+		th->seen = 1;
+
+		if ((cls = gt_match(comm)) < 0)
+			cls = th->hot ? GtRender : GtDefault;
+		counts[cls]++;
+		if (cls == th->cls) {
+			/* apply_cpu_affinity() re-masks every thread */
+			if (gt_policy[cls].idle && bgp)
+				sched_setaffinity(tid, sizeof(*bgp), bgp);
+			continue;
+		}
+
+		gt_set(tid, cls, bgp);
+		if (th->cls >= 0 || cls != GtDefault)
+			wlr_log(WLR_INFO, "gamethreads: %d '%s' → %s%s", tid, comm,
+				gt_policy[cls].name, gt_match(comm) < 0 && th->hot ? " (busy)" : "");
+		th->cls = cls;
+		changed = 1;
+	}
+	closedir(d);
+
+	/* drop exited threads */
+	for (i = 0; i < gt_count; )
+		if (!gt_threads[i].seen)
+			gt_threads[i] = gt_threads[--gt_count];
+		else
+			i++;
+
+	gt_scan_ns = now;
+	if (changed)
+		diag_logf("GAMEMODE", "threads pid=%d: %d render, %d audio, %d default, %d loader, %d compile",
+			gt_pid, counts[GtRender], counts[GtAudio], counts[GtDefault],
+			counts[GtLoader], counts[GtCompile]);
+}
+
+/* Classify every thread of pid and apply its class; replaces whatever
+ * game was tracked before. */
+void
+gamethreads_apply(pid_t pid)
+{
+	pthread_mutex_lock(&gt_lock);
+	gt_count = 0;
+	gt_scan_ns = 0;
+	gt_pid = pid;
+	if (pid > 1)
+		gt_scan();
+	pthread_mutex_unlock(&gt_lock);
+}
+
+/* Pick up new threads and follow the CPU heuristic.  No-op when no
+ * game is tracked. */
+void
+gamethreads_rescan(void)
+{
+	pthread_mutex_lock(&gt_lock);
+	if (gt_pid > 1)
+		gt_scan();
+	pthread_mutex_unlock(&gt_lock);
+}
+
+/* Put every tracked thread back to SCHED_OTHER, nice 0, BE/4 and stop
+ * tracking. */
+void
+gamethreads_restore(void)
+{
+	struct sched_param sp = {0};
+
+	pthread_mutex_lock(&gt_lock);
+	for (int i = 0; i < gt_count; i++) {
+		pid_t tid = gt_threads[i].tid;
+
+		if (gt_threads[i].cls < 0)
+			continue;
+		if (gt_policy[gt_threads[i].cls].idle) {
+			sched_setscheduler(tid, SCHED_OTHER, &sp);
+			sched_setaffinity(tid, sizeof(cputopo_get()->online), &cputopo_get()->online);
+		}
+		setpriority(PRIO_PROCESS, tid, 0);
+		syscall(__NR_ioprio_set, IOPRIO_WHO_PROCESS, tid,
+			IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, 4));
+	}
+	if (gt_pid > 1)
+		wlr_log(WLR_INFO, "gamethreads: restored %d threads of PID %d", gt_count, gt_pid);
+	gt_count = 0;
+	gt_pid = 0;
+	pthread_mutex_unlock(&gt_lock);
+}
@@ -0,0 +1,354 @@
+/*
+ * gpuclients.c — per-process GPU engine time and VRAM from DRM fdinfo.
+ *
+ * Every open DRM file describes its client in /proc/<pid>/fdinfo/<fd>:
+ * cumulative busy time per engine ("drm-engine-gfx: 123 ns", or xe's
+ * "drm-cycles-rcs" against "drm-total-cycles-rcs") and its memory per
+ * region ("drm-resident-vram: 512 KiB").  Two readings give each
+ * process's share of every engine over the interval — which background
+ * app is rendering while a game runs, and how much VRAM it holds.
+ *
+ * A pass walks the user's processes from proctable, finds their DRM fds
+ * the way find_process_drm_fd() does, and folds the fdinfo of each
+ * distinct drm-client-id into one entry per process (dup'd fds share the
+ * client id).  Processes without a DRM fd are re-probed only every
+ * GC_REPROBE passes.  The gpustat worker drives the passes and is the
+ * only writer: a pass builds a new table and swaps it in under gc_lock,
+ * readers copy out under it.
+ *
+ * Paths are relative to a proc root so gpuclients_scan() can be pointed
+ * at fixture fdinfo files.
+ */
+#include "nixlytile.h"
+
+#define GC_ENGINES 8
+#define GC_CLIENT_IDS 32
+#define GC_REPROBE 5
+
+typedef struct {
+	char name[16];
+	uint64_t val, ref;  /* busy ns and 0, or busy cycles and total cycles */
+	unsigned cap;       /* engines of this class */
+} GcEngine;
+
+typedef struct {
+	GcEngine eng[GC_ENGINES];
+	int n;
+	uint64_t resident_kib, memory_kib;
+} GcUsage;
+
+typedef struct {
+	pid_t pid;
+	unsigned long long start;
+	char comm[16];
+	unsigned probe;     /* pass at which a pid without DRM fds is re-read */
+	int has_drm;
+	uint64_t ns;        /* when usage was read */
+	GcUsage use;
+	int busy;           /* busiest engine over the last interval, -1 first */
+	char engine[16];
+} GcProc;
+
+static pthread_mutex_t gc_lock = PTHREAD_MUTEX_INITIALIZER;
+static GcProc *gc_procs;
+static int gc_count;
+static unsigned gc_pass;
+
+static int
+gc_seen(const long long *seen, int nseen, long long id)
+{
+	for (int i = 0; i < nseen; i++)
+		if (seen[i] == id)
+			return 1;
+	return 0;
+}
+
+/* "123 ns", "512 KiB", "3 MiB", "4096" (bytes) → value in ns or KiB */
+static uint64_t
+gc_value(const char *s, int memory)
+{
+	char *end;
+	uint64_t v = strtoull(s, &end, 10);
+
+	while (*end == ' ' || *end == '\t')
+		end++;
+	if (!memory)
+		return v;
+	if (!strncmp(end, "KiB", 3))
+		return v;
+	if (!strncmp(end, "MiB", 3))
+		return v * 1024;
+	if (!strncmp(end, "GiB", 3))
+		return v * 1024 * 1024;
+	return v / 1024;
+}
+
+static GcEngine *
+gc_engine(GcUsage *u, const char *name, size_t len)
+{
+	if (len >= sizeof(u->eng[0].name))
+		len = sizeof(u->eng[0].name) - 1;
+	for (int i = 0; i < u->n; i++)
+		if (!strncmp(u->eng[i].name, name, len) && !u->eng[i].name[len])
+			return &u->eng[i];
+	if (u->n == GC_ENGINES)
+		return NULL;
+	memcpy(u->eng[u->n].name, name, len);
+	u->eng[u->n].name[len] = '\0';
+	return &u->eng[u->n++];
+}
+
+/*
+ * Fold one fdinfo file into u.  Returns its drm-client-id, 0 when the
+ * file is not a DRM client, or -1 when it cannot be read.
+ */
+static long long
+gc_parse_fdinfo(const char *path, GcUsage *u, const long long *seen, int nseen)
+{
+	char buf[4096];
+	char *line, *save = NULL, *colon;
+	long long id = 0;
+	GcUsage one = {0};
+	GcEngine *e;
+	ssize_t n;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n < 0)
+		return -1;
+	buf[n] = '\0';
+
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		if (strncmp(line, "drm-", 4) || !(colon = strchr(line, ':')))
+			continue;
+		line += 4;
+		if (!strncmp(line, "client-id:", 10)) {
+			id = strtoll(colon + 1, NULL, 10);
+		} else if (!strncmp(line, "engine-capacity-", 16)) {
+			if ((e = gc_engine(&one, line + 16, colon - line - 16)))
+				e->cap = (unsigned)strtoul(colon + 1, NULL, 10);
+		} else if (!strncmp(line, "engine-", 7)) {
+			if ((e = gc_engine(&one, line + 7, colon - line - 7)))
+				e->val = gc_value(colon + 1, 0);
+		} else if (!strncmp(line, "total-cycles-", 13)) {
+			if ((e = gc_engine(&one, line + 13, colon - line - 13)))
+				e->ref = gc_value(colon + 1, 0);
+		} else if (!strncmp(line, "cycles-", 7)) {
+			if ((e = gc_engine(&one, line + 7, colon - line - 7)))
+				e->val = gc_value(colon + 1, 0);
+		} else if (!strncmp(line, "resident-vram", 13) || !strncmp(line, "resident-local", 14)) {
+			one.resident_kib += gc_value(colon + 1, 1);
+		} else if (!strncmp(line, "memory-vram", 11)) {
+			one.memory_kib += gc_value(colon + 1, 1);
+		}
+	}
+	if (id <= 0)
+		return 0;
+	if (gc_seen(seen, nseen, id))
+		return id;      /* dup of a client already counted */
+
+	for (int i = 0; i < one.n; i++) {
+		if (!(e = gc_engine(u, one.eng[i].name, strlen(one.eng[i].name))))
+			continue;
+		e->val += one.eng[i].val;
+		e->ref += one.eng[i].ref;
+		e->cap = MAX(e->cap, one.eng[i].cap);
+	}
+	u->resident_kib += one.resident_kib;
+	u->memory_kib += one.memory_kib;
+	return id;
+}
+
+/* Sum the DRM clients pid has open.  Returns how many, -1 if its fds
+ * cannot be listed (gone, or not ours). */
+static int
+gc_read_pid(const char *proc_root, pid_t pid, GcUsage *u)
+{
+	char dir_path[PATH_MAX], path[PATH_MAX], target[256];
+	long long seen[GC_CLIENT_IDS], id;
+	int nseen = 0;
+	struct dirent *ent;
+	ssize_t len;
+	DIR *d;
+
+	memset(u, 0, sizeof(*u));
+	snprintf(dir_path, sizeof(dir_path), "%s/%d/fd", proc_root, pid);
+	if (!(d = opendir(dir_path)))
+		return -1;
+	while ((ent = readdir(d)) != NULL) {
+		if (ent->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir_path, ent->d_name);
+		len = readlink(path, target, sizeof(target) - 1);
+		if (len <= 0)
+			continue;
+		target[len] = '\0';
+		if (strncmp(target, "/dev/dri/", 9))
+			continue;
+		snprintf(path, sizeof(path), "%s/%d/fdinfo/%s", proc_root, pid, ent->d_name);
+		id = gc_parse_fdinfo(path, u, seen, nseen);
+		if (id > 0 && nseen < GC_CLIENT_IDS && !gc_seen(seen, nseen, id))
+			seen[nseen++] = id;
+	}
+	closedir(d);
+	return nseen;
+}
+
+/* Busiest engine of p between its previous usage and u read at now. */
+static void
+gc_rate(GcProc *p, const GcUsage *u, uint64_t now)
+{
+	uint64_t dt = now - p->ns;
+
+	p->busy = -1;
+	p->engine[0] = '\0';
+	if (!p->ns || !dt)
+		return;
+	for (int i = 0; i < u->n; i++) {
+		const GcEngine *e = &u->eng[i];
+		const GcEngine *o = NULL;
+		uint64_t dv, dr;
+		int pct;
+
+		for (int j = 0; j < p->use.n && !o; j++)
+			if (!strcmp(p->use.eng[j].name, e->name))
+				o = &p->use.eng[j];
+		if (!o || e->val < o->val)
+			continue;   /* new engine, or a client closed: no rate yet */
+		dv = e->val - o->val;
+		dr = e->ref ? (e->ref > o->ref ? e->ref - o->ref : 0) : dt;
+		if (!dr)
+			continue;
+		pct = (int)MIN(dv * 100 / dr / (e->cap ? e->cap : 1), 100);
+		if (pct > p->busy) {
+			p->busy = pct;
+			snprintf(p->engine, sizeof(p->engine), "%s", e->name);
+		}
+	}
+	if (p->busy < 0)
+		p->busy = 0;
+}
+
+/*
+ * One pass over the user's processes, reading DRM fdinfo under proc_root
+ * (normally "/proc").  Returns the number of processes with a DRM client.
+ */
+int
+gpuclients_scan(const char *proc_root)
+{
+	ProcInfo *procs;
+	GcProc *next, *p;
+	uid_t uid = getuid();
+	int n, count = 0, drm_procs = 0;
+
+	if ((n = proctable_snapshot(&procs)) < 0)
+		return -1;
+	next = ecalloc((size_t)MAX(n, 1), sizeof(*next));
+
+	gc_pass++;
+	for (int i = 0; i < n; i++) {
+		GcUsage u;
+		uint64_t now;
+
+		if (procs[i].pid <= 1 || procs[i].uid != uid)
+			continue;
+		p = NULL;
+		for (int j = 0; j < gc_count && !p; j++)
+			if (gc_procs[j].pid == procs[i].pid && gc_procs[j].start == procs[i].start)
+				p = &gc_procs[j];
+		next[count] = p ? *p : (GcProc){ .pid = procs[i].pid,
+			.start = procs[i].start, .busy = -1 };
+		p = &next[count++];
+		memcpy(p->comm, procs[i].comm, sizeof(p->comm));
+		if (!p->has_drm && p->probe > gc_pass)
+			continue;
+
+		if (!(p->has_drm = gc_read_pid(proc_root, p->pid, &u) > 0)) {
+			p->probe = gc_pass + GC_REPROBE;
+			p->ns = 0;
+			p->busy = -1;
+			continue;
+		}
+		now = get_time_ns();
+		gc_rate(p, &u, now);
+		p->use = u;
+		p->ns = now;
+		drm_procs++;
+	}
+	pthread_mutex_lock(&gc_lock);
+	free(gc_procs);
+	gc_procs = next;
+	gc_count = count;
+	pthread_mutex_unlock(&gc_lock);
+	free(procs);
+	return drm_procs;
+}
+
+static int
+gc_cmp_busy(const void *a, const void *b)
+{
+	const GpuClient *x = a, *y = b;
+
+	if (x->busy != y->busy)
+		return y->busy - x->busy;
+	return x->vram_kib < y->vram_kib ? 1 : x->vram_kib > y->vram_kib ? -1 : 0;
+}
+
+/* Up to max DRM clients, busiest first.  Returns how many were written. */
+int
+gpuclients_top(GpuClient *out, int max)
+{
+	GpuClient *all;
+	int n = 0;
+
+	pthread_mutex_lock(&gc_lock);
+	all = ecalloc((size_t)MAX(gc_count, 1), sizeof(*all));
+	for (int i = 0; i < gc_count; i++) {
+		const GcProc *p = &gc_procs[i];
+
+		if (!p->has_drm)
+			continue;
+		all[n].pid = p->pid;
+		memcpy(all[n].comm, p->comm, sizeof(all[n].comm));
+		all[n].busy = p->busy;
+		snprintf(all[n].engine, sizeof(all[n].engine), "%s", p->engine);
+		all[n].vram_kib = p->use.resident_kib ? p->use.resident_kib : p->use.memory_kib;
+		n++;
+	}
+	pthread_mutex_unlock(&gc_lock);
+
+	qsort(all, (size_t)n, sizeof(*all), gc_cmp_busy);
+	n = MIN(n, max);
+	memcpy(out, all, (size_t)n * sizeof(*out));
+	free(all);
+	return n;
+}
+
+/* pid's busiest-engine share from the last two passes, -1 unknown. */
+int
+gpuclients_busy(pid_t pid)
+{
+	int busy = -1;
+
+	pthread_mutex_lock(&gc_lock);
+	for (int i = 0; i < gc_count; i++)
+		if (gc_procs[i].pid == pid && gc_procs[i].has_drm) {
+			busy = gc_procs[i].busy;
+			break;
+		}
+	pthread_mutex_unlock(&gc_lock);
+	return busy;
+}
+
+void
+gpuclients_cleanup(void)
+{
+	pthread_mutex_lock(&gc_lock);
+	free(gc_procs);
+	gc_procs = NULL;
+	gc_count = 0;
+	pthread_mutex_unlock(&gc_lock);
+}
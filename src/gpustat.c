@@ -0,0 +1,440 @@
+/*
+ * gpustat.c — GPU telemetry from sysfs, sampled off the compositor thread.
+ *
+ * The diag heartbeat only knew NVIDIA (NVML or nvidia-smi).  amdgpu and
+ * i915/xe publish the same figures as sysfs files:
+ *
+ *  - amdgpu: gpu_busy_percent, mem_busy_percent, the current DPM level
+ *    (the "*" line of pp_dpm_sclk / pp_dpm_mclk) and the hwmon power and
+ *    edge temperature;
+ *  - i915: gt_act_freq_mhz and the RC6 residency counter;
+ *  - xe: tile0/gt0/freq0/act_freq and the gtidle residency counter.
+ *
+ * Intel has no busy figure in sysfs; the share of the interval the GT did
+ * not spend in RC6 is the same thing for our purposes.  Power comes from
+ * hwmon power1_average/power1_input, or from the energy counter's delta.
+ * An NVIDIA dGPU is sampled through NVML so every vendor feeds the same
+ * snapshot.
+ *
+ * A worker reads the files every gpu-stats-interval-ms while a game runs
+ * (every GS_IDLE_MS otherwise, enough for the diag heartbeat) and
+ * publishes one GpuStat; readers copy it and never touch sysfs.  A
+ * runtime-suspended dGPU is reported as such instead of read — several
+ * of these files resume the device.  The same worker runs the per-process
+ * DRM fdinfo passes (gpuclients.c) on their own schedule, every
+ * GS_CLIENTS_MS in game and GS_IDLE_MS otherwise; they keep running when
+ * sampling is off or finds nothing to read.
+ *
+ * Paths are relative to a sysfs root so gpustat_open() can be pointed at
+ * a fixture tree; NIXLY_GPUSTAT_ROOT does the same for a live session.
+ */
+#include "nixlytile.h"
+
+#define GS_IDLE_MS    10000
+#define GS_CLIENTS_MS 2000
+
+static struct {
+	GpuVendor vendor;
+	char pci_slot[16];
+	char busy[PATH_MAX], mem_busy[PATH_MAX];
+	char sclk[PATH_MAX], mclk[PATH_MAX];
+	char freq[PATH_MAX], idle[PATH_MAX];
+	char power[PATH_MAX], energy[PATH_MAX], temp[PATH_MAX];
+	char runtime[PATH_MAX];
+	/* previous counter readings for the delta-based figures */
+	uint64_t prev_ns, prev_idle_ms, prev_energy_uj;
+} gs;
+
+int gpustat_interval_ms = 500;
+
+static pthread_mutex_t gs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gs_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t gs_thread;
+static int gs_sampling, gs_running, gs_alive, gs_kicked, gs_have;
+static GpuStat gs_snap;
+
+static int
+gs_read(const char *path, char *buf, size_t len)
+{
+	ssize_t n;
+	int fd;
+
+	if (!path[0] || (fd = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, len - 1);
+	close(fd);
+	if (n < 0)
+		return -1;
+	buf[n] = '\0';
+	return 0;
+}
+
+static int
+gs_read_u64(const char *path, uint64_t *v)
+{
+	char buf[32];
+	char *end;
+
+	if (gs_read(path, buf, sizeof(buf)) < 0)
+		return -1;
+	*v = strtoull(buf, &end, 10);
+	return end == buf ? -1 : 0;
+}
+
+/* pp_dpm_* lists the levels as "1: 1800Mhz *"; the starred one is active. */
+static int
+gs_read_dpm(const char *path)
+{
+	char buf[1024];
+	char *line, *save = NULL;
+
+	if (gs_read(path, buf, sizeof(buf)) < 0)
+		return 0;
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		char *colon = strchr(line, ':');
+
+		if (colon && strchr(line, '*'))
+			return atoi(colon + 1);
+	}
+	return 0;
+}
+
+/* Keep out = dir/rel when that file is readable, else clear it. */
+static int
+gs_path(char *out, const char *dir, const char *rel)
+{
+	snprintf(out, PATH_MAX, "%s/%s", dir, rel);
+	if (access(out, R_OK) == 0)
+		return 1;
+	out[0] = '\0';
+	return 0;
+}
+
+static void
+gs_hwmon(const char *dev)
+{
+	char dir[PATH_MAX], hw[PATH_MAX];
+	struct dirent *de;
+	DIR *d;
+
+	snprintf(dir, sizeof(dir), "%s/hwmon", dev);
+	if (!(d = opendir(dir)))
+		return;
+	while ((de = readdir(d))) {
+		if (strncmp(de->d_name, "hwmon", 5) != 0)
+			continue;
+		snprintf(hw, sizeof(hw), "%s/%s", dir, de->d_name);
+		if (!gs_path(gs.power, hw, "power1_average"))
+			gs_path(gs.power, hw, "power1_input");
+		if (!gs.power[0])
+			gs_path(gs.energy, hw, "energy1_input");
+		if (!gs_path(gs.temp, hw, "temp1_input"))
+			gs_path(gs.temp, hw, "temp2_input");
+		break;
+	}
+	closedir(d);
+}
+
+/*
+ * Resolve the telemetry files of gpu under sysfs root (normally "/sys").
+ * Not thread-safe against the worker: call before gpustat_setup() starts
+ * it, or without it.  Returns 0 when anything can be sampled.
+ */
+int
+gpustat_open(const char *root, const GpuInfo *gpu)
+{
+	char card[PATH_MAX], dev[PATH_MAX];
+
+	memset(&gs, 0, sizeof(gs));
+	gs.vendor = gpu->vendor;
+	snprintf(gs.pci_slot, sizeof(gs.pci_slot), "%s", gpu->pci_slot);
+	if (gpu->vendor == GPU_VENDOR_NVIDIA)
+		return gs.pci_slot[0] ? 0 : -1;    /* NVML, opened on first sample */
+
+	snprintf(card, sizeof(card), "%s/class/drm/card%d", root, gpu->card_index);
+	snprintf(dev, sizeof(dev), "%s/device", card);
+	gs_path(gs.runtime, dev, "power/runtime_status");
+	gs_hwmon(dev);
+
+	switch (gpu->vendor) {
+	case GPU_VENDOR_AMD:
+		gs_path(gs.busy, dev, "gpu_busy_percent");
+		gs_path(gs.mem_busy, dev, "mem_busy_percent");
+		gs_path(gs.sclk, dev, "pp_dpm_sclk");
+		gs_path(gs.mclk, dev, "pp_dpm_mclk");
+		return gs.busy[0] || gs.sclk[0] ? 0 : -1;
+	case GPU_VENDOR_INTEL:
+		/* xe first: i915 never has the tile directory */
+		if (gs_path(gs.freq, dev, "tile0/gt0/freq0/act_freq"))
+			gs_path(gs.idle, dev, "tile0/gt0/gtidle/idle_residency_ms");
+		else if (gs_path(gs.freq, card, "gt/gt0/rps_act_freq_mhz")
+				|| gs_path(gs.freq, card, "gt_act_freq_mhz")) {
+			if (!gs_path(gs.idle, card, "gt/gt0/rc6_residency_ms"))
+				gs_path(gs.idle, card, "power/rc6_residency_ms");
+		}
+		return gs.freq[0] || gs.idle[0] ? 0 : -1;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Read the opened GPU once.  Delta figures (Intel busy, energy-based
+ * power) stay unknown on the first call.  The worker is normally the
+ * only caller; a fixture check may call it directly.
+ */
+int
+gpustat_sample(GpuStat *s)
+{
+	char buf[32];
+	uint64_t now = get_time_ns(), v;
+	uint64_t dt_ms = gs.prev_ns ? (now - gs.prev_ns) / 1000000 : 0;
+	NvmlTelemetry nt;
+
+	memset(s, 0, sizeof(*s));
+	s->vendor = gs.vendor;
+	s->busy = s->mem_busy = s->temp_c = -1;
+	s->ns = now;
+
+	if (gs.vendor == GPU_VENDOR_NVIDIA) {
+		if (nvml_open(gs.pci_slot) < 0 || nvml_telemetry(&nt) < 0)
+			return -1;
+		s->busy = (int)nt.gpu_util;
+		s->mem_busy = (int)nt.mem_util;
+		s->gfx_mhz = (int)nt.gfx_mhz;
+		s->mem_mhz = (int)nt.mem_mhz;
+		s->temp_c = (int)nt.temp_c;
+		s->power_mw = nt.power_mw;
+		return 0;
+	}
+
+	if (gs_read(gs.runtime, buf, sizeof(buf)) == 0 && !strncmp(buf, "suspended", 9)) {
+		s->suspended = 1;
+		s->busy = 0;
+		gs.prev_ns = 0;     /* counters may have moved; restart deltas */
+		return 0;
+	}
+
+	if (gs_read_u64(gs.busy, &v) == 0)
+		s->busy = (int)v;
+	if (gs_read_u64(gs.mem_busy, &v) == 0)
+		s->mem_busy = (int)v;
+	if (gs.sclk[0])
+		s->gfx_mhz = gs_read_dpm(gs.sclk);
+	else if (gs_read_u64(gs.freq, &v) == 0)
+		s->gfx_mhz = (int)v;
+	if (gs.mclk[0])
+		s->mem_mhz = gs_read_dpm(gs.mclk);
+	if (gs_read_u64(gs.temp, &v) == 0)
+		s->temp_c = (int)(v / 1000);
+	if (gs_read_u64(gs.power, &v) == 0)
+		s->power_mw = (unsigned)(v / 1000);
+
+	if (gs_read_u64(gs.idle, &v) == 0) {
+		if (dt_ms > 0 && v >= gs.prev_idle_ms) {
+			uint64_t idle = v - gs.prev_idle_ms;
+
+			s->busy = idle >= dt_ms ? 0 : (int)(100 - idle * 100 / dt_ms);
+		}
+		gs.prev_idle_ms = v;
+	}
+	if (gs_read_u64(gs.energy, &v) == 0) {
+		if (dt_ms > 0 && v >= gs.prev_energy_uj)
+			s->power_mw = (unsigned)((v - gs.prev_energy_uj) / dt_ms);
+		gs.prev_energy_uj = v;
+	}
+	gs.prev_ns = now;
+	return 0;
+}
+
+static int
+gs_effective_ms(void)
+{
+	if (gpustat_interval_ms <= 0)
+		return 0;
+	return game_mode_active || gpustat_interval_ms > GS_IDLE_MS
+		? gpustat_interval_ms : GS_IDLE_MS;
+}
+
+/* ms from now until `last + period_ms`, 0 when already due */
+static int
+gs_due_in(uint64_t now, uint64_t last, int period_ms)
+{
+	uint64_t at = last + (uint64_t)period_ms * 1000000;
+
+	return last && at > now ? (int)((at - now + 999999) / 1000000) : 0;
+}
+
+static void *
+gs_worker(void *arg)
+{
+	GpuStat s;
+	uint64_t now, sample_ns = 0, clients_ns = 0;
+	int ok, ms, clients_ms, wait_ms;
+
+	(void)arg;
+	pthread_setname_np(pthread_self(), "nixly-gpustat");
+	pthread_mutex_lock(&gs_lock);
+	while (gs_alive) {
+		struct timespec ts;
+
+		/* sysfs / NVML sampling, when there is something to sample */
+		ms = gs_sampling ? gs_effective_ms() : 0;
+		if (ms > 0 && (gs_kicked || !gs_due_in(get_time_ns(), sample_ns, ms))) {
+			pthread_mutex_unlock(&gs_lock);
+			ok = gpustat_sample(&s) == 0;
+			pthread_mutex_lock(&gs_lock);
+			sample_ns = get_time_ns();
+			if (ok) {
+				gs_snap = s;
+				gs_have = 1;
+			} else if (gs.vendor == GPU_VENDOR_NVIDIA) {
+				gs_sampling = 0;  /* no NVML: nothing to sample */
+			}
+		}
+		gs_kicked = 0;
+
+		/* DRM fdinfo passes keep their own schedule: they work from
+		 * /proc alone, whatever the sampler could open */
+		clients_ms = game_mode_active ? GS_CLIENTS_MS : GS_IDLE_MS;
+		if (!gs_due_in(get_time_ns(), clients_ns, clients_ms)) {
+			pthread_mutex_unlock(&gs_lock);
+			gpuclients_scan("/proc");
+			pthread_mutex_lock(&gs_lock);
+			clients_ns = get_time_ns();
+		}
+
+		now = get_time_ns();
+		ms = gs_sampling ? gs_effective_ms() : 0;
+		wait_ms = gs_due_in(now, clients_ns, clients_ms);
+		if (ms > 0)
+			wait_ms = MIN(wait_ms, gs_due_in(now, sample_ns, ms));
+		if (wait_ms <= 0)
+			continue;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += wait_ms / 1000;
+		ts.tv_nsec += (wait_ms % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+		while (!gs_kicked && gs_alive)
+			if (pthread_cond_timedwait(&gs_cond, &gs_lock, &ts) == ETIMEDOUT)
+				break;
+	}
+	pthread_mutex_unlock(&gs_lock);
+	return NULL;
+}
+
+static void
+gs_start(void)
+{
+	gs_alive = 1;
+	if (pthread_create(&gs_thread, NULL, gs_worker, NULL) != 0) {
+		gs_alive = 0;
+		return;
+	}
+	gs_running = 1;
+}
+
+/* The worker always runs: without sysfs telemetry (or with sampling
+ * switched off) it still drives the gpuclients passes. */
+void
+gpustat_setup(void)
+{
+	const char *root = getenv("NIXLY_GPUSTAT_ROOT");
+	int idx = discrete_gpu_idx >= 0 ? discrete_gpu_idx : integrated_gpu_idx;
+	int sampling = 0;
+
+	if (!root || !*root)
+		root = "/sys";
+	if (idx < 0 || gpustat_open(root, &detected_gpus[idx]) < 0) {
+		wlr_log(WLR_INFO, "gpustat: no sysfs telemetry for this GPU");
+	} else {
+		sampling = 1;
+		wlr_log(WLR_INFO, "gpustat: sampling %s card%d every %d ms in game",
+			detected_gpus[idx].driver, detected_gpus[idx].card_index,
+			gpustat_interval_ms);
+	}
+	pthread_mutex_lock(&gs_lock);
+	gs_sampling = sampling;
+	if (!gs_running)
+		gs_start();
+	pthread_mutex_unlock(&gs_lock);
+}
+
+void
+gpustat_cleanup(void)
+{
+	pthread_mutex_lock(&gs_lock);
+	if (!gs_running) {
+		pthread_mutex_unlock(&gs_lock);
+		return;
+	}
+	gs_alive = 0;
+	pthread_cond_signal(&gs_cond);
+	pthread_mutex_unlock(&gs_lock);
+	pthread_join(gs_thread, NULL);
+	gs_running = 0;
+	gs_have = 0;
+}
+
+/* Config `gpu-stats-interval-ms`; 0 stops sampling.  Takes effect at
+ * once, including on reload. */
+void
+gpustat_set_interval(int ms)
+{
+	pthread_mutex_lock(&gs_lock);
+	gpustat_interval_ms = ms > 0 ? ms : 0;
+	if (gs_running) {
+		gs_kicked = 1;
+		pthread_cond_signal(&gs_cond);
+	}
+	pthread_mutex_unlock(&gs_lock);
+}
+
+/* Game mode flipped: resample now and move to the matching rate. */
+void
+gpustat_kick(void)
+{
+	pthread_mutex_lock(&gs_lock);
+	if (gs_running) {
+		gs_kicked = 1;
+		pthread_cond_signal(&gs_cond);
+	}
+	pthread_mutex_unlock(&gs_lock);
+}
+
+/* Latest snapshot.  Returns -1 when there is none or it is older than
+ * three sampling periods (worker stopped, sampling disabled). */
+int
+gpustat_get(GpuStat *s)
+{
+	int ms, ret = -1;
+
+	pthread_mutex_lock(&gs_lock);
+	ms = gs_effective_ms();
+	if (gs_have && ms > 0 && get_time_ns() - gs_snap.ns <= (uint64_t)ms * 3000000) {
+		*s = gs_snap;
+		ret = 0;
+	}
+	pthread_mutex_unlock(&gs_lock);
+	return ret;
+}
+
+/*
+ * What a slow frame was waiting on, judged from GPU busy over the last
+ * sampling period: a saturated GPU means the frame could not be rendered
+ * faster; a mostly idle one means it was not submitted in time.
+ */
+const char *
+gpustat_bound(int busy)
+{
+	if (busy < 0)
+		return "unknown";
+	if (busy >= 90)
+		return "gpu";
+	if (busy < 70)
+		return "cpu";
+	return "mixed";
+}
@@ -0,0 +1,586 @@
+/*
+ * icon_cache.c — shared raster cache for the status bar's SVG icons.
+ *
+ * Every icon module used to keep its own wlr_buffer plus loaded-path /
+ * loaded-height bookkeeping and re-run librsvg + gdk-pixbuf on the
+ * compositor thread whenever its icon or the bar height changed (the
+ * battery/volume/net icons switch path all the time).  One cache now
+ * serves all modules and monitors, keyed by (resolved path, mtime, size,
+ * target height, recolour flags).
+ *
+ * Lookups that miss in memory try a persistent raster cache in
+ * $XDG_CACHE_HOME/nixlytile/icons: a small header plus premultiplied
+ * ARGB8888 ready to wrap in a buffer, so a cold start or theme switch
+ * costs one read per icon instead of an SVG parse and render.  A hit
+ * refreshes the file's mtime; once per run the worker drops files not
+ * used for a month, then the least recently used ones until the
+ * directory fits its size cap (keys change with every SVG edit and bar
+ * height, so otherwise the directory only grows).  SVGs
+ * missing there too are rasterized on a worker thread; the lookup
+ * returns NULL meanwhile (the module draws text only) and the icon
+ * modules are re-rendered once the pixels arrive.
+ *
+ * Returned buffers belong to the cache.  Scene buffers hold their own
+ * lock, so evicting an entry never pulls pixels from under a bar.
+ */
+#include "nixlytile.h"
+
+#include <sys/eventfd.h>
+
+#define ICON_CACHE_SIZE    64
+#define ICON_CACHE_MAGIC   0x4349584eu /* "NXIC" */
+#define ICON_CACHE_VERSION 1
+#define ICON_DISK_MAX_AGE_S (30 * 24 * 3600)
+#define ICON_DISK_MAX_BYTES (32ll << 20)
+/* a writer's temp file this old belongs to a process that died */
+#define ICON_DISK_TMP_AGE_S 3600
+
+typedef struct {
+	uint64_t key;              /* 0 = free slot */
+	struct wlr_buffer *buf;
+	int w, h;
+	int pending;               /* queued on the worker */
+	int failed;
+	uint64_t stamp;
+} IconCacheEntry;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	int32_t w, h;
+} IconCacheFileHeader;
+
+typedef struct IconJob {
+	struct IconJob *next;
+	uint64_t key;
+	int target_h;
+	uint32_t *pixels;          /* result */
+	int w, h;
+	char path[PATH_MAX];
+	char cache_file[PATH_MAX];
+} IconJob;
+
+static IconCacheEntry ic_entries[ICON_CACHE_SIZE];
+static uint64_t ic_clock;
+static char ic_dir[PATH_MAX];
+static int ic_dir_state;       /* 0 = unknown, 1 = usable, -1 = unusable */
+
+static pthread_t ic_thread;
+static int ic_thread_running;
+static int ic_thread_stop;
+static pthread_mutex_t ic_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ic_cond = PTHREAD_COND_INITIALIZER;
+static IconJob *ic_todo, *ic_done;
+static int ic_prune_pending, ic_prune_done;
+static int ic_wake_fd = -1;
+static struct wl_event_source *ic_wake_src;
+
+static uint64_t
+ic_fnv(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static uint64_t
+ic_key(const char *path, const struct stat *st, int target_h, int flags)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int version = ICON_CACHE_VERSION;
+
+	h = ic_fnv(h, path, strlen(path));
+	h = ic_fnv(h, &st->st_mtim, sizeof(st->st_mtim));
+	h = ic_fnv(h, &st->st_size, sizeof(st->st_size));
+	h = ic_fnv(h, &target_h, sizeof(target_h));
+	h = ic_fnv(h, &flags, sizeof(flags));
+	h = ic_fnv(h, &version, sizeof(version));
+	return h ? h : 1;
+}
+
+static int
+ic_cache_dir(void)
+{
+	const char *xdg, *home;
+	char base[PATH_MAX];
+
+	if (ic_dir_state)
+		return ic_dir_state > 0;
+
+	ic_dir_state = -1;
+	if ((xdg = getenv("XDG_CACHE_HOME")) && *xdg)
+		snprintf(base, sizeof(base), "%s", xdg);
+	else if ((home = getenv("HOME")) && *home)
+		snprintf(base, sizeof(base), "%s/.cache", home);
+	else
+		return 0;
+
+	mkdir(base, 0755);
+	snprintf(ic_dir, sizeof(ic_dir), "%s/nixlytile", base);
+	mkdir(ic_dir, 0755);
+	if (strlen(ic_dir) + sizeof("/icons") >= sizeof(ic_dir))
+		return 0;
+	strcat(ic_dir, "/icons");
+	if (mkdir(ic_dir, 0755) != 0 && errno != EEXIST)
+		return 0;
+	ic_dir_state = 1;
+	return 1;
+}
+
+static void
+ic_cache_file(uint64_t key, char *out, size_t len)
+{
+	out[0] = '\0';
+	if (ic_cache_dir())
+		snprintf(out, len, "%s/%016llx.argb", ic_dir, (unsigned long long)key);
+}
+
+static struct wlr_buffer *
+ic_load_file(const char *file, uint64_t key, int *w, int *h)
+{
+	IconCacheFileHeader hdr;
+	struct wlr_buffer *buf = NULL;
+	uint32_t *pixels;
+	size_t size;
+	int fd;
+
+	if (!file[0] || (fd = open(file, O_RDONLY | O_CLOEXEC)) < 0)
+		return NULL;
+	if (read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)
+			|| hdr.magic != ICON_CACHE_MAGIC
+			|| hdr.version != ICON_CACHE_VERSION || hdr.key != key
+			|| hdr.w <= 0 || hdr.h <= 0 || hdr.w > 4096 || hdr.h > 4096)
+		goto out;
+
+	size = (size_t)hdr.w * (size_t)hdr.h * 4;
+	pixels = malloc(size);
+	if (pixels && read(fd, pixels, size) == (ssize_t)size) {
+		buf = statusbar_buffer_from_argb32_raw(pixels, hdr.w, hdr.h);
+		*w = hdr.w;
+		*h = hdr.h;
+		/* mtime is the last use: ic_prune_disk() evicts by it */
+		futimens(fd, NULL);
+	}
+	free(pixels);
+out:
+	close(fd);
+	return buf;
+}
+
+/* Worker side: write-to-temp then rename, so a crash mid-write never
+ * leaves a truncated entry behind. */
+static void
+ic_store_file(const IconJob *job)
+{
+	IconCacheFileHeader hdr = {
+		.magic = ICON_CACHE_MAGIC,
+		.version = ICON_CACHE_VERSION,
+		.key = job->key,
+		.w = job->w,
+		.h = job->h,
+	};
+	char tmp[PATH_MAX + 16];
+	size_t size = (size_t)job->w * (size_t)job->h * 4;
+	int fd, ok;
+
+	if (!job->cache_file[0])
+		return;
+	snprintf(tmp, sizeof(tmp), "%s.%d", job->cache_file, (int)getpid());
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0)
+		return;
+	ok = write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr)
+		&& write(fd, job->pixels, size) == (ssize_t)size;
+	close(fd);
+	if (!ok || rename(tmp, job->cache_file) != 0)
+		unlink(tmp);
+}
+
+typedef struct {
+	char name[32];
+	time_t mtime;
+	off_t size;
+} IconDiskFile;
+
+static int
+ic_disk_file_cmp(const void *a, const void *b)
+{
+	const IconDiskFile *fa = a, *fb = b;
+
+	return (fa->mtime > fb->mtime) - (fa->mtime < fb->mtime);
+}
+
+/* Worker side: age out unused rasters, then evict least recently used
+ * ones until the directory is under ICON_DISK_MAX_BYTES. */
+static void
+ic_prune_disk(void)
+{
+	IconDiskFile *files = NULL;
+	size_t n = 0, cap = 0;
+	long long total = 0;
+	time_t now = time(NULL);
+	struct dirent *de;
+	DIR *dir;
+	int dfd;
+
+	if (!(dir = opendir(ic_dir)))
+		return;
+	dfd = dirfd(dir);
+	while ((de = readdir(dir))) {
+		const char *ext = strstr(de->d_name, ".argb");
+		struct stat st;
+
+		if (!ext || strlen(de->d_name) >= sizeof(files->name)
+				|| fstatat(dfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0
+				|| !S_ISREG(st.st_mode))
+			continue;
+		if (ext[5]) {
+			/* "<key>.argb.<pid>" from ic_store_file() */
+			if (now - st.st_mtime > ICON_DISK_TMP_AGE_S)
+				unlinkat(dfd, de->d_name, 0);
+			continue;
+		}
+		if (now - st.st_mtime > ICON_DISK_MAX_AGE_S) {
+			unlinkat(dfd, de->d_name, 0);
+			continue;
+		}
+		if (n == cap) {
+			IconDiskFile *grown;
+
+			cap = cap ? cap * 2 : 256;
+			if (!(grown = realloc(files, cap * sizeof(*files))))
+				break;
+			files = grown;
+		}
+		snprintf(files[n].name, sizeof(files[n].name), "%s", de->d_name);
+		files[n].mtime = st.st_mtime;
+		files[n].size = st.st_size;
+		total += st.st_size;
+		n++;
+	}
+
+	if (total > ICON_DISK_MAX_BYTES) {
+		qsort(files, n, sizeof(*files), ic_disk_file_cmp);
+		for (size_t i = 0; i < n && total > ICON_DISK_MAX_BYTES; i++)
+			if (unlinkat(dfd, files[i].name, 0) == 0)
+				total -= files[i].size;
+	}
+	free(files);
+	closedir(dir);
+}
+
+static void *
+ic_worker(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&ic_lock);
+	for (;;) {
+		IconJob *job;
+		GdkPixbuf *pixbuf = NULL;
+		uint64_t one = 1;
+
+		while (!ic_todo && !ic_prune_pending && !ic_thread_stop)
+			pthread_cond_wait(&ic_cond, &ic_lock);
+		if (ic_thread_stop)
+			break;
+		if (!ic_todo) {
+			/* icons the bar is waiting for go first */
+			ic_prune_pending = 0;
+			pthread_mutex_unlock(&ic_lock);
+			ic_prune_disk();
+			pthread_mutex_lock(&ic_lock);
+			continue;
+		}
+		job = ic_todo;
+		ic_todo = job->next;
+		pthread_mutex_unlock(&ic_lock);
+
+		if (tray_load_svg_pixbuf(job->path, job->target_h, &pixbuf) != 0)
+			pixbuf = gdk_pixbuf_new_from_file(job->path, NULL);
+		if (pixbuf)
+			job->pixels = statusbar_argb32_from_pixbuf(pixbuf,
+					job->target_h, &job->w, &job->h);
+		if (job->pixels)
+			ic_store_file(job);
+
+		pthread_mutex_lock(&ic_lock);
+		job->next = ic_done;
+		ic_done = job;
+		if (write(ic_wake_fd, &one, sizeof(one)) < 0) {
+			/* counter saturated: the main loop is already woken */
+		}
+	}
+	pthread_mutex_unlock(&ic_lock);
+	return NULL;
+}
+
+static IconCacheEntry *
+ic_find(uint64_t key)
+{
+	for (int i = 0; i < ICON_CACHE_SIZE; i++)
+		if (ic_entries[i].key == key)
+			return &ic_entries[i];
+	return NULL;
+}
+
+static int
+ic_wake_cb(int fd, uint32_t mask, void *data)
+{
+	IconJob *done, *next;
+	uint64_t count;
+	int any = 0;
+
+	(void)mask;
+	(void)data;
+
+	if (read(fd, &count, sizeof(count)) < 0) {
+		/* spurious wakeup; drain whatever is queued anyway */
+	}
+
+	pthread_mutex_lock(&ic_lock);
+	done = ic_done;
+	ic_done = NULL;
+	pthread_mutex_unlock(&ic_lock);
+
+	for (; done; done = next) {
+		IconCacheEntry *e = ic_find(done->key);
+
+		next = done->next;
+		if (e && e->pending) {
+			e->pending = 0;
+			if (done->pixels)
+				e->buf = statusbar_buffer_from_argb32_raw(done->pixels,
+						done->w, done->h);
+			if (e->buf) {
+				e->w = done->w;
+				e->h = done->h;
+				any = 1;
+			} else {
+				e->failed = 1;
+				wlr_log(WLR_ERROR, "icon cache: failed to load '%s'",
+						done->path);
+			}
+		}
+		free(done->pixels);
+		free(done);
+	}
+
+	if (any)
+		statusbar_rerender_icon_modules();
+	return 0;
+}
+
+static int
+ic_start_worker(void)
+{
+	if (ic_thread_running)
+		return 0;
+	if (ic_wake_fd < 0) {
+		ic_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (ic_wake_fd < 0)
+			return -1;
+	}
+	if (!ic_wake_src)
+		ic_wake_src = wl_event_loop_add_fd(event_loop, ic_wake_fd,
+				WL_EVENT_READABLE, ic_wake_cb, NULL);
+	if (!ic_wake_src)
+		return -1;
+	ic_thread_stop = 0;
+	if (pthread_create(&ic_thread, NULL, ic_worker, NULL) != 0)
+		return -1;
+	ic_thread_running = 1;
+	return 0;
+}
+
+/* Once per run, as soon as the cache directory is known. */
+static void
+ic_schedule_prune(void)
+{
+	if (ic_prune_done || ic_dir_state <= 0 || ic_start_worker() != 0)
+		return;
+	ic_prune_done = 1;
+	pthread_mutex_lock(&ic_lock);
+	ic_prune_pending = 1;
+	pthread_cond_signal(&ic_cond);
+	pthread_mutex_unlock(&ic_lock);
+}
+
+static IconCacheEntry *
+ic_slot(uint64_t key)
+{
+	IconCacheEntry *victim = NULL;
+
+	for (int i = 0; i < ICON_CACHE_SIZE; i++) {
+		IconCacheEntry *e = &ic_entries[i];
+		if (!e->key) {
+			victim = e;
+			break;
+		}
+		if (e->pending)
+			continue;
+		if (!victim || e->stamp < victim->stamp)
+			victim = e;
+	}
+	if (!victim)
+		return NULL;
+	if (victim->buf)
+		wlr_buffer_drop(victim->buf);
+	memset(victim, 0, sizeof(*victim));
+	victim->key = key;
+	return victim;
+}
+
+static int
+ic_is_svg(const char *path)
+{
+	size_t len = strlen(path);
+
+	return (len > 4 && !strcasecmp(path + len - 4, ".svg"))
+		|| (len > 5 && !strcasecmp(path + len - 5, ".svgz"));
+}
+
+/* Look up (or start producing) the icon at `path` scaled to `target_h`.
+ * Returns a cache-owned buffer, or NULL while an SVG is still being
+ * rasterized or when the icon can't be loaded. */
+struct wlr_buffer *
+icon_cache_get(const char *path, int target_h, int flags, int *w, int *h)
+{
+	char resolved[PATH_MAX];
+	char file[PATH_MAX];
+	struct stat st;
+	IconCacheEntry *e;
+	uint64_t key;
+
+	if (!path || !*path || target_h <= 0)
+		return NULL;
+	if (resolve_asset_path(path, resolved, sizeof(resolved)) != 0
+			|| stat(resolved, &st) != 0)
+		return NULL;
+
+	key = ic_key(resolved, &st, target_h, flags);
+	if ((e = ic_find(key))) {
+		e->stamp = ++ic_clock;
+		if (!e->buf)
+			return NULL;
+		*w = e->w;
+		*h = e->h;
+		return e->buf;
+	}
+
+	if (!(e = ic_slot(key)))
+		return NULL;
+	e->stamp = ++ic_clock;
+
+	if (flags & ICON_CACHE_WIFI100) {
+		/* Themes tint this asset; the bars are synthesized, no SVG. */
+		e->buf = statusbar_buffer_from_wifi100(target_h, &e->w, &e->h);
+		goto done;
+	}
+
+	ic_cache_file(key, file, sizeof(file));
+	ic_schedule_prune();
+	if ((e->buf = ic_load_file(file, key, &e->w, &e->h)))
+		goto done;
+
+	if (ic_is_svg(resolved) && ic_start_worker() == 0) {
+		IconJob *job = ecalloc(1, sizeof(*job));
+
+		job->key = key;
+		job->target_h = target_h;
+		snprintf(job->path, sizeof(job->path), "%s", resolved);
+		snprintf(job->cache_file, sizeof(job->cache_file), "%s", file);
+		e->pending = 1;
+
+		pthread_mutex_lock(&ic_lock);
+		job->next = ic_todo;
+		ic_todo = job;
+		pthread_cond_signal(&ic_cond);
+		pthread_mutex_unlock(&ic_lock);
+		return NULL;
+	}
+
+	/* Raster formats decode quickly enough to stay inline (and so do
+	 * SVGs if the worker could not be started). */
+	{
+		GError *gerr = NULL;
+		GdkPixbuf *pixbuf = NULL;
+
+		if (!ic_is_svg(resolved)
+				|| tray_load_svg_pixbuf(resolved, target_h, &pixbuf) != 0)
+			pixbuf = gdk_pixbuf_new_from_file(resolved, &gerr);
+		if (pixbuf) {
+			e->buf = statusbar_buffer_from_pixbuf(pixbuf, target_h,
+					&e->w, &e->h);
+		} else if (gerr) {
+			wlr_log(WLR_ERROR, "icon cache: failed to load '%s': %s",
+					resolved, gerr->message);
+			g_error_free(gerr);
+		}
+	}
+
+done:
+	if (!e->buf) {
+		e->failed = 1;
+		return NULL;
+	}
+	*w = e->w;
+	*h = e->h;
+	return e->buf;
+}
+
+/* Forget every in-memory raster (theme switch, config reload).  The
+ * on-disk cache stays: its keys already include the file's mtime. */
+void
+icon_cache_flush(void)
+{
+	for (int i = 0; i < ICON_CACHE_SIZE; i++) {
+		IconCacheEntry *e = &ic_entries[i];
+		if (e->pending)
+			continue;
+		if (e->buf)
+			wlr_buffer_drop(e->buf);
+		memset(e, 0, sizeof(*e));
+	}
+}
+
+void
+icon_cache_cleanup(void)
+{
+	IconJob *job, *next;
+
+	if (ic_thread_running) {
+		pthread_mutex_lock(&ic_lock);
+		ic_thread_stop = 1;
+		pthread_cond_signal(&ic_cond);
+		pthread_mutex_unlock(&ic_lock);
+		pthread_join(ic_thread, NULL);
+		ic_thread_running = 0;
+	}
+	for (job = ic_todo; job; job = next) {
+		next = job->next;
+		free(job);
+	}
+	for (job = ic_done; job; job = next) {
+		next = job->next;
+		free(job->pixels);
+		free(job);
+	}
+	ic_todo = ic_done = NULL;
+	ic_prune_pending = 0;
+
+	if (ic_wake_src)
+		wl_event_source_remove(ic_wake_src);
+	ic_wake_src = NULL;
+	if (ic_wake_fd >= 0)
+		close(ic_wake_fd);
+	ic_wake_fd = -1;
+
+	for (int i = 0; i < ICON_CACHE_SIZE; i++)
+		ic_entries[i].pending = 0;
+	icon_cache_flush();
+}
@@ -0,0 +1,1158 @@
+/*
+ * icon_theme.c — persistent name → file index over the XDG icon themes.
+ *
+ * tray_find_icon_path used to answer every IconName by stat()ing
+ * size × category × candidate × extension paths in each theme of each
+ * icon root (a few thousand syscalls per miss, and a 1 MB static table
+ * of root paths).  The themes are now walked once: index.theme supplies
+ * Size/Scale/Type per directory (directory names are parsed when it is
+ * missing or silent), and every image file becomes an entry
+ * {theme priority, directory, nominal size, scalable, extension} filed
+ * under its stem.  A lookup is one hash probe plus a scan of that
+ * name's entries.
+ *
+ * The index is a single position-independent blob written to
+ * $XDG_CACHE_HOME/nixlytile/icon-theme.idx and mmap'd on the next start.
+ * It records every directory it walked with that directory's mtime, so a
+ * stale file is detected with one stat per directory instead of a walk.
+ * While running, inotify watches on the same directories mark the index
+ * stale; it is rebuilt after a settle delay and the tray icons reload
+ * against the new one.
+ *
+ * Loading, validating, walking and watching all happen on a worker
+ * thread, which hands the finished index back over an eventfd; the
+ * compositor thread only swaps it in.  Until then lookups keep using the
+ * old index (or miss, on the very first load).
+ */
+#include "nixlytile.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#define ICON_THEME_MAGIC     0x5449584eu /* "NXIT" */
+#define ICON_THEME_VERSION   1
+#define ICON_THEME_SETTLE_MS 1000
+#define ICON_THEME_MAX_WATCH 4096
+#define ICON_THEME_NONE      UINT32_MAX
+
+enum { IT_SCALABLE = 1 << 0 };
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t roots_sig;        /* root list + preferred themes */
+	uint32_t n_dirs;
+	uint32_t n_names;
+	uint32_t n_entries;
+	uint32_t n_buckets;        /* power of two */
+	uint32_t strings_size;
+	uint32_t pad;
+} IconThemeHeader;
+
+typedef struct {
+	uint32_t path;             /* string offset */
+	uint32_t prio;             /* lower wins; one step per theme/root */
+	uint32_t depth;            /* 0 = root, 1 = theme, 2-3 = size dirs */
+	uint32_t pad;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+} IconThemeDir;
+
+typedef struct {
+	uint32_t str;              /* string offset of the stem */
+	uint32_t next;             /* bucket chain */
+	uint32_t first;            /* entries[first .. first + count) */
+	uint32_t count;
+} IconThemeName;
+
+typedef struct {
+	uint32_t dir;
+	int16_t size;              /* nominal px, 0 = unsized */
+	uint8_t flags;
+	uint8_t ext;               /* index into it_exts; lower preferred */
+} IconThemeEntry;
+
+typedef struct {
+	char rel[96];
+	int size;
+	int scale;
+	int scalable;
+} IconThemeSection;
+
+typedef struct {
+	char *str;
+	size_t str_len, str_cap;
+	IconThemeDir *dirs;
+	size_t n_dirs, dirs_cap;
+	IconThemeName *names;
+	uint32_t *last;            /* per name: tail of its raw entry list */
+	size_t n_names, names_cap;
+	uint32_t *buckets;
+	uint32_t n_buckets;
+	struct { IconThemeEntry e; uint32_t next; } *raw;
+	size_t n_raw, raw_cap;
+	struct { dev_t dev; ino_t ino; } *seen;
+	size_t n_seen, seen_cap;
+	uint32_t prio;
+	IconThemeSection *sections;
+	size_t n_sections, sections_cap;
+} IconThemeBuild;
+
+static const char *it_exts[] = { "png", "svg", "xpm", "jpg", "jpeg" };
+
+/* A loaded index: the blob and the tables inside it. */
+typedef struct {
+	uint8_t *blob;
+	size_t size;
+	int mapped;
+	const IconThemeHeader *hdr;
+	const IconThemeDir *dirs;
+	const uint32_t *buckets;
+	const IconThemeName *names;
+	const IconThemeEntry *entries;
+	const char *strings;
+} IconThemeIndex;
+
+static IconThemeIndex it_idx;  /* the one lookups use */
+static int it_state;           /* 0 = not loaded, 1 = ready, -1 = stale */
+static int it_pending;         /* a load has been asked of the worker */
+
+static int it_inotify_fd = -1;
+static struct wl_event_source *it_inotify_src;
+static struct wl_event_source *it_settle_timer;
+
+static pthread_t it_thread;
+static int it_thread_running;
+static int it_thread_stop;
+static pthread_mutex_t it_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t it_cond = PTHREAD_COND_INITIALIZER;
+static int it_want;            /* worker: load again */
+static int it_busy;            /* worker: loading */
+static int it_have_done;
+static IconThemeIndex it_done; /* finished index, not yet swapped in */
+static int it_done_watch = -1; /* its inotify fd */
+static int it_wake_fd = -1;
+static struct wl_event_source *it_wake_src;
+
+static uint32_t
+it_hash(const char *s)
+{
+	uint32_t h = 2166136261u;
+
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static uint64_t
+it_hash64(uint64_t h, const char *s)
+{
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 0x100000001b3ULL;
+	}
+	h ^= 0xff;
+	return h * 0x100000001b3ULL;
+}
+
+static void *
+it_reserve(void *p, size_t *cap, size_t need, size_t elem)
+{
+	size_t ncap = *cap ? *cap : 64;
+
+	if (need <= *cap)
+		return p;
+	while (ncap < need)
+		ncap *= 2;
+	if (!(p = realloc(p, ncap * elem)))
+		die("icon_theme: out of memory");
+	*cap = ncap;
+	return p;
+}
+
+/* ── building ─────────────────────────────────────────────────────── */
+
+static uint32_t
+it_add_string(IconThemeBuild *b, const char *s)
+{
+	size_t len = strlen(s) + 1;
+	uint32_t off = (uint32_t)b->str_len;
+
+	b->str = it_reserve(b->str, &b->str_cap, b->str_len + len, 1);
+	memcpy(b->str + b->str_len, s, len);
+	b->str_len += len;
+	return off;
+}
+
+static void
+it_rehash(IconThemeBuild *b, uint32_t n_buckets)
+{
+	free(b->buckets);
+	b->buckets = ecalloc(n_buckets, sizeof(*b->buckets));
+	memset(b->buckets, 0xff, n_buckets * sizeof(*b->buckets));
+	b->n_buckets = n_buckets;
+	for (size_t i = 0; i < b->n_names; i++) {
+		uint32_t h = it_hash(b->str + b->names[i].str) & (n_buckets - 1);
+		b->names[i].next = b->buckets[h];
+		b->buckets[h] = (uint32_t)i;
+	}
+}
+
+static uint32_t
+it_intern_name(IconThemeBuild *b, const char *name)
+{
+	uint32_t h = it_hash(name) & (b->n_buckets - 1);
+	IconThemeName *n;
+
+	for (uint32_t i = b->buckets[h]; i != ICON_THEME_NONE; i = b->names[i].next)
+		if (strcmp(b->str + b->names[i].str, name) == 0)
+			return i;
+
+	b->names = it_reserve(b->names, &b->names_cap, b->n_names + 1, sizeof(*b->names));
+	b->last = realloc(b->last, b->names_cap * sizeof(*b->last));
+	if (!b->last)
+		die("icon_theme: out of memory");
+	n = &b->names[b->n_names];
+	n->str = it_add_string(b, name);
+	n->first = n->count = 0;
+	n->next = b->buckets[h];
+	b->buckets[h] = (uint32_t)b->n_names;
+	b->last[b->n_names] = ICON_THEME_NONE;
+	if (++b->n_names > b->n_buckets / 2)
+		it_rehash(b, b->n_buckets * 2);
+	return (uint32_t)(b->n_names - 1);
+}
+
+/* Files an icon under its stem; returns 0 for names without an image
+ * extension. */
+static int
+it_add_entry(IconThemeBuild *b, const char *file, uint32_t dir, int size, int scalable)
+{
+	char stem[128];
+	const char *dot = strrchr(file, '.');
+	size_t stemlen;
+	uint32_t name, idx;
+	size_t e;
+
+	if (!dot || dot == file)
+		return 0;
+	for (e = 0; e < LENGTH(it_exts); e++)
+		if (strcmp(dot + 1, it_exts[e]) == 0)
+			break;
+	if (e == LENGTH(it_exts))
+		return 0;
+	stemlen = (size_t)(dot - file);
+	if (stemlen >= sizeof(stem))
+		return 1;
+	memcpy(stem, file, stemlen);
+	stem[stemlen] = '\0';
+
+	name = it_intern_name(b, stem);
+	b->raw = it_reserve(b->raw, &b->raw_cap, b->n_raw + 1, sizeof(*b->raw));
+	idx = (uint32_t)b->n_raw++;
+	b->raw[idx].e.dir = dir;
+	b->raw[idx].e.size = (int16_t)MIN(size, INT16_MAX);
+	b->raw[idx].e.flags = scalable ? IT_SCALABLE : 0;
+	b->raw[idx].e.ext = (uint8_t)e;
+	b->raw[idx].next = ICON_THEME_NONE;
+	if (b->last[name] == ICON_THEME_NONE)
+		b->names[name].first = idx;
+	else
+		b->raw[b->last[name]].next = idx;
+	b->last[name] = idx;
+	b->names[name].count++;
+	return 1;
+}
+
+static uint32_t
+it_add_dir(IconThemeBuild *b, const char *path, uint32_t depth, const struct stat *st)
+{
+	IconThemeDir *d;
+
+	b->dirs = it_reserve(b->dirs, &b->dirs_cap, b->n_dirs + 1, sizeof(*b->dirs));
+	d = &b->dirs[b->n_dirs];
+	memset(d, 0, sizeof(*d));
+	d->path = it_add_string(b, path);
+	d->prio = b->prio;
+	d->depth = depth;
+	d->mtime_sec = st->st_mtim.tv_sec;
+	d->mtime_nsec = st->st_mtim.tv_nsec;
+	return (uint32_t)b->n_dirs++;
+}
+
+/* Themes are reachable through several roots at once (XDG_DATA_DIRS and
+ * the NixOS system profile usually point at the same store path); index
+ * each physical directory once. */
+static int
+it_seen(IconThemeBuild *b, const struct stat *st)
+{
+	for (size_t i = 0; i < b->n_seen; i++)
+		if (b->seen[i].dev == st->st_dev && b->seen[i].ino == st->st_ino)
+			return 1;
+	b->seen = it_reserve(b->seen, &b->seen_cap, b->n_seen + 1, sizeof(*b->seen));
+	b->seen[b->n_seen].dev = st->st_dev;
+	b->seen[b->n_seen].ino = st->st_ino;
+	b->n_seen++;
+	return 0;
+}
+
+static int
+it_entry_is_dir(const char *parent, const struct dirent *ent)
+{
+	char path[PATH_MAX];
+
+	if (ent->d_type == DT_DIR)
+		return 1;
+	if (ent->d_type != DT_LNK && ent->d_type != DT_UNKNOWN)
+		return 0;
+	snprintf(path, sizeof(path), "%s/%s", parent, ent->d_name);
+	return pathisdir(path);
+}
+
+static void
+it_parse_index_theme(IconThemeBuild *b, const char *theme_dir)
+{
+	char path[PATH_MAX], line[512];
+	IconThemeSection *cur = NULL;
+	FILE *f;
+
+	b->n_sections = 0;
+	snprintf(path, sizeof(path), "%s/index.theme", theme_dir);
+	if (!(f = fopen(path, "re")))
+		return;
+	while (fgets(line, sizeof(line), f)) {
+		char *end = line + strcspn(line, "\r\n");
+
+		*end = '\0';
+		if (line[0] == '[') {
+			char *close = strchr(line, ']');
+			cur = NULL;
+			if (!close || strcmp(line, "[Icon Theme]") == 0
+					|| (size_t)(close - line - 1) >= sizeof(cur->rel))
+				continue;
+			b->sections = it_reserve(b->sections, &b->sections_cap,
+					b->n_sections + 1, sizeof(*b->sections));
+			cur = &b->sections[b->n_sections++];
+			memset(cur, 0, sizeof(*cur));
+			snprintf(cur->rel, sizeof(cur->rel), "%.*s",
+					(int)(close - line - 1), line + 1);
+		} else if (!cur) {
+			continue;
+		} else if (strncmp(line, "Size=", 5) == 0) {
+			cur->size = atoi(line + 5);
+		} else if (strncmp(line, "Scale=", 6) == 0) {
+			cur->scale = atoi(line + 6);
+		} else if (strncmp(line, "Type=", 5) == 0) {
+			cur->scalable = strcmp(line + 5, "Scalable") == 0;
+		}
+	}
+	fclose(f);
+}
+
+/* Nominal size for a directory below a theme: index.theme first, then
+ * the "48x48" / "48x48@2" / "scalable" naming every theme follows, in
+ * either component ("48x48/apps" or "apps/48"). */
+static int
+it_dir_size(IconThemeBuild *b, const char *rel, int *scalable)
+{
+	char comp[96];
+	const char *p = rel;
+	int a, c, scale;
+
+	*scalable = 0;
+	if (!rel[0])
+		return 0;
+	for (size_t i = 0; i < b->n_sections; i++) {
+		if (strcmp(b->sections[i].rel, rel) == 0) {
+			*scalable = b->sections[i].scalable;
+			return b->sections[i].size * MAX(b->sections[i].scale, 1);
+		}
+	}
+	while (*p) {
+		size_t len = strcspn(p, "/");
+		snprintf(comp, sizeof(comp), "%.*s", (int)MIN(len, sizeof(comp) - 1), p);
+		if (strcmp(comp, "scalable") == 0 || strcmp(comp, "symbolic") == 0) {
+			*scalable = 1;
+			return 0;
+		}
+		scale = 1;
+		if (sscanf(comp, "%dx%d@%d", &a, &c, &scale) >= 2 && a > 0 && a == c)
+			return a * MAX(scale, 1);
+		if (sscanf(comp, "%d", &a) == 1 && a > 0 && strspn(comp, "0123456789") == len)
+			return a;
+		p += len;
+		if (*p)
+			p++;
+	}
+	return 0;
+}
+
+static void
+it_walk_dir(IconThemeBuild *b, const char *path, const char *rel, uint32_t depth)
+{
+	struct stat st;
+	struct dirent *ent;
+	uint32_t dir;
+	int size, scalable;
+	DIR *d;
+
+	if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode) || !(d = opendir(path)))
+		return;
+	dir = it_add_dir(b, path, depth, &st);
+	size = it_dir_size(b, rel, &scalable);
+	while ((ent = readdir(d))) {
+		char sub[PATH_MAX], subrel[PATH_MAX];
+
+		if (ent->d_name[0] == '.')
+			continue;
+		/* Names with an image extension are files; statting every
+		 * (mostly symlinked) icon would cost what the index saves. */
+		if (ent->d_type != DT_DIR && it_add_entry(b, ent->d_name, dir, size, scalable))
+			continue;
+		if (depth >= 3 || !it_entry_is_dir(path, ent))
+			continue;
+		snprintf(sub, sizeof(sub), "%s/%s", path, ent->d_name);
+		snprintf(subrel, sizeof(subrel), "%s%s%s", rel, rel[0] ? "/" : "", ent->d_name);
+		it_walk_dir(b, sub, subrel, depth + 1);
+	}
+	closedir(d);
+}
+
+static void
+it_walk_theme(IconThemeBuild *b, const char *theme_dir)
+{
+	struct stat st;
+
+	if (stat(theme_dir, &st) != 0 || !S_ISDIR(st.st_mode) || it_seen(b, &st))
+		return;
+	it_parse_index_theme(b, theme_dir);
+	it_walk_dir(b, theme_dir, "", 1);
+	b->prio++;
+}
+
+/* Same search order tray_find_icon_path always had: preferred themes of a
+ * root first, then its other themes, then loose files in the root. */
+static void
+it_walk_root(IconThemeBuild *b, const char *root, const char *themes[], size_t n_themes)
+{
+	struct dirent *ent;
+	struct stat st;
+	uint32_t dir;
+	DIR *d;
+
+	if (stat(root, &st) != 0 || !S_ISDIR(st.st_mode) || it_seen(b, &st))
+		return;
+	for (size_t i = 0; i < n_themes; i++) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s", root, themes[i]);
+		it_walk_theme(b, path);
+	}
+	if (!(d = opendir(root)))
+		return;
+	while ((ent = readdir(d))) {
+		char path[PATH_MAX];
+		if (ent->d_name[0] == '.' || !it_entry_is_dir(root, ent))
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", root, ent->d_name);
+		it_walk_theme(b, path);
+	}
+	rewinddir(d);
+	dir = it_add_dir(b, root, 0, &st);
+	while ((ent = readdir(d)))
+		if (ent->d_name[0] != '.')
+			it_add_entry(b, ent->d_name, dir, 0, 0);
+	closedir(d);
+	b->prio++;
+}
+
+static size_t
+it_themes(char *buf, size_t buflen, const char *themes[], size_t max)
+{
+	const char *default_themes[] = {
+		"Papirus", "Papirus-Dark", "Papirus-Light", "Adwaita", "hicolor"
+	};
+	const char *env = getenv("STATUSBAR_ICON_THEMES");
+	size_t n = 0;
+
+	if (env && *env) {
+		snprintf(buf, buflen, "%s", env);
+		for (char *tok = buf; tok && *tok && n < max; ) {
+			char *sep = strchr(tok, ':');
+			if (sep)
+				*sep = '\0';
+			if (*tok)
+				themes[n++] = tok;
+			if (!sep)
+				break;
+			tok = sep + 1;
+		}
+	}
+	for (size_t i = 0; n == 0 && i < LENGTH(default_themes); i++)
+		themes[i] = default_themes[i];
+	return n ? n : LENGTH(default_themes);
+}
+
+/* Calls fn for every icon root in search order. */
+static void
+it_for_each_root(void (*fn)(const char *root, void *data), void *data)
+{
+	const char *xdg_home = getenv("XDG_DATA_HOME");
+	const char *home = getenv("HOME");
+	const char *dirs = getenv("XDG_DATA_DIRS");
+	const char *profiles = getenv("NIX_PROFILES");
+	char path[PATH_MAX];
+
+	if (xdg_home && *xdg_home) {
+		snprintf(path, sizeof(path), "%s/icons", xdg_home);
+		fn(path, data);
+	} else if (home && *home) {
+		snprintf(path, sizeof(path), "%s/.local/share/icons", home);
+		fn(path, data);
+	}
+	if (home && *home) {
+		snprintf(path, sizeof(path), "%s/.icons", home);
+		fn(path, data);
+	}
+
+	if (!dirs || !*dirs)
+		dirs = "/usr/local/share:/usr/share";
+	while (*dirs) {
+		const char *end = strchrnul(dirs, ':');
+		if (end > dirs) {
+			snprintf(path, sizeof(path), "%.*s/icons", (int)(end - dirs), dirs);
+			fn(path, data);
+		}
+		if (!*end)
+			break;
+		dirs = end + 1;
+	}
+
+	while (profiles && *profiles) {
+		const char *end = strchrnul(profiles, ' ');
+		if (end > profiles) {
+			snprintf(path, sizeof(path), "%.*s/share/icons", (int)(end - profiles), profiles);
+			fn(path, data);
+			snprintf(path, sizeof(path), "%.*s/share/pixmaps", (int)(end - profiles), profiles);
+			fn(path, data);
+		}
+		if (!*end)
+			break;
+		profiles = end + 1;
+	}
+
+	fn("/run/current-system/sw/share/icons", data);
+	fn("/run/current-system/sw/share/pixmaps", data);
+	fn("/usr/share/pixmaps", data);
+}
+
+typedef struct {
+	IconThemeBuild *b;
+	const char **themes;
+	size_t n_themes;
+	uint64_t sig;
+} IconThemeRootCtx;
+
+static void
+it_root_sig_cb(const char *root, void *data)
+{
+	IconThemeRootCtx *ctx = data;
+
+	if (pathisdir(root))
+		ctx->sig = it_hash64(ctx->sig, root);
+}
+
+static void
+it_root_walk_cb(const char *root, void *data)
+{
+	IconThemeRootCtx *ctx = data;
+
+	it_walk_root(ctx->b, root, ctx->themes, ctx->n_themes);
+}
+
+static uint64_t
+it_roots_sig(void)
+{
+	const char *themes[16];
+	char buf[256];
+	IconThemeRootCtx ctx = { .sig = 0xcbf29ce484222325ULL };
+	size_t n = it_themes(buf, sizeof(buf), themes, LENGTH(themes));
+
+	for (size_t i = 0; i < n; i++)
+		ctx.sig = it_hash64(ctx.sig, themes[i]);
+	it_for_each_root(it_root_sig_cb, &ctx);
+	return ctx.sig;
+}
+
+/* ── the blob ─────────────────────────────────────────────────────── */
+
+static void
+it_index_free(IconThemeIndex *ix)
+{
+	if (ix->blob && ix->mapped)
+		munmap(ix->blob, ix->size);
+	else
+		free(ix->blob);
+	memset(ix, 0, sizeof(*ix));
+}
+
+/* Bounds-check the whole blob once so lookups can trust every offset. */
+static int
+it_attach(IconThemeIndex *ix)
+{
+	const IconThemeHeader *h = (const IconThemeHeader *)ix->blob;
+	uint8_t *blob = ix->blob;
+	size_t size = ix->size, off, need;
+	const IconThemeDir *dirs;
+	const uint32_t *buckets;
+	const IconThemeName *names;
+	const IconThemeEntry *entries;
+	const char *strings;
+
+	if (size < sizeof(*h) || h->magic != ICON_THEME_MAGIC
+			|| h->version != ICON_THEME_VERSION
+			|| h->n_buckets == 0 || (h->n_buckets & (h->n_buckets - 1))
+			|| h->strings_size == 0)
+		return -1;
+	need = sizeof(*h) + (size_t)h->n_dirs * sizeof(IconThemeDir)
+		+ (size_t)h->n_buckets * sizeof(uint32_t)
+		+ (size_t)h->n_names * sizeof(IconThemeName)
+		+ (size_t)h->n_entries * sizeof(IconThemeEntry)
+		+ h->strings_size;
+	if (need != size)
+		return -1;
+
+	off = sizeof(*h);
+	dirs = (const IconThemeDir *)(blob + off);
+	off += (size_t)h->n_dirs * sizeof(IconThemeDir);
+	buckets = (const uint32_t *)(blob + off);
+	off += (size_t)h->n_buckets * sizeof(uint32_t);
+	names = (const IconThemeName *)(blob + off);
+	off += (size_t)h->n_names * sizeof(IconThemeName);
+	entries = (const IconThemeEntry *)(blob + off);
+	off += (size_t)h->n_entries * sizeof(IconThemeEntry);
+	strings = (const char *)(blob + off);
+
+	if (strings[h->strings_size - 1] != '\0')
+		return -1;
+	for (uint32_t i = 0; i < h->n_buckets; i++)
+		if (buckets[i] != ICON_THEME_NONE && buckets[i] >= h->n_names)
+			return -1;
+	for (uint32_t i = 0; i < h->n_dirs; i++)
+		if (dirs[i].path >= h->strings_size)
+			return -1;
+	for (uint32_t i = 0; i < h->n_names; i++) {
+		const IconThemeName *n = &names[i];
+		if (n->str >= h->strings_size
+				|| (n->next != ICON_THEME_NONE && n->next >= h->n_names)
+				|| n->first > h->n_entries || n->count > h->n_entries - n->first)
+			return -1;
+	}
+	for (uint32_t i = 0; i < h->n_entries; i++)
+		if (entries[i].dir >= h->n_dirs || entries[i].ext >= LENGTH(it_exts))
+			return -1;
+
+	ix->hdr = h;
+	ix->dirs = dirs;
+	ix->buckets = buckets;
+	ix->names = names;
+	ix->entries = entries;
+	ix->strings = strings;
+	return 0;
+}
+
+static int
+it_cache_path(char *out, size_t len)
+{
+	const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+	char base[PATH_MAX];
+
+	if (xdg && *xdg)
+		snprintf(base, sizeof(base), "%s", xdg);
+	else if (home && *home)
+		snprintf(base, sizeof(base), "%s/.cache", home);
+	else
+		return -1;
+	mkdir(base, 0755);
+	snprintf(out, len, "%s/nixlytile", base);
+	if (mkdir(out, 0755) != 0 && errno != EEXIST)
+		return -1;
+	if (strlen(out) + sizeof("/icon-theme.idx") > len)
+		return -1;
+	strcat(out, "/icon-theme.idx");
+	return 0;
+}
+
+static int
+it_load_file(IconThemeIndex *ix, const char *file, uint64_t sig)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	if ((fd = open(file, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(IconThemeHeader)) {
+		close(fd);
+		return -1;
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -1;
+	ix->blob = map;
+	ix->size = (size_t)st.st_size;
+	ix->mapped = 1;
+	if (it_attach(ix) != 0 || ix->hdr->roots_sig != sig)
+		goto stale;
+
+	for (uint32_t i = 0; i < ix->hdr->n_dirs; i++) {
+		const IconThemeDir *d = &ix->dirs[i];
+		if (stat(ix->strings + d->path, &st) != 0
+				|| st.st_mtim.tv_sec != d->mtime_sec
+				|| st.st_mtim.tv_nsec != d->mtime_nsec)
+			goto stale;
+	}
+	return 0;
+
+stale:
+	it_index_free(ix);
+	return -1;
+}
+
+static void
+it_store_file(const IconThemeIndex *ix, const char *file)
+{
+	char tmp[PATH_MAX + 16];
+	int fd, ok;
+
+	snprintf(tmp, sizeof(tmp), "%s.%d", file, (int)getpid());
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0)
+		return;
+	ok = write(fd, ix->blob, ix->size) == (ssize_t)ix->size;
+	close(fd);
+	if (!ok || rename(tmp, file) != 0)
+		unlink(tmp);
+}
+
+static int
+it_build(IconThemeIndex *ix, uint64_t sig)
+{
+	IconThemeBuild b = {0};
+	const char *themes[16];
+	char buf[256];
+	IconThemeRootCtx ctx = { .b = &b, .themes = themes };
+	IconThemeHeader *h;
+	uint8_t *p;
+	size_t size;
+
+	ctx.n_themes = it_themes(buf, sizeof(buf), themes, LENGTH(themes));
+	it_rehash(&b, 1024);
+	it_add_string(&b, "");
+	it_for_each_root(it_root_walk_cb, &ctx);
+
+	size = sizeof(*h) + b.n_dirs * sizeof(IconThemeDir)
+		+ b.n_buckets * sizeof(uint32_t)
+		+ b.n_names * sizeof(IconThemeName)
+		+ b.n_raw * sizeof(IconThemeEntry) + b.str_len;
+	p = ecalloc(1, size);
+	h = (IconThemeHeader *)p;
+	h->magic = ICON_THEME_MAGIC;
+	h->version = ICON_THEME_VERSION;
+	h->roots_sig = sig;
+	h->n_dirs = (uint32_t)b.n_dirs;
+	h->n_names = (uint32_t)b.n_names;
+	h->n_entries = (uint32_t)b.n_raw;
+	h->n_buckets = b.n_buckets;
+	h->strings_size = (uint32_t)b.str_len;
+	p += sizeof(*h);
+	memcpy(p, b.dirs, b.n_dirs * sizeof(IconThemeDir));
+	p += b.n_dirs * sizeof(IconThemeDir);
+	memcpy(p, b.buckets, b.n_buckets * sizeof(uint32_t));
+	p += b.n_buckets * sizeof(uint32_t);
+	{
+		/* Lay each name's entries out contiguously, in walk order. */
+		IconThemeName *names = (IconThemeName *)p;
+		IconThemeEntry *entries = (IconThemeEntry *)(p + b.n_names * sizeof(IconThemeName));
+		uint32_t out = 0;
+
+		for (size_t i = 0; i < b.n_names; i++) {
+			names[i] = b.names[i];
+			names[i].first = out;
+			for (uint32_t r = b.names[i].count ? b.names[i].first : ICON_THEME_NONE;
+					r != ICON_THEME_NONE; r = b.raw[r].next)
+				entries[out++] = b.raw[r].e;
+		}
+		p += b.n_names * sizeof(IconThemeName) + b.n_raw * sizeof(IconThemeEntry);
+	}
+	memcpy(p, b.str, b.str_len);
+
+	free(b.str);
+	free(b.dirs);
+	free(b.names);
+	free(b.last);
+	free(b.buckets);
+	free(b.raw);
+	free(b.seen);
+	free(b.sections);
+
+	ix->blob = (uint8_t *)h;
+	ix->size = size;
+	ix->mapped = 0;
+	if (it_attach(ix) != 0) {
+		it_index_free(ix);
+		return -1;
+	}
+	return 0;
+}
+
+/* The cached file if it is still current, else a fresh walk (stored for
+ * the next start). */
+static int
+it_load(IconThemeIndex *ix)
+{
+	char file[PATH_MAX];
+	uint64_t sig = it_roots_sig();
+	int have_file = it_cache_path(file, sizeof(file)) == 0;
+
+	if (have_file && it_load_file(ix, file, sig) == 0)
+		return 0;
+	if (it_build(ix, sig) != 0)
+		return -1;
+	if (have_file)
+		it_store_file(ix, file);
+	return 0;
+}
+
+/* ── worker ───────────────────────────────────────────────────────── */
+
+/* Watches for the directories ix was built from; -1 if none. */
+static int
+it_open_watches(const IconThemeIndex *ix)
+{
+	uint32_t watched = 0;
+	int fd;
+
+	if ((fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+		return -1;
+	for (uint32_t i = 0; i < ix->hdr->n_dirs && watched < ICON_THEME_MAX_WATCH; i++) {
+		if (inotify_add_watch(fd, ix->strings + ix->dirs[i].path,
+				IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+				| IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR) >= 0)
+			watched++;
+	}
+	if (watched < ix->hdr->n_dirs)
+		wlr_log(WLR_INFO, "icon_theme: watching %u of %u directories",
+				watched, ix->hdr->n_dirs);
+	return fd;
+}
+
+static void *
+it_worker(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&it_lock);
+	for (;;) {
+		IconThemeIndex ix = {0};
+		int watch_fd = -1;
+		uint64_t one = 1;
+
+		while (!it_want && !it_thread_stop)
+			pthread_cond_wait(&it_cond, &it_lock);
+		if (it_thread_stop)
+			break;
+		it_want = 0;
+		it_busy = 1;
+		pthread_mutex_unlock(&it_lock);
+
+		if (it_load(&ix) == 0)
+			watch_fd = it_open_watches(&ix);
+
+		pthread_mutex_lock(&it_lock);
+		it_busy = 0;
+		if (it_have_done) {
+			/* never picked up; this one is newer */
+			it_index_free(&it_done);
+			if (it_done_watch >= 0)
+				close(it_done_watch);
+		}
+		it_done = ix;
+		it_done_watch = watch_fd;
+		it_have_done = 1;
+		if (write(it_wake_fd, &one, sizeof(one)) < 0) {
+			/* counter saturated: the main loop is already woken */
+		}
+	}
+	pthread_mutex_unlock(&it_lock);
+	return NULL;
+}
+
+/* ── invalidation ─────────────────────────────────────────────────── */
+
+static void it_request(void);
+
+static int
+it_settle_cb(void *data)
+{
+	(void)data;
+	if (it_state < 0)
+		it_request();
+	return 0;
+}
+
+static int
+it_inotify_cb(int fd, uint32_t mask, void *data)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	int changed = 0;
+	ssize_t len;
+
+	(void)mask;
+	(void)data;
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		changed = 1;
+	if (!changed || !it_idx.hdr)
+		return 0;
+
+	/* Package updates touch hundreds of directories in a burst; rebuild
+	 * once things have been quiet for a moment.  Lookups meanwhile keep
+	 * using the old index and re-check that the file still exists. */
+	it_state = -1;
+	if (!it_settle_timer)
+		it_settle_timer = wl_event_loop_add_timer(event_loop, it_settle_cb, NULL);
+	if (it_settle_timer)
+		wl_event_source_timer_update(it_settle_timer, ICON_THEME_SETTLE_MS);
+	return 0;
+}
+
+static void
+it_unwatch(void)
+{
+	if (it_inotify_src) {
+		wl_event_source_remove(it_inotify_src);
+		it_inotify_src = NULL;
+	}
+	if (it_inotify_fd >= 0) {
+		close(it_inotify_fd);
+		it_inotify_fd = -1;
+	}
+}
+
+/* Put a finished index in place of the old one and let every tray icon
+ * look itself up again.  A failed load keeps the old index. */
+static void
+it_swap(IconThemeIndex *next, int watch_fd)
+{
+	TrayItem *it;
+
+	if (!next->hdr) {
+		if (watch_fd >= 0)
+			close(watch_fd);
+		return;
+	}
+	it_unwatch();
+	it_index_free(&it_idx);
+	it_idx = *next;
+	it_state = 1;
+	wlr_log(WLR_INFO, "icon_theme: %u icons (%u names) in %u directories",
+			it_idx.hdr->n_entries, it_idx.hdr->n_names, it_idx.hdr->n_dirs);
+	if ((it_inotify_fd = watch_fd) >= 0 && event_loop)
+		it_inotify_src = wl_event_loop_add_fd(event_loop, it_inotify_fd,
+				WL_EVENT_READABLE, it_inotify_cb, NULL);
+
+	wl_list_for_each(it, &tray_items, link) {
+		it->icon_tried = 0;
+		it->icon_failed = 0;
+		tray_item_load_icon(it);
+	}
+	tray_update_icons_text();
+}
+
+static int
+it_wake_cb(int fd, uint32_t mask, void *data)
+{
+	IconThemeIndex next = {0};
+	int watch_fd = -1, have;
+	uint64_t count;
+
+	(void)mask;
+	(void)data;
+
+	if (read(fd, &count, sizeof(count)) < 0) {
+		/* spurious wakeup; check for a result anyway */
+	}
+
+	pthread_mutex_lock(&it_lock);
+	have = it_have_done;
+	if (have) {
+		next = it_done;
+		watch_fd = it_done_watch;
+		memset(&it_done, 0, sizeof(it_done));
+		it_done_watch = -1;
+		it_have_done = 0;
+	}
+	it_pending = it_want || it_busy;
+	pthread_mutex_unlock(&it_lock);
+
+	if (have)
+		it_swap(&next, watch_fd);
+	return 0;
+}
+
+static int
+it_start_worker(void)
+{
+	if (it_thread_running)
+		return 0;
+	if (!event_loop)
+		return -1;
+	if (it_wake_fd < 0) {
+		it_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (it_wake_fd < 0)
+			return -1;
+	}
+	if (!it_wake_src)
+		it_wake_src = wl_event_loop_add_fd(event_loop, it_wake_fd,
+				WL_EVENT_READABLE, it_wake_cb, NULL);
+	if (!it_wake_src)
+		return -1;
+	it_thread_stop = 0;
+	if (pthread_create(&it_thread, NULL, it_worker, NULL) != 0)
+		return -1;
+	it_thread_running = 1;
+	return 0;
+}
+
+/* Ask for a (re)load.  Requests made while one is running are folded
+ * into a single follow-up load. */
+static void
+it_request(void)
+{
+	if (it_start_worker() != 0) {
+		/* No worker: load inline, as before there was one. */
+		IconThemeIndex ix = {0};
+
+		if (it_load(&ix) == 0)
+			it_swap(&ix, event_loop ? it_open_watches(&ix) : -1);
+		return;
+	}
+	pthread_mutex_lock(&it_lock);
+	it_want = 1;
+	pthread_cond_signal(&it_cond);
+	pthread_mutex_unlock(&it_lock);
+	it_pending = 1;
+}
+
+/* ── public ───────────────────────────────────────────────────────── */
+
+/* 0 once an index is in place; otherwise starts loading one and returns
+ * -1 (the tray retries its icons when it arrives). */
+int
+icon_theme_ready(void)
+{
+	if (it_idx.hdr)
+		return 0;
+	if (!it_pending)
+		it_request();
+	return it_idx.hdr ? 0 : -1;
+}
+
+int
+icon_theme_lookup(const char *name, int desired_h, char *out, size_t outlen, int *diff)
+{
+	char symbolic[128] = {0};
+	char nosymbolic[128] = {0};
+	const char *candidates[3] = { name, NULL, NULL };
+	size_t cand_count = 1;
+	const IconThemeEntry *best = NULL;
+	const char *best_name = NULL;
+	int best_diff = INT_MAX;
+	uint32_t best_prio = UINT32_MAX;
+
+	if (!name || !*name || !out || outlen == 0 || icon_theme_ready() != 0)
+		return -1;
+
+	if (strip_symbolic_suffix(name, nosymbolic, sizeof(nosymbolic))) {
+		candidates[0] = nosymbolic; /* Prefer colored variant over symbolic */
+		candidates[cand_count++] = name;
+	}
+	if (!strstr(name, "-symbolic") && cand_count < LENGTH(candidates)) {
+		snprintf(symbolic, sizeof(symbolic), "%s-symbolic", name);
+		candidates[cand_count++] = symbolic;
+	}
+
+	for (size_t c = 0; c < cand_count; c++) {
+		uint32_t i = it_idx.buckets[it_hash(candidates[c]) & (it_idx.hdr->n_buckets - 1)];
+
+		for (; i != ICON_THEME_NONE; i = it_idx.names[i].next)
+			if (strcmp(it_idx.strings + it_idx.names[i].str, candidates[c]) == 0)
+				break;
+		if (i == ICON_THEME_NONE)
+			continue;
+		for (uint32_t e = 0; e < it_idx.names[i].count; e++) {
+			const IconThemeEntry *ent = &it_idx.entries[it_idx.names[i].first + e];
+			uint32_t prio = it_idx.dirs[ent->dir].prio;
+			int d = 0;
+
+			if (desired_h > 0 && ent->size > 0 && !(ent->flags & IT_SCALABLE))
+				d = abs(ent->size - desired_h);
+			if (d < best_diff || (d == best_diff && (prio < best_prio
+					|| (prio == best_prio && ent->ext < best->ext)))) {
+				best = ent;
+				best_name = candidates[c];
+				best_diff = d;
+				best_prio = prio;
+			}
+		}
+	}
+	if (!best)
+		return -1;
+
+	snprintf(out, outlen, "%s/%s.%s", it_idx.strings + it_idx.dirs[best->dir].path,
+			best_name, it_exts[best->ext]);
+	if (access(out, R_OK) != 0) {
+		/* Raced a theme update the watches have not reported yet. */
+		out[0] = '\0';
+		return -1;
+	}
+	if (diff)
+		*diff = best_diff;
+	return 0;
+}
+
+void
+icon_theme_cleanup(void)
+{
+	if (it_thread_running) {
+		pthread_mutex_lock(&it_lock);
+		it_thread_stop = 1;
+		pthread_cond_signal(&it_cond);
+		pthread_mutex_unlock(&it_lock);
+		pthread_join(it_thread, NULL);
+		it_thread_running = 0;
+	}
+	if (it_have_done) {
+		it_index_free(&it_done);
+		if (it_done_watch >= 0)
+			close(it_done_watch);
+		it_done_watch = -1;
+		it_have_done = 0;
+	}
+	it_want = it_busy = it_pending = 0;
+	if (it_wake_src)
+		wl_event_source_remove(it_wake_src);
+	it_wake_src = NULL;
+	if (it_wake_fd >= 0)
+		close(it_wake_fd);
+	it_wake_fd = -1;
+
+	it_unwatch();
+	if (it_settle_timer) {
+		wl_event_source_remove(it_settle_timer);
+		it_settle_timer = NULL;
+	}
+	it_index_free(&it_idx);
+	it_state = 0;
+}
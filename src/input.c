@@ -201,8 +201,9 @@ adjust_backlight_by_steps(int steps)
 
 	/* Re-probe in case a dock/undock changed backlight availability.
 	 * Rate-limited: a scroll gesture delivers dozens of notches/sec
-	 * and each probe is a /sys/class/backlight directory scan. */
-	{
+	 * and each probe is a /sys/class/backlight directory scan.  With
+	 * uevent_watch running, backlight add/remove already re-probes. */
+	if (!uevent_watch_active()) {
 		static uint64_t last_probe_ms;
 		uint64_t now_ms = monotonic_msec();
 		if (!backlight_available || now_ms - last_probe_ms > 2000) {
@@ -2229,6 +2230,7 @@ motionnotify(uint32_t time, struct wlr_input_device *device, double dx, double d
 				updatebatteryhover(selmon, cursor->x, cursor->y);
 				updatenethover(selmon, cursor->x, cursor->y);
 				tray_menu_update_hover(selmon, cursor->x, cursor->y);
+				tray_menu_prefetch_at(selmon, cursor->x, cursor->y);
 			}
 		}
 	}
@@ -1,9 +1,9 @@
 /*
  * launchfx.c — instant Steam-launch reaction.
  *
- *  1. Detect the Play press by polling for Steam's `reaper` launch
- *     wrapper (spawned the moment Play is clicked, seconds before any
- *     window exists).
+ *  1. Detect the Play press by Steam's `reaper` launch wrapper
+ *     (spawned the moment Play is clicked, seconds before any window
+ *     exists).  proctable.c reports its exec as it happens.
  *  2. Pre-boost: CPU governor → performance immediately, so Proton
  *     setup / shader compilation / asset loading run at full clock
  *     from t=0.  Full ultra game mode takes over when the window maps.
@@ -50,6 +50,7 @@ static struct {
 	pid_t reaper;             /* newest live reaper of the launch chain */
 	uint64_t orphan_ms;       /* when the tracked reaper died; 0 = alive */
 	uint64_t window_ms;       /* when the first game window mapped; 0 = none */
+	uint32_t appid;           /* Steam AppId from the reaper's cmdline; 0 = unknown */
 	Monitor *mon;
 	struct wlr_scene_tree *tree;
 	struct wlr_scene_buffer *dot;
@@ -135,6 +136,7 @@ fx_teardown(void)
 	fx.reaper = 0;
 	fx.orphan_ms = 0;
 	fx.window_ms = 0;
+	fx.appid = 0;
 	fx.mon = NULL;
 }
 
@@ -221,8 +223,8 @@ fx_watchdog_cb(void *data)
 }
 
 /* Warm the page cache for the game being launched: reaper's cmdline
- * carries "AppId=N".  Fire-and-forget; nixly-prewarm does the work at
- * idle I/O priority. */
+ * carries "AppId=N", which is also kept for gameprofile.c.
+ * Fire-and-forget; nixly-prewarm does the work at idle I/O priority. */
 static void
 fx_readahead(pid_t reaper)
 {
@@ -250,6 +252,7 @@ fx_readahead(pid_t reaper)
 	if (!p || !p[0])
 		return;
 	snprintf(appid, sizeof(appid), "%s", p);
+	fx.appid = (uint32_t)strtoul(appid, NULL, 10);
 
 	if (fork() == 0) {
 		setsid();
@@ -405,6 +408,13 @@ launchfx_active(void)
 	return fx.active;
 }
 
+/* Steam AppId of the launch being tracked, 0 if none or not known. */
+uint32_t
+launchfx_appid(void)
+{
+	return fx.active ? fx.appid : 0;
+}
+
 /* Head start for the cover: update_game_mode() delays ultra activation
  * until the cover has been playing this long, so the grow animation
  * finishes before the game (direct scanout) takes over the screen.
@@ -482,24 +492,6 @@ launchfx_note_commit(Client *c)
 	fx.content_seen = 1;
 }
 
-static int
-proc_comm_is(pid_t pid, const char *want)
-{
-	char path[64], comm[64];
-	FILE *fp;
-	char *nl;
-
-	snprintf(path, sizeof(path), "/proc/%d/comm", (int)pid);
-	fp = fopen(path, "r");
-	if (!fp)
-		return 0;
-	comm[0] = '\0';
-	if (fgets(comm, sizeof(comm), fp) && (nl = strchr(comm, '\n')))
-		*nl = '\0';
-	fclose(fp);
-	return strcmp(comm, want) == 0;
-}
-
 static int
 reaper_seen(pid_t pid)
 {
@@ -510,13 +502,45 @@ reaper_seen(pid_t pid)
 	return 0;
 }
 
+/* Is a Play press possible right now?  Needs a Steam window; while a
+ * game is in game mode and no launch is being tracked there is none to
+ * detect, so the compositor thread spends nothing on it mid-game. */
 static int
-fx_poll_cb(void *data)
+fx_steam_up(void)
 {
-	DIR *dir;
-	struct dirent *ent;
 	Client *c;
-	int steam_up = 0;
+
+	if (game_mode_active && !fx.active)
+		return 0;
+	wl_list_for_each(c, &clients, link) {
+		if (is_steam_client(c))
+			return 1;
+	}
+	return 0;
+}
+
+void
+launchfx_note_exec(pid_t pid, const char *comm)
+{
+	if (!comm || strcmp(comm, "reaper") != 0)
+		return;
+	if (reaper_seen(pid) || !fx_steam_up())
+		return;
+	if (seen_reaper_count < (int)LENGTH(seen_reapers))
+		seen_reapers[seen_reaper_count++] = pid;
+	if (fx.active) {
+		/* Next stage of the same Play press —
+		 * adopt it, keep the one cover up. */
+		fx.reaper = pid;
+		fx.orphan_ms = 0;
+	} else {
+		launchfx_start(pid);
+	}
+}
+
+static int
+fx_poll_cb(void *data)
+{
 	int i, j;
 
 	(void)data;
@@ -525,8 +549,8 @@ fx_poll_cb(void *data)
 		uint64_t now = monotonic_msec();
 
 		/* Track the launch chain: the reaper wrapper lives exactly as
-		 * long as its stage.  Setup stages die and are replaced (the
-		 * scan below adopts the successor); only a chain that ends
+		 * long as its stage.  Setup stages die and are replaced
+		 * (launchfx_note_exec adopts the successor); only a chain that ends
 		 * with no successor and no window means abort/crash. */
 		if (fx.reaper > 0 && kill(fx.reaper, 0) != 0) {
 			fx.reaper = 0;
@@ -561,47 +585,11 @@ fx_poll_cb(void *data)
 		}
 	}
 
-	wl_list_for_each(c, &clients, link) {
-		if (is_steam_client(c)) {
-			steam_up = 1;
-			break;
-		}
-	}
-
-	/* While a game is in game mode and no launch is being tracked there
-	 * is no Play press to detect — skip the /proc sweep (readdir + one
-	 * comm read per pid, every 200 ms) so the compositor thread spends
-	 * nothing on it mid-game.  Resumes when game mode exits. */
-	if (game_mode_active && !fx.active)
-		steam_up = 0;
-
-	if (steam_up) {
-		dir = opendir("/proc");
-		if (dir) {
-			while ((ent = readdir(dir))) {
-				pid_t pid;
-				if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
-					continue;
-				pid = (pid_t)atoi(ent->d_name);
-				if (reaper_seen(pid))
-					continue;
-				if (!proc_comm_is(pid, "reaper"))
-					continue;
-				if (seen_reaper_count <
-						(int)LENGTH(seen_reapers))
-					seen_reapers[seen_reaper_count++] = pid;
-				if (fx.active) {
-					/* Next stage of the same Play press —
-					 * adopt it, keep the one cover up. */
-					fx.reaper = pid;
-					fx.orphan_ms = 0;
-				} else {
-					launchfx_start(pid);
-				}
-			}
-			closedir(dir);
-		}
-	}
+	/* Reapers arrive through launchfx_note_exec().  Without the proc
+	 * connector the table only learns of them on a resync; ask for one
+	 * while a Play press is possible. */
+	if (fx_steam_up() && !proctable_live())
+		proctable_refresh();
 
 	wl_event_source_timer_update(fx_poll_timer, FX_POLL_MS);
 	return 0;
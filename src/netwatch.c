@@ -0,0 +1,891 @@
+/*
+ * netwatch.c — rtnetlink/nl80211 network state for the net module.
+ *
+ * Replaces the per-refresh sysfs walk (findactiveinterface + operstate
+ * for every interface, getifaddrs, /proc/net/wireless, an nmcli/iw
+ * helper for the SSID).  One rtnetlink socket subscribed to link, IPv4
+ * address and route changes and one generic-netlink socket on the
+ * nl80211 "mlme" group (connect/disconnect/roam) sit on the event loop
+ * and keep a small link table current; any change re-arms the net
+ * refresh immediately instead of waiting for its 60s slot.
+ *
+ * Queries (dumps, per-link rtnl_link_stats64, SSID, station signal) go
+ * over separate non-blocking request sockets that also sit on the event
+ * loop.  One query is in flight per socket and the rest queue behind it;
+ * answers land in the link table, so netwatch_state() and
+ * netwatch_link_stats() report the last answer and queue the next
+ * question without ever waiting on the kernel.
+ *
+ * If netlink can't be opened the net module keeps polling sysfs as
+ * before (netwatch_state returns -1).
+ */
+#include "nixlytile.h"
+
+#include <linux/genetlink.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/nl80211.h>
+#include <linux/rtnetlink.h>
+
+/* <linux/if.h> clashes with <net/if.h>; RFC 2863 "up" is all we need. */
+#ifndef IF_OPER_UP
+#define IF_OPER_UP 6
+#endif
+
+#define NETWATCH_MAX_LINKS   32
+#define NETWATCH_BUF         16384
+#define NETWATCH_MAX_QUERIES 8
+/* A query the kernel never answered is dropped after this long so the
+ * queue behind it can't wedge. */
+#define NETWATCH_QUERY_TIMEOUT_MS 1000
+/* Counters older than this would turn the popup's rate into an average
+ * over however long it was closed. */
+#define NETWATCH_STATS_MAX_AGE_MS 2500
+/* Signal moves smaller than this wait for the next regular refresh. */
+#define NETWATCH_QUALITY_STEP 10.0
+
+typedef struct {
+	int ifindex;               /* 0 = free slot */
+	char name[IF_NAMESIZE];
+	int oper_up;
+	int wireless;
+	int speed_mbps;
+	char ip[INET_ADDRSTRLEN];
+	char ssid[64];
+	int ssid_valid;
+	double quality;            /* -1 = unknown */
+	unsigned long long rx, tx;
+	uint64_t stats_ms;         /* 0 = no counters yet */
+	/* resync bookkeeping while a link/address dump runs */
+	int seen;
+	int ip_seen;
+	char dump_ip[INET_ADDRSTRLEN];
+} NetLink;
+
+typedef struct {
+	int family;
+	unsigned int mlme_group;
+} NwFamily;
+
+enum { NW_Q_LINKS, NW_Q_ADDRS, NW_Q_STATS, NW_Q_FAMILY, NW_Q_SSID, NW_Q_SIGNAL };
+
+typedef struct {
+	int kind;                  /* NW_Q_* */
+	int ifindex;               /* link the answer belongs to, or 0 */
+	uint32_t seq;              /* 0 while still queued */
+	uint64_t sent_ms;
+	union {
+		int changed;           /* NW_Q_LINKS, NW_Q_ADDRS */
+		struct {
+			unsigned long long rx, tx;
+			int ok;
+		} stats;
+		NwFamily fam;
+		char ssid[64];
+		int dbm;
+	} r;
+	char msg[128] __attribute__((aligned(NLMSG_ALIGNTO)));
+} NwQuery;
+
+/* A request socket and its FIFO of queries; the head is in flight.
+ * The kernel refuses a second dump on a socket that is still dumping,
+ * so nothing is sent until the head is answered. */
+typedef struct {
+	int fd;
+	struct wl_event_source *src;
+	NwQuery q[NETWATCH_MAX_QUERIES];
+	int head, count;
+} NwReqSock;
+
+static NetLink nw_links[NETWATCH_MAX_LINKS];
+static int nw_rt_ev = -1, nw_gn_ev = -1;
+static NwReqSock nw_rt_rq = { .fd = -1 }, nw_gn_rq = { .fd = -1 };
+static int nw_nl80211_id;
+static uint32_t nw_seq;
+static struct wl_event_source *nw_rt_src, *nw_gn_src;
+
+/* Debounce for bursts (a reconnect is a dozen link/addr/route messages). */
+#define NETWATCH_SETTLE_MS 150
+
+static NetLink *
+nw_link(int ifindex, int create)
+{
+	NetLink *free_slot = NULL;
+
+	for (int i = 0; i < NETWATCH_MAX_LINKS; i++) {
+		if (nw_links[i].ifindex == ifindex)
+			return &nw_links[i];
+		if (!nw_links[i].ifindex && !free_slot)
+			free_slot = &nw_links[i];
+	}
+	if (!create || !free_slot)
+		return NULL;
+	memset(free_slot, 0, sizeof(*free_slot));
+	free_slot->ifindex = ifindex;
+	free_slot->speed_mbps = -1;
+	free_slot->quality = -1.0;
+	free_slot->seen = 1;
+	return free_slot;
+}
+
+static int
+nw_open(int proto, unsigned int groups)
+{
+	struct sockaddr_nl sa = { .nl_family = AF_NETLINK, .nl_groups = groups };
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, proto);
+	if (fd < 0)
+		return -1;
+	if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* ── generic attribute walking (rtattr and nlattr share a layout) ── */
+
+#define NW_ATTR_OK(a, len) ((len) >= (int)sizeof(struct nlattr) \
+		&& (a)->nla_len >= sizeof(struct nlattr) && (a)->nla_len <= (len))
+#define NW_ATTR_NEXT(a, len) ((len) -= NLA_ALIGN((a)->nla_len), \
+		(struct nlattr *)((char *)(a) + NLA_ALIGN((a)->nla_len)))
+#define NW_ATTR_DATA(a) ((void *)((char *)(a) + NLA_HDRLEN))
+#define NW_ATTR_LEN(a)  ((int)(a)->nla_len - NLA_HDRLEN)
+
+static void
+nw_parse_attrs(struct nlattr **tb, int max, struct nlattr *a, int len)
+{
+	memset(tb, 0, sizeof(*tb) * (max + 1));
+	for (; NW_ATTR_OK(a, len); a = NW_ATTR_NEXT(a, len)) {
+		int type = a->nla_type & NLA_TYPE_MASK;
+		if (type <= max)
+			tb[type] = a;
+	}
+}
+
+/* ── rtnetlink ───────────────────────────────────────────────────── */
+
+static int
+nw_read_speed(const char *name)
+{
+	int speed;
+
+	return readlinkspeedmbps(name, &speed) == 0 ? speed : -1;
+}
+
+static void nw_rt_dump(int type);
+
+/* Returns 1 when something the bar shows changed.  dump is set for
+ * answers to our own link/address dumps, which only mark what they see
+ * and leave the verdict to nw_sweep_links() / nw_settle_addrs(). */
+static int
+nw_rt_msg(struct nlmsghdr *h, int dump)
+{
+	struct nlattr *tb[IFLA_MAX + 1];
+
+	if (h->nlmsg_type == RTM_NEWLINK || h->nlmsg_type == RTM_DELLINK) {
+		struct ifinfomsg *ifi = NLMSG_DATA(h);
+		NetLink *l;
+		int up;
+
+		if (ifi->ifi_flags & IFF_LOOPBACK)
+			return 0;
+		if (h->nlmsg_type == RTM_DELLINK) {
+			if ((l = nw_link(ifi->ifi_index, 0)))
+				l->ifindex = 0;
+			return l != NULL;
+		}
+		if (!(l = nw_link(ifi->ifi_index, 1)))
+			return 0;
+		l->seen = 1;
+		nw_parse_attrs(tb, IFLA_MAX, (struct nlattr *)IFLA_RTA(ifi),
+				(int)IFLA_PAYLOAD(h));
+		if (tb[IFLA_IFNAME] && strncmp(l->name,
+					NW_ATTR_DATA(tb[IFLA_IFNAME]), sizeof(l->name))) {
+			snprintf(l->name, sizeof(l->name), "%s",
+					(char *)NW_ATTR_DATA(tb[IFLA_IFNAME]));
+			l->wireless = iface_is_wireless(l->name);
+		}
+		up = tb[IFLA_OPERSTATE]
+			&& *(uint8_t *)NW_ATTR_DATA(tb[IFLA_OPERSTATE]) == IF_OPER_UP;
+		if (up == l->oper_up)
+			return 0;
+		l->oper_up = up;
+		l->speed_mbps = up ? nw_read_speed(l->name) : -1;
+		l->ssid_valid = 0;
+		return 1;
+	}
+
+	if (h->nlmsg_type == RTM_NEWADDR || h->nlmsg_type == RTM_DELADDR) {
+		struct ifaddrmsg *ifa = NLMSG_DATA(h);
+		struct nlattr *ta[IFA_MAX + 1], *a;
+		NetLink *l;
+		char ip[INET_ADDRSTRLEN];
+
+		if (ifa->ifa_family != AF_INET || !(l = nw_link(ifa->ifa_index, 0)))
+			return 0;
+		nw_parse_attrs(ta, IFA_MAX, (struct nlattr *)IFA_RTA(ifa),
+				(int)IFA_PAYLOAD(h));
+		a = ta[IFA_LOCAL] ? ta[IFA_LOCAL] : ta[IFA_ADDRESS];
+		if (!a || !inet_ntop(AF_INET, NW_ATTR_DATA(a), ip, sizeof(ip)))
+			return 0;
+		if (dump) {
+			if (!strcmp(l->ip, ip))
+				l->ip_seen = 1;
+			else if (!l->dump_ip[0])
+				snprintf(l->dump_ip, sizeof(l->dump_ip), "%s", ip);
+			return 0;
+		}
+		if (h->nlmsg_type == RTM_DELADDR) {
+			/* Only the address on display matters.  When that one
+			 * goes, ask which the link still has. */
+			if (strcmp(l->ip, ip))
+				return 0;
+			l->ip[0] = '\0';
+			nw_rt_dump(RTM_GETADDR);
+			return 1;
+		}
+		/* A secondary address showing up doesn't replace the one on
+		 * display; a renumbered link deletes the old one first or
+		 * right after, which lands in the branch above. */
+		if (l->ip[0])
+			return 0;
+		snprintf(l->ip, sizeof(l->ip), "%s", ip);
+		return 1;
+	}
+
+	/* Route changes carry nothing we store, but a new default route is
+	 * exactly when the popup's public IP / speeds go stale. */
+	return h->nlmsg_type == RTM_NEWROUTE || h->nlmsg_type == RTM_DELROUTE;
+}
+
+/* After a link dump: whatever it did not report is gone. */
+static int
+nw_sweep_links(void)
+{
+	int changed = 0;
+
+	for (int i = 0; i < NETWATCH_MAX_LINKS; i++) {
+		if (nw_links[i].ifindex && !nw_links[i].seen) {
+			nw_links[i].ifindex = 0;
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/* After an address dump: keep the displayed address if the link still
+ * has it, else show the first one the dump found (or none). */
+static int
+nw_settle_addrs(void)
+{
+	int changed = 0;
+
+	for (int i = 0; i < NETWATCH_MAX_LINKS; i++) {
+		NetLink *l = &nw_links[i];
+
+		if (!l->ifindex || l->ip_seen || !strcmp(l->ip, l->dump_ip))
+			continue;
+		snprintf(l->ip, sizeof(l->ip), "%s", l->dump_ip);
+		changed = 1;
+	}
+	return changed;
+}
+
+static int
+nw_rt_drain(int fd)
+{
+	char buf[NETWATCH_BUF] __attribute__((aligned(NLMSG_ALIGNTO)));
+	int changed = 0;
+	ssize_t n;
+
+	while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		int len = (int)n;
+
+		for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, len);
+				h = NLMSG_NEXT(h, len))
+			changed |= nw_rt_msg(h, 0);
+	}
+	if (n < 0 && errno == ENOBUFS) {
+		/* Overran the socket buffer: events were lost, so the table
+		 * can't be trusted.  Rebuild it from fresh dumps; their
+		 * completion re-arms the refresh if anything moved. */
+		nw_rt_dump(RTM_GETLINK);
+		nw_rt_dump(RTM_GETADDR);
+	}
+	return changed;
+}
+
+/* ── query sockets ───────────────────────────────────────────────── */
+
+static void
+nw_stats_msg(struct nlmsghdr *h, NwQuery *q)
+{
+	struct ifinfomsg *ifi = NLMSG_DATA(h);
+	struct nlattr *tb[IFLA_MAX + 1];
+
+	if (h->nlmsg_type != RTM_NEWLINK)
+		return;
+	nw_parse_attrs(tb, IFLA_MAX, (struct nlattr *)IFLA_RTA(ifi), (int)IFLA_PAYLOAD(h));
+	if (tb[IFLA_STATS64]
+			&& NW_ATTR_LEN(tb[IFLA_STATS64]) >= (int)sizeof(struct rtnl_link_stats64)) {
+		struct rtnl_link_stats64 s;
+
+		memcpy(&s, NW_ATTR_DATA(tb[IFLA_STATS64]), sizeof(s));
+		q->r.stats.rx = s.rx_bytes;
+		q->r.stats.tx = s.tx_bytes;
+		q->r.stats.ok = 1;
+	}
+}
+
+static void nw_query_msg(NwQuery *q, struct nlmsghdr *h);
+static void nw_query_done(NwQuery *q, int err);
+
+/* Reset the per-dump marks just before the dump goes out, so events
+ * that arrived while it sat in the queue don't count as seen. */
+static void
+nw_query_begin(NwQuery *q)
+{
+	for (int i = 0; i < NETWATCH_MAX_LINKS; i++) {
+		if (q->kind == NW_Q_LINKS) {
+			nw_links[i].seen = 0;
+		} else if (q->kind == NW_Q_ADDRS) {
+			nw_links[i].ip_seen = 0;
+			nw_links[i].dump_ip[0] = '\0';
+		}
+	}
+}
+
+/* Retire the head query.  It is popped before its completion runs so
+ * the completion may queue follow-ups. */
+static void
+nw_query_pop(NwReqSock *rq, int err)
+{
+	NwQuery q = rq->q[rq->head];
+
+	rq->head = (rq->head + 1) % NETWATCH_MAX_QUERIES;
+	rq->count--;
+	nw_query_done(&q, err);
+}
+
+/* Send the head query if it hasn't gone out yet. */
+static void
+nw_query_kick(NwReqSock *rq)
+{
+	while (rq->fd >= 0 && rq->count && !rq->q[rq->head].seq) {
+		NwQuery *q = &rq->q[rq->head];
+		struct nlmsghdr *h = (struct nlmsghdr *)q->msg;
+
+		if (!++nw_seq)
+			++nw_seq;
+		q->seq = h->nlmsg_seq = nw_seq;
+		q->sent_ms = monotonic_msec();
+		nw_query_begin(q);
+		if (send(rq->fd, h, h->nlmsg_len, 0) >= 0)
+			break;
+		nw_query_pop(rq, -errno);
+	}
+}
+
+/* Queue a request; the answer is handled by nw_query_msg() and
+ * nw_query_done() from the event loop.  An identical query that has
+ * not been sent yet already covers this one. */
+static void
+nw_query(NwReqSock *rq, int kind, int ifindex, const struct nlmsghdr *req)
+{
+	NwQuery *q;
+
+	if (rq->fd < 0 || req->nlmsg_len > sizeof(q->msg))
+		return;
+	if (rq->count && rq->q[rq->head].seq && monotonic_msec()
+			- rq->q[rq->head].sent_ms > NETWATCH_QUERY_TIMEOUT_MS)
+		nw_query_pop(rq, -ETIMEDOUT);
+	for (int i = 0; i < rq->count; i++) {
+		q = &rq->q[(rq->head + i) % NETWATCH_MAX_QUERIES];
+		if (!q->seq && q->kind == kind && q->ifindex == ifindex)
+			return;
+	}
+	if (rq->count == NETWATCH_MAX_QUERIES)
+		return;
+	q = &rq->q[(rq->head + rq->count++) % NETWATCH_MAX_QUERIES];
+	memset(q, 0, sizeof(*q));
+	q->kind = kind;
+	q->ifindex = ifindex;
+	memcpy(q->msg, req, req->nlmsg_len);
+	nw_query_kick(rq);
+}
+
+static int
+nw_query_cb(int fd, uint32_t mask, void *data)
+{
+	char buf[NETWATCH_BUF] __attribute__((aligned(NLMSG_ALIGNTO)));
+	NwReqSock *rq = data;
+	ssize_t n;
+
+	(void)mask;
+	while (rq->fd >= 0 && (n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		int len = (int)n;
+
+		for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, len);
+				h = NLMSG_NEXT(h, len)) {
+			NwQuery *q = &rq->q[rq->head];
+
+			/* late answer to a query that timed out */
+			if (!rq->count || h->nlmsg_seq != q->seq)
+				continue;
+			if (h->nlmsg_type == NLMSG_DONE) {
+				nw_query_pop(rq, 0);
+			} else if (h->nlmsg_type == NLMSG_ERROR) {
+				nw_query_pop(rq, ((struct nlmsgerr *)NLMSG_DATA(h))->error);
+			} else {
+				nw_query_msg(q, h);
+				if (!(((struct nlmsghdr *)q->msg)->nlmsg_flags & NLM_F_DUMP))
+					nw_query_pop(rq, 0);
+			}
+			/* a completion may have closed this socket */
+			if (rq->fd < 0)
+				return 0;
+		}
+	}
+	nw_query_kick(rq);
+	return 0;
+}
+
+static int
+nw_query_open(NwReqSock *rq, int proto)
+{
+	if ((rq->fd = nw_open(proto, 0)) < 0)
+		return -1;
+	rq->head = rq->count = 0;
+	rq->src = wl_event_loop_add_fd(event_loop, rq->fd, WL_EVENT_READABLE,
+			nw_query_cb, rq);
+	return 0;
+}
+
+static void
+nw_query_close(NwReqSock *rq)
+{
+	if (rq->src)
+		wl_event_source_remove(rq->src);
+	if (rq->fd >= 0)
+		close(rq->fd);
+	rq->src = NULL;
+	rq->fd = -1;
+	rq->head = rq->count = 0;
+}
+
+static void
+nw_rt_dump(int type)
+{
+	struct {
+		struct nlmsghdr h;
+		struct rtgenmsg g;
+	} req = {
+		.h.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg)),
+		.h.nlmsg_type = (uint16_t)type,
+		.h.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+		.g.rtgen_family = AF_UNSPEC,
+	};
+
+	nw_query(&nw_rt_rq, type == RTM_GETLINK ? NW_Q_LINKS : NW_Q_ADDRS,
+			0, &req.h);
+}
+
+/* ── nl80211 ─────────────────────────────────────────────────────── */
+
+typedef struct {
+	struct nlmsghdr h;
+	struct genlmsghdr g;
+	char attrs[64];
+} NwGenlReq;
+
+static void
+nw_genl_init(NwGenlReq *req, int family, int cmd, int flags)
+{
+	memset(req, 0, sizeof(*req));
+	req->h.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	req->h.nlmsg_type = (uint16_t)family;
+	req->h.nlmsg_flags = (uint16_t)(NLM_F_REQUEST | flags);
+	req->g.cmd = (uint8_t)cmd;
+	req->g.version = 1;
+}
+
+static void
+nw_genl_put(NwGenlReq *req, int type, const void *data, int len)
+{
+	struct nlattr *a = (struct nlattr *)((char *)&req->h + NLMSG_ALIGN(req->h.nlmsg_len));
+
+	a->nla_type = (uint16_t)type;
+	a->nla_len = (uint16_t)(NLA_HDRLEN + len);
+	memcpy(NW_ATTR_DATA(a), data, (size_t)len);
+	req->h.nlmsg_len = NLMSG_ALIGN(req->h.nlmsg_len) + NLA_ALIGN(a->nla_len);
+}
+
+static void
+nw_family_msg(struct nlmsghdr *h, NwFamily *fam)
+{
+	struct nlattr *tb[CTRL_ATTR_MAX + 1], *grp;
+	int len;
+
+	nw_parse_attrs(tb, CTRL_ATTR_MAX,
+			(struct nlattr *)((char *)NLMSG_DATA(h) + GENL_HDRLEN),
+			(int)h->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+	if (tb[CTRL_ATTR_FAMILY_ID])
+		fam->family = *(uint16_t *)NW_ATTR_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+	if (!tb[CTRL_ATTR_MCAST_GROUPS])
+		return;
+
+	grp = NW_ATTR_DATA(tb[CTRL_ATTR_MCAST_GROUPS]);
+	len = NW_ATTR_LEN(tb[CTRL_ATTR_MCAST_GROUPS]);
+	for (; NW_ATTR_OK(grp, len); grp = NW_ATTR_NEXT(grp, len)) {
+		struct nlattr *g[CTRL_ATTR_MCAST_GRP_MAX + 1];
+
+		nw_parse_attrs(g, CTRL_ATTR_MCAST_GRP_MAX, NW_ATTR_DATA(grp),
+				NW_ATTR_LEN(grp));
+		if (g[CTRL_ATTR_MCAST_GRP_NAME] && g[CTRL_ATTR_MCAST_GRP_ID]
+				&& !strcmp(NW_ATTR_DATA(g[CTRL_ATTR_MCAST_GRP_NAME]),
+					NL80211_MULTICAST_GROUP_MLME))
+			fam->mlme_group = *(uint32_t *)NW_ATTR_DATA(g[CTRL_ATTR_MCAST_GRP_ID]);
+	}
+}
+
+static void
+nw_ssid_msg(struct nlmsghdr *h, NwQuery *q)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	int n;
+
+	nw_parse_attrs(tb, NL80211_ATTR_MAX,
+			(struct nlattr *)((char *)NLMSG_DATA(h) + GENL_HDRLEN),
+			(int)h->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+	if (!tb[NL80211_ATTR_SSID])
+		return;
+	n = MIN(NW_ATTR_LEN(tb[NL80211_ATTR_SSID]), (int)sizeof(q->r.ssid) - 1);
+	memcpy(q->r.ssid, NW_ATTR_DATA(tb[NL80211_ATTR_SSID]), (size_t)n);
+	q->r.ssid[n] = '\0';
+}
+
+static void
+nw_signal_msg(struct nlmsghdr *h, NwQuery *q)
+{
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct nlattr *si[NL80211_STA_INFO_MAX + 1];
+
+	nw_parse_attrs(tb, NL80211_ATTR_MAX,
+			(struct nlattr *)((char *)NLMSG_DATA(h) + GENL_HDRLEN),
+			(int)h->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+	if (!tb[NL80211_ATTR_STA_INFO])
+		return;
+	nw_parse_attrs(si, NL80211_STA_INFO_MAX, NW_ATTR_DATA(tb[NL80211_ATTR_STA_INFO]),
+			NW_ATTR_LEN(tb[NL80211_ATTR_STA_INFO]));
+	if (si[NL80211_STA_INFO_SIGNAL])
+		q->r.dbm = *(int8_t *)NW_ATTR_DATA(si[NL80211_STA_INFO_SIGNAL]);
+}
+
+static void
+nw_fetch_ssid(NetLink *l)
+{
+	NwGenlReq req;
+	uint32_t idx = (uint32_t)l->ifindex;
+
+	nw_genl_init(&req, nw_nl80211_id, NL80211_CMD_GET_INTERFACE, 0);
+	nw_genl_put(&req, NL80211_ATTR_IFINDEX, &idx, sizeof(idx));
+	nw_query(&nw_gn_rq, NW_Q_SSID, l->ifindex, &req.h);
+}
+
+static void
+nw_fetch_quality(NetLink *l)
+{
+	NwGenlReq req;
+	uint32_t idx = (uint32_t)l->ifindex;
+
+	nw_genl_init(&req, nw_nl80211_id, NL80211_CMD_GET_STATION, NLM_F_DUMP);
+	nw_genl_put(&req, NL80211_ATTR_IFINDEX, &idx, sizeof(idx));
+	nw_query(&nw_gn_rq, NW_Q_SIGNAL, l->ifindex, &req.h);
+}
+
+/* ── event loop glue ─────────────────────────────────────────────── */
+
+static void
+nw_changed(void)
+{
+	set_status_task_due(refreshstatusnet, monotonic_msec() + NETWATCH_SETTLE_MS);
+}
+
+static int
+nw_rt_cb(int fd, uint32_t mask, void *data)
+{
+	(void)mask;
+	(void)data;
+	if (nw_rt_drain(fd))
+		nw_changed();
+	return 0;
+}
+
+static int
+nw_gn_cb(int fd, uint32_t mask, void *data)
+{
+	char buf[NETWATCH_BUF] __attribute__((aligned(NLMSG_ALIGNTO)));
+	int changed = 0;
+	ssize_t n;
+
+	(void)mask;
+	(void)data;
+	while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		int len = (int)n;
+
+		for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, len);
+				h = NLMSG_NEXT(h, len)) {
+			struct genlmsghdr *g = NLMSG_DATA(h);
+
+			if (g->cmd == NL80211_CMD_CONNECT || g->cmd == NL80211_CMD_ROAM
+					|| g->cmd == NL80211_CMD_DISCONNECT)
+				changed = 1;
+		}
+	}
+	/* overrun: a connect/disconnect may be among the lost events */
+	if (n < 0 && errno == ENOBUFS)
+		changed = 1;
+	if (changed) {
+		for (int i = 0; i < NETWATCH_MAX_LINKS; i++)
+			nw_links[i].ssid_valid = 0;
+		nw_changed();
+	}
+	return 0;
+}
+
+static void
+nw_genl_ready(const NwFamily *fam, int err)
+{
+	if (err || !fam->family) {
+		/* No cfg80211 (wired-only box): SSID/signal fall back. */
+		nw_query_close(&nw_gn_rq);
+		return;
+	}
+	nw_nl80211_id = fam->family;
+	nw_changed();
+
+	if (!fam->mlme_group || (nw_gn_ev = nw_open(NETLINK_GENERIC, 0)) < 0)
+		return;
+	if (setsockopt(nw_gn_ev, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP,
+				&fam->mlme_group, sizeof(fam->mlme_group)) < 0) {
+		close(nw_gn_ev);
+		nw_gn_ev = -1;
+		return;
+	}
+	nw_gn_src = wl_event_loop_add_fd(event_loop, nw_gn_ev, WL_EVENT_READABLE,
+			nw_gn_cb, NULL);
+}
+
+static void
+nw_query_msg(NwQuery *q, struct nlmsghdr *h)
+{
+	switch (q->kind) {
+	case NW_Q_LINKS:
+	case NW_Q_ADDRS:
+		q->r.changed |= nw_rt_msg(h, 1);
+		break;
+	case NW_Q_STATS:
+		nw_stats_msg(h, q);
+		break;
+	case NW_Q_FAMILY:
+		nw_family_msg(h, &q->r.fam);
+		break;
+	case NW_Q_SSID:
+		nw_ssid_msg(h, q);
+		break;
+	case NW_Q_SIGNAL:
+		nw_signal_msg(h, q);
+		break;
+	}
+}
+
+/* err is 0 or a negative errno (NLMSG_ERROR, send failure, timeout). */
+static void
+nw_query_done(NwQuery *q, int err)
+{
+	NetLink *l = q->ifindex ? nw_link(q->ifindex, 0) : NULL;
+	double quality;
+
+	switch (q->kind) {
+	case NW_Q_LINKS:
+		if (!err)
+			q->r.changed |= nw_sweep_links();
+		if (q->r.changed)
+			nw_changed();
+		break;
+	case NW_Q_ADDRS:
+		if (!err)
+			q->r.changed |= nw_settle_addrs();
+		if (q->r.changed)
+			nw_changed();
+		break;
+	case NW_Q_STATS:
+		if (!l || err || !q->r.stats.ok)
+			break;
+		l->rx = q->r.stats.rx;
+		l->tx = q->r.stats.tx;
+		l->stats_ms = monotonic_msec();
+		break;
+	case NW_Q_FAMILY:
+		nw_genl_ready(&q->r.fam, err);
+		break;
+	case NW_Q_SSID:
+		if (!l || err)
+			break;
+		l->ssid_valid = 1;
+		if (strcmp(l->ssid, q->r.ssid)) {
+			snprintf(l->ssid, sizeof(l->ssid), "%s", q->r.ssid);
+			nw_changed();
+		}
+		break;
+	case NW_Q_SIGNAL:
+		if (!l)
+			break;
+		/* dBm onto the 0-100 scale the icon thresholds use
+		 * (-100 dBm → 0, -50 dBm and better → 100) */
+		quality = !err && q->r.dbm
+			? MAX(0.0, MIN(100.0, 2.0 * (q->r.dbm + 100))) : -1.0;
+		if (fabs(quality - l->quality) >= NETWATCH_QUALITY_STEP)
+			nw_changed();
+		l->quality = quality;
+		break;
+	}
+}
+
+static void
+nw_genl_setup(void)
+{
+	NwGenlReq req;
+	const char *name = NL80211_GENL_NAME;
+
+	if (nw_query_open(&nw_gn_rq, NETLINK_GENERIC) < 0)
+		return;
+	nw_genl_init(&req, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0);
+	nw_genl_put(&req, CTRL_ATTR_FAMILY_NAME, name, (int)strlen(name) + 1);
+	nw_query(&nw_gn_rq, NW_Q_FAMILY, 0, &req.h);
+}
+
+void
+netwatch_setup(void)
+{
+	if (nw_rt_ev >= 0)
+		return;
+
+	nw_rt_ev = nw_open(NETLINK_ROUTE,
+			RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE);
+	if (nw_rt_ev < 0 || nw_query_open(&nw_rt_rq, NETLINK_ROUTE) < 0) {
+		wlr_log(WLR_ERROR, "netwatch: rtnetlink unavailable, polling sysfs");
+		netwatch_cleanup();
+		return;
+	}
+	nw_rt_src = wl_event_loop_add_fd(event_loop, nw_rt_ev, WL_EVENT_READABLE,
+			nw_rt_cb, NULL);
+
+	/* Subscribe first, then dump: nothing slips between the two. */
+	nw_rt_dump(RTM_GETLINK);
+	nw_rt_dump(RTM_GETADDR);
+	nw_genl_setup();
+}
+
+void
+netwatch_cleanup(void)
+{
+	if (nw_rt_src)
+		wl_event_source_remove(nw_rt_src);
+	if (nw_gn_src)
+		wl_event_source_remove(nw_gn_src);
+	nw_rt_src = nw_gn_src = NULL;
+	if (nw_rt_ev >= 0)
+		close(nw_rt_ev);
+	if (nw_gn_ev >= 0)
+		close(nw_gn_ev);
+	nw_rt_ev = nw_gn_ev = -1;
+	nw_query_close(&nw_rt_rq);
+	nw_query_close(&nw_gn_rq);
+	nw_nl80211_id = 0;
+	memset(nw_links, 0, sizeof(nw_links));
+}
+
+/* Same choice findactiveinterface() makes: an operationally-up wireless
+ * link wins, else the first up wired one.  Returns -1 when netlink is
+ * not running (caller polls sysfs), 0 with no active link, 1 otherwise.
+ * quality is -1 (unknown) for wired links or without nl80211; ssid is
+ * empty when nl80211 can't say (yet), and ssid_native tells the caller
+ * whether nl80211 is there to say it at all (its family lookup counts,
+ * while it is in flight).  SSID and signal are the last answers
+ * from nl80211; the next query is queued here and its answer re-arms
+ * the refresh when it moves the display. */
+int
+netwatch_state(NetState *out)
+{
+	NetLink *best = NULL;
+
+	if (nw_rt_rq.fd < 0)
+		return -1;
+
+	for (int i = 0; i < NETWATCH_MAX_LINKS; i++) {
+		NetLink *l = &nw_links[i];
+
+		if (!l->ifindex || !l->oper_up || !l->name[0])
+			continue;
+		if (l->wireless) {
+			best = l;
+			break;
+		}
+		if (!best)
+			best = l;
+	}
+	if (!best)
+		return 0;
+
+	memset(out, 0, sizeof(*out));
+	snprintf(out->iface, sizeof(out->iface), "%s", best->name);
+	out->ifindex = best->ifindex;
+	out->wireless = best->wireless;
+	out->speed_mbps = best->speed_mbps;
+	snprintf(out->ip, sizeof(out->ip), "%s", best->ip[0] ? best->ip : "--");
+	out->quality = -1.0;
+	out->ssid_native = best->wireless && nw_gn_rq.fd >= 0;
+	if (best->wireless && nw_nl80211_id) {
+		if (!best->ssid_valid)
+			nw_fetch_ssid(best);
+		nw_fetch_quality(best);
+		snprintf(out->ssid, sizeof(out->ssid), "%s", best->ssid);
+		out->quality = best->quality;
+	}
+	return 1;
+}
+
+/* rx/tx byte counters for one link, straight from rtnl_link_stats64.
+ * Reports the previous query's answer and queues the next one, so the
+ * counters trail the call by one popup refresh; sample_ms is when that
+ * answer arrived (monotonic_msec), which is what a rate must divide by.
+ * -1 until there is an answer recent enough to diff against. */
+int
+netwatch_link_stats(int ifindex, unsigned long long *rx, unsigned long long *tx,
+		uint64_t *sample_ms)
+{
+	struct {
+		struct nlmsghdr h;
+		struct ifinfomsg i;
+	} req = {
+		.h.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg)),
+		.h.nlmsg_type = RTM_GETLINK,
+		.h.nlmsg_flags = NLM_F_REQUEST,
+		.i.ifi_family = AF_UNSPEC,
+		.i.ifi_index = ifindex,
+	};
+	NetLink *l;
+
+	if (nw_rt_rq.fd < 0 || ifindex <= 0 || !(l = nw_link(ifindex, 0)))
+		return -1;
+	nw_query(&nw_rt_rq, NW_Q_STATS, ifindex, &req.h);
+	if (!l->stats_ms || monotonic_msec() - l->stats_ms > NETWATCH_STATS_MAX_AGE_MS)
+		return -1;
+	*rx = l->rx;
+	*tx = l->tx;
+	*sample_ms = l->stats_ms;
+	return 0;
+}
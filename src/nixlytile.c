@@ -761,8 +761,22 @@ cleanup(void)
 	wlr_log(WLR_ERROR, "cleanup() called - starting cleanup sequence");
 	apptoggle_cleanup();
 	mic_watch_cleanup();
+	pw_audio_cleanup();
+	netwatch_cleanup();
+	uevent_watch_cleanup();
+	procstat_cleanup();
+	tray_pixmap_cleanup();
+	classify_cleanup();
+	psiwatch_cleanup();
+	gpustat_cleanup();
+	gpuclients_cleanup();  /* after the worker that fills it */
+	icon_cache_cleanup();
+	icon_theme_cleanup();
+	label_cache_flush();
 	/* Shut down game mode background worker (unfreezes processes if needed) */
 	gm_bg_cleanup();
+	nvml_close();  /* after the worker's final GPU restore */
+	proctable_cleanup();
 	window_ipc_finish();
 	cleanuplisteners();
 #ifdef XWAYLAND
@@ -1252,6 +1266,16 @@ run(const char *startup_cmd)
 	/* Microphone module follows capture-device hotplug. */
 	mic_watch_setup();
 
+	/* Volume/mic state straight from PipeWire instead of wpctl. */
+	pw_audio_setup();
+	netwatch_setup();
+	uevent_watch_setup();
+
+	/* Process table for launch detection and game-mode sweeps. */
+	proctable_setup();
+	psiwatch_setup();
+	gpustat_setup();
+
 	/* Always-on responsiveness: elevate the compositor thread so it keeps
 	 * getting CPU even when the machine is saturated (100% load) — input
 	 * and the spring-driven animations stay smooth under any load.  nice
@@ -2221,6 +2245,27 @@ diag_log_nvidia(void)
 	clock_gettime(CLOCK_REALTIME, &now_ts);
 	localtime_r(&now_ts.tv_sec, &tm);
 
+	int gpu_util = 0, mem_util = 0, temp = 0, gpu_clk = 0, mem_clk = 0;
+	float power = 0, power_limit = -1;
+	char pstate[8] = "";
+	NvmlTelemetry nt;
+
+	/* NVML when the driver has it: a few library calls, no fork */
+	if (nvml_open(detected_gpus[discrete_gpu_idx].pci_slot) == 0
+			&& nvml_telemetry(&nt) == 0) {
+		gpu_util = (int)nt.gpu_util;
+		mem_util = (int)nt.mem_util;
+		temp     = (int)nt.temp_c;
+		gpu_clk  = (int)nt.gfx_mhz;
+		mem_clk  = (int)nt.mem_mhz;
+		power    = (float)nt.power_mw / 1000.0f;
+		if (nt.limit_mw)
+			power_limit = (float)nt.limit_mw / 1000.0f;
+		if (nt.pstate >= 0)
+			snprintf(pstate, sizeof(pstate), "P%d", nt.pstate);
+		goto report;
+	}
+
 	/* Query multiple fields in one nvidia-smi call */
 	char buf[512] = "";
 	FILE *p = popen("nvidia-smi --query-gpu=utilization.gpu,utilization.memory,"
@@ -2239,10 +2284,6 @@ diag_log_nvidia(void)
 	pclose(p);
 
 	/* Parse CSV: gpu_util, mem_util, temp, gpu_clk, mem_clk, power, power_limit, pstate */
-	int gpu_util = 0, mem_util = 0, temp = 0, gpu_clk = 0, mem_clk = 0;
-	float power = 0, power_limit = -1;
-	char pstate[8] = "";
-
 	/* Use strtok to handle [N/A] fields from nvidia-smi */
 	char *fields[8];
 	int nfields = 0;
@@ -2269,6 +2310,7 @@ diag_log_nvidia(void)
 	for (int i = strlen(pstate)-1; i >= 0 && (pstate[i] == '\n' || pstate[i] == ' '); i--)
 		pstate[i] = '\0';
 
+report:;
 	char power_str[32];
 	if (power_limit < 0)
 		snprintf(power_str, sizeof(power_str), "%.0f/N/A W", power);
@@ -2292,6 +2334,83 @@ diag_log_nvidia(void)
 		diag_log_error("NVIDIA", "Unexpected PState %s during game mode (expected P0-P2)", pstate);
 }
 
+/* amdgpu / i915 / xe: the gpustat worker's latest sample, no sysfs reads
+ * on this thread.  NVIDIA keeps its own section above. */
+static void
+diag_log_gpustat(void)
+{
+	GpuStat s;
+	const char *name;
+	char vram[24] = "", temp[24] = "";
+
+	if (diag_log_fd < 0 || gpustat_get(&s) < 0 || s.vendor == GPU_VENDOR_NVIDIA)
+		return;
+	name = s.vendor == GPU_VENDOR_AMD ? "AMD" : "Intel";
+
+	struct timespec now_ts;
+	struct tm tm;
+	clock_gettime(CLOCK_REALTIME, &now_ts);
+	localtime_r(&now_ts.tv_sec, &tm);
+
+	char out[256];
+	int off;
+	if (s.suspended) {
+		off = snprintf(out, sizeof(out),
+			"[%02d:%02d:%02d] === %s GPU ===\n  runtime-suspended\n",
+			tm.tm_hour, tm.tm_min, tm.tm_sec, name);
+		(void)!write(diag_log_fd, out, off);
+		return;
+	}
+	if (s.mem_busy >= 0)
+		snprintf(vram, sizeof(vram), ", %d%% VRAM", s.mem_busy);
+	if (s.temp_c >= 0)
+		snprintf(temp, sizeof(temp), " | Temp: %d°C", s.temp_c);
+	off = snprintf(out, sizeof(out),
+		"[%02d:%02d:%02d] === %s GPU ===\n"
+		"  Util: %d%% GPU%s%s\n"
+		"  Clocks: %d/%d MHz | Power: %.1f W\n",
+		tm.tm_hour, tm.tm_min, tm.tm_sec, name,
+		s.busy, vram, temp,
+		s.gfx_mhz, s.mem_mhz, s.power_mw / 1000.0);
+	(void)!write(diag_log_fd, out, off);
+
+	if (s.temp_c >= 90)
+		diag_log_error(name, "GPU temp critical: %d°C (threshold: 90°C)", s.temp_c);
+}
+
+/* While a game runs: who else holds the GPU (DRM fdinfo, gpuclients.c). */
+static void
+diag_log_gpuclients(void)
+{
+	GpuClient top[6];
+	int n;
+
+	if (diag_log_fd < 0 || !game_mode_active)
+		return;
+	if ((n = gpuclients_top(top, LENGTH(top))) <= 0)
+		return;
+
+	struct timespec now_ts;
+	struct tm tm;
+	clock_gettime(CLOCK_REALTIME, &now_ts);
+	localtime_r(&now_ts.tv_sec, &tm);
+
+	char out[1024];
+	int off = snprintf(out, sizeof(out),
+		"[%02d:%02d:%02d] === GPU clients ===\n",
+		tm.tm_hour, tm.tm_min, tm.tm_sec);
+	for (int i = 0; i < n && off < (int)sizeof(out); i++)
+		off += snprintf(out + off, sizeof(out) - off,
+			"  %-15s [%d] %3d%% %-8s VRAM %llu MiB%s\n",
+			top[i].comm, top[i].pid, top[i].busy,
+			top[i].engine[0] ? top[i].engine : "-",
+			(unsigned long long)(top[i].vram_kib / 1024),
+			top[i].pid == game_mode_pid ? " (game)" : "");
+	if (off > (int)sizeof(out))
+		off = sizeof(out);
+	(void)!write(diag_log_fd, out, off);
+}
+
 static int
 diag_timer_cb(void *data)
 {
@@ -2304,6 +2423,8 @@ diag_timer_cb(void *data)
 	diag_log_cpu_breakdown();
 	diag_log_io_stats();
 	diag_log_nvidia();
+	diag_log_gpustat();
+	diag_log_gpuclients();
 
 	/* Reschedule at 10s instead of 5s — halves wakeups while still useful */
 	if (diag_timer)
@@ -3752,6 +3873,7 @@ associatex11(struct wl_listener *listener, void *data)
 
 	LISTEN(&client_surface(c)->events.map, &c->map, mapnotify);
 	LISTEN(&client_surface(c)->events.unmap, &c->unmap, unmapnotify);
+	classify_client(c);
 }
 
 void
@@ -4067,6 +4189,7 @@ createnotifyx11(struct wl_listener *listener, void *data)
 	LISTEN(&xsurface->events.set_hints, &c->set_hints, sethints);
 	LISTEN(&xsurface->events.set_title, &c->set_title, updatetitle);
 	LISTEN(&xsurface->events.set_override_redirect, &c->set_override_redirect, setoverrideredirect);
+	classify_client(c);
 }
 
 void
@@ -410,6 +410,28 @@ struct StatusModule {
 	uint64_t render_sig;
 };
 
+/* One status refresh pass: the first module drawn per bar geometry,
+ * copied onto the other monitors that share it (status_share_render).
+ * One group per distinct geometry, however many outputs there are. */
+typedef struct {
+	struct {
+		int barh;
+		float scale;
+		StatusModule *src;
+	} *group;
+	int n, cap;
+} StatusShare;
+
+/* procstat.c: one comm-group of the last /proc sample */
+typedef struct {
+	pid_t pid;               /* heaviest member */
+	char name[64];
+	double cpu;              /* summed %CPU, per-core scale like top */
+	double max_single_cpu;
+	unsigned long rss_kb;
+	unsigned long max_single_rss_kb;
+} ProcGroup;
+
 typedef struct {
 	pid_t pid;
 	char name[64];
@@ -582,6 +604,9 @@ typedef struct TrayMenuEntry {
 	int y;
 	int height;
 	char label[256];
+	struct wlr_buffer *text_buf; /* shaped row text, locked; NULL for separators */
+	int text_left;
+	int text_w;
 	struct wl_list link;
 } TrayMenuEntry;
 
@@ -600,6 +625,8 @@ typedef struct {
 	struct wlr_scene_rect *hover_rect; /* persistent highlight; moved on hover */
 } TrayMenu;
 
+#define STATUSBAR_FLAT_MAX 12 /* bar modules a flat bar composites */
+
 struct StatusBar {
 	struct wlr_scene_tree *tree;
 	struct wlr_box area;
@@ -626,6 +653,15 @@ struct StatusBar {
 	FanPopup fan_popup;
 	TrayMenu tray_menu;
 	StatusModule fan;
+	/* statusbar-flat: module trees live under the disabled flat_src and
+	 * are composited into the single scene buffer flat. */
+	struct wlr_scene_tree *flat_src;
+	struct wlr_scene_buffer *flat;
+	struct wlr_buffer *flat_buf[2];
+	int flat_cur;
+	pixman_region32_t flat_prev_damage;
+	uint64_t flat_sig[STATUSBAR_FLAT_MAX];
+	pixman_box32_t flat_box[STATUSBAR_FLAT_MAX];
 };
 
 struct TrayItem {
@@ -639,6 +675,16 @@ struct TrayItem {
 	int icon_failed;
 	int passive; /* SNI Status == "Passive" -> hidden in tray */
 	uint64_t icon_retry_not_before_ms;
+	uint64_t seq;              /* registration order; newest wins dedup */
+	sd_bus_slot *slot;         /* in-flight Introspect/GetAll, or NULL */
+	struct TrayProbe *probe;   /* object path search, NULL once resolved */
+	struct TrayMenuModel *menu_model; /* cached dbusmenu layout, or NULL */
+	uint64_t icon_hash;        /* content hash of the pixmap shown, 0 if none */
+	uint64_t pixmap_gen;       /* queued pixmap decode, 0 if none */
+	int fetch_iface;           /* SNI interface name that answers GetAll */
+	int fetch_icon;            /* in-flight GetAll also reloads the icon */
+	int refetch;               /* changed while a GetAll was in flight */
+	int refetch_icon;
 	int x;
 	int w;
 	int icon_w;
@@ -989,12 +1035,17 @@ typedef struct {
 	                             * (Gaea.Viewport) — float borderless, honor the
 	                             * client's own geometry, never center or tile */
 	/* Memoized pid-based probes (0=unknown, 1=yes, -1=no).  The pid
-	 * never changes for a client, and the uncached versions walk
-	 * /proc on every call — from per-event hot paths like
-	 * configurex11 and buttonpress. */
+	 * never changes for a client; classify.c computes all of them on a
+	 * worker as soon as the pid is known and publishes them together,
+	 * so neither map nor per-event hot paths like configurex11 and
+	 * buttonpress read /proc. */
 	int wine_verdict;
 	int launcher_child_verdict;   /* Steam ancestry (game mode, monitor pin) */
 	int game_runtime_verdict;     /* any launcher/runtime ancestry */
+	int retro_verdict;            /* emulator comm/exe/cmdline in ancestry */
+	int classify_state;           /* 0=not asked, 1=on the worker, 2=published */
+	struct ClassifyJob *classify_job;
+	int map_w, map_h;             /* size the client mapped with, before tiling */
 	uint32_t resize;
 	int pending_resize_w, pending_resize_h;
 	struct wlr_box old_geom;
@@ -1304,6 +1355,7 @@ struct Monitor {
 	uint32_t diag_commits_in;     /* client surface commits on this mon since last heartbeat */
 	uint32_t diag_commit_fails;   /* failed output commit attempts since last heartbeat */
 	uint32_t diag_scanout_falls;  /* scanout->GPU-composition fallbacks engaged since last heartbeat */
+	uint32_t scanout_falls;       /* the same, never reset */
 	uint32_t diag_scanout_rearms; /* direct scanout re-armed (cooldown drained) since last heartbeat */
 	uint64_t diag_xpaint_ns;      /* last XPAINT cross-monitor paint log timestamp */
 	struct wlr_scene_tree *hz_osd_tree;
@@ -1341,6 +1393,8 @@ struct Monitor {
 	int gamescan_stable;                /* consecutive vblanks at that size, no scanout */
 	int gamescan_pending;               /* modeset decided, applied top of next rendermon */
 	int gamescan_mode_active;           /* output currently on the game's mode */
+	int gamescan_from_profile;          /* ...set from a game profile, not yet
+	                                       matched against the game's buffer */
 	int gamescan_failed_w, gamescan_failed_h; /* size with no mode / failed commit */
 	struct wlr_output_mode *gamescan_original;
 	/* Auto FPS lock (autolock.c) */
@@ -1412,6 +1466,7 @@ struct Monitor {
 	int supports_10bit;
 	int render_10bit_active;
 	int game_dropped_10bit;   /* 10-bit dropped for game scanout; restore on exit */
+	int profile_keep_10bit;   /* learned HDR title: skip that drop (gameprofile.c) */
 	int scene_build_failures;
 	/* Commit failure throttle — break infinite retry-loops when the
 	 * kernel refuses a buffer format/modifier (e.g. 10-bit Y-tiled CCS
@@ -1957,37 +2012,13 @@ extern int net_available;
 
 /* icon paths + buffers */
 extern char net_icon_path[PATH_MAX];
-extern char net_icon_loaded_path[PATH_MAX];
 extern char cpu_icon_path[PATH_MAX];
-extern char cpu_icon_loaded_path[PATH_MAX];
 extern char light_icon_path[PATH_MAX];
-extern char light_icon_loaded_path[PATH_MAX];
 extern char ram_icon_path[PATH_MAX];
-extern char ram_icon_loaded_path[PATH_MAX];
 extern char battery_icon_path[PATH_MAX];
-extern char battery_icon_loaded_path[PATH_MAX];
 extern char mic_icon_path[PATH_MAX];
-extern char mic_icon_loaded_path[PATH_MAX];
 extern char volume_icon_path[PATH_MAX];
-extern char volume_icon_loaded_path[PATH_MAX];
 extern char clock_icon_path[PATH_MAX];
-extern char clock_icon_loaded_path[PATH_MAX];
-extern int net_icon_loaded_h, net_icon_w, net_icon_h;
-extern struct wlr_buffer *net_icon_buf;
-extern int clock_icon_loaded_h, clock_icon_w, clock_icon_h;
-extern struct wlr_buffer *clock_icon_buf;
-extern int cpu_icon_loaded_h, cpu_icon_w, cpu_icon_h;
-extern struct wlr_buffer *cpu_icon_buf;
-extern int light_icon_loaded_h, light_icon_w, light_icon_h;
-extern struct wlr_buffer *light_icon_buf;
-extern int ram_icon_loaded_h, ram_icon_w, ram_icon_h;
-extern struct wlr_buffer *ram_icon_buf;
-extern int battery_icon_loaded_h, battery_icon_w, battery_icon_h;
-extern struct wlr_buffer *battery_icon_buf;
-extern int mic_icon_loaded_h, mic_icon_w, mic_icon_h;
-extern struct wlr_buffer *mic_icon_buf;
-extern int volume_icon_loaded_h, volume_icon_w, volume_icon_h;
-extern struct wlr_buffer *volume_icon_buf;
 extern char fan_icon_path[PATH_MAX];
 extern char fan_icon_loaded_path[PATH_MAX];
 extern int fan_icon_loaded_h, fan_icon_w, fan_icon_h;
@@ -2111,6 +2142,7 @@ void draw_border(struct wlr_scene_tree *parent, int x, int y,
 		int w, int h, int thickness, const float color[static 4]);
 void drawroundedrect(struct wlr_scene_tree *parent, int x, int y,
 		int width, int height, const float color[static 4]);
+void scene_count(struct wlr_scene_node *node, int *nodes, int *textures);
 #if 1
 struct wlr_buffer *statusbar_buffer_from_argb32(const uint32_t *data, int width, int height);
 struct wlr_buffer *statusbar_buffer_from_argb32_raw(const uint32_t *data, int width, int height);
@@ -2118,7 +2150,9 @@ struct wlr_buffer *statusbar_scaled_buffer_from_argb32(const uint32_t *data,
 		int width, int height, int target_h);
 struct wlr_buffer *statusbar_scaled_buffer_from_argb32_raw(const uint32_t *data,
 		int width, int height, int target_h);
-struct wlr_buffer *statusbar_buffer_from_glyph(const struct fcft_glyph *glyph);
+struct wlr_buffer *statusbar_label_buffer(const char *text, const float color[static 4],
+		int *left, int *top, int *advance);
+uint32_t *statusbar_argb32_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h);
 struct wlr_buffer *statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h);
 struct wlr_buffer *statusbar_buffer_from_wifi100(int target_h, int *out_w, int *out_h);
 void recolor_wifi100_pixbuf(GdkPixbuf *pixbuf);
@@ -2129,11 +2163,10 @@ int pathisdir(const char *path);
 int strip_symbolic_suffix(const char *name, char *out, size_t outlen);
 void tray_consider_icon(const char *path, int size_hint, int desired_h,
 	char *best_path, int *best_diff, int *found);
-void add_icon_root_paths(const char *base, const char *themes[], size_t theme_count,
-	char pathbufs[][PATH_MAX], size_t *pathcount, size_t max_paths);
 int loadstatusfont(void);
 void freestatusfont(void);
 int status_text_width(const char *text);
+void label_cache_flush(void);
 void fix_tray_argb32(uint32_t *pixels, size_t count, int use_rgba_order);
 #endif
 
@@ -2258,6 +2291,9 @@ void xwayland_set_primary(Monitor *m);
 int is_steam_cmd(const char *cmd);
 int is_game_launcher_child(pid_t pid);
 int is_game_runtime_child(pid_t pid);
+int is_wine_or_proton_process(pid_t pid);
+int is_retro_emulator_pid(pid_t pid);
+void game_place_mapped(Client *c, int initial_w, int initial_h);
 int client_wants_tearing(Client *c);
 void track_client_frame(Client *c);
 float detect_video_framerate(Client *c);
@@ -2346,6 +2382,7 @@ void client_unfreeze(Client *c);
 void client_start_open_anim(Client *c);
 void anim_spawn_close(Monitor *m, struct wlr_buffer *buffer, struct wlr_box geom);
 void closing_anims_tick(Monitor *m, double dt, int *still);
+void closing_anims_drop(void);
 void client_apply_open_anim(Client *c);
 
 /* layout.c */
@@ -2528,8 +2565,7 @@ void rendermic(StatusModule *module, int bar_height, const char *text);
 void rendercpu(StatusModule *module, int bar_height, const char *text);
 void renderram(StatusModule *module, int bar_height, const char *text);
 void render_icon_label(StatusModule *module, int bar_height, const char *text,
-		int (*ensure_icon)(int target_h), struct wlr_buffer **icon_buf,
-		int *icon_w, int *icon_h, int min_text_w, int icon_gap,
+		const char *icon_path, int min_text_w, int icon_gap,
 		const float text_color[static 4]);
 void renderworkspaces(Monitor *m, StatusModule *module, int bar_height);
 int tray_render_label(StatusModule *module, const char *text, int x, int bar_height,
@@ -2556,6 +2592,10 @@ uint32_t random_status_delay_ms(void);
 double volume_last_for_type(int is_headset);
 void volume_cache_store(int is_headset, double level, int muted, uint64_t now);
 int status_should_render(StatusModule *module, int barh, const char *text);
+void status_share_render(StatusShare *share, Monitor *m, StatusModule *module,
+		int barh, void (*render)(StatusModule *module, int bar_height,
+			const char *text), const char *text);
+void status_share_finish(StatusShare *share);
 void clearstatusmodule(StatusModule *module);
 void initial_status_refresh(void);
 void schedule_status_timer(void);
@@ -2566,35 +2606,20 @@ void netlink_monitor_setup(void);
 void trigger_status_task_now(void (*fn)(void));
 void set_status_task_due(void (*fn)(void), uint64_t due_ms);
 void schedule_hover_timer(void);
-int ensure_cpu_icon_buffer(int target_h);
-void drop_cpu_icon_buffer(void);
-int ensure_light_icon_buffer(int target_h);
-void drop_light_icon_buffer(void);
-int ensure_ram_icon_buffer(int target_h);
-void drop_ram_icon_buffer(void);
-int ensure_battery_icon_buffer(int target_h);
-void drop_battery_icon_buffer(void);
-int ensure_clock_icon_buffer(int target_h);
-void drop_clock_icon_buffer(void);
-int ensure_mic_icon_buffer(int target_h);
-void drop_mic_icon_buffer(void);
-void drop_net_icon_buffer(void);
 void init_net_icon_paths(void);
-int ensure_volume_icon_buffer(int target_h);
-void drop_volume_icon_buffer(void);
+struct wlr_buffer *net_icon_buffer(int target_h, int *w, int *h);
+void statusbar_rerender_icon_modules(void);
 void rendercpupopup(Monitor *m);
 void renderrampopup(Monitor *m);
 void renderbatterypopup(Monitor *m);
 int cpu_popup_clamped_x(Monitor *m, CpuPopup *p);
 int cpu_popup_hover_index(Monitor *m, CpuPopup *p);
-int cpu_proc_cmp(const void *a, const void *b);
 int kill_processes_with_name(const char *name);
 int cpu_proc_is_critical(pid_t pid, const char *name);
 int read_top_cpu_processes(CpuPopup *p);
 int cpu_popup_handle_click(Monitor *m, int lx, int ly, uint32_t button);
 int ram_popup_clamped_x(Monitor *m, RamPopup *p);
 int ram_popup_hover_index(Monitor *m, RamPopup *p);
-int ram_proc_cmp(const void *a, const void *b);
 int read_top_ram_processes(RamPopup *p);
 int ram_popup_handle_click(Monitor *m, int lx, int ly, uint32_t button);
 /* read_battery_info is file-local to statusbar.c (static) */
@@ -2646,7 +2671,10 @@ double backlight_percent(void);
 int findbacklightdevice(char *brightness_path, size_t brightness_len,
 		char *max_path, size_t max_len);
 int readfirstline(const char *path, char *buf, size_t len);
+int readlinkspeedmbps(const char *iface, int *out);
+int iface_is_wireless(const char *iface);
 int findbatterydevice(char *capacity_path, size_t capacity_len);
+int readulong(const char *path, unsigned long long *out);
 int findbluetoothdevice(void);
 int cpu_popup_refresh_timeout(void *data);
 void schedule_cpu_popup_refresh(uint32_t ms);
@@ -2670,24 +2698,23 @@ void tray_emit_host_registered(void);
 void tray_menu_clear(TrayMenu *menu);
 void tray_menu_hide(Monitor *m);
 void tray_menu_hide_all(void);
-int tray_item_get_menu_path(TrayItem *it);
 int tray_menu_open_at(Monitor *m, TrayItem *it, int icon_x);
 void tray_menu_render(Monitor *m);
 void tray_menu_draw_text(struct wlr_scene_tree *tree, const char *text, int x, int y, int row_h,
 		int max_w);
 TrayMenuEntry *tray_menu_entry_at(Monitor *m, int lx, int ly);
 void tray_menu_update_hover(Monitor *m, double cx, double cy);
+void tray_menu_prefetch_at(Monitor *m, double cx, double cy);
 int statusbar_popup_at(Monitor *m, double cx, double cy);
 int tray_menu_send_event(TrayMenu *menu, TrayMenuEntry *entry, uint32_t time_msec);
-int tray_menu_parse_node(sd_bus_message *msg, TrayMenu *menu, int depth, int max_depth);
-int tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int max_depth);
+int tray_menu_parse_node(sd_bus_message *msg, struct wl_list *entries, int depth, int max_depth);
+int tray_menu_parse_node_body(sd_bus_message *msg, struct wl_list *entries, int depth,
+		int max_depth);
 void tray_sanitize_label(const char *src, char *dst, size_t len);
-int tray_search_item_path(const char *service, const char *start_path,
-		char *out, size_t outlen, int depth);
-int tray_find_item_path(const char *service, char *path, size_t pathlen);
 void tray_add_item(const char *service, const char *path, int emit_signals);
 void tray_scan_existing_items(void);
 void tray_update_icons_text(void);
+void tray_item_pixmap_ready(TrayItem *it, struct wlr_buffer *buf, uint64_t hash);
 void tray_remove_item(const char *service);
 int tray_name_owner_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
 void tray_init(void);
@@ -2878,17 +2905,22 @@ int launchfx_cover_headstart_remaining(void);
 void launchfx_game_ready(void);
 void launchfx_note_commit(Client *c);
 int launchfx_active(void);
+uint32_t launchfx_appid(void);
+void launchfx_note_exec(pid_t pid, const char *comm);
 
 /* osd.c — compositor-drawn toast notifications */
 void osd_show(Monitor *m, const char *msg);
 void osd_show_force(Monitor *m, const char *msg);
 void osd_tick(Monitor *m, double dt, int *still);
 void osd_purge_mon(Monitor *m);
+void osd_scene_count(Monitor *m, int *nodes, int *textures);
 void schedule_game_mode_update(void);
 void gm_bg_init(void);
 void gm_bg_cleanup(void);
+void gm_reclaim_frozen(void);
 /* Async-signal-safe: unfreeze/unthrottle everything from a fatal handler */
 void gm_emergency_restore(void);
+int get_memory_pressure(void);
 void freeze_background_processes(void);
 void unfreeze_background_processes(void);
 void apply_cpu_affinity(pid_t game_pid);
@@ -2917,6 +2949,192 @@ void apptoggle_cleanup(void);
 void mic_watch_setup(void);
 void mic_watch_cleanup(void);
 
+/* procstat.c — incremental /proc sampler for the CPU/RAM popups */
+int procstat_sample(void);
+int procstat_top(ProcGroup *out, int k, int by_rss,
+		int (*keep)(pid_t pid, const char *name, unsigned long rss_kb));
+void procstat_cleanup(void);
+
+/* pw_audio.c — native PipeWire volume/mute tracking (wpctl fallback) */
+void pw_audio_setup(void);
+void pw_audio_cleanup(void);
+int pw_audio_get(int is_source, double *percent, int *muted, int *headset);
+int pw_audio_set_volume(int is_source, double percent);
+int pw_audio_set_mute(int is_source, int mute);
+
+/* netwatch.c — rtnetlink/nl80211 network state for the net module */
+typedef struct {
+	char iface[IF_NAMESIZE];
+	int ifindex;
+	int wireless;
+	int speed_mbps;
+	char ip[INET_ADDRSTRLEN];
+	char ssid[64];
+	int ssid_native;           /* SSID comes from nl80211, not a helper */
+	double quality;
+} NetState;
+void netwatch_setup(void);
+void netwatch_cleanup(void);
+int netwatch_state(NetState *out);
+int netwatch_link_stats(int ifindex, unsigned long long *rx, unsigned long long *tx,
+		uint64_t *sample_ms);
+
+/* icon_cache.c — shared status icon rasters, on-disk cache, SVG worker */
+#define ICON_CACHE_WIFI100 (1 << 0) /* synthesize the wifi_100 bars */
+struct wlr_buffer *icon_cache_get(const char *path, int target_h, int flags,
+		int *w, int *h);
+void icon_cache_flush(void);
+void icon_cache_cleanup(void);
+
+/* tray_pixmap.c — SNI IconPixmap decoding on a worker thread */
+enum { TRAY_PIXMAP_AUTO = -1, TRAY_PIXMAP_SCALAR, TRAY_PIXMAP_SSE2, TRAY_PIXMAP_AVX2 };
+int tray_pixmap_set_isa(int isa);
+uint32_t tray_pixmap_convert(uint32_t *dst, const uint32_t *src, size_t n, int rgba);
+uint32_t *tray_pixmap_box_reduce(const uint32_t *src, int w, int h, int k,
+		int *out_w, int *out_h);
+int tray_pixmap_decode(TrayItem *it, sd_bus_message *msg, const void *data,
+		int w, int h, int target_h);
+void tray_pixmap_cleanup(void);
+
+/* icon_theme.c — persistent, inotify-invalidated icon theme index */
+int icon_theme_ready(void);
+int icon_theme_lookup(const char *name, int desired_h, char *out, size_t outlen,
+		int *diff);
+void icon_theme_cleanup(void);
+
+/* uevent_watch.c — kernel uevents for battery/backlight, coalesced brightness writes */
+void uevent_watch_setup(void);
+void uevent_watch_cleanup(void);
+int uevent_watch_active(void);
+int uevent_watch_battery(double *percent);
+int uevent_watch_backlight(double *percent);
+int backlight_queue_percent(double percent);
+
+/* proctable.c — process table kept current from the netlink proc connector */
+typedef struct {
+	pid_t pid;
+	pid_t ppid;
+	uid_t uid;                 /* effective */
+	unsigned long long start;  /* clock ticks since boot */
+	char comm[16];
+} ProcInfo;
+void proctable_setup(void);
+void proctable_cleanup(void);
+int proctable_live(void);
+void proctable_refresh(void);
+int proctable_get(pid_t pid, ProcInfo *out);
+int proctable_exe(pid_t pid, char *out, size_t len);
+int proctable_running(const char *name, int substr);
+int proctable_is_descendant(pid_t pid, pid_t ancestor);
+int proctable_ancestry_matches(pid_t pid, const char *const *needles, int exact, int self);
+int proctable_snapshot(ProcInfo **out);
+
+/* cputopo.c — L3 domain / core / thread topology and placement policies */
+#define CPUTOPO_MAX_DOMAINS 16
+/* CPU_SETSIZE, which is hidden from files including libc before this header */
+#define CPUTOPO_MAX_CPUS (8 * (int)sizeof(cpu_set_t))
+typedef struct {
+	cpu_set_t cpus;            /* online CPUs sharing one L3 */
+	unsigned l3_kb;            /* 0 when the L3 is not described */
+	int capacity;              /* largest cpu_capacity in the domain */
+} CpuDomain;
+typedef struct {
+	int ncpus;                 /* highest online CPU + 1 */
+	cpu_set_t online;
+	cpu_set_t pcores, ecores;  /* both empty unless cores are asymmetric */
+	int ndomains;
+	CpuDomain dom[CPUTOPO_MAX_DOMAINS];
+	short dom_of[CPUTOPO_MAX_CPUS]; /* CPU → domain index, -1 if offline */
+	short core_of[CPUTOPO_MAX_CPUS]; /* CPU → lowest SMT sibling, -1 if offline */
+	int capacity[CPUTOPO_MAX_CPUS]; /* cpu_capacity, 1024 when not exposed */
+} CpuTopo;
+int cputopo_load(CpuTopo *t, const char *root);
+const CpuTopo *cputopo_get(void);
+int cputopo_game_set(const CpuTopo *t, cpu_set_t *out);
+int cputopo_compositor_set(const CpuTopo *t, const cpu_set_t *game, cpu_set_t *out);
+int cputopo_background_set(const CpuTopo *t, const cpu_set_t *game, cpu_set_t *out);
+void cputopo_format(const cpu_set_t *set, char *buf, size_t len);
+void cputopo_describe(const CpuTopo *t, char *buf, size_t len);
+
+/* psiwatch.c — PSI memory/io stall triggers with escalating relief */
+void psiwatch_setup(void);
+void psiwatch_cleanup(void);
+
+/* gamethreads.c — per-thread scheduling classes for the game process */
+void gamethreads_apply(pid_t pid);
+void gamethreads_rescan(void);
+void gamethreads_restore(void);
+
+/* nvml.c — NVIDIA telemetry and power control via a dlopen'd libnvidia-ml */
+typedef struct {
+	unsigned gpu_util, mem_util;  /* percent */
+	unsigned temp_c;
+	unsigned gfx_mhz, mem_mhz;
+	unsigned power_mw, limit_mw;  /* limit 0 when not reported */
+	int pstate;                   /* P-state number, -1 unknown */
+} NvmlTelemetry;
+int nvml_open(const char *pci_slot);
+void nvml_close(void);
+int nvml_index(void);
+int nvml_telemetry(NvmlTelemetry *t);
+int nvml_persistence(int *on);
+int nvml_set_persistence(int on);
+int nvml_power_limit(unsigned *cur_mw, unsigned *max_mw);
+int nvml_set_power_limit(unsigned mw);
+int nvml_max_clocks(unsigned *gfx_mhz, unsigned *mem_mhz);
+int nvml_lock_gpu_clocks(unsigned mhz);
+int nvml_lock_mem_clocks(unsigned mhz);
+int nvml_compute_mode_default(void);
+
+/* gpustat.c — sysfs (amdgpu, i915, xe) / NVML GPU telemetry worker */
+typedef struct {
+	GpuVendor vendor;
+	int busy, mem_busy;           /* percent, -1 unknown */
+	int gfx_mhz, mem_mhz;         /* 0 unknown */
+	int temp_c;                   /* -1 unknown */
+	unsigned power_mw;            /* 0 unknown */
+	int suspended;                /* runtime-suspended, nothing read */
+	uint64_t ns;                  /* get_time_ns() of the sample */
+} GpuStat;
+extern int gpustat_interval_ms; /* config `gpu-stats-interval-ms`, 0 = off */
+int gpustat_open(const char *root, const GpuInfo *gpu);
+int gpustat_sample(GpuStat *s);
+void gpustat_setup(void);
+void gpustat_cleanup(void);
+void gpustat_set_interval(int ms);
+void gpustat_kick(void);
+int gpustat_get(GpuStat *s);
+const char *gpustat_bound(int busy);
+
+/* gpuclients.c — per-process GPU engine time and VRAM from DRM fdinfo */
+typedef struct {
+	pid_t pid;
+	char comm[16];
+	int busy;                     /* busiest engine, percent; -1 unknown */
+	char engine[16];              /* that engine's fdinfo name */
+	uint64_t vram_kib;
+} GpuClient;
+int gpuclients_scan(const char *proc_root);
+int gpuclients_top(GpuClient *out, int max);
+int gpuclients_busy(pid_t pid);
+void gpuclients_cleanup(void);
+
+/* gameprofile.c — per-title learned mode, lock, span and scanout state */
+void gameprofile_begin(Client *c);
+void gameprofile_apply(Client *c);
+void gameprofile_learn(Client *c);
+
+/* classify.c — pid-based client verdicts computed off the compositor thread */
+void classify_client(Client *c);
+int classify_client_ready(Client *c);
+void classify_client_forget(Client *c);
+void classify_cleanup(void);
+
+/* statusbar_flat.c — optional single-buffer, damage-tracked status bar */
+extern int statusbar_flat_enabled;
+void statusbar_flat_schedule(void);
+void statusbar_flat_cleanup(Monitor *m);
+
 /* nixlytile.c */
 void steam_set_ge_proton_default(void);
 
@@ -0,0 +1,261 @@
+/*
+ * nvml.c — NVIDIA telemetry and power control through libnvidia-ml.
+ *
+ * Game-mode tuning and the diag heartbeat used to fork nvidia-smi (and
+ * nvidia-settings) for every query and every setter and parse its CSV:
+ * tens of milliseconds each, up to eight of them just to map the PCI slot
+ * to an nvidia-smi index.  NVML is the library nvidia-smi itself sits on.
+ * It is loaded with dlopen on first use — the driver ships it, nothing
+ * links against it — and the device handle is kept, so a read or a
+ * clock/power-limit change is one library call.
+ *
+ * When the library or one of its entry points is missing every call
+ * returns -1 and the callers keep their nvidia-smi path.
+ * NIXLY_NVML_LIB names a different library to load, e.g. a stub that
+ * returns scripted values.
+ *
+ * Only the slice of the NVML ABI used here is declared; the values are
+ * the ones in nvml.h.  NVML is thread-safe, so the gm-bg worker (tuning)
+ * and the compositor thread (diag) share the handle.
+ */
+#include "nixlytile.h"
+
+#include <dlfcn.h>
+
+typedef int nvmlReturn_t;                 /* NVML_SUCCESS = 0 */
+typedef struct nvmlDevice_st *nvmlDevice_t;
+typedef struct {
+	unsigned int gpu;
+	unsigned int memory;
+} nvmlUtilization_t;
+
+enum { NVML_TEMPERATURE_GPU = 0 };
+enum { NVML_CLOCK_GRAPHICS = 0, NVML_CLOCK_MEM = 2 };
+enum { NVML_COMPUTEMODE_DEFAULT = 0 };
+enum { NVML_PSTATE_UNKNOWN = 32 };
+
+static struct {
+	void *lib;
+	nvmlDevice_t dev;
+	unsigned index;
+	nvmlReturn_t (*Init)(void);
+	nvmlReturn_t (*Shutdown)(void);
+	nvmlReturn_t (*GetHandleByPciBusId)(const char *, nvmlDevice_t *);
+	nvmlReturn_t (*GetIndex)(nvmlDevice_t, unsigned *);
+	nvmlReturn_t (*GetUtilizationRates)(nvmlDevice_t, nvmlUtilization_t *);
+	nvmlReturn_t (*GetTemperature)(nvmlDevice_t, int, unsigned *);
+	nvmlReturn_t (*GetClockInfo)(nvmlDevice_t, int, unsigned *);
+	nvmlReturn_t (*GetMaxClockInfo)(nvmlDevice_t, int, unsigned *);
+	nvmlReturn_t (*GetPowerUsage)(nvmlDevice_t, unsigned *);
+	nvmlReturn_t (*GetPerformanceState)(nvmlDevice_t, int *);
+	/* setters and their getters; any may be missing on old drivers */
+	nvmlReturn_t (*GetPowerLimit)(nvmlDevice_t, unsigned *);
+	nvmlReturn_t (*GetPowerLimitConstraints)(nvmlDevice_t, unsigned *, unsigned *);
+	nvmlReturn_t (*SetPowerLimit)(nvmlDevice_t, unsigned);
+	nvmlReturn_t (*GetPersistenceMode)(nvmlDevice_t, int *);
+	nvmlReturn_t (*SetPersistenceMode)(nvmlDevice_t, int);
+	nvmlReturn_t (*SetGpuLockedClocks)(nvmlDevice_t, unsigned, unsigned);
+	nvmlReturn_t (*ResetGpuLockedClocks)(nvmlDevice_t);
+	nvmlReturn_t (*SetMemoryLockedClocks)(nvmlDevice_t, unsigned, unsigned);
+	nvmlReturn_t (*ResetMemoryLockedClocks)(nvmlDevice_t);
+	nvmlReturn_t (*SetComputeMode)(nvmlDevice_t, int);
+} nv;
+
+static pthread_mutex_t nv_lock = PTHREAD_MUTEX_INITIALIZER;
+static int nv_tried;
+
+#define NV_SYM(field, name) \
+	(*(void **)&nv.field = dlsym(nv.lib, name))
+
+static int
+nv_load(const char *pci_slot)
+{
+	const char *path = getenv("NIXLY_NVML_LIB");
+
+	if (!(nv.lib = dlopen(path && *path ? path : "libnvidia-ml.so.1",
+			RTLD_NOW | RTLD_LOCAL)))
+		return -1;
+	/* telemetry: all or nothing */
+	if (!NV_SYM(Init, "nvmlInit_v2") || !NV_SYM(Shutdown, "nvmlShutdown")
+			|| !NV_SYM(GetHandleByPciBusId, "nvmlDeviceGetHandleByPciBusId_v2")
+			|| !NV_SYM(GetIndex, "nvmlDeviceGetIndex")
+			|| !NV_SYM(GetUtilizationRates, "nvmlDeviceGetUtilizationRates")
+			|| !NV_SYM(GetTemperature, "nvmlDeviceGetTemperature")
+			|| !NV_SYM(GetClockInfo, "nvmlDeviceGetClockInfo")
+			|| !NV_SYM(GetMaxClockInfo, "nvmlDeviceGetMaxClockInfo")
+			|| !NV_SYM(GetPowerUsage, "nvmlDeviceGetPowerUsage")
+			|| !NV_SYM(GetPerformanceState, "nvmlDeviceGetPerformanceState"))
+		goto fail;
+	NV_SYM(GetPowerLimit, "nvmlDeviceGetPowerManagementLimit");
+	NV_SYM(GetPowerLimitConstraints, "nvmlDeviceGetPowerManagementLimitConstraints");
+	NV_SYM(SetPowerLimit, "nvmlDeviceSetPowerManagementLimit");
+	NV_SYM(GetPersistenceMode, "nvmlDeviceGetPersistenceMode");
+	NV_SYM(SetPersistenceMode, "nvmlDeviceSetPersistenceMode");
+	NV_SYM(SetGpuLockedClocks, "nvmlDeviceSetGpuLockedClocks");
+	NV_SYM(ResetGpuLockedClocks, "nvmlDeviceResetGpuLockedClocks");
+	NV_SYM(SetMemoryLockedClocks, "nvmlDeviceSetMemoryLockedClocks");
+	NV_SYM(ResetMemoryLockedClocks, "nvmlDeviceResetMemoryLockedClocks");
+	NV_SYM(SetComputeMode, "nvmlDeviceSetComputeMode");
+
+	if (nv.Init() != 0)
+		goto fail;
+	/* accepts our "0000:01:00.0" as well as its own 8-digit domain */
+	if (nv.GetHandleByPciBusId(pci_slot, &nv.dev) != 0
+			|| nv.GetIndex(nv.dev, &nv.index) != 0) {
+		nv.Shutdown();
+		goto fail;
+	}
+	return 0;
+
+fail:
+	dlclose(nv.lib);
+	memset(&nv, 0, sizeof(nv));
+	return -1;
+}
+
+/* Open NVML for the GPU at pci_slot.  Tried once; later calls only
+ * report the outcome.  Returns 0 when the device handle is usable. */
+int
+nvml_open(const char *pci_slot)
+{
+	int ret;
+
+	pthread_mutex_lock(&nv_lock);
+	if (!nv_tried && pci_slot && *pci_slot) {
+		uint64_t t0 = get_time_ns();
+
+		nv_tried = 1;
+		if (nv_load(pci_slot) == 0)
+			wlr_log(WLR_INFO, "NVML: %s is device %u (opened in %llu us)",
+				pci_slot, nv.index,
+				(unsigned long long)((get_time_ns() - t0) / 1000));
+		else
+			wlr_log(WLR_INFO, "NVML: unavailable for %s — using nvidia-smi",
+				pci_slot);
+	}
+	ret = nv.dev ? 0 : -1;
+	pthread_mutex_unlock(&nv_lock);
+	return ret;
+}
+
+void
+nvml_close(void)
+{
+	pthread_mutex_lock(&nv_lock);
+	if (nv.dev) {
+		nv.Shutdown();
+		dlclose(nv.lib);
+		memset(&nv, 0, sizeof(nv));
+	}
+	pthread_mutex_unlock(&nv_lock);
+}
+
+/* nvidia-smi / nvidia-settings index of the device (same enumeration) */
+int
+nvml_index(void)
+{
+	return nv.dev ? (int)nv.index : -1;
+}
+
+int
+nvml_telemetry(NvmlTelemetry *t)
+{
+	nvmlUtilization_t util;
+	int pstate;
+
+	if (!nv.dev)
+		return -1;
+	memset(t, 0, sizeof(*t));
+	t->pstate = -1;
+	if (nv.GetUtilizationRates(nv.dev, &util) != 0)
+		return -1;
+	t->gpu_util = util.gpu;
+	t->mem_util = util.memory;
+	nv.GetTemperature(nv.dev, NVML_TEMPERATURE_GPU, &t->temp_c);
+	nv.GetClockInfo(nv.dev, NVML_CLOCK_GRAPHICS, &t->gfx_mhz);
+	nv.GetClockInfo(nv.dev, NVML_CLOCK_MEM, &t->mem_mhz);
+	nv.GetPowerUsage(nv.dev, &t->power_mw);
+	if (nv.GetPowerLimit)
+		nv.GetPowerLimit(nv.dev, &t->limit_mw);
+	if (nv.GetPerformanceState(nv.dev, &pstate) == 0 && pstate != NVML_PSTATE_UNKNOWN)
+		t->pstate = pstate;
+	return 0;
+}
+
+int
+nvml_persistence(int *on)
+{
+	if (!nv.dev || !nv.GetPersistenceMode)
+		return -1;
+	return nv.GetPersistenceMode(nv.dev, on) == 0 ? 0 : -1;
+}
+
+int
+nvml_set_persistence(int on)
+{
+	if (!nv.dev || !nv.SetPersistenceMode)
+		return -1;
+	return nv.SetPersistenceMode(nv.dev, on) == 0 ? 0 : -1;
+}
+
+/* Current and maximum power limit in mW. */
+int
+nvml_power_limit(unsigned *cur_mw, unsigned *max_mw)
+{
+	unsigned min_mw;
+
+	if (!nv.dev || !nv.GetPowerLimit || !nv.GetPowerLimitConstraints)
+		return -1;
+	if (nv.GetPowerLimit(nv.dev, cur_mw) != 0
+			|| nv.GetPowerLimitConstraints(nv.dev, &min_mw, max_mw) != 0)
+		return -1;
+	return 0;
+}
+
+int
+nvml_set_power_limit(unsigned mw)
+{
+	if (!nv.dev || !nv.SetPowerLimit)
+		return -1;
+	return nv.SetPowerLimit(nv.dev, mw) == 0 ? 0 : -1;
+}
+
+int
+nvml_max_clocks(unsigned *gfx_mhz, unsigned *mem_mhz)
+{
+	if (!nv.dev)
+		return -1;
+	if (nv.GetMaxClockInfo(nv.dev, NVML_CLOCK_GRAPHICS, gfx_mhz) != 0
+			|| nv.GetMaxClockInfo(nv.dev, NVML_CLOCK_MEM, mem_mhz) != 0)
+		return -1;
+	return 0;
+}
+
+/* Lock the graphics / memory clock to one frequency; 0 releases it. */
+int
+nvml_lock_gpu_clocks(unsigned mhz)
+{
+	if (!nv.dev || !nv.SetGpuLockedClocks || !nv.ResetGpuLockedClocks)
+		return -1;
+	if (!mhz)
+		return nv.ResetGpuLockedClocks(nv.dev) == 0 ? 0 : -1;
+	return nv.SetGpuLockedClocks(nv.dev, mhz, mhz) == 0 ? 0 : -1;
+}
+
+int
+nvml_lock_mem_clocks(unsigned mhz)
+{
+	if (!nv.dev || !nv.SetMemoryLockedClocks || !nv.ResetMemoryLockedClocks)
+		return -1;
+	if (!mhz)
+		return nv.ResetMemoryLockedClocks(nv.dev) == 0 ? 0 : -1;
+	return nv.SetMemoryLockedClocks(nv.dev, mhz, mhz) == 0 ? 0 : -1;
+}
+
+int
+nvml_compute_mode_default(void)
+{
+	if (!nv.dev || !nv.SetComputeMode)
+		return -1;
+	return nv.SetComputeMode(nv.dev, NVML_COMPUTEMODE_DEFAULT) == 0 ? 0 : -1;
+}
@@ -143,52 +143,21 @@ make_card_buffer(int w, int h)
 static int
 toast_build(Toast *t, const char *msg)
 {
-	tll(struct GlyphRun) glyphs = tll_init();
-	const struct fcft_glyph *glyph;
 	struct wlr_scene_buffer *scene_buf;
-	struct wlr_buffer *buffer;
+	struct wlr_buffer *buffer, *text_buf;
 	struct wlr_scene_node *node, *tmp;
-	uint32_t prev_cp = 0;
-	int pen_x = 0;
-	int min_y = INT_MAX, max_y = INT_MIN;
+	int left, top, advance;
 	int text_x;
 
 	if (!statusfont.font || !msg || !*msg)
 		return 0;
 
-	for (size_t i = 0; msg[i]; i++) {
-		long kern_x = 0, kern_y = 0;
-		uint32_t cp = (unsigned char)msg[i];
-
-		if (prev_cp)
-			fcft_kerning(statusfont.font, prev_cp, cp, &kern_x, &kern_y);
-		pen_x += (int)kern_x;
-
-		glyph = fcft_rasterize_char_utf32(statusfont.font, cp,
-				statusbar_font_subpixel);
-		if (glyph && glyph->pix) {
-			tll_push_back(glyphs, ((struct GlyphRun){
-				.glyph = glyph,
-				.pen_x = pen_x,
-				.codepoint = cp,
-			}));
-			if (-glyph->y < min_y)
-				min_y = -glyph->y;
-			if (-glyph->y + (int)glyph->height > max_y)
-				max_y = -glyph->y + (int)glyph->height;
-		}
-		if (glyph)
-			pen_x += glyph->advance.x;
-		prev_cp = cp;
-	}
-
-	if (tll_length(glyphs) == 0) {
-		tll_free(glyphs);
+	text_buf = statusbar_label_buffer(msg, statusbar_fg, &left, &top, &advance);
+	if (!text_buf)
 		return 0;
-	}
 
-	t->w = pen_x + OSD_ACCENT_W + OSD_PAD_X * 2;
-	t->h = (max_y - min_y) + OSD_PAD_Y * 2;
+	t->w = advance + OSD_ACCENT_W + OSD_PAD_X * 2;
+	t->h = text_buf->height + OSD_PAD_Y * 2;
 	text_x = OSD_ACCENT_W + OSD_PAD_X;
 
 	wl_list_for_each_safe(node, tmp, &t->tree->children, link)
@@ -204,26 +173,12 @@ toast_build(Toast *t, const char *msg)
 		wlr_buffer_drop(buffer);
 	}
 
-	{
-		int origin_y = OSD_PAD_Y - min_y;
-
-		tll_foreach(glyphs, it) {
-			glyph = it->item.glyph;
-			buffer = statusbar_buffer_from_glyph(glyph);
-			if (!buffer)
-				continue;
-			scene_buf = wlr_scene_buffer_create(t->tree, NULL);
-			if (scene_buf) {
-				wlr_scene_buffer_set_buffer(scene_buf, buffer);
-				wlr_scene_node_set_position(&scene_buf->node,
-						text_x + it->item.pen_x + glyph->x,
-						origin_y - glyph->y);
-			}
-			wlr_buffer_drop(buffer);
-		}
+	scene_buf = wlr_scene_buffer_create(t->tree, NULL);
+	if (scene_buf) {
+		wlr_scene_buffer_set_buffer(scene_buf, text_buf);
+		wlr_scene_node_set_position(&scene_buf->node,
+				text_x + left, OSD_PAD_Y);
 	}
-
-	tll_free(glyphs);
 	return 1;
 }
 
@@ -370,3 +325,14 @@ osd_purge_mon(Monitor *m)
 		if (t->m == m)
 			toast_destroy(t);
 }
+
+/* Scene cost of m's toasts, for the diag TEXT line. */
+void
+osd_scene_count(Monitor *m, int *nodes, int *textures)
+{
+	Toast *t;
+
+	wl_list_for_each(t, &toasts, link)
+		if (t->m == m && t->tree)
+			scene_count(&t->tree->node, nodes, textures);
+}
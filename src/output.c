@@ -1759,6 +1759,20 @@ track_game_frame_pacing(Monitor *m, uint64_t frame_start_ns)
 
 		/* Only track reasonable intervals (3ms - 100ms = ~10-333fps) */
 		if (game_interval > 3000000 && game_interval < 100000000) {
+			/* Slow frame: over twice the running average.  Tag it
+			 * with the GPU's recent load so GPU-bound and CPU-bound
+			 * stutter read apart in the log. */
+			if (m->game_frame_interval_count >= 4 && m->estimated_game_fps > 0.0f
+					&& (float)game_interval * m->estimated_game_fps > 2e9f) {
+				GpuStat gst;
+				int busy = gpustat_get(&gst) == 0 ? gst.busy : -1;
+
+				diag_logf("GAMEHITCH",
+					"%s frame=%.2fms avg=%.2fms gpu_busy=%d gfx=%dMHz bound=%s",
+					m->wlr_output->name, game_interval / 1e6,
+					1000.0 / m->estimated_game_fps, busy,
+					busy >= 0 ? gst.gfx_mhz : 0, gpustat_bound(busy));
+			}
 			m->game_frame_intervals[m->game_frame_interval_idx] = game_interval;
 			m->game_frame_interval_idx = (m->game_frame_interval_idx + 1) % 16;
 			if (m->game_frame_interval_count < 16)
@@ -2183,6 +2197,7 @@ commit_output_frame(Monitor *m, struct wlr_output_state *state, int allow_tearin
 					if (!m->scanout_blacklist) {
 						m->scanout_blacklist = 1;
 						m->diag_scanout_falls++;
+						m->scanout_falls++;
 					}
 					/* Re-arm after ~600 good commits (~10s @ 60Hz).
 					 * The old 1u<<30 hold kept every 4K frame going
@@ -2311,6 +2326,7 @@ commit_output_frame(Monitor *m, struct wlr_output_state *state, int allow_tearin
 						commit_errno, strerror(commit_errno));
 					m->scanout_blacklist = 1;
 					m->diag_scanout_falls++;
+					m->scanout_falls++;
 					/* Hold the fallback for the rest of this fullscreen
 					 * session so we don't re-arm direct scanout on the
 					 * very next good commit and flap back into the failing
@@ -2759,8 +2775,9 @@ rendermon(struct wl_listener *listener, void *data)
 	 * falls back to GPU composition every frame.  Scanout is the single
 	 * biggest win for game latency/pacing — drop to 8-bit while a
 	 * fullscreen game is up and restore 10-bit when it leaves.  Games
-	 * render 8-bit anyway, so nothing is lost visually. */
-	if (is_game && m->render_10bit_active) {
+	 * render 8-bit anyway, so nothing is lost visually.  Not for a title
+	 * known to go HDR: that would take the deep format straight back. */
+	if (is_game && m->render_10bit_active && !m->profile_keep_10bit) {
 		struct wlr_output_state fmt;
 		wlr_output_state_init(&fmt);
 		wlr_output_state_set_render_format(&fmt, DRM_FORMAT_XRGB8888);
@@ -2799,13 +2816,15 @@ rendermon(struct wl_listener *listener, void *data)
 		const char *appid = fc ? client_get_appid(fc) : NULL;
 		unsigned long long presents = m->frames_presented - m->diag_presented0;
 		struct wlr_box fcnat = {0};
+		GpuStat gst;
+		int gpu_busy = gpustat_get(&gst) == 0 ? gst.busy : -1;
 		if (fc)
 			client_get_geometry(fc, &fcnat);
 
 		diag_logf("MON",
 			"%s fs=%s cls=%s vblanks=%u builds=%u idle_skip=%u "
 			"client_commits=%u presents=%llu/s dropped=%lu held=%lu "
-			"cadence=%d vrr=%d gvrr=%d gfps=%.0f alock=%d pace=%d "
+			"cadence=%d vrr=%d gvrr=%d gfps=%.0f gpu=%d alock=%d pace=%d "
 			"scanout=%d hdr=%d 10bit=%d "
 			"commit_fail=%u commitfail_ev=%u scanout_fall=%u scanout_rearm=%u "
 			"scanout_bl=%d scene_fail=%d geom=%dx%d@%d,%d surf=%dx%d mm=%dx%d@%d,%d",
@@ -2815,7 +2834,7 @@ rendermon(struct wl_listener *listener, void *data)
 			m->diag_commits_in, presents,
 			(unsigned long)m->frames_dropped, (unsigned long)m->frames_held,
 			m->video_cadence_active, m->vrr_active,
-			m->game_vrr_active, m->estimated_game_fps,
+			m->game_vrr_active, m->estimated_game_fps, gpu_busy,
 			m->al_lock_fps, m->frame_pacing_active,
 			m->direct_scanout_active,
 			m->hdr_active, m->render_10bit_active,
@@ -2852,6 +2871,26 @@ rendermon(struct wl_listener *listener, void *data)
 				m->diag_commits_in);
 		}
 
+		/* What compositor-drawn text costs the scene graph: nodes and
+		 * textures under the bar (popups and tray menu included) and
+		 * this monitor's toasts. */
+		{
+			int bar_n = 0, bar_t = 0, cpu_n = 0, cpu_t = 0;
+			int osd_n = 0, osd_t = 0;
+
+			if (m->statusbar.tree)
+				scene_count(&m->statusbar.tree->node, &bar_n, &bar_t);
+			if (m->statusbar.cpu_popup.tree)
+				scene_count(&m->statusbar.cpu_popup.tree->node,
+						&cpu_n, &cpu_t);
+			osd_scene_count(m, &osd_n, &osd_t);
+			diag_logf("TEXT",
+				"%s bar nodes=%d textures=%d (cpu_popup %d/%d) "
+				"toasts nodes=%d textures=%d",
+				m->wlr_output->name, bar_n, bar_t, cpu_n, cpu_t,
+				osd_n, osd_t);
+		}
+
 		/* Cross-edge audit: any enabled client scene node whose geometry
 		 * crosses this monitor's horizontal bounds can paint onto the
 		 * neighbouring output (visible in its gap margin).  Log the
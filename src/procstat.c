@@ -0,0 +1,401 @@
+/*
+ * procstat.c — incremental /proc sampler behind the CPU and RAM popups.
+ *
+ * Replaces the `top -bn1 | tail | head` and `ps --sort=-rss` pipelines:
+ * every tick reads /proc/<pid>/stat once per process (pread on a cached
+ * fd where the fd budget allows), keeps utime+stime between ticks so
+ * %CPU is a real per-interval delta, and answers top-K queries grouped
+ * by comm with a bounded insertion select instead of a full sort.
+ */
+#include "nixlytile.h"
+
+/* Samples closer together than this are served from the last tick —
+ * the CPU and RAM popups both pull on the same refresh cadence. */
+#define PROCSTAT_MIN_INTERVAL_MS  200
+/* Previous tick older than this: deltas would be a long-term average,
+ * so the caller should re-sample shortly. */
+#define PROCSTAT_STALE_MS         5000
+
+typedef struct {
+	pid_t pid;
+	int fd;                          /* cached /proc/<pid>/stat, or -1 */
+	unsigned long long starttime;    /* detects pid reuse */
+	unsigned long long ticks;        /* utime + stime */
+	double cpu;                      /* %CPU over the last interval */
+	unsigned long rss_kb;
+	char comm[64];
+} ProcStatEntry;
+
+static ProcStatEntry *ps_cur, *ps_next;
+static int ps_cur_n, ps_cap;
+/* pid -> index into ps_cur, open addressing, size is a power of two */
+static int *ps_index;
+static size_t ps_index_size;
+static int ps_proc_fd = -1;
+static int ps_fd_budget = -1;
+static int ps_fds_open;
+static uint64_t ps_last_ms;
+static int ps_have_prev;
+static long ps_clk_tck;
+static long ps_page_kb;
+
+static size_t
+ps_hash_pid(pid_t pid, size_t size)
+{
+	return ((uint32_t)pid * 2654435761u) & (size - 1);
+}
+
+static int
+ps_lookup(pid_t pid)
+{
+	size_t h;
+
+	if (!ps_index)
+		return -1;
+	for (h = ps_hash_pid(pid, ps_index_size);; h = (h + 1) & (ps_index_size - 1)) {
+		int idx = ps_index[h];
+		if (idx < 0)
+			return -1;
+		if (ps_cur[idx].pid == pid)
+			return idx;
+	}
+}
+
+static void
+ps_rebuild_index(void)
+{
+	size_t want = 1024;
+
+	while (want < (size_t)ps_cur_n * 2)
+		want <<= 1;
+	if (want != ps_index_size) {
+		free(ps_index);
+		ps_index = ecalloc(want, sizeof(*ps_index));
+		ps_index_size = want;
+	}
+	memset(ps_index, 0xff, ps_index_size * sizeof(*ps_index));
+	for (int i = 0; i < ps_cur_n; i++) {
+		size_t h = ps_hash_pid(ps_cur[i].pid, ps_index_size);
+		while (ps_index[h] >= 0)
+			h = (h + 1) & (ps_index_size - 1);
+		ps_index[h] = i;
+	}
+}
+
+static void
+ps_reserve(int n)
+{
+	if (n <= ps_cap)
+		return;
+	ps_cap = ps_cap ? ps_cap : 512;
+	while (ps_cap < n)
+		ps_cap *= 2;
+	ps_cur = realloc(ps_cur, (size_t)ps_cap * sizeof(*ps_cur));
+	ps_next = realloc(ps_next, (size_t)ps_cap * sizeof(*ps_next));
+	if (!ps_cur || !ps_next)
+		die("procstat: out of memory");
+}
+
+/* Keep a quarter of the soft fd limit for cached stat fds: the
+ * compositor's own clients need the rest. */
+static void
+ps_init_once(void)
+{
+	struct rlimit rl;
+
+	if (ps_fd_budget >= 0)
+		return;
+	ps_clk_tck = sysconf(_SC_CLK_TCK);
+	if (ps_clk_tck <= 0)
+		ps_clk_tck = 100;
+	ps_page_kb = sysconf(_SC_PAGESIZE) / 1024;
+	if (ps_page_kb <= 0)
+		ps_page_kb = 4;
+	ps_fd_budget = 256;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+		ps_fd_budget = (int)MIN(rl.rlim_cur / 4, 4096);
+}
+
+/* Parse the fields after "pid (comm) ". comm may itself contain spaces
+ * and parentheses, so split on the LAST ')'. */
+static int
+ps_parse_stat(const char *buf, ProcStatEntry *e, unsigned long long *starttime)
+{
+	const char *open = strchr(buf, '(');
+	const char *close = strrchr(buf, ')');
+	unsigned long long utime, stime;
+	long rss;
+
+	if (!open || !close || close < open)
+		return -1;
+	snprintf(e->comm, sizeof(e->comm), "%.*s", (int)(close - open - 1), open + 1);
+	/* state ppid pgrp session tty tpgid flags minflt cminflt majflt
+	 * cmajflt utime stime cutime cstime prio nice threads itreal
+	 * starttime vsize rss */
+	if (sscanf(close + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+			"%llu %llu %*d %*d %*d %*d %*d %*d %llu %*u %ld",
+			&utime, &stime, starttime, &rss) != 4)
+		return -1;
+	e->ticks = utime + stime;
+	e->rss_kb = rss > 0 ? (unsigned long)rss * (unsigned long)ps_page_kb : 0;
+	return 0;
+}
+
+static int
+ps_read_stat(ProcStatEntry *e, unsigned long long *starttime)
+{
+	char path[32], buf[1024];
+	ssize_t n;
+	int fd = e->fd;
+
+	if (fd < 0) {
+		snprintf(path, sizeof(path), "%d/stat", (int)e->pid);
+		fd = openat(ps_proc_fd, path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+	}
+	n = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (n <= 0) {
+		/* ESRCH on a cached fd: the process is gone */
+		if (fd != e->fd)
+			close(fd);
+		return -1;
+	}
+	buf[n] = '\0';
+
+	if (e->fd < 0) {
+		if (ps_fds_open < ps_fd_budget) {
+			e->fd = fd;
+			ps_fds_open++;
+		} else {
+			close(fd);
+		}
+	}
+	return ps_parse_stat(buf, e, starttime);
+}
+
+static void
+ps_close_entry(ProcStatEntry *e)
+{
+	if (e->fd >= 0) {
+		close(e->fd);
+		e->fd = -1;
+		ps_fds_open--;
+	}
+}
+
+/* Take a new sample of every process.  Returns 1 when the result has a
+ * fresh previous tick to diff against, 0 when %CPU is not meaningful yet
+ * (first sample, or the last one is stale) and the caller should come
+ * back shortly. */
+int
+procstat_sample(void)
+{
+	DIR *dir;
+	struct dirent *de;
+	uint64_t now = monotonic_msec();
+	double elapsed_s;
+	int n = 0, fresh;
+
+	ps_init_once();
+	if (ps_have_prev && now - ps_last_ms < PROCSTAT_MIN_INTERVAL_MS)
+		return 1;
+	fresh = ps_have_prev && now - ps_last_ms < PROCSTAT_STALE_MS;
+	elapsed_s = ps_have_prev ? (double)(now - ps_last_ms) / 1000.0 : 0.0;
+
+	if (ps_proc_fd < 0) {
+		/* NIXLY_PROC_ROOT points the sampler at a fixture tree
+		 * (tests/procstat_bench.c) instead of the live /proc. */
+		const char *root = getenv("NIXLY_PROC_ROOT");
+
+		ps_proc_fd = open(root && *root ? root : "/proc",
+				O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (ps_proc_fd < 0)
+			return 0;
+	}
+	dir = fdopendir(dup(ps_proc_fd));
+	if (!dir)
+		return 0;
+	/* the dup shares its offset with ps_proc_fd: start from the top */
+	rewinddir(dir);
+
+	while ((de = readdir(dir))) {
+		ProcStatEntry *e;
+		unsigned long long starttime = 0;
+		unsigned long long prev_ticks = 0;
+		pid_t pid;
+		int old;
+
+		if (de->d_name[0] < '1' || de->d_name[0] > '9')
+			continue;
+		pid = (pid_t)strtol(de->d_name, NULL, 10);
+		if (pid <= 0)
+			continue;
+
+		ps_reserve(n + 1);
+		e = &ps_next[n];
+		old = ps_lookup(pid);
+		if (old >= 0) {
+			*e = ps_cur[old];
+			prev_ticks = e->ticks;
+			ps_cur[old].fd = -1; /* ownership moved */
+			ps_cur[old].pid = 0;
+		} else {
+			memset(e, 0, sizeof(*e));
+			e->pid = pid;
+			e->fd = -1;
+		}
+
+		if (ps_read_stat(e, &starttime) != 0) {
+			ps_close_entry(e);
+			continue;
+		}
+		if (old >= 0 && starttime != e->starttime) {
+			/* pid reused since the last tick */
+			old = -1;
+			ps_close_entry(e);
+		}
+		e->starttime = starttime;
+		if (old >= 0 && elapsed_s > 0.0 && e->ticks >= prev_ticks)
+			e->cpu = (double)(e->ticks - prev_ticks)
+					/ (double)ps_clk_tck / elapsed_s * 100.0;
+		else
+			e->cpu = 0.0;
+		n++;
+	}
+	closedir(dir);
+
+	/* Whatever was not carried over has exited. */
+	for (int i = 0; i < ps_cur_n; i++)
+		if (ps_cur[i].pid != 0)
+			ps_close_entry(&ps_cur[i]);
+
+	{
+		ProcStatEntry *tmp = ps_cur;
+		ps_cur = ps_next;
+		ps_next = tmp;
+	}
+	ps_cur_n = n;
+	ps_rebuild_index();
+	ps_last_ms = now;
+	ps_have_prev = 1;
+	return fresh;
+}
+
+/* Insert g into the descending top-K list out[0..*count) if it makes
+ * the cut. */
+static void
+ps_topk_insert(ProcGroup *out, int k, int *count, const ProcGroup *g,
+		int by_rss)
+{
+	int pos = *count;
+
+	if (k <= 0)
+		return;
+	while (pos > 0) {
+		const ProcGroup *prev = &out[pos - 1];
+		int better = by_rss ? g->rss_kb > prev->rss_kb : g->cpu > prev->cpu;
+		if (!better)
+			break;
+		pos--;
+	}
+	if (pos >= k)
+		return;
+	if (*count < k)
+		(*count)++;
+	memmove(&out[pos + 1], &out[pos],
+			(size_t)(*count - 1 - pos) * sizeof(*out));
+	out[pos] = *g;
+}
+
+static uint32_t
+ps_hash_name(const char *s)
+{
+	uint32_t h = 2166136261u;
+
+	while (*s)
+		h = (h ^ (unsigned char)*s++) * 16777619u;
+	return h;
+}
+
+/* Group the last sample by comm and return the top k groups by summed
+ * %CPU (by_rss = 0) or summed RSS.  keep() decides per process whether
+ * it counts at all.  Each group's pid is its heaviest member. */
+int
+procstat_top(ProcGroup *out, int k, int by_rss,
+		int (*keep)(pid_t pid, const char *name, unsigned long rss_kb))
+{
+	static ProcGroup *groups;
+	static int *slots;
+	static size_t slots_size;
+	int ngroups = 0, count = 0;
+	size_t want = 256;
+
+	if (ps_cur_n == 0)
+		return 0;
+	while (want < (size_t)ps_cur_n * 2)
+		want <<= 1;
+	if (want != slots_size) {
+		free(slots);
+		free(groups);
+		slots = ecalloc(want, sizeof(*slots));
+		groups = ecalloc(want / 2, sizeof(*groups));
+		slots_size = want;
+	}
+	memset(slots, 0xff, slots_size * sizeof(*slots));
+
+	for (int i = 0; i < ps_cur_n; i++) {
+		const ProcStatEntry *e = &ps_cur[i];
+		ProcGroup *g;
+		size_t h;
+
+		if (keep && !keep(e->pid, e->comm, e->rss_kb))
+			continue;
+		for (h = ps_hash_name(e->comm) & (slots_size - 1);;
+				h = (h + 1) & (slots_size - 1)) {
+			if (slots[h] < 0 || strcmp(groups[slots[h]].name, e->comm) == 0)
+				break;
+		}
+		if (slots[h] < 0) {
+			slots[h] = ngroups;
+			g = &groups[ngroups++];
+			memset(g, 0, sizeof(*g));
+			snprintf(g->name, sizeof(g->name), "%s", e->comm);
+			g->pid = e->pid;
+		} else {
+			g = &groups[slots[h]];
+		}
+		g->cpu += e->cpu;
+		g->rss_kb += e->rss_kb;
+		if (by_rss ? e->rss_kb > g->max_single_rss_kb
+				: e->cpu > g->max_single_cpu)
+			g->pid = e->pid;
+		if (e->cpu > g->max_single_cpu)
+			g->max_single_cpu = e->cpu;
+		if (e->rss_kb > g->max_single_rss_kb)
+			g->max_single_rss_kb = e->rss_kb;
+	}
+
+	for (int i = 0; i < ngroups; i++)
+		ps_topk_insert(out, k, &count, &groups[i], by_rss);
+	return count;
+}
+
+void
+procstat_cleanup(void)
+{
+	for (int i = 0; i < ps_cur_n; i++)
+		ps_close_entry(&ps_cur[i]);
+	free(ps_cur);
+	free(ps_next);
+	free(ps_index);
+	ps_cur = ps_next = NULL;
+	ps_index = NULL;
+	ps_index_size = 0;
+	ps_cur_n = ps_cap = 0;
+	ps_have_prev = 0;
+	if (ps_proc_fd >= 0) {
+		close(ps_proc_fd);
+		ps_proc_fd = -1;
+	}
+}
@@ -0,0 +1,799 @@
+/*
+ * proctable.c — in-memory process table kept current from the netlink
+ * proc connector.
+ *
+ * Game classification, launch tracking, game-mode freezing and the
+ * auto-kill timer used to answer "is X running" and "does this pid
+ * descend from Y" by walking /proc on the compositor thread: a readdir
+ * plus a comm/stat read per pid, or one stat read per ancestor.  This
+ * module keeps pid, ppid, uid, start time and comm for every process
+ * (threads are ignored) in a pid hash, plus a per-comm count, so those
+ * questions become hash lookups.
+ *
+ * The table is kept current from PROC_EVENT_FORK/EXEC/UID/COMM/EXIT.
+ * Subscribing needs CAP_NET_ADMIN; without it (or after the kernel
+ * dropped events) the table is resynced from /proc instead: a readdir
+ * that only reads stat for pids it has not seen.  Resyncs run on a slow
+ * timer, whenever a caller asks via proctable_refresh() and before every
+ * by-name query, and a pid missing from the table is read from /proc on
+ * demand, so answers are never staler than the old direct reads.
+ *
+ * Exec (or a first sighting while resyncing) is forwarded to launchfx,
+ * which reacts to Steam's reaper at exec time instead of on its next
+ * /proc sweep.  exe is resolved lazily and cached on the heap (most
+ * entries are never asked) until the next exec.
+ *
+ * The game-mode worker sweeps the table too, so every entry point takes
+ * pt_lock.  Exec notifications are queued under the lock and delivered
+ * on the compositor thread once it is released.
+ */
+#include "nixlytile.h"
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+#define PT_BUCKETS      4096       /* pid hash; pids are dense, so pid & mask */
+#define PT_NAME_BUCKETS 512
+#define PT_RESYNC_MS    5000       /* backstop without the connector */
+#define PT_YOUNG_MS     2000       /* re-read comm this long after discovery */
+#define PT_MAX_DEPTH    32
+#define PT_BUF          8192
+#define PT_EXEC_QUEUE   256
+
+typedef struct PtEntry {
+	struct PtEntry *next;
+	ProcInfo info;
+	uint64_t seen_ms;          /* discovery, for the young-comm re-read */
+	unsigned int mark;         /* resync generation */
+	char *exe;                 /* NULL until asked for */
+} PtEntry;
+
+typedef struct PtName {
+	struct PtName *next;
+	char name[sizeof(((ProcInfo *)0)->comm)]; /* lower-cased */
+	int count;
+} PtName;
+
+static PtEntry *pt_buckets[PT_BUCKETS];
+static PtName *pt_names[PT_NAME_BUCKETS];
+static int pt_count;
+static unsigned int pt_mark;
+static int pt_proc_fd = -1;
+static long pt_clk_tck;
+
+static int pt_nl_fd = -1;
+static int pt_live;                /* connector subscribed and acked */
+static struct wl_event_source *pt_nl_src;
+static struct wl_event_source *pt_resync_timer;
+static int pt_in_resync;
+static int pt_primed;              /* first resync done: later sightings are new */
+static pthread_mutex_t pt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t pt_main;
+
+static struct {
+	pid_t pid;
+	char comm[sizeof(((ProcInfo *)0)->comm)];
+} pt_exec_q[PT_EXEC_QUEUE];
+static int pt_exec_n;
+
+/* ── comm index ───────────────────────────────────────────────────── */
+
+static uint32_t
+pt_name_hash(const char *s)
+{
+	uint32_t h = 2166136261u;
+
+	for (; *s; s++) {
+		h ^= (unsigned char)tolower((unsigned char)*s);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static PtName **
+pt_name_slot(const char *comm)
+{
+	PtName **pp = &pt_names[pt_name_hash(comm) & (PT_NAME_BUCKETS - 1)];
+
+	for (; *pp; pp = &(*pp)->next)
+		if (!strcasecmp((*pp)->name, comm))
+			break;
+	return pp;
+}
+
+static void
+pt_name_add(const char *comm)
+{
+	PtName **pp = pt_name_slot(comm), *n;
+
+	if (!*pp) {
+		n = ecalloc(1, sizeof(*n));
+		for (size_t i = 0; comm[i] && i < sizeof(n->name) - 1; i++)
+			n->name[i] = (char)tolower((unsigned char)comm[i]);
+		*pp = n;
+	}
+	(*pp)->count++;
+}
+
+static void
+pt_name_del(const char *comm)
+{
+	PtName **pp = pt_name_slot(comm), *n;
+
+	if (!(n = *pp))
+		return;
+	if (--n->count <= 0) {
+		*pp = n->next;
+		free(n);
+	}
+}
+
+/* ── pid table ────────────────────────────────────────────────────── */
+
+static PtEntry **
+pt_slot(pid_t pid)
+{
+	PtEntry **pp = &pt_buckets[(unsigned int)pid & (PT_BUCKETS - 1)];
+
+	for (; *pp; pp = &(*pp)->next)
+		if ((*pp)->info.pid == pid)
+			break;
+	return pp;
+}
+
+static void
+pt_set_comm(PtEntry *e, const char *comm)
+{
+	if (!strcmp(e->info.comm, comm))
+		return;
+	pt_name_del(e->info.comm);
+	snprintf(e->info.comm, sizeof(e->info.comm), "%s", comm);
+	pt_name_add(e->info.comm);
+}
+
+static PtEntry *
+pt_insert(pid_t pid)
+{
+	PtEntry **pp = pt_slot(pid), *e;
+
+	if ((e = *pp))
+		return e;
+	e = ecalloc(1, sizeof(*e));
+	e->info.pid = pid;
+	e->seen_ms = monotonic_msec();
+	e->mark = pt_mark;
+	pt_name_add(e->info.comm);
+	*pp = e;
+	pt_count++;
+	return e;
+}
+
+/* The cached exe belongs to the program, not the pid: drop it on exec. */
+static void
+pt_forget_exe(PtEntry *e)
+{
+	free(e->exe);
+	e->exe = NULL;
+}
+
+static void
+pt_free(PtEntry *e)
+{
+	free(e->exe);
+	free(e);
+}
+
+static void
+pt_remove(pid_t pid)
+{
+	PtEntry **pp = pt_slot(pid), *e;
+
+	if (!(e = *pp))
+		return;
+	*pp = e->next;
+	pt_name_del(e->info.comm);
+	pt_free(e);
+	pt_count--;
+}
+
+static int
+pt_open_proc(void)
+{
+	if (pt_proc_fd < 0)
+		pt_proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	return pt_proc_fd;
+}
+
+/* Fills ppid, comm, start and uid from /proc/<pid>.  Returns -1 if the
+ * process is gone (or is not a process we may look at). */
+static int
+pt_read(pid_t pid, ProcInfo *info)
+{
+	char path[32], buf[512], *lp, *rp;
+	unsigned long long start = 0;
+	struct stat st;
+	int fd, ppid = 0;
+	ssize_t n;
+	size_t len;
+
+	if (pt_open_proc() < 0)
+		return -1;
+	snprintf(path, sizeof(path), "%d/stat", (int)pid);
+	if ((fd = openat(pt_proc_fd, path, O_RDONLY | O_CLOEXEC)) < 0)
+		return -1;
+	n = read(fd, buf, sizeof(buf) - 1);
+	/* /proc/<pid> is owned by the process's effective uid */
+	if (n > 0 && fstat(fd, &st) != 0)
+		n = -1;
+	close(fd);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+
+	/* pid (comm) state ppid ... starttime is field 22; comm may hold
+	 * spaces and parentheses, so split on the last ')'. */
+	if (!(lp = strchr(buf, '(')) || !(rp = strrchr(buf, ')')) || rp < lp)
+		return -1;
+	if (sscanf(rp + 2, "%*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u "
+			"%*d %*d %*d %*d %*d %*d %llu", &ppid, &start) != 2)
+		return -1;
+
+	len = MIN((size_t)(rp - lp - 1), sizeof(info->comm) - 1);
+	memcpy(info->comm, lp + 1, len);
+	info->comm[len] = '\0';
+	info->pid = pid;
+	info->ppid = (pid_t)ppid;
+	info->start = start;
+	info->uid = st.st_uid;
+	return 0;
+}
+
+/* A freshly seen pid, or a new program in an existing one.  Queued;
+ * pt_flush_exec() delivers it.  A burst larger than the queue drops the
+ * newest sightings, which only costs launchfx its early start. */
+static void
+pt_notify_exec(const PtEntry *e)
+{
+	if (!pt_primed || pt_exec_n >= PT_EXEC_QUEUE)
+		return;
+	pt_exec_q[pt_exec_n].pid = e->info.pid;
+	memcpy(pt_exec_q[pt_exec_n].comm, e->info.comm, sizeof(e->info.comm));
+	pt_exec_n++;
+}
+
+/* Called without pt_lock held; launchfx may call back into the table. */
+static void
+pt_flush_exec(void)
+{
+	pid_t pid;
+	char comm[sizeof(((ProcInfo *)0)->comm)];
+
+	if (!pthread_equal(pthread_self(), pt_main))
+		return;
+	for (;;) {
+		pthread_mutex_lock(&pt_lock);
+		if (pt_exec_n == 0) {
+			pthread_mutex_unlock(&pt_lock);
+			return;
+		}
+		pid = pt_exec_q[0].pid;
+		memcpy(comm, pt_exec_q[0].comm, sizeof(comm));
+		memmove(&pt_exec_q[0], &pt_exec_q[1],
+				(size_t)(--pt_exec_n) * sizeof(pt_exec_q[0]));
+		pthread_mutex_unlock(&pt_lock);
+		launchfx_note_exec(pid, comm);
+	}
+}
+
+static PtEntry *
+pt_load(pid_t pid)
+{
+	ProcInfo info = {0};
+	PtEntry *e;
+
+	if (pid <= 0 || pt_read(pid, &info) != 0)
+		return NULL;
+	e = pt_insert(pid);
+	e->info.ppid = info.ppid;
+	e->info.uid = info.uid;
+	e->info.start = info.start;
+	pt_set_comm(e, info.comm);
+	return e;
+}
+
+/* Table entry for pid, read from /proc if the table has not heard of it
+ * (a process that started since the last resync, or whose fork event
+ * is still queued on the socket). */
+static PtEntry *
+pt_lookup(pid_t pid)
+{
+	PtEntry *e;
+
+	if (pid <= 0)
+		return NULL;
+	if ((e = *pt_slot(pid)))
+		return e;
+	return pt_load(pid);
+}
+
+/* ── /proc resync ─────────────────────────────────────────────────── */
+
+static void
+pt_resync(void)
+{
+	DIR *dir;
+	struct dirent *ent;
+	uint64_t now = monotonic_msec();
+	PtEntry *e, **pp;
+
+	if (pt_in_resync || pt_open_proc() < 0)
+		return;
+	/* fdopendir takes ownership; rewind a dup of the cached fd */
+	{
+		int fd = dup(pt_proc_fd);
+		if (fd < 0 || !(dir = fdopendir(fd))) {
+			if (fd >= 0)
+				close(fd);
+			return;
+		}
+		rewinddir(dir);
+	}
+	pt_in_resync = 1;
+	pt_mark++;
+
+	while ((ent = readdir(dir))) {
+		pid_t pid;
+		if (ent->d_name[0] < '1' || ent->d_name[0] > '9')
+			continue;
+		pid = (pid_t)atoi(ent->d_name);
+		if ((e = *pt_slot(pid))) {
+			e->mark = pt_mark;
+			/* Caught between fork and exec: pick up the new comm */
+			if (!pt_live && now - e->seen_ms < PT_YOUNG_MS) {
+				char old[sizeof(e->info.comm)];
+				snprintf(old, sizeof(old), "%s", e->info.comm);
+				if (pt_load(pid) && strcmp(old, e->info.comm) != 0) {
+					pt_forget_exe(e);
+					pt_notify_exec(e);
+				}
+			}
+			continue;
+		}
+		if ((e = pt_load(pid))) {
+			e->mark = pt_mark;
+			pt_notify_exec(e);
+		}
+	}
+	closedir(dir);
+	pt_primed = 1;
+
+	/* Anything not listed has exited */
+	for (int b = 0; b < PT_BUCKETS; b++) {
+		for (pp = &pt_buckets[b]; (e = *pp); ) {
+			if (e->mark != pt_mark) {
+				*pp = e->next;
+				pt_name_del(e->info.comm);
+				pt_free(e);
+				pt_count--;
+			} else {
+				pp = &e->next;
+			}
+		}
+	}
+	pt_in_resync = 0;
+}
+
+static int
+pt_resync_cb(void *data)
+{
+	(void)data;
+
+	pthread_mutex_lock(&pt_lock);
+	if (!pt_live)
+		pt_resync();
+	pthread_mutex_unlock(&pt_lock);
+	pt_flush_exec();
+	wl_event_source_timer_update(pt_resync_timer, PT_RESYNC_MS);
+	return 0;
+}
+
+/* ── proc connector ───────────────────────────────────────────────── */
+
+static void
+pt_nl_close(void)
+{
+	if (pt_nl_src)
+		wl_event_source_remove(pt_nl_src);
+	pt_nl_src = NULL;
+	if (pt_nl_fd >= 0)
+		close(pt_nl_fd);
+	pt_nl_fd = -1;
+	pt_live = 0;
+}
+
+/* /proc starttime (clock ticks since boot) for a fork stamped ts_ns.
+ * The connector stamps CLOCK_MONOTONIC, which stops during suspend;
+ * starttime counts from CLOCK_BOOTTIME, which does not. */
+static unsigned long long
+pt_fork_start(uint64_t ts_ns)
+{
+	struct timespec mono, boot;
+	int64_t off;
+
+	if (pt_clk_tck <= 0 || clock_gettime(CLOCK_MONOTONIC, &mono) != 0
+			|| clock_gettime(CLOCK_BOOTTIME, &boot) != 0)
+		return 0;
+	off = (int64_t)(boot.tv_sec - mono.tv_sec) * 1000000000LL
+		+ (boot.tv_nsec - mono.tv_nsec);
+	return (ts_ns + (uint64_t)MAX(off, 0))
+		/ (1000000000ULL / (unsigned long long)pt_clk_tck);
+}
+
+static void
+pt_handle(const struct proc_event *ev)
+{
+	PtEntry *e, *parent;
+
+	switch (ev->what) {
+	case PROC_EVENT_NONE:
+		/* ack of our PROC_CN_MCAST_LISTEN */
+		if (ev->event_data.ack.err != 0) {
+			wlr_log(WLR_INFO, "proctable: proc connector refused (%s), "
+					"resyncing from /proc",
+					strerror((int)ev->event_data.ack.err));
+			pt_nl_close();
+		} else if (!pt_live) {
+			/* events flow from here on; fill in what came before */
+			pt_resync();
+			pt_live = 1;
+		}
+		break;
+	case PROC_EVENT_FORK:
+		if (ev->event_data.fork.child_pid != ev->event_data.fork.child_tgid)
+			break; /* a thread */
+		e = pt_insert(ev->event_data.fork.child_tgid);
+		e->info.ppid = ev->event_data.fork.parent_tgid;
+		e->info.start = pt_fork_start(ev->timestamp_ns);
+		pt_forget_exe(e);
+		/* A fork runs the parent's program until it execs */
+		if ((parent = *pt_slot(ev->event_data.fork.parent_tgid))) {
+			e->info.uid = parent->info.uid;
+			pt_set_comm(e, parent->info.comm);
+		} else {
+			pt_load(e->info.pid);
+		}
+		break;
+	case PROC_EVENT_EXEC:
+		if (ev->event_data.exec.process_pid != ev->event_data.exec.process_tgid)
+			break;
+		/* The event carries no name: one stat read per exec */
+		if ((e = pt_load(ev->event_data.exec.process_tgid))) {
+			pt_forget_exe(e);
+			pt_notify_exec(e);
+		}
+		break;
+	case PROC_EVENT_UID:
+		if ((e = *pt_slot(ev->event_data.id.process_tgid)))
+			e->info.uid = ev->event_data.id.e.euid;
+		break;
+	case PROC_EVENT_COMM:
+		/* prctl(PR_SET_NAME) on the main thread renames the process */
+		if (ev->event_data.comm.process_pid != ev->event_data.comm.process_tgid)
+			break;
+		if ((e = *pt_slot(ev->event_data.comm.process_tgid))) {
+			char comm[sizeof(ev->event_data.comm.comm) + 1];
+			memcpy(comm, ev->event_data.comm.comm, sizeof(ev->event_data.comm.comm));
+			comm[sizeof(comm) - 1] = '\0';
+			pt_set_comm(e, comm);
+			pt_notify_exec(e);
+		}
+		break;
+	case PROC_EVENT_EXIT:
+		if (ev->event_data.exit.process_pid == ev->event_data.exit.process_tgid)
+			pt_remove(ev->event_data.exit.process_tgid);
+		break;
+	default:
+		break;
+	}
+}
+
+static int
+pt_readable(int fd, uint32_t mask, void *data)
+{
+	char buf[PT_BUF] __attribute__((aligned(NLMSG_ALIGNTO)));
+	struct nlmsghdr *nh;
+	ssize_t n;
+
+	(void)data;
+
+	pthread_mutex_lock(&pt_lock);
+	if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+		wlr_log(WLR_ERROR, "proctable: connector socket error, resyncing from /proc");
+		pt_nl_close();
+		pt_resync();
+		goto out;
+	}
+
+	while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) != 0) {
+		if (n < 0) {
+			/* Fork storms can overrun the socket: the table is
+			 * only trustworthy again after a full resync. */
+			if (errno == ENOBUFS) {
+				pt_live = 0;
+				pt_resync();
+				pt_live = pt_nl_fd >= 0;
+				continue;
+			}
+			break;
+		}
+		for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, (size_t)n);
+				nh = NLMSG_NEXT(nh, n)) {
+			struct cn_msg *cn;
+			if (nh->nlmsg_type == NLMSG_ERROR || nh->nlmsg_type == NLMSG_NOOP)
+				continue;
+			cn = NLMSG_DATA(nh);
+			if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC
+					|| cn->len < sizeof(struct proc_event))
+				continue;
+			pt_handle((const struct proc_event *)cn->data);
+			if (pt_nl_fd < 0)
+				goto out;
+		}
+	}
+out:
+	pthread_mutex_unlock(&pt_lock);
+	pt_flush_exec();
+	return 0;
+}
+
+static int
+pt_nl_open(void)
+{
+	struct sockaddr_nl sa = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = CN_IDX_PROC,
+	};
+	char req[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))]
+		__attribute__((aligned(NLMSG_ALIGNTO))) = {0};
+	struct nlmsghdr *nh = (struct nlmsghdr *)req;
+	struct cn_msg *cn = NLMSG_DATA(nh);
+	enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+	int rcvbuf = 1024 * 1024;
+
+	pt_nl_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+			NETLINK_CONNECTOR);
+	if (pt_nl_fd < 0 || bind(pt_nl_fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+		goto fail;
+	setsockopt(pt_nl_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	nh->nlmsg_len = NLMSG_LENGTH(sizeof(*cn) + sizeof(op));
+	nh->nlmsg_type = NLMSG_DONE;
+	nh->nlmsg_pid = (uint32_t)getpid();
+	cn->id.idx = CN_IDX_PROC;
+	cn->id.val = CN_VAL_PROC;
+	cn->len = sizeof(op);
+	memcpy(cn->data, &op, sizeof(op));
+	if (send(pt_nl_fd, req, nh->nlmsg_len, 0) != (ssize_t)nh->nlmsg_len)
+		goto fail;
+
+	pt_nl_src = wl_event_loop_add_fd(event_loop, pt_nl_fd, WL_EVENT_READABLE,
+			pt_readable, NULL);
+	if (!pt_nl_src)
+		goto fail;
+	/* pt_live is set once the kernel acks the subscription */
+	return 0;
+
+fail:
+	wlr_log(WLR_INFO, "proctable: proc connector unavailable (%s), "
+			"resyncing from /proc", strerror(errno));
+	pt_nl_close();
+	return -1;
+}
+
+/* ── public ───────────────────────────────────────────────────────── */
+
+void
+proctable_setup(void)
+{
+	pt_main = pthread_self();
+	pt_clk_tck = sysconf(_SC_CLK_TCK);
+	pthread_mutex_lock(&pt_lock);
+	pt_resync();
+	pthread_mutex_unlock(&pt_lock);
+	pt_nl_open();
+	pt_resync_timer = wl_event_loop_add_timer(event_loop, pt_resync_cb, NULL);
+	if (pt_resync_timer)
+		wl_event_source_timer_update(pt_resync_timer, PT_RESYNC_MS);
+}
+
+void
+proctable_cleanup(void)
+{
+	pt_nl_close();
+	if (pt_resync_timer)
+		wl_event_source_remove(pt_resync_timer);
+	pt_resync_timer = NULL;
+	pthread_mutex_lock(&pt_lock);
+	for (int b = 0; b < PT_BUCKETS; b++) {
+		PtEntry *e, *next;
+		for (e = pt_buckets[b]; e; e = next) {
+			next = e->next;
+			pt_free(e);
+		}
+		pt_buckets[b] = NULL;
+	}
+	for (int b = 0; b < PT_NAME_BUCKETS; b++) {
+		PtName *n, *next;
+		for (n = pt_names[b]; n; n = next) {
+			next = n->next;
+			free(n);
+		}
+		pt_names[b] = NULL;
+	}
+	pt_count = 0;
+	pt_exec_n = 0;
+	pt_primed = 0;
+	if (pt_proc_fd >= 0)
+		close(pt_proc_fd);
+	pt_proc_fd = -1;
+	pthread_mutex_unlock(&pt_lock);
+}
+
+/* Is the table event driven (1) or resynced from /proc (0)? */
+int
+proctable_live(void)
+{
+	int live;
+
+	pthread_mutex_lock(&pt_lock);
+	live = pt_live;
+	pthread_mutex_unlock(&pt_lock);
+	return live;
+}
+
+/* Bring the table up to date before a decision that must see every
+ * process (game-mode freeze, launch detection).  Free when live. */
+void
+proctable_refresh(void)
+{
+	pthread_mutex_lock(&pt_lock);
+	if (!pt_live)
+		pt_resync();
+	pthread_mutex_unlock(&pt_lock);
+	pt_flush_exec();
+}
+
+int
+proctable_get(pid_t pid, ProcInfo *out)
+{
+	PtEntry *e;
+	int ret = -1;
+
+	pthread_mutex_lock(&pt_lock);
+	if ((e = pt_lookup(pid))) {
+		if (out)
+			*out = e->info;
+		ret = 0;
+	}
+	pthread_mutex_unlock(&pt_lock);
+	return ret;
+}
+
+/* Resolved /proc/<pid>/exe, cached until the process execs again. */
+int
+proctable_exe(pid_t pid, char *out, size_t len)
+{
+	PtEntry *e;
+	char path[32];
+	ssize_t n;
+	int ret = -1;
+
+	if (len == 0)
+		return -1;
+	pthread_mutex_lock(&pt_lock);
+	if (!(e = pt_lookup(pid)))
+		goto out;
+	if (!e->exe) {
+		char buf[PATH_MAX];
+
+		snprintf(path, sizeof(path), "%d/exe", (int)pid);
+		if (pt_open_proc() < 0
+				|| (n = readlinkat(pt_proc_fd, path, buf, sizeof(buf) - 1)) <= 0)
+			goto out;
+		e->exe = ecalloc(1, (size_t)n + 1);
+		memcpy(e->exe, buf, (size_t)n);
+	}
+	snprintf(out, len, "%s", e->exe);
+	ret = 0;
+out:
+	pthread_mutex_unlock(&pt_lock);
+	return ret;
+}
+
+/* Is a process whose comm equals name (case-insensitively) running?
+ * With substr, any comm containing name counts; that scans the distinct
+ * comm names, not the processes.  Without the connector the name index
+ * is resynced first: it only changes on a resync. */
+int
+proctable_running(const char *name, int substr)
+{
+	int found;
+
+	if (!name || !*name)
+		return 0;
+	pthread_mutex_lock(&pt_lock);
+	if (!pt_live)
+		pt_resync();
+	found = *pt_name_slot(name) != NULL;
+	for (int b = 0; substr && !found && b < PT_NAME_BUCKETS; b++)
+		for (PtName *n = pt_names[b]; n && !found; n = n->next)
+			found = strcasestr(n->name, name) != NULL;
+	pthread_mutex_unlock(&pt_lock);
+	pt_flush_exec();
+	return found;
+}
+
+/* Is pid, or one of its ancestors, `ancestor`? */
+int
+proctable_is_descendant(pid_t pid, pid_t ancestor)
+{
+	PtEntry *e;
+	int found = 0;
+
+	pthread_mutex_lock(&pt_lock);
+	for (int depth = 0; depth < PT_MAX_DEPTH && pid > 1; depth++) {
+		if ((found = pid == ancestor) || !(e = pt_lookup(pid)))
+			break;
+		pid = e->info.ppid;
+	}
+	pthread_mutex_unlock(&pt_lock);
+	return found;
+}
+
+/* Does the comm of pid (with self) or of one of its ancestors match one
+ * of the needles — exactly (case-insensitive) or as a substring? */
+int
+proctable_ancestry_matches(pid_t pid, const char *const *needles, int exact, int self)
+{
+	PtEntry *e;
+	int found = 0;
+
+	pthread_mutex_lock(&pt_lock);
+	if (!self)
+		pid = (e = pt_lookup(pid)) ? e->info.ppid : 0;
+	for (int depth = 0; !found && depth < PT_MAX_DEPTH && pid > 1; depth++) {
+		if (!(e = pt_lookup(pid)))
+			break;
+		for (int i = 0; needles[i] && !found; i++) {
+			found = exact ? strcasecmp(e->info.comm, needles[i]) == 0
+				      : strcasestr(e->info.comm, needles[i]) != NULL;
+		}
+		pid = e->info.ppid;
+	}
+	pthread_mutex_unlock(&pt_lock);
+	return found;
+}
+
+/* Copies the table into a malloc'd array (caller frees) for sweeps that
+ * signal or reprioritise processes.  Returns the count, or -1. */
+int
+proctable_snapshot(ProcInfo **out)
+{
+	ProcInfo *arr;
+	int n = 0;
+
+	*out = NULL;
+	pthread_mutex_lock(&pt_lock);
+	arr = calloc((size_t)MAX(pt_count, 1), sizeof(*arr));
+	if (arr) {
+		for (int b = 0; b < PT_BUCKETS; b++)
+			for (PtEntry *e = pt_buckets[b]; e && n < pt_count; e = e->next)
+				arr[n++] = e->info;
+	}
+	pthread_mutex_unlock(&pt_lock);
+	if (!arr)
+		return -1;
+	*out = arr;
+	return n;
+}
@@ -0,0 +1,202 @@
+/*
+ * psiwatch.c — pressure-stall triggers for memory and I/O.
+ *
+ * Memory handling used to key off get_memory_pressure(), a "percent of
+ * RAM used" figure computed from /proc/meminfo whenever something asked.
+ * Used RAM says little — page cache fills it on a healthy system — and
+ * nothing asked often enough to react before the game started stalling.
+ *
+ * PSI triggers report real stalls: the kernel wakes us as soon as tasks
+ * have spent more than a threshold waiting on memory (or I/O) within a
+ * window.  Trigger fds signal with EPOLLPRI, which wl_event_loop cannot
+ * ask for, so they live in a private epoll set whose fd is what the
+ * event loop watches.
+ *
+ * Memory stalls escalate while they keep coming, one step per event
+ * that arrives within PSI_ESCALATE_MS of the last:
+ *   1. page out the memory of processes game mode froze,
+ *   2. drop compositor caches (icon and label rasters, closing-animation
+ *      snapshots),
+ *   3. tell the user through the OSD.
+ * After PSI_QUIET_MS without an event the ladder starts again from 1.
+ * I/O stalls are logged, and shown once per quiet period — reclaim is
+ * the wrong answer to them, it only adds paging I/O.
+ */
+#include "nixlytile.h"
+#include "diag.h"
+
+#include <sys/epoll.h>
+
+#define PSI_ESCALATE_MS 5000
+#define PSI_QUIET_MS    30000
+
+enum { PsiMemSome, PsiMemFull, PsiIo, PsiCount };
+
+static const struct {
+	const char *file;
+	const char *trigger;       /* stall µs within a 1 s window */
+	const char *name;
+} psi_spec[PsiCount] = {
+	[PsiMemSome] = { "/proc/pressure/memory", "some 150000", "memory some" },
+	[PsiMemFull] = { "/proc/pressure/memory", "full 50000",  "memory full" },
+	[PsiIo]      = { "/proc/pressure/io",     "full 150000", "io full" },
+};
+
+static int psi_fd[PsiCount] = { -1, -1, -1 };
+static int psi_epfd = -1;
+static struct wl_event_source *psi_src;
+static int psi_level;              /* memory steps taken so far */
+static int psi_io_noted;
+static uint64_t psi_mem_last_ns, psi_io_last_ns;
+
+/* Open one trigger.  Privileged triggers accept a 1 s window; since 6.5
+ * unprivileged ones are allowed too, but only with a window that is a
+ * multiple of 2 s, so retry with that. */
+static int
+psi_open(int i)
+{
+	static const char *const windows[] = { "1000000", "2000000" };
+	char buf[64];
+	int fd;
+
+	for (size_t w = 0; w < LENGTH(windows); w++) {
+		if ((fd = open(psi_spec[i].file, O_RDWR | O_NONBLOCK | O_CLOEXEC)) < 0)
+			return -1;
+		snprintf(buf, sizeof(buf), "%s %s", psi_spec[i].trigger, windows[w]);
+		/* the trailing NUL is part of the write */
+		if (write(fd, buf, strlen(buf) + 1) >= 0)
+			return fd;
+		close(fd);
+	}
+	return -1;
+}
+
+static void
+psi_memory(uint64_t now, int which)
+{
+	uint64_t gap = psi_mem_last_ns ? now - psi_mem_last_ns : UINT64_MAX;
+
+	psi_mem_last_ns = now;
+	if (gap > (uint64_t)PSI_QUIET_MS * 1000000)
+		psi_level = 0;
+	if (psi_level >= 3)
+		return;         /* already told the user */
+	/* A slow trickle repeats the last step instead of climbing. */
+	if (gap > (uint64_t)PSI_ESCALATE_MS * 1000000 && psi_level > 0)
+		psi_level--;
+	psi_level++;
+	diag_logf("PSI", "%s stall, step %d (%d%% RAM used)", psi_spec[which].name,
+		psi_level, get_memory_pressure());
+	wlr_log(WLR_INFO, "psiwatch: %s stall, step %d", psi_spec[which].name, psi_level);
+
+	switch (psi_level) {
+	case 1:
+		gm_reclaim_frozen();
+		break;
+	case 2:
+		icon_cache_flush();
+		label_cache_flush();
+		closing_anims_drop();
+		break;
+	case 3:
+		if (selmon)
+			osd_show_force(selmon, "Memory pressure: system is stalling on RAM");
+		break;
+	}
+}
+
+static void
+psi_io(uint64_t now)
+{
+	if (psi_io_last_ns && now - psi_io_last_ns > (uint64_t)PSI_QUIET_MS * 1000000)
+		psi_io_noted = 0;
+	psi_io_last_ns = now;
+
+	diag_logf("PSI", "io full stall");
+	if (psi_io_noted)
+		return;
+	psi_io_noted = 1;
+	wlr_log(WLR_INFO, "psiwatch: io stall");
+	if (selmon)
+		osd_show(selmon, "Disk I/O is stalling");
+}
+
+static int
+psi_readable(int fd, uint32_t mask, void *data)
+{
+	struct epoll_event ev[PsiCount];
+	uint64_t now = get_time_ns();
+	int n, mem = -1;
+
+	(void)fd;
+	(void)mask;
+	(void)data;
+
+	n = epoll_wait(psi_epfd, ev, PsiCount, 0);
+	for (int i = 0; i < n; i++) {
+		int which = (int)ev[i].data.u32;
+
+		if (ev[i].events & EPOLLERR) {
+			/* the pressure file went away (cgroup/psi disabled) */
+			wlr_log(WLR_ERROR, "psiwatch: %s trigger failed", psi_spec[which].name);
+			epoll_ctl(psi_epfd, EPOLL_CTL_DEL, psi_fd[which], NULL);
+			close(psi_fd[which]);
+			psi_fd[which] = -1;
+			continue;
+		}
+		if (which == PsiIo)
+			psi_io(now);
+		else if (mem < 0 || which == PsiMemFull)
+			mem = which;    /* one step per wakeup, "full" wins */
+	}
+	if (mem >= 0)
+		psi_memory(now, mem);
+	return 0;
+}
+
+void
+psiwatch_setup(void)
+{
+	int armed = 0;
+
+	if ((psi_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		return;
+	for (int i = 0; i < PsiCount; i++) {
+		struct epoll_event ev = { .events = EPOLLPRI, .data.u32 = (uint32_t)i };
+
+		if ((psi_fd[i] = psi_open(i)) < 0)
+			continue;
+		if (epoll_ctl(psi_epfd, EPOLL_CTL_ADD, psi_fd[i], &ev) < 0) {
+			close(psi_fd[i]);
+			psi_fd[i] = -1;
+			continue;
+		}
+		armed++;
+	}
+	if (armed)
+		psi_src = wl_event_loop_add_fd(event_loop, psi_epfd, WL_EVENT_READABLE,
+				psi_readable, NULL);
+	if (!psi_src) {
+		wlr_log(WLR_INFO, "psiwatch: PSI triggers unavailable (%s)",
+			armed ? "event loop" : strerror(errno));
+		psiwatch_cleanup();
+		return;
+	}
+	wlr_log(WLR_INFO, "psiwatch: %d PSI triggers armed", armed);
+}
+
+void
+psiwatch_cleanup(void)
+{
+	if (psi_src)
+		wl_event_source_remove(psi_src);
+	psi_src = NULL;
+	for (int i = 0; i < PsiCount; i++) {
+		if (psi_fd[i] >= 0)
+			close(psi_fd[i]);
+		psi_fd[i] = -1;
+	}
+	if (psi_epfd >= 0)
+		close(psi_epfd);
+	psi_epfd = -1;
+}
@@ -0,0 +1,666 @@
+/*
+ * pw_audio.c — native PipeWire client for the volume and microphone
+ * modules.  A pw_thread_loop follows the "default" metadata and the
+ * Props params of every Audio/Sink and Audio/Source node, so volume,
+ * mute and headset-ness of the current defaults are known without ever
+ * forking wpctl.  Changes are pushed to the compositor thread through an
+ * eventfd; setters go straight to the node's Props param.
+ *
+ * Everything here degrades to "not connected": the wpctl path in
+ * statusbar.c stays as the fallback while PipeWire is down or still
+ * cold-starting, and a timer retries the connection.
+ */
+#include "nixlytile.h"
+
+#include <sys/eventfd.h>
+#include <pipewire/pipewire.h>
+#include <pipewire/extensions/metadata.h>
+#include <spa/param/props.h>
+#include <spa/param/audio/raw.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/iter.h>
+
+#define PW_AUDIO_MAX_NODES    64
+#define PW_AUDIO_RETRY_MS     5000
+
+typedef struct {
+	uint32_t id;
+	struct pw_node *proxy;
+	struct spa_hook listener;
+	char name[128];
+	int is_source;
+	int headset;
+	int have_props;
+	double percent;       /* cubic scale, what wpctl reports */
+	int muted;
+	uint32_t n_channels;
+} PwAudioNode;
+
+static struct pw_thread_loop *pw_loop;
+static struct pw_context *pw_ctx;
+static struct pw_core *pw_core_proxy;
+static struct spa_hook pw_core_listener;
+static struct pw_registry *pw_registry;
+static struct spa_hook pw_registry_listener;
+static struct pw_metadata *pw_default_meta;
+static struct spa_hook pw_meta_listener;
+static uint32_t pw_default_meta_id = SPA_ID_INVALID;
+
+/* All fields below are guarded by the thread-loop lock. */
+static PwAudioNode pw_nodes[PW_AUDIO_MAX_NODES];
+static int pw_node_count;
+static char pw_default_sink[128];
+static char pw_default_source[128];
+static int pw_connected;
+static int pw_initialized;
+
+static int pw_wake_fd = -1;
+static struct wl_event_source *pw_wake_src;
+static struct wl_event_source *pw_retry_timer;
+
+/* Same keyword list the wpctl inspect/status probe greps for. */
+static const char *pw_headset_kw[] = {
+	"headset", "headphone", "headphones", "earbud", "earbuds",
+	"earphone", "handsfree", "bluez", "bluetooth", "a2dp",
+	"hfp", "hsp", "head-unit"
+};
+
+static void pw_audio_teardown(void);
+static int pw_audio_connect(void);
+
+static void
+pw_audio_wake(void)
+{
+	uint64_t one = 1;
+
+	if (pw_wake_fd >= 0 && write(pw_wake_fd, &one, sizeof(one)) < 0) {
+		/* counter saturated: a wake is already pending */
+	}
+}
+
+static int
+pw_dict_is_headset(const struct spa_dict *props)
+{
+	const struct spa_dict_item *item;
+	size_t i;
+
+	if (!props)
+		return 0;
+	spa_dict_for_each(item, props) {
+		if (!item->value)
+			continue;
+		for (i = 0; i < LENGTH(pw_headset_kw); i++)
+			if (strcasestr(item->value, pw_headset_kw[i]))
+				return 1;
+	}
+	return 0;
+}
+
+static PwAudioNode *
+pw_find_node_by_id(uint32_t id)
+{
+	for (int i = 0; i < pw_node_count; i++)
+		if (pw_nodes[i].proxy && pw_nodes[i].id == id)
+			return &pw_nodes[i];
+	return NULL;
+}
+
+static PwAudioNode *
+pw_find_default(int is_source)
+{
+	const char *want = is_source ? pw_default_source : pw_default_sink;
+
+	if (!want[0])
+		return NULL;
+	for (int i = 0; i < pw_node_count; i++)
+		if (pw_nodes[i].proxy && pw_nodes[i].is_source == is_source
+				&& strcmp(pw_nodes[i].name, want) == 0)
+			return &pw_nodes[i];
+	return NULL;
+}
+
+static int
+pw_node_is_default(const PwAudioNode *n)
+{
+	const char *want = n->is_source ? pw_default_source : pw_default_sink;
+
+	return want[0] && strcmp(n->name, want) == 0;
+}
+
+/* ── node listener (thread loop) ─────────────────────────────────── */
+
+static void
+pw_node_info(void *data, const struct pw_node_info *info)
+{
+	PwAudioNode *n = data;
+	int headset;
+
+	if (!(info->change_mask & PW_NODE_CHANGE_MASK_PROPS) || !info->props)
+		return;
+	headset = pw_dict_is_headset(info->props);
+	if (headset != n->headset) {
+		n->headset = headset;
+		if (pw_node_is_default(n))
+			pw_audio_wake();
+	}
+}
+
+static void
+pw_node_param(void *data, int seq, uint32_t id, uint32_t index,
+		uint32_t next, const struct spa_pod *param)
+{
+	PwAudioNode *n = data;
+	const struct spa_pod_prop *prop;
+	float vols[SPA_AUDIO_MAX_CHANNELS];
+	uint32_t nvol = 0;
+	bool mute = n->muted;
+	double sum = 0.0, percent;
+
+	(void)seq;
+	(void)index;
+	(void)next;
+
+	if (id != SPA_PARAM_Props || !param
+			|| !spa_pod_is_object_type(param, SPA_TYPE_OBJECT_Props))
+		return;
+
+	SPA_POD_OBJECT_FOREACH((const struct spa_pod_object *)param, prop) {
+		switch (prop->key) {
+		case SPA_PROP_mute:
+			spa_pod_get_bool(&prop->value, &mute);
+			break;
+		case SPA_PROP_channelVolumes:
+			nvol = spa_pod_copy_array(&prop->value, SPA_TYPE_Float,
+					vols, SPA_AUDIO_MAX_CHANNELS);
+			break;
+		default:
+			break;
+		}
+	}
+
+	/* Props also arrives for partial updates without volumes; keep the
+	 * last known level then. */
+	if (nvol > 0) {
+		for (uint32_t i = 0; i < nvol; i++)
+			sum += vols[i];
+		/* channelVolumes is linear; wpctl and every mixer UI show the
+		 * cubic-root scale. */
+		percent = cbrt(sum / nvol) * 100.0;
+		n->n_channels = nvol;
+	} else {
+		percent = n->percent;
+	}
+
+	if (n->have_props && fabs(percent - n->percent) < 0.05
+			&& n->muted == (int)mute)
+		return;
+	n->percent = percent;
+	n->muted = mute;
+	n->have_props = nvol > 0 || n->have_props;
+	if (pw_node_is_default(n))
+		pw_audio_wake();
+}
+
+static const struct pw_node_events pw_node_events = {
+	PW_VERSION_NODE_EVENTS,
+	.info = pw_node_info,
+	.param = pw_node_param,
+};
+
+/* ── default metadata (thread loop) ──────────────────────────────── */
+
+/* Values look like {"name":"alsa_output.pci-0000_00_1f.3.analog-stereo"} */
+static void
+pw_parse_default_name(const char *value, char *out, size_t len)
+{
+	const char *p, *end;
+
+	out[0] = '\0';
+	if (!value || !(p = strstr(value, "\"name\"")))
+		return;
+	p = strchr(p + 6, ':');
+	if (!p || !(p = strchr(p, '"')))
+		return;
+	p++;
+	end = strchr(p, '"');
+	if (!end)
+		return;
+	snprintf(out, len, "%.*s", (int)(end - p), p);
+}
+
+static int
+pw_meta_property(void *data, uint32_t subject, const char *key,
+		const char *type, const char *value)
+{
+	char name[128];
+
+	(void)data;
+	(void)type;
+
+	if (subject != PW_ID_CORE)
+		return 0;
+
+	/* key == NULL: every property of the subject was cleared */
+	if (!key || strcmp(key, "default.audio.sink") == 0) {
+		pw_parse_default_name(value, name, sizeof(name));
+		if (strcmp(name, pw_default_sink) != 0) {
+			snprintf(pw_default_sink, sizeof(pw_default_sink), "%s", name);
+			pw_audio_wake();
+		}
+	}
+	if (!key || strcmp(key, "default.audio.source") == 0) {
+		pw_parse_default_name(value, name, sizeof(name));
+		if (strcmp(name, pw_default_source) != 0) {
+			snprintf(pw_default_source, sizeof(pw_default_source), "%s", name);
+			pw_audio_wake();
+		}
+	}
+	return 0;
+}
+
+static const struct pw_metadata_events pw_meta_events = {
+	PW_VERSION_METADATA_EVENTS,
+	.property = pw_meta_property,
+};
+
+/* ── registry (thread loop) ──────────────────────────────────────── */
+
+static void
+pw_registry_global(void *data, uint32_t id, uint32_t permissions,
+		const char *type, uint32_t version, const struct spa_dict *props)
+{
+	const char *media_class, *name;
+	PwAudioNode *n;
+	uint32_t param_ids[] = { SPA_PARAM_Props };
+
+	(void)data;
+	(void)permissions;
+	(void)version;
+
+	if (!props)
+		return;
+
+	if (strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0) {
+		name = spa_dict_lookup(props, PW_KEY_METADATA_NAME);
+		if (!name || strcmp(name, "default") != 0 || pw_default_meta)
+			return;
+		pw_default_meta = pw_registry_bind(pw_registry, id,
+				PW_TYPE_INTERFACE_Metadata, PW_VERSION_METADATA, 0);
+		if (!pw_default_meta)
+			return;
+		pw_default_meta_id = id;
+		pw_metadata_add_listener(pw_default_meta, &pw_meta_listener,
+				&pw_meta_events, NULL);
+		return;
+	}
+
+	if (strcmp(type, PW_TYPE_INTERFACE_Node) != 0)
+		return;
+	media_class = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+	name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+	if (!media_class || !name)
+		return;
+	if (strcmp(media_class, "Audio/Sink") != 0
+			&& strcmp(media_class, "Audio/Source") != 0)
+		return;
+	n = NULL;
+	for (int i = 0; i < pw_node_count; i++) {
+		if (!pw_nodes[i].proxy) {
+			n = &pw_nodes[i];
+			break;
+		}
+	}
+	if (!n) {
+		if (pw_node_count >= PW_AUDIO_MAX_NODES)
+			return;
+		n = &pw_nodes[pw_node_count++];
+	}
+	memset(n, 0, sizeof(*n));
+	n->proxy = pw_registry_bind(pw_registry, id, PW_TYPE_INTERFACE_Node,
+			PW_VERSION_NODE, 0);
+	if (!n->proxy)
+		return;
+	n->id = id;
+	n->is_source = strcmp(media_class, "Audio/Source") == 0;
+	n->headset = pw_dict_is_headset(props);
+	n->percent = -1.0;
+	snprintf(n->name, sizeof(n->name), "%s", name);
+
+	pw_node_add_listener(n->proxy, &n->listener, &pw_node_events, n);
+	pw_node_subscribe_params(n->proxy, param_ids, LENGTH(param_ids));
+}
+
+static void
+pw_registry_global_remove(void *data, uint32_t id)
+{
+	PwAudioNode *n;
+	int was_default;
+
+	(void)data;
+
+	if (id == pw_default_meta_id && pw_default_meta) {
+		spa_hook_remove(&pw_meta_listener);
+		pw_proxy_destroy((struct pw_proxy *)pw_default_meta);
+		pw_default_meta = NULL;
+		pw_default_meta_id = SPA_ID_INVALID;
+		return;
+	}
+
+	if (!(n = pw_find_node_by_id(id)))
+		return;
+	was_default = pw_node_is_default(n);
+	spa_hook_remove(&n->listener);
+	pw_proxy_destroy((struct pw_proxy *)n->proxy);
+	/* Slots are never moved: the spa_hook inside is linked into the
+	 * proxy's listener list by address. */
+	memset(n, 0, sizeof(*n));
+	n->id = SPA_ID_INVALID;
+	if (was_default)
+		pw_audio_wake();
+}
+
+static const struct pw_registry_events pw_registry_events = {
+	PW_VERSION_REGISTRY_EVENTS,
+	.global = pw_registry_global,
+	.global_remove = pw_registry_global_remove,
+};
+
+static void
+pw_core_error(void *data, uint32_t id, int seq, int res, const char *message)
+{
+	(void)data;
+	(void)seq;
+
+	if (id != PW_ID_CORE || res != -EPIPE)
+		return;
+	wlr_log(WLR_INFO, "pw_audio: connection lost (%s)",
+			message ? message : "");
+	pw_connected = 0;
+	pw_audio_wake();
+}
+
+static const struct pw_core_events pw_core_events = {
+	PW_VERSION_CORE_EVENTS,
+	.error = pw_core_error,
+};
+
+/* ── compositor thread ───────────────────────────────────────────── */
+
+static int
+pw_retry_cb(void *data)
+{
+	(void)data;
+	pw_audio_teardown();
+	if (pw_audio_connect() != 0)
+		wl_event_source_timer_update(pw_retry_timer, PW_AUDIO_RETRY_MS);
+	return 0;
+}
+
+static void
+pw_schedule_retry(void)
+{
+	if (!pw_retry_timer)
+		pw_retry_timer = wl_event_loop_add_timer(event_loop,
+				pw_retry_cb, NULL);
+	if (pw_retry_timer)
+		wl_event_source_timer_update(pw_retry_timer, PW_AUDIO_RETRY_MS);
+}
+
+static int
+pw_wake_cb(int fd, uint32_t mask, void *data)
+{
+	uint64_t cnt;
+	int connected;
+
+	(void)mask;
+	(void)data;
+
+	while (read(fd, &cnt, sizeof(cnt)) > 0)
+		;
+
+	pw_thread_loop_lock(pw_loop);
+	connected = pw_connected;
+	pw_thread_loop_unlock(pw_loop);
+
+	if (!connected) {
+		pw_schedule_retry();
+		return 0;
+	}
+
+	/* Both readers now answer from the native snapshot, so a refresh
+	 * costs no process spawn. */
+	refreshstatusvolume();
+	refreshstatusmic();
+	return 0;
+}
+
+static int
+pw_audio_connect(void)
+{
+	pw_loop = pw_thread_loop_new("nixly-pw", NULL);
+	if (!pw_loop)
+		return -1;
+	pw_ctx = pw_context_new(pw_thread_loop_get_loop(pw_loop), NULL, 0);
+	if (!pw_ctx)
+		goto fail;
+
+	pw_thread_loop_lock(pw_loop);
+	if (pw_thread_loop_start(pw_loop) < 0) {
+		pw_thread_loop_unlock(pw_loop);
+		goto fail;
+	}
+	pw_core_proxy = pw_context_connect(pw_ctx, NULL, 0);
+	if (!pw_core_proxy) {
+		pw_thread_loop_unlock(pw_loop);
+		goto fail;
+	}
+	pw_core_add_listener(pw_core_proxy, &pw_core_listener,
+			&pw_core_events, NULL);
+	pw_registry = pw_core_get_registry(pw_core_proxy,
+			PW_VERSION_REGISTRY, 0);
+	if (pw_registry)
+		pw_registry_add_listener(pw_registry, &pw_registry_listener,
+				&pw_registry_events, NULL);
+	pw_connected = pw_registry != NULL;
+	pw_thread_loop_unlock(pw_loop);
+
+	if (!pw_connected)
+		goto fail;
+	wlr_log(WLR_INFO, "pw_audio: connected to PipeWire");
+	return 0;
+
+fail:
+	pw_audio_teardown();
+	return -1;
+}
+
+static void
+pw_audio_teardown(void)
+{
+	if (!pw_loop)
+		return;
+
+	pw_thread_loop_stop(pw_loop);
+	for (int i = 0; i < pw_node_count; i++) {
+		if (!pw_nodes[i].proxy)
+			continue;
+		spa_hook_remove(&pw_nodes[i].listener);
+		pw_proxy_destroy((struct pw_proxy *)pw_nodes[i].proxy);
+		pw_nodes[i].proxy = NULL;
+	}
+	pw_node_count = 0;
+	if (pw_default_meta) {
+		spa_hook_remove(&pw_meta_listener);
+		pw_proxy_destroy((struct pw_proxy *)pw_default_meta);
+		pw_default_meta = NULL;
+		pw_default_meta_id = SPA_ID_INVALID;
+	}
+	if (pw_registry) {
+		spa_hook_remove(&pw_registry_listener);
+		pw_proxy_destroy((struct pw_proxy *)pw_registry);
+		pw_registry = NULL;
+	}
+	if (pw_core_proxy) {
+		spa_hook_remove(&pw_core_listener);
+		pw_core_disconnect(pw_core_proxy);
+		pw_core_proxy = NULL;
+	}
+	if (pw_ctx) {
+		pw_context_destroy(pw_ctx);
+		pw_ctx = NULL;
+	}
+	pw_thread_loop_destroy(pw_loop);
+	pw_loop = NULL;
+	pw_connected = 0;
+	pw_default_sink[0] = '\0';
+	pw_default_source[0] = '\0';
+}
+
+void
+pw_audio_setup(void)
+{
+	if (pw_initialized)
+		return;
+	pw_init(NULL, NULL);
+	pw_initialized = 1;
+
+	pw_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pw_wake_fd < 0)
+		return;
+	pw_wake_src = wl_event_loop_add_fd(event_loop, pw_wake_fd,
+			WL_EVENT_READABLE, pw_wake_cb, NULL);
+
+	/* PipeWire usually cold-starts alongside the compositor: a failed
+	 * first connect just arms the retry timer. */
+	if (pw_audio_connect() != 0)
+		pw_schedule_retry();
+}
+
+void
+pw_audio_cleanup(void)
+{
+	if (!pw_initialized)
+		return;
+	if (pw_retry_timer) {
+		wl_event_source_remove(pw_retry_timer);
+		pw_retry_timer = NULL;
+	}
+	pw_audio_teardown();
+	if (pw_wake_src) {
+		wl_event_source_remove(pw_wake_src);
+		pw_wake_src = NULL;
+	}
+	if (pw_wake_fd >= 0) {
+		close(pw_wake_fd);
+		pw_wake_fd = -1;
+	}
+	pw_deinit();
+	pw_initialized = 0;
+}
+
+/* Snapshot of the default sink (is_source = 0) or source.
+ * Returns -1 when not connected (callers fall back to wpctl), 0 when
+ * connected but there is no such default node, 2 when the node is
+ * bound but its Props have not arrived yet (only *headset is filled,
+ * from the global's properties), 1 on success. */
+int
+pw_audio_get(int is_source, double *percent, int *muted, int *headset)
+{
+	PwAudioNode *n;
+	int ret;
+
+	if (!pw_loop)
+		return -1;
+
+	pw_thread_loop_lock(pw_loop);
+	if (!pw_connected) {
+		ret = -1;
+	} else if (!(n = pw_find_default(is_source))) {
+		ret = 0;
+	} else if (!n->have_props) {
+		if (headset)
+			*headset = n->headset;
+		ret = 2;
+	} else {
+		if (percent)
+			*percent = n->percent;
+		if (muted)
+			*muted = n->muted;
+		if (headset)
+			*headset = n->headset;
+		ret = 1;
+	}
+	pw_thread_loop_unlock(pw_loop);
+	return ret;
+}
+
+static int
+pw_audio_set_props(int is_source, double percent, int mute)
+{
+	uint8_t buf[1024];
+	struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buf, sizeof(buf));
+	struct spa_pod_frame f;
+	struct spa_pod *pod;
+	float vols[SPA_AUDIO_MAX_CHANNELS];
+	PwAudioNode *n;
+	int ret = -1;
+
+	if (!pw_loop)
+		return -1;
+
+	pw_thread_loop_lock(pw_loop);
+	if (!pw_connected || !(n = pw_find_default(is_source))
+			|| !n->have_props)
+		goto out;
+
+	spa_pod_builder_push_object(&b, &f, SPA_TYPE_OBJECT_Props,
+			SPA_PARAM_Props);
+	if (percent >= 0.0) {
+		float lin;
+
+		if (!n->n_channels)
+			goto out;
+		lin = (float)pow(percent / 100.0, 3.0);
+		for (uint32_t i = 0; i < n->n_channels; i++)
+			vols[i] = lin;
+		spa_pod_builder_prop(&b, SPA_PROP_channelVolumes, 0);
+		spa_pod_builder_array(&b, sizeof(float), SPA_TYPE_Float,
+				n->n_channels, vols);
+	}
+	if (mute >= 0) {
+		if (mute > 1) /* toggle */
+			mute = !n->muted;
+		spa_pod_builder_prop(&b, SPA_PROP_mute, 0);
+		spa_pod_builder_bool(&b, mute);
+	}
+	pod = spa_pod_builder_pop(&b, &f);
+
+	if (pw_node_set_param(n->proxy, SPA_PARAM_Props, 0, pod) < 0)
+		goto out;
+
+	/* Optimistic: the param echo lands a few ms later and wakes the bar
+	 * again only if PipeWire ended up somewhere else. */
+	if (percent >= 0.0)
+		n->percent = percent;
+	if (mute >= 0)
+		n->muted = mute;
+	ret = 0;
+out:
+	pw_thread_loop_unlock(pw_loop);
+	return ret;
+}
+
+int
+pw_audio_set_volume(int is_source, double percent)
+{
+	if (percent < 0.0)
+		percent = 0.0;
+	return pw_audio_set_props(is_source, percent, -1);
+}
+
+/* mute: 0/1 sets, -1 toggles */
+int
+pw_audio_set_mute(int is_source, int mute)
+{
+	return pw_audio_set_props(is_source, -1.0, mute < 0 ? 2 : !!mute);
+}
@@ -16,6 +16,7 @@ clearstatusmodule(StatusModule *module)
 			continue;
 		wlr_scene_node_destroy(node);
 	}
+	statusbar_flat_schedule();
 }
 
 void
@@ -31,6 +32,7 @@ updatemodulebg(StatusModule *module, int width, int height,
 
 	if (!module->bg && !(module->bg = wlr_scene_tree_create(module->tree)))
 		return;
+	statusbar_flat_schedule();
 	wlr_scene_node_set_enabled(&module->bg->node, 1);
 	wlr_scene_node_set_position(&module->bg->node, 0, 0);
 
@@ -72,15 +74,13 @@ updatemodulebg(StatusModule *module, int width, int height,
 void
 renderclock(StatusModule *module, int bar_height, const char *text)
 {
-	render_icon_label(module, bar_height, text,
-			ensure_clock_icon_buffer, &clock_icon_buf, &clock_icon_w, &clock_icon_h,
+	render_icon_label(module, bar_height, text, clock_icon_path,
 			0, statusbar_icon_text_gap_clock, statusbar_fg);
 }
 
 void
 render_icon_label(StatusModule *module, int bar_height, const char *text,
-		int (*ensure_icon)(int target_h), struct wlr_buffer **icon_buf,
-		int *icon_w, int *icon_h, int min_text_w, int icon_gap,
+		const char *icon_path, int min_text_w, int icon_gap,
 		const float text_color[static 4])
 {
 	int padding = statusbar_module_padding;
@@ -90,6 +90,7 @@ render_icon_label(StatusModule *module, int bar_height, const char *text,
 	int target_h;
 	int scaled_target_h;
 	struct wlr_scene_buffer *scene_buf;
+	struct wlr_buffer *icon = NULL;
 	const float *fg = text_color ? text_color : statusbar_fg;
 
 	if (!module || !module->tree)
@@ -115,11 +116,10 @@ render_icon_label(StatusModule *module, int bar_height, const char *text,
 			scaled_target_h = target_h;
 	}
 
-	if (ensure_icon && icon_buf && icon_w && icon_h
-			&& ensure_icon(scaled_target_h) == 0
-			&& *icon_buf && *icon_w > 0 && *icon_h > 0) {
-		iw = *icon_w;
-		ih = *icon_h;
+	if (icon_path && (icon = icon_cache_get(icon_path, scaled_target_h, 0,
+					&iw, &ih)) && (iw <= 0 || ih <= 0)) {
+		icon = NULL;
+		iw = ih = 0;
 	}
 
 	if (text && *text)
@@ -138,11 +138,11 @@ render_icon_label(StatusModule *module, int bar_height, const char *text,
 	updatemodulebg(module, module->width, bar_height, statusbar_bg);
 	x = padding;
 
-	if (iw > 0 && icon_buf && *icon_buf) {
+	if (icon) {
 		scene_buf = wlr_scene_buffer_create(module->tree, NULL);
 		if (scene_buf) {
 			int icon_y = (bar_height - ih) / 2;
-			wlr_scene_buffer_set_buffer(scene_buf, *icon_buf);
+			wlr_scene_buffer_set_buffer(scene_buf, icon);
 			wlr_scene_node_set_position(&scene_buf->node, x, icon_y);
 		}
 		x += iw + (text_w > 0 ? icon_gap : padding);
@@ -152,9 +152,172 @@ render_icon_label(StatusModule *module, int bar_height, const char *text,
 		tray_render_label(module, text, x, bar_height, fg);
 }
 
+/* Shaped-label cache.  The clock, CPU/RAM percentages and net labels
+ * repeat the same handful of strings on every refresh; decoding, kerning
+ * and compositing them glyph by glyph (one pixman image and one
+ * wlr_buffer per character) each time is pure waste.  An entry keeps the
+ * measured width and, once rendered, a single pre-composited buffer for
+ * the whole label.  Scene buffers hold their own lock, so evicting an
+ * entry never pulls pixels from under a bar that still shows them. */
+#define LABEL_CACHE_SIZE 128
+
+struct LabelCacheEntry {
+	char *text;
+	uint64_t hash;
+	struct fcft_font *font;
+	int spacing;
+	enum fcft_subpixel subpixel;
+	int force_color;
+	float color[4];
+	struct wlr_buffer *buf;		/* NULL: width-only entry */
+	int width;
+	int left, top;			/* buffer offset from pen origin */
+	uint64_t stamp;
+};
+
+static struct LabelCacheEntry label_cache[LABEL_CACHE_SIZE];
+static uint64_t label_cache_clock;
+
+static uint64_t
+label_cache_hash(const char *text)
+{
+	uint64_t h = 1469598103934665603ULL;
+
+	for (; *text; text++)
+		h = (h ^ (unsigned char)*text) * 1099511628211ULL;
+	return h;
+}
+
+/* Entry whose shaping (width) matches the current font settings.  With
+ * color != NULL the entry must also carry a buffer in that colour. */
+static struct LabelCacheEntry *
+label_cache_find(const char *text, uint64_t hash, const float *color)
+{
+	struct LabelCacheEntry *e;
+
+	for (size_t i = 0; i < LENGTH(label_cache); i++) {
+		e = &label_cache[i];
+		if (!e->text || e->hash != hash || e->font != statusfont.font
+				|| e->spacing != statusbar_font_spacing
+				|| e->subpixel != statusbar_font_subpixel
+				|| strcmp(e->text, text) != 0)
+			continue;
+		if (color && (!e->buf || e->force_color != statusbar_font_force_color
+				|| memcmp(e->color, color, sizeof(e->color)) != 0))
+			continue;
+		e->stamp = ++label_cache_clock;
+		return e;
+	}
+	return NULL;
+}
+
+static void
+label_cache_release(struct LabelCacheEntry *e)
+{
+	if (e->buf)
+		wlr_buffer_drop(e->buf);
+	free(e->text);
+	memset(e, 0, sizeof(*e));
+}
+
+/* Fresh slot for text: a free one, else the least recently used. */
+static struct LabelCacheEntry *
+label_cache_insert(const char *text, uint64_t hash)
+{
+	struct LabelCacheEntry *e = &label_cache[0];
+
+	for (size_t i = 0; i < LENGTH(label_cache); i++) {
+		if (!label_cache[i].text) {
+			e = &label_cache[i];
+			break;
+		}
+		if (label_cache[i].stamp < e->stamp)
+			e = &label_cache[i];
+	}
+	label_cache_release(e);
+	if (!(e->text = strdup(text)))
+		return NULL;
+	e->hash = hash;
+	e->font = statusfont.font;
+	e->spacing = statusbar_font_spacing;
+	e->subpixel = statusbar_font_subpixel;
+	e->stamp = ++label_cache_clock;
+	return e;
+}
+
+void
+label_cache_flush(void)
+{
+	for (size_t i = 0; i < LENGTH(label_cache); i++)
+		label_cache_release(&label_cache[i]);
+}
+
+/* One ARGB buffer holding every glyph of the run, composited with OVER
+ * so overlapping (kerned) glyphs blend the same way separate scene
+ * buffers did. */
+static struct wlr_buffer *
+label_buffer_from_glyphs(const struct GlyphRun *runs, size_t n, int left,
+		int top, int width, int height, const float color[static 4])
+{
+	pixman_image_t *dst, *solid = NULL;
+	struct PixmanBuffer *buf;
+	pixman_color_t col;
+	uint32_t *data;
+	int stride;
+
+	if (width <= 0 || height <= 0)
+		return NULL;
+
+	stride = width * 4;
+	data = ecalloc(height, stride);
+	dst = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, width, height,
+			data, stride);
+	if (!dst) {
+		free(data);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		const struct fcft_glyph *glyph = runs[i].glyph;
+		int dx = runs[i].pen_x + glyph->x - left;
+		int dy = -glyph->y - top;
+
+		if (statusbar_font_force_color
+				|| pixman_image_get_format(glyph->pix) == PIXMAN_a8) {
+			if (!solid) {
+				col.alpha = (uint16_t)lroundf(color[3] * 65535.0f);
+				col.red = (uint16_t)lroundf(color[0] * 65535.0f);
+				col.green = (uint16_t)lroundf(color[1] * 65535.0f);
+				col.blue = (uint16_t)lroundf(color[2] * 65535.0f);
+				solid = pixman_image_create_solid_fill(&col);
+			}
+			pixman_image_composite32(PIXMAN_OP_OVER, solid, glyph->pix, dst,
+					0, 0, 0, 0, dx, dy, glyph->width, glyph->height);
+		} else {
+			pixman_image_composite32(PIXMAN_OP_OVER, glyph->pix, NULL, dst,
+					0, 0, 0, 0, dx, dy, glyph->width, glyph->height);
+		}
+	}
+
+	if (solid)
+		pixman_image_unref(solid);
+
+	buf = ecalloc(1, sizeof(*buf));
+	buf->image = dst;
+	buf->data = data;
+	buf->drm_format = DRM_FORMAT_ARGB8888;
+	buf->stride = stride;
+	buf->owns_data = 1;
+	wlr_buffer_init(&buf->base, &pixman_buffer_impl, width, height);
+
+	return &buf->base;
+}
+
 int
 status_text_width(const char *text)
 {
+	struct LabelCacheEntry *e;
+	uint64_t hash;
 	int pen_x = 0;
 	uint32_t prev_cp = 0;
 
@@ -164,6 +327,10 @@ status_text_width(const char *text)
 	if (!statusfont.font)
 		return (int)strlen(text) * 8;
 
+	hash = label_cache_hash(text);
+	if ((e = label_cache_find(text, hash, NULL)))
+		return e->width;
+
 	for (int i = 0; text[i]; ) {
 		long kern_x = 0, kern_y = 0;
 		uint32_t cp;
@@ -230,35 +397,38 @@ status_text_width(const char *text)
 		prev_cp = cp;
 	}
 
+	if ((e = label_cache_insert(text, hash)))
+		e->width = pen_x;
 	return pen_x;
 }
 
-int
-tray_render_label(StatusModule *module, const char *text, int x, int bar_height,
-		const float color[static 4])
+/* Shape text once and return the cached buffer holding the whole run
+ * in color, or NULL when nothing in it has pixels.  The buffer belongs
+ * to the cache; attach it to a scene buffer (which takes its own lock)
+ * rather than dropping it.  *left and *top place the buffer relative to
+ * the pen origin and baseline, *advance is the pen advance for layout. */
+struct wlr_buffer *
+statusbar_label_buffer(const char *text, const float color[static 4],
+		int *left, int *top, int *advance)
 {
 	tll(struct GlyphRun) glyphs = tll_init();
 	const struct fcft_glyph *glyph;
-	struct wlr_scene_buffer *scene_buf;
-	struct wlr_buffer *buffer;
+	struct LabelCacheEntry *e;
+	struct GlyphRun *runs;
+	uint64_t hash;
 	uint32_t prev_cp = 0;
 	int pen_x = 0;
+	int min_x = INT_MAX, max_x = INT_MIN;
 	int min_y = INT_MAX, max_y = INT_MIN;
-	int text_width, text_height, origin_y;
-	size_t i;
-	const float *prev_fg = statusbar_fg_override;
+	size_t i, n;
 
-	if (!module || !module->tree || !text || !*text || bar_height <= 0)
-		return 0;
+	*left = *top = *advance = 0;
+	if (!statusfont.font || !text || !*text)
+		return NULL;
 
-	statusbar_fg_override = color;
-	if (!statusfont.font) {
-		int w = status_text_width(text);
-		if (w <= 0)
-			w = statusbar_font_spacing;
-		statusbar_fg_override = prev_fg;
-		return w;
-	}
+	hash = label_cache_hash(text);
+	if ((e = label_cache_find(text, hash, color)))
+		goto out;
 
 	for (i = 0; text[i]; ) {
 		long kern_x = 0, kern_y = 0;
@@ -326,6 +496,10 @@ tray_render_label(StatusModule *module, const char *text, int x, int bar_height,
 				.pen_x = pen_x,
 				.codepoint = cp,
 			}));
+			if (pen_x + glyph->x < min_x)
+				min_x = pen_x + glyph->x;
+			if (pen_x + glyph->x + glyph->width > max_x)
+				max_x = pen_x + glyph->x + glyph->width;
 			if (-glyph->y < min_y)
 				min_y = -glyph->y;
 			if (-glyph->y + glyph->height > max_y)
@@ -337,45 +511,78 @@ tray_render_label(StatusModule *module, const char *text, int x, int bar_height,
 		prev_cp = cp;
 	}
 
-	if (tll_length(glyphs) == 0) {
+	n = tll_length(glyphs);
+	if (n == 0) {
 		tll_free(glyphs);
-		statusbar_fg_override = prev_fg;
-		return 0;
+		return NULL;
 	}
 
+	/* Upgrade a width-only entry left by status_text_width() rather
+	 * than shaping the same string into a second slot. */
+	if (!(e = label_cache_find(text, hash, NULL)) || e->buf)
+		e = label_cache_insert(text, hash);
+	if (!e) {
+		tll_free(glyphs);
+		*advance = pen_x;
+		return NULL;
+	}
+
+	runs = ecalloc(n, sizeof(*runs));
+	i = 0;
+	tll_foreach(glyphs, it)
+		runs[i++] = it->item;
+	tll_free(glyphs);
+
 	/* pen_x already holds the exact advance from the glyph loop —
 	 * status_text_width() would re-walk the string and redo kerning
 	 * and glyph-cache lookups for the same value. */
-	text_width = pen_x;
-	text_height = max_y - min_y;
-	origin_y = (bar_height - text_height) / 2 - min_y;
-
-	tll_foreach(glyphs, it) {
-		glyph = it->item.glyph;
-		buffer = statusbar_buffer_from_glyph(glyph);
-		if (!buffer)
-			continue;
+	e->width = pen_x;
+	e->left = min_x;
+	e->top = min_y;
+	e->force_color = statusbar_font_force_color;
+	memcpy(e->color, color, sizeof(e->color));
+	e->buf = label_buffer_from_glyphs(runs, n, min_x, min_y,
+			max_x - min_x, max_y - min_y, color);
+	free(runs);
+
+out:
+	*left = e->left;
+	*top = e->top;
+	*advance = e->width;
+	return e->buf;
+}
 
-		scene_buf = wlr_scene_buffer_create(module->tree, NULL);
-		if (scene_buf) {
-			wlr_scene_buffer_set_buffer(scene_buf, buffer);
-			wlr_scene_node_set_position(&scene_buf->node,
-					x + it->item.pen_x + glyph->x,
-					origin_y - glyph->y);
-		}
-		wlr_buffer_drop(buffer);
+int
+tray_render_label(StatusModule *module, const char *text, int x, int bar_height,
+		const float color[static 4])
+{
+	struct wlr_scene_buffer *scene_buf;
+	struct wlr_buffer *buffer;
+	int left, top, advance;
+
+	if (!module || !module->tree || !text || !*text || bar_height <= 0)
+		return 0;
+
+	if (!statusfont.font) {
+		int w = status_text_width(text);
+		if (w <= 0)
+			w = statusbar_font_spacing;
+		return w;
 	}
 
-	tll_free(glyphs);
-	statusbar_fg_override = prev_fg;
-	return text_width;
+	buffer = statusbar_label_buffer(text, color, &left, &top, &advance);
+	if (buffer && (scene_buf = wlr_scene_buffer_create(module->tree, NULL))) {
+		wlr_scene_buffer_set_buffer(scene_buf, buffer);
+		wlr_scene_node_set_position(&scene_buf->node, x + left,
+				(bar_height - buffer->height) / 2);
+	}
+	return advance;
 }
 
 void
 rendercpu(StatusModule *module, int bar_height, const char *text)
 {
-	render_icon_label(module, bar_height, text,
-			ensure_cpu_icon_buffer, &cpu_icon_buf, &cpu_icon_w, &cpu_icon_h,
+	render_icon_label(module, bar_height, text, cpu_icon_path,
 			0, statusbar_icon_text_gap_cpu, statusbar_fg);
 }
 
@@ -393,8 +600,7 @@ renderlight(StatusModule *module, int bar_height, const char *text)
 		return;
 	}
 
-	render_icon_label(module, bar_height, text,
-			ensure_light_icon_buffer, &light_icon_buf, &light_icon_w, &light_icon_h,
+	render_icon_label(module, bar_height, text, light_icon_path,
 			0, statusbar_icon_text_gap_light, statusbar_fg);
 }
 
@@ -421,24 +627,21 @@ renderbattery(StatusModule *module, int bar_height, const char *text)
 		return;
 	}
 
-	render_icon_label(module, bar_height, text,
-			ensure_battery_icon_buffer, &battery_icon_buf, &battery_icon_w, &battery_icon_h,
+	render_icon_label(module, bar_height, text, battery_icon_path,
 			0, statusbar_icon_text_gap_battery, statusbar_fg);
 }
 
 void
 renderram(StatusModule *module, int bar_height, const char *text)
 {
-	render_icon_label(module, bar_height, text,
-			ensure_ram_icon_buffer, &ram_icon_buf, &ram_icon_w, &ram_icon_h,
+	render_icon_label(module, bar_height, text, ram_icon_path,
 			0, statusbar_icon_text_gap_ram, statusbar_fg);
 }
 
 void
 rendervolume(StatusModule *module, int bar_height, const char *text)
 {
-	render_icon_label(module, bar_height, text,
-			ensure_volume_icon_buffer, &volume_icon_buf, &volume_icon_w, &volume_icon_h,
+	render_icon_label(module, bar_height, text, volume_icon_path,
 			0, statusbar_icon_text_gap_volume, volume_text_color);
 }
 
@@ -454,503 +657,29 @@ rendermic(StatusModule *module, int bar_height, const char *text)
 		return;
 	}
 
-	render_icon_label(module, bar_height, text,
-			ensure_mic_icon_buffer, &mic_icon_buf, &mic_icon_w, &mic_icon_h,
+	render_icon_label(module, bar_height, text, mic_icon_path,
 			0, statusbar_icon_text_gap_microphone, mic_text_color);
 }
 
-void
-drop_cpu_icon_buffer(void)
+/* The (currently hidden) net module's icon.  wifi_100 is synthesized
+ * rather than loaded: themes tint that asset. */
+struct wlr_buffer *
+net_icon_buffer(int target_h, int *w, int *h)
 {
-	if (cpu_icon_buf) {
-		wlr_buffer_drop(cpu_icon_buf);
-		cpu_icon_buf = NULL;
-	}
-	cpu_icon_loaded_h = 0;
-	cpu_icon_w = cpu_icon_h = 0;
-	cpu_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_cpu_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
 	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = cpu_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(cpu_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (cpu_icon_buf && cpu_icon_loaded_h == target_h &&
-			strncmp(cpu_icon_loaded_path, path, sizeof(cpu_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "cpu icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_cpu_icon_buffer();
-	cpu_icon_buf = buf;
-	cpu_icon_w = w;
-	cpu_icon_h = h;
-	cpu_icon_loaded_h = target_h;
-	snprintf(cpu_icon_loaded_path, sizeof(cpu_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_clock_icon_buffer(void)
-{
-	if (clock_icon_buf) {
-		wlr_buffer_drop(clock_icon_buf);
-		clock_icon_buf = NULL;
-	}
-	clock_icon_loaded_h = 0;
-	clock_icon_w = clock_icon_h = 0;
-	clock_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_clock_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = clock_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(clock_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (clock_icon_buf && clock_icon_loaded_h == target_h &&
-			strncmp(clock_icon_loaded_path, path, sizeof(clock_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "clock icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_clock_icon_buffer();
-	clock_icon_buf = buf;
-	clock_icon_w = w;
-	clock_icon_h = h;
-	clock_icon_loaded_h = target_h;
-	snprintf(clock_icon_loaded_path, sizeof(clock_icon_loaded_path), "%s", path);
-	return 0;
-}
+	int flags = 0;
 
-void
-drop_light_icon_buffer(void)
-{
-	if (light_icon_buf) {
-		wlr_buffer_drop(light_icon_buf);
-		light_icon_buf = NULL;
-	}
-	light_icon_loaded_h = 0;
-	light_icon_w = light_icon_h = 0;
-	light_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_light_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = light_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(light_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (light_icon_buf && light_icon_loaded_h == target_h &&
-			strncmp(light_icon_loaded_path, path, sizeof(light_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "light icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_light_icon_buffer();
-	light_icon_buf = buf;
-	light_icon_w = w;
-	light_icon_h = h;
-	light_icon_loaded_h = target_h;
-	snprintf(light_icon_loaded_path, sizeof(light_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_ram_icon_buffer(void)
-{
-	if (ram_icon_buf) {
-		wlr_buffer_drop(ram_icon_buf);
-		ram_icon_buf = NULL;
-	}
-	ram_icon_loaded_h = 0;
-	ram_icon_w = ram_icon_h = 0;
-	ram_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_ram_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = ram_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(ram_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (ram_icon_buf && ram_icon_loaded_h == target_h &&
-			strncmp(ram_icon_loaded_path, path, sizeof(ram_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "ram icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_ram_icon_buffer();
-	ram_icon_buf = buf;
-	ram_icon_w = w;
-	ram_icon_h = h;
-	ram_icon_loaded_h = target_h;
-	snprintf(ram_icon_loaded_path, sizeof(ram_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_volume_icon_buffer(void)
-{
-	if (volume_icon_buf) {
-		wlr_buffer_drop(volume_icon_buf);
-		volume_icon_buf = NULL;
-	}
-	volume_icon_loaded_h = 0;
-	volume_icon_w = volume_icon_h = 0;
-	volume_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_volume_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = volume_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(volume_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (volume_icon_buf && volume_icon_loaded_h == target_h &&
-			strncmp(volume_icon_loaded_path, path, sizeof(volume_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "volume icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_volume_icon_buffer();
-	volume_icon_buf = buf;
-	volume_icon_w = w;
-	volume_icon_h = h;
-	volume_icon_loaded_h = target_h;
-	snprintf(volume_icon_loaded_path, sizeof(volume_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_battery_icon_buffer(void)
-{
-	if (battery_icon_buf) {
-		wlr_buffer_drop(battery_icon_buf);
-		battery_icon_buf = NULL;
-	}
-	battery_icon_loaded_h = 0;
-	battery_icon_w = battery_icon_h = 0;
-	battery_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_battery_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = battery_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(battery_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (battery_icon_buf && battery_icon_loaded_h == target_h &&
-			strncmp(battery_icon_loaded_path, path, sizeof(battery_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "battery icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_battery_icon_buffer();
-	battery_icon_buf = buf;
-	battery_icon_w = w;
-	battery_icon_h = h;
-	battery_icon_loaded_h = target_h;
-	snprintf(battery_icon_loaded_path, sizeof(battery_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_mic_icon_buffer(void)
-{
-	if (mic_icon_buf) {
-		wlr_buffer_drop(mic_icon_buf);
-		mic_icon_buf = NULL;
-	}
-	mic_icon_loaded_h = 0;
-	mic_icon_w = mic_icon_h = 0;
-	mic_icon_loaded_path[0] = '\0';
-}
-
-int
-ensure_mic_icon_buffer(int target_h)
-{
-	GdkPixbuf *pixbuf = NULL;
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	char resolved[PATH_MAX];
-	const char *path = mic_icon_path;
-
-	if (target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(mic_icon_path, resolved, sizeof(resolved)) == 0 && resolved[0])
-		path = resolved;
-
-	if (mic_icon_buf && mic_icon_loaded_h == target_h &&
-			strncmp(mic_icon_loaded_path, path, sizeof(mic_icon_loaded_path)) == 0)
-		return 0;
-
-	if (tray_load_svg_pixbuf(path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "mic icon: failed to load '%s': %s",
-						path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-	drop_mic_icon_buffer();
-	mic_icon_buf = buf;
-	mic_icon_w = w;
-	mic_icon_h = h;
-	mic_icon_loaded_h = target_h;
-	snprintf(mic_icon_loaded_path, sizeof(mic_icon_loaded_path), "%s", path);
-	return 0;
-}
-
-void
-drop_net_icon_buffer(void)
-{
-	if (net_icon_buf) {
-		wlr_buffer_drop(net_icon_buf);
-		net_icon_buf = NULL;
-	}
-	net_icon_loaded_h = 0;
-	net_icon_loaded_path[0] = '\0';
-	net_icon_w = 0;
-	net_icon_h = 0;
-}
-
-int
-load_net_icon_buffer(const char *path, int target_h)
-{
-	GError *gerr = NULL;
-	struct wlr_buffer *buf;
-	int w = 0, h = 0;
-	GdkPixbuf *pixbuf = NULL;
-	char resolved[PATH_MAX];
-	const char *load_path = path;
-
-	if (!path || !*path || target_h <= 0)
-		return -1;
-
-	if (resolve_asset_path(path, resolved, sizeof(resolved)) == 0)
-		load_path = resolved;
-
-	/* For the 100% icon, synthesize the bars to avoid theme tinting entirely */
-	if (strcmp(path, net_icon_wifi_100) == 0
-			|| (net_icon_wifi_100_resolved[0]
-				&& strcmp(load_path, net_icon_wifi_100_resolved) == 0)) {
-		buf = statusbar_buffer_from_wifi100(target_h, &w, &h);
-		if (!buf) {
-			wlr_log(WLR_ERROR, "net icon: synth wifi_100 failed (path=%s resolved=%s)",
-					path, load_path);
-			return -1;
-		}
-		snprintf(net_icon_loaded_path, sizeof(net_icon_loaded_path), "%s", load_path);
-		goto done;
-	}
-
-	if (tray_load_svg_pixbuf(load_path, target_h, &pixbuf) != 0) {
-		pixbuf = gdk_pixbuf_new_from_file(load_path, &gerr);
-		if (!pixbuf) {
-			if (gerr) {
-				wlr_log(WLR_ERROR, "net icon: failed to load '%s': %s", load_path, gerr->message);
-				g_error_free(gerr);
-			}
-			return -1;
-		}
-	} else if (strcmp(path, net_icon_wifi_100) == 0
+	if (!strcmp(net_icon_path, net_icon_wifi_100)
 			|| (net_icon_wifi_100_resolved[0]
-					&& strcmp(load_path, net_icon_wifi_100_resolved) == 0)) {
-		/* Some themes tint this asset; normalize to expected green */
-		recolor_wifi100_pixbuf(pixbuf);
-	}
-
-	buf = statusbar_buffer_from_pixbuf(pixbuf, target_h, &w, &h);
-	if (!buf)
-		return -1;
-
-done:
-	drop_net_icon_buffer();
-	net_icon_buf = buf;
-	net_icon_w = w;
-	net_icon_h = h;
-	net_icon_loaded_h = target_h;
-	snprintf(net_icon_loaded_path, sizeof(net_icon_loaded_path), "%s", load_path);
-	wlr_log(WLR_INFO, "net icon: loaded %s (resolved=%s) w=%d h=%d target_h=%d",
-			path, load_path, net_icon_w, net_icon_h, target_h);
-	return 0;
-}
-
-int
-ensure_net_icon_buffer(int target_h)
-{
-	if (target_h <= 0)
-		return -1;
-
-	if (net_icon_buf && net_icon_loaded_h == target_h &&
-			strncmp(net_icon_loaded_path, net_icon_path, sizeof(net_icon_loaded_path)) == 0)
-		return 0;
-
-	if (load_net_icon_buffer(net_icon_path, target_h) == 0)
-		return 0;
+				&& !strcmp(net_icon_path, net_icon_wifi_100_resolved)))
+		flags = ICON_CACHE_WIFI100;
 
+	if ((buf = icon_cache_get(net_icon_path, target_h, flags, w, h)))
+		return buf;
 	/* fallback to offline icon if the requested asset is missing */
 	if (strcmp(net_icon_path, net_icon_no_conn) != 0)
-		return load_net_icon_buffer(net_icon_no_conn, target_h);
-
-	return -1;
+		return icon_cache_get(net_icon_no_conn, target_h, 0, w, h);
+	return NULL;
 }
 
 /* Render the SNI system-tray items (real icons) into the traylabel module.
@@ -988,10 +717,10 @@ rendertray(Monitor *m, int bar_height)
 			 * properties were ready (SNI startup race).  NewIcon
 			 * signals clear the failed-latch when the app publishes
 			 * an icon; this timed retry is only the safety net.
-			 * Unconditional retry here would re-run the full icon
-			 * theme scan (potentially 1e5 stat() calls) plus D-Bus
-			 * round-trips on EVERY layout pass for a permanently
-			 * icon-less item. */
+			 * Unconditional retry here would send a GetAll to a
+			 * permanently icon-less item on EVERY layout pass.  The
+			 * load is asynchronous: a failed reply arms the retry
+			 * itself. */
 			uint64_t now_ms = monotonic_msec();
 			if (!it->icon_tried ||
 			    (it->icon_failed &&
@@ -1155,23 +884,6 @@ cpu_proc_is_critical(pid_t pid, const char *name)
 	return 1;
 }
 
-int
-cpu_proc_cmp(const void *a, const void *b)
-{
-	const CpuProcEntry *pa = a;
-	const CpuProcEntry *pb = b;
-
-	if (pa->cpu < pb->cpu)
-		return 1;
-	if (pa->cpu > pb->cpu)
-		return -1;
-	if (pa->pid < pb->pid)
-		return -1;
-	if (pa->pid > pb->pid)
-		return 1;
-	return 0;
-}
-
 int
 cpu_popup_clamped_x(Monitor *m, CpuPopup *p)
 {
@@ -1222,55 +934,25 @@ cpu_popup_hover_index(Monitor *m, CpuPopup *p)
 int
 kill_processes_with_name(const char *name)
 {
-	DIR *dir;
-	struct dirent *ent;
+	ProcInfo *procs;
 	int killed = 0;
 	int found = 0;
+	int n;
 
 	if (!name || !*name)
 		return 0;
 
-	dir = opendir("/proc");
-	if (!dir)
+	proctable_refresh();
+	if ((n = proctable_snapshot(&procs)) < 0)
 		return 0;
 
-	while ((ent = readdir(dir))) {
-		pid_t pid = 0;
-		char comm_path[PATH_MAX];
-		char comm[256];
-		FILE *fp;
-		size_t len;
-		int is_num = 1;
-
-		if (!ent->d_name || !*ent->d_name)
-			continue;
-		for (size_t i = 0; ent->d_name[i]; i++) {
-			if (!isdigit((unsigned char)ent->d_name[i])) {
-				is_num = 0;
-				break;
-			}
-		}
-		if (!is_num)
-			continue;
+	for (int i = 0; i < n; i++) {
+		pid_t pid = procs[i].pid;
 
-		pid = (pid_t)atoi(ent->d_name);
 		if (pid <= 1 || pid == getpid())
 			continue;
 
-		snprintf(comm_path, sizeof(comm_path), "/proc/%s/comm", ent->d_name);
-		fp = fopen(comm_path, "r");
-		if (!fp)
-			continue;
-		if (!fgets(comm, sizeof(comm), fp)) {
-			fclose(fp);
-			continue;
-		}
-		fclose(fp);
-		len = strlen(comm);
-		if (len > 0 && comm[len - 1] == '\n')
-			comm[len - 1] = '\0';
-
-		if (strcmp(comm, name) == 0) {
+		if (strcmp(procs[i].comm, name) == 0) {
 			/* found means "a process with this comm exists" —
 			 * setting it for every numeric /proc entry made the
 			 * pkill fallback fork for names that never existed. */
@@ -1284,7 +966,7 @@ kill_processes_with_name(const char *name)
 		}
 	}
 
-	closedir(dir);
+	free(procs);
 	if (killed == 0 && found > 0) {
 		/* Fallback: use pkill (non-blocking) */
 		if (fork() == 0) {
@@ -1296,72 +978,40 @@ kill_processes_with_name(const char *name)
 	return killed;
 }
 
+static int
+cpu_proc_keep(pid_t pid, const char *name, unsigned long rss_kb)
+{
+	(void)rss_kb;
+	return !cpu_proc_is_critical(pid, name);
+}
+
 int
 read_top_cpu_processes(CpuPopup *p)
 {
-	FILE *fp;
-	char line[256];
-	int count = 0;
-	int lines = 0;
+	ProcGroup top[LENGTH(p->procs)];
+	int count;
 
 	if (!p)
 		return 0;
 
-	/* Use top for real-time CPU usage (not cumulative like ps pcpu) */
-	fp = popen("top -bn1 -o %CPU 2>/dev/null | tail -n +8 | head -50", "r");
-	if (!fp) {
-		p->proc_count = 0;
-		return 0;
-	}
-
-	while (fgets(line, sizeof(line), fp) && lines < 128) {
-		CpuProcEntry *e;
-		pid_t pid = 0;
-		char name[64] = {0};
-		double cpu = 0.0;
-		int existing = -1;
-		char user[32], pr[8], ni[8], virt[16], res[16], shr[16], s[4];
+	/* Incremental /proc sampler: real per-interval %CPU like top, without
+	 * the shell pipeline.  The first sample has nothing to diff against,
+	 * so come back quickly for real numbers. */
+	if (!procstat_sample())
+		schedule_cpu_popup_refresh(250);
+	count = procstat_top(top, (int)LENGTH(top), 0, cpu_proc_keep);
 
-		lines++;
-		/* top format: PID USER PR NI VIRT RES SHR S %CPU %MEM TIME+ COMMAND */
-		if (sscanf(line, "%d %31s %7s %7s %15s %15s %15s %3s %lf %*f %*s %63s",
-		           &pid, user, pr, ni, virt, res, shr, s, &cpu, name) < 10)
-			continue;
-		if (name[0] == '[')
-			continue;
-		if (cpu_proc_is_critical(pid, name))
-			continue;
-
-		for (int i = 0; i < count; i++) {
-			if (strcmp(p->procs[i].name, name) == 0) {
-				existing = i;
-				break;
-			}
-		}
+	for (int i = 0; i < count; i++) {
+		CpuProcEntry *e = &p->procs[i];
 
-		if (existing >= 0) {
-			e = &p->procs[existing];
-			e->cpu += cpu;
-			if (cpu > e->max_single_cpu) {
-				e->max_single_cpu = cpu;
-				e->pid = pid;
-			}
-		} else if (count < (int)LENGTH(p->procs)) {
-			e = &p->procs[count];
-			e->pid = pid;
-			snprintf(e->name, sizeof(e->name), "%s", name);
-			e->cpu = cpu;
-			e->max_single_cpu = cpu;
-			e->y = e->height = 0;
-			e->kill_x = e->kill_y = e->kill_w = e->kill_h = 0;
-			e->has_kill = 1;
-			count++;
-		}
+		e->pid = top[i].pid;
+		snprintf(e->name, sizeof(e->name), "%s", top[i].name);
+		e->cpu = top[i].cpu;
+		e->max_single_cpu = top[i].max_single_cpu;
+		e->y = e->height = 0;
+		e->kill_x = e->kill_y = e->kill_w = e->kill_h = 0;
+		e->has_kill = 1;
 	}
-
-	pclose(fp);
-	if (count > 1)
-		qsort(p->procs, (size_t)count, sizeof(p->procs[0]), cpu_proc_cmp);
 	p->proc_count = count;
 	return count;
 }
@@ -1655,90 +1305,42 @@ cpu_popup_handle_click(Monitor *m, int lx, int ly, uint32_t button)
 	return 0;
 }
 
-int
-ram_proc_cmp(const void *a, const void *b)
+static int
+ram_proc_keep(pid_t pid, const char *name, unsigned long rss_kb)
 {
-	const RamProcEntry *pa = a;
-	const RamProcEntry *pb = b;
-
-	if (pa->mem_kb < pb->mem_kb)
-		return 1;
-	if (pa->mem_kb > pb->mem_kb)
-		return -1;
-	if (pa->pid < pb->pid)
-		return -1;
-	if (pa->pid > pb->pid)
-		return 1;
-	return 0;
+	(void)pid;
+	if (rss_kb < 50 * 1024) /* 50 MB minimum */
+		return 0;
+	/* Hide system processes from RAM popup */
+	return strcmp(name, "nixlytile") != 0 &&
+			strcmp(name, "Xwayland") != 0 &&
+			strncmp(name, "blueman", 7) != 0;
 }
 
 int
 read_top_ram_processes(RamPopup *p)
 {
-	FILE *fp;
-	char line[256];
-	int count = 0;
-	int lines = 0;
-	const unsigned long min_kb = 50 * 1024; /* 50 MB minimum */
+	ProcGroup top[LENGTH(p->procs)];
+	int count;
 
 	if (!p)
 		return 0;
 
-	/* ps with RSS (resident set size) in KB, sorted by memory */
-	fp = popen("ps -eo pid,rss,comm --no-headers --sort=-rss", "r");
-	if (!fp) {
-		p->proc_count = 0;
-		return 0;
-	}
-
-	while (fgets(line, sizeof(line), fp) && lines < 200 && count < 15) {
-		RamProcEntry *e;
-		pid_t pid = 0;
-		unsigned long rss = 0;
-		char name[64] = {0};
-		int existing = -1;
-
-		lines++;
-		if (sscanf(line, "%d %lu %63s", &pid, &rss, name) != 3)
-			continue;
-		if (name[0] == '[')
-			continue;
-		if (rss < min_kb)
-			continue;
-		/* Hide system processes from RAM popup */
-		if (strcmp(name, "nixlytile") == 0 ||
-				strcmp(name, "Xwayland") == 0 ||
-				strncmp(name, "blueman", 7) == 0)
-			continue;
+	/* RSS straight from /proc/<pid>/stat, shared sample with the CPU
+	 * popup — no ps fork per refresh. */
+	procstat_sample();
+	count = procstat_top(top, (int)LENGTH(top), 1, ram_proc_keep);
 
-		/* Check for existing entry with same name */
-		for (int i = 0; i < count; i++) {
-			if (strcmp(p->procs[i].name, name) == 0) {
-				existing = i;
-				break;
-			}
-		}
+	for (int i = 0; i < count; i++) {
+		RamProcEntry *e = &p->procs[i];
 
-		if (existing >= 0) {
-			e = &p->procs[existing];
-			e->mem_kb += rss;
-			if (rss > e->mem_kb / 2)
-				e->pid = pid;
-		} else {
-			e = &p->procs[count];
-			e->pid = pid;
-			snprintf(e->name, sizeof(e->name), "%s", name);
-			e->mem_kb = rss;
-			e->y = e->height = 0;
-			e->kill_x = e->kill_y = e->kill_w = e->kill_h = 0;
-			e->has_kill = 1;
-			count++;
-		}
+		e->pid = top[i].pid;
+		snprintf(e->name, sizeof(e->name), "%s", top[i].name);
+		e->mem_kb = top[i].rss_kb;
+		e->y = e->height = 0;
+		e->kill_x = e->kill_y = e->kill_w = e->kill_h = 0;
+		e->has_kill = 1;
 	}
-
-	pclose(fp);
-	if (count > 1)
-		qsort(p->procs, (size_t)count, sizeof(p->procs[0]), ram_proc_cmp);
 	p->proc_count = count;
 	return count;
 }
@@ -2107,8 +1709,6 @@ schedule_ram_popup_refresh(uint32_t ms)
 		wl_event_source_timer_update(ram_popup_refresh_timer, ms);
 }
 
-int readulong(const char *path, unsigned long long *out);
-
 /* Battery Popup Functions */
 static void
 read_battery_info(BatteryPopup *p)
@@ -2430,6 +2030,8 @@ rendernetpopup(Monitor *m)
 	int max_width = 0;
 	int total_height;
 	char lines[4][128];
+	struct wlr_buffer *bufs[4];
+	int lefts[4], tops[4], advance;
 	struct wlr_scene_node *node, *tmp;
 
 	if (!m || !m->statusbar.net_popup.tree)
@@ -2472,38 +2074,12 @@ rendernetpopup(Monitor *m)
 		return;
 	}
 
-	/* First pass: compute max width */
+	/* First pass: shape every line and take the widest ink box */
 	for (int i = 0; i < line_count; i++) {
-		const struct fcft_glyph *glyph;
-		uint32_t prev_cp = 0;
-		int pen_x = 0;
-		int min_x = INT_MAX, max_x_local = INT_MIN;
-		const char *text = lines[i];
-
-		for (size_t j = 0; text[j]; j++) {
-			long kern_x = 0, kern_y = 0;
-			uint32_t cp = (unsigned char)text[j];
-			if (prev_cp)
-				fcft_kerning(statusfont.font, prev_cp, cp, &kern_x, &kern_y);
-			pen_x += (int)kern_x;
-
-			glyph = fcft_rasterize_char_utf32(statusfont.font, cp, statusbar_font_subpixel);
-			if (!glyph || !glyph->pix) {
-				prev_cp = cp;
-				continue;
-			}
-
-			min_x = MIN(min_x, pen_x + glyph->x);
-			max_x_local = MAX(max_x_local, pen_x + glyph->x + glyph->width);
-			pen_x += glyph->advance.x;
-			if (text[j + 1])
-				pen_x += statusbar_font_spacing;
-			prev_cp = cp;
-		}
-
-		if (min_x == INT_MAX || max_x_local == INT_MIN)
-			continue;
-		max_width = MAX(max_width, max_x_local - min_x);
+		bufs[i] = statusbar_label_buffer(lines[i], statusbar_fg,
+				&lefts[i], &tops[i], &advance);
+		if (bufs[i])
+			max_width = MAX(max_width, bufs[i]->width);
 	}
 
 	p->width = max_width + 2 * padding;
@@ -2519,78 +2095,17 @@ rendernetpopup(Monitor *m)
 	drawrect(p->bg, 0, 0, p->width, total_height, statusbar_popup_bg);
 
 	for (int i = 0; i < line_count; i++) {
-		const char *text = lines[i];
-		int min_x = INT_MAX, max_x_local = INT_MIN;
-		int min_y = INT_MAX, max_y = INT_MIN;
-		int pen_x = 0;
-		int width = 0;
-		int origin_x = 0;
-		int origin_y = 0;
-		uint32_t prev_cp = 0;
-
-		tll(struct GlyphRun) glyphs = tll_init();
-		for (size_t j = 0; text[j]; j++) {
-			long kern_x = 0, kern_y = 0;
-			uint32_t cp = (unsigned char)text[j];
-			struct GlyphRun run;
-			const struct fcft_glyph *glyph;
-
-			if (prev_cp)
-				fcft_kerning(statusfont.font, prev_cp, cp, &kern_x, &kern_y);
-			pen_x += (int)kern_x;
-
-			glyph = fcft_rasterize_char_utf32(statusfont.font,
-					cp, statusbar_font_subpixel);
-			if (!glyph || !glyph->pix) {
-				prev_cp = cp;
-				continue;
-			}
-
-			run.glyph = glyph;
-			run.pen_x = pen_x;
-			run.codepoint = cp;
-			tll_push_back(glyphs, run);
-
-			min_x = MIN(min_x, pen_x + glyph->x);
-			min_y = MIN(min_y, -glyph->y);
-			max_x_local = MAX(max_x_local, pen_x + glyph->x + glyph->width);
-			max_y = MAX(max_y, -glyph->y + glyph->height);
-
-			pen_x += glyph->advance.x;
-			if (text[j + 1])
-				pen_x += statusbar_font_spacing;
-			prev_cp = cp;
-		}
+		struct wlr_scene_buffer *scene_buf;
+		int origin_x, origin_y;
 
-		if (tll_length(glyphs) == 0) {
-			tll_free(glyphs);
+		if (!bufs[i] || !(scene_buf = wlr_scene_buffer_create(p->tree, NULL)))
 			continue;
-		}
 
-		width = max_x_local - min_x;
-		origin_x = padding + (max_width - width) / 2;
+		origin_x = padding + (max_width - bufs[i]->width) / 2;
 		origin_y = padding + i * (statusfont.height + line_spacing) + statusfont.ascent;
-
-		tll_foreach(glyphs, it) {
-			struct wlr_buffer *buffer;
-			struct wlr_scene_buffer *scene_buf;
-			const struct fcft_glyph *glyph = it->item.glyph;
-
-			buffer = statusbar_buffer_from_glyph(glyph);
-			if (!buffer)
-				continue;
-
-			scene_buf = wlr_scene_buffer_create(p->tree, NULL);
-			if (scene_buf) {
-				wlr_scene_buffer_set_buffer(scene_buf, buffer);
-				wlr_scene_node_set_position(&scene_buf->node,
-						origin_x + it->item.pen_x + glyph->x,
-						origin_y - glyph->y);
-			}
-			wlr_buffer_drop(buffer);
-		}
-
-		tll_free(glyphs);
+		wlr_scene_buffer_set_buffer(scene_buf, bufs[i]);
+		wlr_scene_node_set_position(&scene_buf->node,
+				origin_x + lefts[i], origin_y + tops[i]);
 	}
 
 	if (p->width <= 0 || p->height <= 0)
@@ -2699,6 +2214,8 @@ renderworkspaces(Monitor *m, StatusModule *module, int bar_height)
 		int text_w, text_h, box_w;
 		int origin_x, origin_y;
 		const float *bgcol;
+		char digit[2] = "";
+		int dl, dt, da;
 		int active = shown[n].active;
 		int i = shown[n].tag;
 
@@ -2734,16 +2251,19 @@ renderworkspaces(Monitor *m, StatusModule *module, int bar_height)
 					statusbar_tag_hover_bg, module->hover_alpha[i]);
 		}
 
-		buffer = statusbar_buffer_from_glyph(glyph);
+		/* Digit buffers come from the label cache, so a re-render
+		 * reuses the textures instead of uploading new ones. */
+		digit[0] = (char)('1' + i);
+		buffer = statusbar_label_buffer(digit,
+				statusbar_fg_override ? statusbar_fg_override : statusbar_fg,
+				&dl, &dt, &da);
 		if (buffer) {
 			scene_buf = wlr_scene_buffer_create(module->tree, NULL);
 			if (scene_buf) {
 				wlr_scene_buffer_set_buffer(scene_buf, buffer);
 				wlr_scene_node_set_position(&scene_buf->node,
-						origin_x + glyph->x,
-						origin_y - glyph->y);
+						origin_x + dl, origin_y + dt);
 			}
-			wlr_buffer_drop(buffer);
 		}
 
 		x += box_w;
@@ -3405,7 +2925,14 @@ backlight_percent(void)
 	unsigned long long cur, max;
 	double percent;
 
-	/* sysfs first — two file reads, no fork.  The brightnessctl /
+	/* uevent-maintained cache: no read at all until the kernel says
+	 * the brightness changed. */
+	if (uevent_watch_backlight(&percent) == 0) {
+		light_cached_percent = percent;
+		return percent;
+	}
+
+	/* sysfs next — two file reads, no fork.  The brightnessctl /
 	 * light fallbacks each cost a fork+exec and this runs on every
 	 * brightness scroll notch and 45 s refresh tick. */
 	if (backlight_available) {
@@ -3513,6 +3040,10 @@ set_backlight_relative(double delta_percent)
 		if (target > 100.0)
 			target = 100.0;
 		light_cached_percent = target;
+
+		/* Direct sysfs/logind write, coalesced per frame. */
+		if (backlight_queue_percent(target) == 0)
+			return 0;
 	}
 
 	/* Use external tools (non-blocking) */
@@ -3539,7 +3070,10 @@ double
 battery_percent(void)
 {
 	unsigned long long cur;
+	double cached;
 
+	if (uevent_watch_battery(&cached) == 0)
+		return cached;
 	if (!battery_available)
 		return -1.0;
 	if (readulong(battery_capacity_path, &cur) != 0)
@@ -3607,6 +3141,34 @@ pipewire_volume_percent(int *is_headset_out)
 	double cached = is_headset ? volume_cached_headset : volume_cached_speaker;
 	int cached_muted = is_headset ? volume_cached_headset_muted : volume_cached_speaker_muted;
 
+	/* Native PipeWire snapshot: always current, no cache needed. */
+	switch (pw_audio_get(0, &level, &muted, &is_headset)) {
+	case 1:
+		if (is_headset_out)
+			*is_headset_out = is_headset;
+		volume_muted = muted;
+		volume_cache_store(is_headset, level, muted, now);
+		return level;
+	case 2:
+		/* Sink is bound but its Props are still in flight: keep
+		 * showing the last level we had for this sink type rather
+		 * than blanking the module for a frame. */
+		if (is_headset_out)
+			*is_headset_out = is_headset;
+		cached = is_headset ? volume_cached_headset : volume_cached_speaker;
+		if (cached < 0.0)
+			return -1.0;
+		volume_muted = is_headset ? volume_cached_headset_muted
+				: volume_cached_speaker_muted;
+		return cached;
+	case 0:
+		if (is_headset_out)
+			*is_headset_out = is_headset;
+		return -1.0;
+	default:
+		break;
+	}
+
 	if (is_headset_out)
 		*is_headset_out = is_headset;
 
@@ -3653,6 +3215,20 @@ pipewire_mic_volume_percent(void)
 	int muted = 0;
 	uint64_t now = monotonic_msec();
 
+	switch (pw_audio_get(1, &level, &muted, NULL)) {
+	case 1:
+		goto store;
+	case 2:
+		if (mic_cached < 0.0)
+			return -1.0;
+		mic_muted = mic_cached_muted;
+		return mic_cached;
+	case 0:
+		return -1.0;
+	default:
+		break;
+	}
+
 	if (mic_last_read_ms != 0 && now - mic_last_read_ms < 8000) {
 		if (mic_cached >= 0.0) {
 			mic_muted = mic_cached_muted;
@@ -3678,6 +3254,7 @@ pipewire_mic_volume_percent(void)
 	if (level < 0.0)
 		return -1.0;
 
+store:
 	mic_muted = muted;
 	mic_cached = level;
 	mic_cached_muted = muted;
@@ -3700,6 +3277,9 @@ pipewire_sink_is_headset(void)
 	size_t i;
 	uint64_t now = monotonic_msec();
 
+	if (pw_audio_get(0, NULL, NULL, &headset) > 0)
+		return headset;
+
 	if (headset_probe_cached >= 0 && now - headset_probe_ms < 8000)
 		return headset_probe_cached;
 
@@ -3755,7 +3335,7 @@ set_pipewire_mute(int mute)
 
 	snprintf(arg, sizeof(arg), "%d", mute ? 1 : 0);
 
-	if (fork() == 0) {
+	if (pw_audio_set_mute(0, mute) != 0 && fork() == 0) {
 		setsid();
 		execlp("wpctl", "wpctl", "set-mute", "@DEFAULT_AUDIO_SINK@", arg, (char *)NULL);
 		_exit(127);
@@ -3773,7 +3353,7 @@ set_pipewire_mic_mute(int mute)
 
 	snprintf(arg, sizeof(arg), "%d", mute ? 1 : 0);
 
-	if (fork() == 0) {
+	if (pw_audio_set_mute(1, mute) != 0 && fork() == 0) {
 		setsid();
 		execlp("wpctl", "wpctl", "set-mute", "@DEFAULT_AUDIO_SOURCE@", arg, (char *)NULL);
 		_exit(127);
@@ -3797,7 +3377,7 @@ set_pipewire_volume(double percent)
 
 	snprintf(arg, sizeof(arg), "%.2f%%", percent);
 
-	if (fork() == 0) {
+	if (pw_audio_set_volume(0, percent) != 0 && fork() == 0) {
 		setsid();
 		execlp("wpctl", "wpctl", "set-volume", "@DEFAULT_AUDIO_SINK@", arg, (char *)NULL);
 		_exit(127);
@@ -3818,7 +3398,7 @@ set_pipewire_mic_volume(double percent)
 
 	snprintf(arg, sizeof(arg), "%.2f%%", percent);
 
-	if (fork() == 0) {
+	if (pw_audio_set_volume(1, percent) != 0 && fork() == 0) {
 		setsid();
 		execlp("wpctl", "wpctl", "set-volume", "@DEFAULT_AUDIO_SOURCE@", arg, (char *)NULL);
 		_exit(127);
@@ -3852,7 +3432,8 @@ toggle_pipewire_mute(void)
 	/* Native toggle: PipeWire flips mute atomically and preserves the
 	 * volume level, so no compositor-side state guessing or volume
 	 * restore is needed. */
-	run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SINK@ toggle");
+	if (pw_audio_set_mute(0, -1) != 0)
+		run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SINK@ toggle");
 
 	/* Read back the ACTUAL state so icon and system can never
 	 * disagree. */
@@ -3866,7 +3447,8 @@ toggle_pipewire_mute(void)
 int
 toggle_pipewire_mic_mute(void)
 {
-	run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SOURCE@ toggle");
+	if (pw_audio_set_mute(1, -1) != 0)
+		run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SOURCE@ toggle");
 
 	mic_last_read_ms = 0;
 	pipewire_mic_volume_percent();
@@ -3883,6 +3465,7 @@ positionstatusmodules(Monitor *m)
 	if (!m || !m->statusbar.tree)
 		return;
 
+	statusbar_flat_schedule();
 	if (!m->showbar || !m->statusbar.area.width || !m->statusbar.area.height) {
 		/* Bar toggled off but already laid out once: it is sliding out
 		 * with the tile edge. Tear down popups and menus, but leave the
@@ -4384,6 +3967,7 @@ refreshstatusclock(void)
 	struct tm tm;
 	char timestr[6] = {0};
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 
 	now = time(NULL);
@@ -4398,15 +3982,18 @@ refreshstatusclock(void)
 		if (!m->statusbar.clock.tree)
 			continue;
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
-		renderclock(&m->statusbar.clock, barh, timestr);
+		status_share_render(&share, m, &m->statusbar.clock, barh,
+				renderclock, timestr);
 		positionstatusmodules(m);
 	}
+	status_share_finish(&share);
 }
 
 void
 refreshstatuslight(void)
 {
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 	double percent, display;
 
@@ -4444,10 +4031,12 @@ refreshstatuslight(void)
 			continue;
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.light, barh, light_text)) {
-			renderlight(&m->statusbar.light, barh, light_text);
+			status_share_render(&share, m, &m->statusbar.light, barh,
+					renderlight, light_text);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4461,11 +4050,13 @@ refreshstatusnet(void)
 		unsigned long long rx = 0, tx = 0;
 	struct timespec now_ts = {0};
 	double elapsed = 0.0;
-	int rx_ok = 0, tx_ok = 0;
+	int rx_ok = 0, tx_ok = 0, stale = 0;
 	double wifi_quality = -1.0;
 	const char *icon_path = net_icon_no_conn_resolved[0] ? net_icon_no_conn_resolved : net_icon_no_conn;
 	int link_speed = -1;
 	int popup_active = 0;
+	NetState ns;
+	int nw;
 
 	wl_list_for_each(m, &mons, link) {
 		if (m->statusbar.net_popup.visible) {
@@ -4473,7 +4064,18 @@ refreshstatusnet(void)
 			break;
 		}
 	}
-	net_available = findactiveinterface(iface, sizeof(iface), &net_is_wireless);
+	/* netwatch keeps link/addr/SSID current from netlink events; the
+	 * sysfs walk is only the fallback when netlink isn't available. */
+	nw = netwatch_state(&ns);
+	if (nw > 0) {
+		snprintf(iface, sizeof(iface), "%s", ns.iface);
+		net_is_wireless = ns.wireless;
+		net_available = 1;
+	} else if (nw == 0) {
+		net_available = 0;
+	} else {
+		net_available = findactiveinterface(iface, sizeof(iface), &net_is_wireless);
+	}
 	if (!net_available) {
 		snprintf(net_text, sizeof(net_text), "Net: --");
 		snprintf(net_local_ip, sizeof(net_local_ip), "--");
@@ -4498,10 +4100,21 @@ refreshstatusnet(void)
 			if (net_is_wireless) {
 				stop_ssid_fetch();
 				ssid_last_time = 0;
+				net_ssid[0] = '\0';
 			}
 		}
 
-		if (net_is_wireless) {
+		if (net_is_wireless && nw > 0 && ns.ssid_native) {
+			/* nl80211 answers SSID questions: no helper, ever.  Until
+			 * it has one (associating, reply pending) keep the last. */
+			if (ns.ssid[0]) {
+				snprintf(net_ssid, sizeof(net_ssid), "%s", ns.ssid);
+				ssid_last_time = now_sec;
+			} else if (!net_ssid[0] || strcmp(net_ssid, "Ethernet") == 0) {
+				snprintf(net_ssid, sizeof(net_ssid), "--");
+			}
+			snprintf(net_text, sizeof(net_text), "WiFi: %s", net_ssid);
+		} else if (net_is_wireless) {
 			need_ssid = (!net_ssid[0] || strcmp(net_ssid, "--") == 0 ||
 					(now_sec != (time_t)-1 &&
 					 (now_sec - ssid_last_time > 60 || ssid_last_time == 0)));
@@ -4519,26 +4132,29 @@ refreshstatusnet(void)
 			snprintf(net_ssid, sizeof(net_ssid), "Ethernet");
 		}
 
+		if (nw > 0)
+			net_link_speed_mbps = ns.speed_mbps;
+		else if (readlinkspeedmbps(net_iface, &link_speed) == 0)
+			net_link_speed_mbps = link_speed;
+		else
+			net_link_speed_mbps = -1;
+
 		if (!net_is_wireless) {
 			icon_path = net_icon_eth_resolved[0] ? net_icon_eth_resolved : net_icon_eth;
-			if (readlinkspeedmbps(net_iface, &link_speed) == 0)
-				net_link_speed_mbps = link_speed;
-			else
-				net_link_speed_mbps = -1;
 			net_last_wifi_quality = -1.0;
 		} else {
-			wifi_quality = wireless_signal_percent(net_iface);
+			wifi_quality = nw > 0 ? ns.quality : -1.0;
+			if (wifi_quality < 0.0)
+				wifi_quality = wireless_signal_percent(net_iface);
 			if (wifi_quality < 0.0)
 				wifi_quality = 50.0;
 			icon_path = wifi_icon_for_quality(wifi_quality);
 			net_last_wifi_quality = wifi_quality;
-			if (readlinkspeedmbps(net_iface, &link_speed) == 0)
-				net_link_speed_mbps = link_speed;
-			else
-				net_link_speed_mbps = -1;
 		}
 
-		if (!localip(net_iface, net_local_ip, sizeof(net_local_ip)))
+		if (nw > 0)
+			snprintf(net_local_ip, sizeof(net_local_ip), "%s", ns.ip);
+		else if (!localip(net_iface, net_local_ip, sizeof(net_local_ip)))
 			snprintf(net_local_ip, sizeof(net_local_ip), "--");
 
 		if (popup_active)
@@ -4547,27 +4163,46 @@ refreshstatusnet(void)
 		clock_gettime(CLOCK_MONOTONIC, &now_ts);
 
 		if (popup_active) {
-			if (snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/rx_bytes", net_iface)
-					< (int)sizeof(path))
-				rx_ok = (readulong(path, &rx) == 0);
-			if (snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/tx_bytes", net_iface)
-					< (int)sizeof(path))
-				tx_ok = (readulong(path, &tx) == 0);
-
-			if (net_prev_valid) {
-				elapsed = (now_ts.tv_sec - net_prev_ts.tv_sec)
-					+ (now_ts.tv_nsec - net_prev_ts.tv_nsec) / 1e9;
+			if (nw > 0) {
+				uint64_t sample_ms;
+
+				rx_ok = tx_ok = (netwatch_link_stats(ns.ifindex, &rx, &tx,
+							&sample_ms) == 0);
+				/* Divide by when the kernel counted, not by when we
+				 * asked; the counters trail this refresh. */
+				if (rx_ok) {
+					now_ts.tv_sec = (time_t)(sample_ms / 1000);
+					now_ts.tv_nsec = (long)(sample_ms % 1000) * 1000000L;
+				}
+				/* No answer since the last refresh: keep its rates */
+				stale = rx_ok && net_prev_valid
+					&& now_ts.tv_sec == net_prev_ts.tv_sec
+					&& now_ts.tv_nsec == net_prev_ts.tv_nsec;
+			} else {
+				if (snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/rx_bytes", net_iface)
+						< (int)sizeof(path))
+					rx_ok = (readulong(path, &rx) == 0);
+				if (snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/tx_bytes", net_iface)
+						< (int)sizeof(path))
+					tx_ok = (readulong(path, &tx) == 0);
 			}
-			net_last_down_bps = (net_prev_valid && rx_ok) ? net_bytes_to_rate(rx, net_prev_rx, elapsed) : -1.0;
-			net_last_up_bps = (net_prev_valid && tx_ok) ? net_bytes_to_rate(tx, net_prev_tx, elapsed) : -1.0;
-			format_speed(net_last_down_bps, net_down_text, sizeof(net_down_text));
-			format_speed(net_last_up_bps, net_up_text, sizeof(net_up_text));
-
-			if (rx_ok && tx_ok) {
-				net_prev_rx = rx;
-				net_prev_tx = tx;
-				net_prev_ts = now_ts;
-				net_prev_valid = 1;
+
+			if (!stale) {
+				if (net_prev_valid) {
+					elapsed = (now_ts.tv_sec - net_prev_ts.tv_sec)
+						+ (now_ts.tv_nsec - net_prev_ts.tv_nsec) / 1e9;
+				}
+				net_last_down_bps = (net_prev_valid && rx_ok) ? net_bytes_to_rate(rx, net_prev_rx, elapsed) : -1.0;
+				net_last_up_bps = (net_prev_valid && tx_ok) ? net_bytes_to_rate(tx, net_prev_tx, elapsed) : -1.0;
+				format_speed(net_last_down_bps, net_down_text, sizeof(net_down_text));
+				format_speed(net_last_up_bps, net_up_text, sizeof(net_up_text));
+
+				if (rx_ok && tx_ok) {
+					net_prev_rx = rx;
+					net_prev_tx = tx;
+					net_prev_ts = now_ts;
+					net_prev_valid = 1;
+				}
 			}
 		}
 	}
@@ -4593,6 +4228,7 @@ void
 refreshstatusbattery(void)
 {
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 	double percent, display;
 	const char *icon = battery_icon_100;
@@ -4642,10 +4278,12 @@ refreshstatusbattery(void)
 			continue;
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.battery, barh, battery_text)) {
-			renderbattery(&m->statusbar.battery, barh, battery_text);
+			status_share_render(&share, m, &m->statusbar.battery, barh,
+					renderbattery, battery_text);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4653,6 +4291,7 @@ refreshstatuscpu(void)
 {
 	double usage = cpuaverage();
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 
 	if (usage >= 0.0)
@@ -4671,12 +4310,14 @@ refreshstatuscpu(void)
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.cpu, barh, cpu_text)
 				|| m->statusbar.cpu_popup.visible) {
-			rendercpu(&m->statusbar.cpu, barh, cpu_text);
+			status_share_render(&share, m, &m->statusbar.cpu, barh,
+					rendercpu, cpu_text);
 			if (m->statusbar.cpu_popup.visible)
 				rendercpupopup(m);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4684,6 +4325,7 @@ refreshstatusram(void)
 {
 	double used_mb = ramused_mb();
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 
 	if (used_mb >= 0.0)
@@ -4703,10 +4345,12 @@ refreshstatusram(void)
 			continue;
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.ram, barh, ram_text)) {
-			renderram(&m->statusbar.ram, barh, ram_text);
+			status_share_render(&share, m, &m->statusbar.ram, barh,
+					renderram, ram_text);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4715,6 +4359,7 @@ refreshstatusvolume(void)
 	int is_headset = pipewire_sink_is_headset();
 	double vol = speaker_active;
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 	double display = vol;
 	int force_render = 0;
@@ -4793,10 +4438,12 @@ refreshstatusvolume(void)
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.volume, barh, volume_text)
 				|| force_render) {
-			rendervolume(&m->statusbar.volume, barh, volume_text);
+			status_share_render(&share, m, &m->statusbar.volume, barh,
+					rendervolume, volume_text);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4804,6 +4451,7 @@ refreshstatusmic(void)
 {
 	double vol = microphone_active;
 	Monitor *m;
+	StatusShare share = {0};
 	int barh;
 	double display = vol;
 	int force_render = 0;
@@ -4887,10 +4535,12 @@ refreshstatusmic(void)
 		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
 		if (status_should_render(&m->statusbar.mic, barh, mic_text)
 				|| force_render) {
-			rendermic(&m->statusbar.mic, barh, mic_text);
+			status_share_render(&share, m, &m->statusbar.mic, barh,
+					rendermic, mic_text);
 			positionstatusmodules(m);
 		}
 	}
+	status_share_finish(&share);
 }
 
 void
@@ -4907,6 +4557,41 @@ refreshstatusicons(void)
 	}
 }
 
+/* Redraw the icon+label modules with the text they already show; the
+ * icon cache calls this when a rasterized SVG arrives from its worker. */
+void
+statusbar_rerender_icon_modules(void)
+{
+	static const struct {
+		size_t off;
+		void (*render)(StatusModule *module, int bar_height, const char *text);
+	} mods[] = {
+		{ offsetof(StatusBar, clock), renderclock },
+		{ offsetof(StatusBar, cpu), rendercpu },
+		{ offsetof(StatusBar, ram), renderram },
+		{ offsetof(StatusBar, light), renderlight },
+		{ offsetof(StatusBar, battery), renderbattery },
+		{ offsetof(StatusBar, volume), rendervolume },
+		{ offsetof(StatusBar, mic), rendermic },
+	};
+	StatusShare share[LENGTH(mods)] = {0};
+	Monitor *m;
+	int barh;
+
+	wl_list_for_each(m, &mons, link) {
+		barh = m->statusbar.area.height ? m->statusbar.area.height : (int)statusbar_height;
+		for (size_t i = 0; i < LENGTH(mods); i++) {
+			StatusModule *module = (StatusModule *)((char *)&m->statusbar + mods[i].off);
+			if (module->tree && module->last_render_text[0])
+				status_share_render(&share[i], m, module, barh,
+						mods[i].render, module->last_render_text);
+		}
+		positionstatusmodules(m);
+	}
+	for (size_t i = 0; i < LENGTH(mods); i++)
+		status_share_finish(&share[i]);
+}
+
 /* Re-render the workspace boxes for one monitor (workspace switched or
  * occupancy changed). */
 void
@@ -4975,6 +4660,118 @@ status_should_render(StatusModule *module, int barh, const char *text)
 	return 0;
 }
 
+/* Copy `src`'s children under `dst`.  Buffer nodes reference the same
+ * wlr_buffer (the scene node takes its own lock), so no pixels are
+ * re-rendered or copied on the CPU.  Each copy is still its own
+ * wlr_scene_buffer and gets its own texture upload: wlr_scene caches
+ * textures per node, and the one shared-texture path (wlr_client_buffer)
+ * has no public constructor. */
+static void
+status_clone_tree(struct wlr_scene_tree *dst, struct wlr_scene_tree *src,
+		struct wlr_scene_node *skip)
+{
+	struct wlr_scene_node *node, *copy;
+
+	wl_list_for_each(node, &src->children, link) {
+		if (node == skip)
+			continue;
+		copy = NULL;
+		if (node->type == WLR_SCENE_NODE_RECT) {
+			struct wlr_scene_rect *r = wlr_scene_rect_from_node(node);
+			struct wlr_scene_rect *c = wlr_scene_rect_create(dst,
+					r->width, r->height, r->color);
+			copy = c ? &c->node : NULL;
+		} else if (node->type == WLR_SCENE_NODE_BUFFER) {
+			struct wlr_scene_buffer *b = wlr_scene_buffer_from_node(node);
+			struct wlr_scene_buffer *c = wlr_scene_buffer_create(dst, b->buffer);
+			if (c) {
+				wlr_scene_buffer_set_source_box(c, &b->src_box);
+				wlr_scene_buffer_set_dest_size(c, b->dst_width, b->dst_height);
+				wlr_scene_buffer_set_opacity(c, b->opacity);
+				copy = &c->node;
+			}
+		} else if (node->type == WLR_SCENE_NODE_TREE) {
+			struct wlr_scene_tree *c = wlr_scene_tree_create(dst);
+			if (c) {
+				status_clone_tree(c, wlr_scene_tree_from_node(node), NULL);
+				copy = &c->node;
+			}
+		}
+		if (!copy)
+			continue;
+		wlr_scene_node_set_position(copy, node->x, node->y);
+		wlr_scene_node_set_enabled(copy, node->enabled);
+	}
+}
+
+/* Make `dst` show exactly what `src` shows (same bar geometry). */
+static void
+status_clone_module(StatusModule *dst, StatusModule *src)
+{
+	clearstatusmodule(dst);
+	dst->width = src->width;
+	wlr_scene_node_set_enabled(&dst->tree->node, src->tree->node.enabled);
+
+	if (src->bg) {
+		struct wlr_scene_node *node, *tmp;
+
+		if (!dst->bg && !(dst->bg = wlr_scene_tree_create(dst->tree)))
+			return;
+		wl_list_for_each_safe(node, tmp, &dst->bg->children, link)
+			wlr_scene_node_destroy(node);
+		status_clone_tree(dst->bg, src->bg, NULL);
+		wlr_scene_node_set_position(&dst->bg->node, src->bg->node.x, src->bg->node.y);
+		wlr_scene_node_set_enabled(&dst->bg->node, src->bg->node.enabled);
+		wlr_scene_node_lower_to_bottom(&dst->bg->node);
+	} else if (dst->bg) {
+		wlr_scene_node_set_enabled(&dst->bg->node, 0);
+	}
+	status_clone_tree(dst->tree, src->tree, src->bg ? &src->bg->node : NULL);
+}
+
+/* Render a module on one monitor within a refresh pass.  Monitors whose
+ * bar has the same height and output scale as one already drawn in this
+ * pass get a copy of that monitor's nodes instead of a second layout
+ * (text measuring, label/icon cache lookups, background rounding).  This
+ * saves CPU, not texture uploads (see status_clone_tree).  End the pass
+ * with status_share_finish(). */
+void
+status_share_render(StatusShare *share, Monitor *m, StatusModule *module,
+		int barh, void (*render)(StatusModule *module, int bar_height,
+			const char *text), const char *text)
+{
+	float scale = m->wlr_output ? m->wlr_output->scale : 1.0f;
+
+	for (int i = 0; i < share->n; i++) {
+		if (share->group[i].barh == barh && share->group[i].scale == scale
+				&& share->group[i].src != module
+				&& share->group[i].src->tree) {
+			status_clone_module(module, share->group[i].src);
+			return;
+		}
+	}
+
+	render(module, barh, text);
+	if (share->n == share->cap) {
+		share->cap = share->cap ? share->cap * 2 : 4;
+		share->group = realloc(share->group,
+				(size_t)share->cap * sizeof(*share->group));
+		if (!share->group)
+			die("status share: out of memory");
+	}
+	share->group[share->n].barh = barh;
+	share->group[share->n].scale = scale;
+	share->group[share->n].src = module;
+	share->n++;
+}
+
+void
+status_share_finish(StatusShare *share)
+{
+	free(share->group);
+	memset(share, 0, sizeof(*share));
+}
+
 void
 initial_status_refresh(void)
 {
@@ -5162,6 +4959,12 @@ updatestatuscpu(void *data)
 		 * show up without a focus round-trip.  Render only happens
 		 * when the text actually changes (status_should_render). */
 		status_tasks[chosen].next_due_ms = now + 500;
+	} else if (uevent_watch_active()
+			&& (status_tasks[chosen].fn == refreshstatuslight
+				|| status_tasks[chosen].fn == refreshstatusbattery)) {
+		/* Kernel uevents re-arm these (uevent_watch.c); the poll is
+		 * only a safety net. */
+		status_tasks[chosen].next_due_ms = now + 3600000;
 	} else if (status_task_hover_active(status_tasks[chosen].fn)) {
 		status_tasks[chosen].next_due_ms = now + STATUS_FAST_MS;
 	} else {
@@ -5781,6 +5584,7 @@ cleanupstatusbar(Monitor *m)
 
 	tray_menu_clear(&m->statusbar.tray_menu);
 	m->statusbar.tray_menu.hover_rect = NULL;
+	statusbar_flat_cleanup(m);
 
 	if (m->statusbar.tree)
 		wlr_scene_node_destroy(&m->statusbar.tree->node);
@@ -0,0 +1,454 @@
+/*
+ * statusbar_flat.c — optional single-buffer status bar ("statusbar-flat").
+ *
+ * The module renderers keep building their scene subtrees as before, but
+ * in flat mode those subtrees hang off a disabled container instead of
+ * the bar tree.  After each batch of module updates an idle pass
+ * fingerprints every module's subtree, composites only the modules whose
+ * fingerprint (content or position) changed into one pixman buffer per
+ * monitor, and hands that buffer to the scene with exactly that damage.
+ * The output then sees one node for the whole bar instead of a few
+ * hundred rects and glyph buffers, and a clock tick repaints the clock's
+ * box, not the bar.
+ *
+ * Two buffers alternate so the scene always gets a new wlr_buffer and
+ * re-imports it; each one is two updates behind, so a repaint covers this
+ * update's damage plus the previous one's.
+ */
+#include "nixlytile.h"
+
+int statusbar_flat_enabled = 0;
+
+static struct wl_event_source *flat_idle;
+static int flat_live; /* monitors currently in flat mode */
+
+/* flat_sig[] and flat_box[] are indexed by a module's slot in this
+ * table, never by its position among the modules that happen to exist,
+ * so a module appearing or going away cannot shift another's state.
+ * Slots whose module has no tree come back NULL. */
+static void
+flat_modules(Monitor *m, StatusModule *out[static STATUSBAR_FLAT_MAX])
+{
+	StatusModule *all[STATUSBAR_FLAT_MAX] = {
+		&m->statusbar.tags, &m->statusbar.net, &m->statusbar.traylabel,
+		&m->statusbar.terminfo, &m->statusbar.battery, &m->statusbar.light,
+		&m->statusbar.volume, &m->statusbar.mic, &m->statusbar.cpu,
+		&m->statusbar.ram, &m->statusbar.clock, &m->statusbar.fan,
+	};
+
+	for (int i = 0; i < STATUSBAR_FLAT_MAX; i++)
+		out[i] = all[i]->tree ? all[i] : NULL;
+}
+
+/* Move module trees created since the last pass under flat_src; left on
+ * the bar tree they would draw on top of the composited copy.  The pass
+ * runs from an idle callback, so it lands before the next frame. */
+static void
+flat_adopt(Monitor *m, StatusModule *mods[static STATUSBAR_FLAT_MAX])
+{
+	StatusBar *bar = &m->statusbar;
+
+	for (int i = 0; i < STATUSBAR_FLAT_MAX; i++) {
+		if (!mods[i] || mods[i]->tree->node.parent == bar->flat_src)
+			continue;
+		wlr_scene_node_reparent(&mods[i]->tree->node, bar->flat_src);
+		bar->flat_sig[i] = 0;
+	}
+}
+
+/* ── fingerprint ─────────────────────────────────────────────────── */
+
+#define FLAT_MIX(v) do { *sig = (*sig ^ (uint64_t)(int64_t)(v)) * 1099511628211ULL; } while (0)
+
+static void
+flat_sig_node(struct wlr_scene_node *node, int ox, int oy, uint64_t *sig,
+		pixman_box32_t *ext)
+{
+	int x = ox + node->x, y = oy + node->y, w = 0, h = 0;
+
+	FLAT_MIX(node->type);
+	FLAT_MIX(node->enabled);
+	FLAT_MIX(x);
+	FLAT_MIX(y);
+	if (!node->enabled)
+		return;
+
+	if (node->type == WLR_SCENE_NODE_TREE) {
+		struct wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
+		struct wlr_scene_node *child;
+
+		wl_list_for_each(child, &tree->children, link)
+			flat_sig_node(child, x, y, sig, ext);
+		return;
+	}
+
+	if (node->type == WLR_SCENE_NODE_RECT) {
+		struct wlr_scene_rect *r = wlr_scene_rect_from_node(node);
+
+		w = r->width;
+		h = r->height;
+		for (int i = 0; i < 4; i++)
+			FLAT_MIX(lroundf(r->color[i] * 65535.0f));
+	} else if (node->type == WLR_SCENE_NODE_BUFFER) {
+		struct wlr_scene_buffer *sb = wlr_scene_buffer_from_node(node);
+
+		if (!sb->buffer)
+			return;
+		w = sb->dst_width > 0 ? sb->dst_width : sb->buffer->width;
+		h = sb->dst_height > 0 ? sb->dst_height : sb->buffer->height;
+		FLAT_MIX((uintptr_t)sb->buffer);
+		FLAT_MIX(lroundf(sb->opacity * 65535.0f));
+		FLAT_MIX(lround(sb->src_box.x));
+		FLAT_MIX(lround(sb->src_box.y));
+		FLAT_MIX(lround(sb->src_box.width));
+		FLAT_MIX(lround(sb->src_box.height));
+	}
+	FLAT_MIX(w);
+	FLAT_MIX(h);
+
+	if (w > 0 && h > 0) {
+		ext->x1 = MIN(ext->x1, x);
+		ext->y1 = MIN(ext->y1, y);
+		ext->x2 = MAX(ext->x2, x + w);
+		ext->y2 = MAX(ext->y2, y + h);
+	}
+}
+
+#undef FLAT_MIX
+
+/* ── compositing ─────────────────────────────────────────────────── */
+
+static pixman_format_code_t
+flat_pixman_format(uint32_t drm_format)
+{
+	switch (drm_format) {
+	case DRM_FORMAT_ARGB8888: return PIXMAN_a8r8g8b8;
+	case DRM_FORMAT_XRGB8888: return PIXMAN_x8r8g8b8;
+	case DRM_FORMAT_ABGR8888: return PIXMAN_a8b8g8r8;
+	case DRM_FORMAT_XBGR8888: return PIXMAN_x8b8g8r8;
+	default:                  return 0;
+	}
+}
+
+/* Scene rect and text colours are already what the renderer blends as
+ * premultiplied, so they go to pixman unchanged. */
+static pixman_image_t *
+flat_solid(const float color[static 4], float alpha)
+{
+	pixman_color_t col = {
+		.red = (uint16_t)lroundf(color[0] * alpha * 65535.0f),
+		.green = (uint16_t)lroundf(color[1] * alpha * 65535.0f),
+		.blue = (uint16_t)lroundf(color[2] * alpha * 65535.0f),
+		.alpha = (uint16_t)lroundf(color[3] * alpha * 65535.0f),
+	};
+
+	return pixman_image_create_solid_fill(&col);
+}
+
+static void
+flat_draw_buffer(pixman_image_t *dst, struct wlr_scene_buffer *sb, int x, int y)
+{
+	struct wlr_buffer *buf = sb->buffer;
+	pixman_image_t *src, *mask = NULL;
+	pixman_format_code_t fmt;
+	void *data;
+	uint32_t drm_format;
+	size_t stride;
+	double sx = 0, sy = 0, sw = buf->width, sh = buf->height;
+	int dw, dh;
+
+	if (sb->transform != WL_OUTPUT_TRANSFORM_NORMAL)
+		return;
+	if (!wlr_buffer_begin_data_ptr_access(buf,
+			WLR_BUFFER_DATA_PTR_ACCESS_READ, &data, &drm_format, &stride))
+		return;
+	if (!(fmt = flat_pixman_format(drm_format))
+			|| !(src = pixman_image_create_bits_no_clear(fmt, buf->width,
+					buf->height, data, (int)stride))) {
+		wlr_buffer_end_data_ptr_access(buf);
+		return;
+	}
+
+	if (!wlr_fbox_empty(&sb->src_box)) {
+		sx = sb->src_box.x;
+		sy = sb->src_box.y;
+		sw = sb->src_box.width;
+		sh = sb->src_box.height;
+	}
+	dw = sb->dst_width > 0 ? sb->dst_width : (int)sw;
+	dh = sb->dst_height > 0 ? sb->dst_height : (int)sh;
+
+	if (dw != (int)sw || dh != (int)sh) {
+		pixman_transform_t t;
+
+		pixman_transform_init_scale(&t, pixman_double_to_fixed(sw / dw),
+				pixman_double_to_fixed(sh / dh));
+		pixman_image_set_transform(src, &t);
+		pixman_image_set_filter(src, PIXMAN_FILTER_BILINEAR, NULL, 0);
+		sx = sx * dw / sw;
+		sy = sy * dh / sh;
+	}
+	if (sb->opacity < 1.0f)
+		mask = flat_solid((const float[4]){ 1, 1, 1, 1 }, sb->opacity);
+
+	pixman_image_composite32(PIXMAN_OP_OVER, src, mask, dst,
+			(int)sx, (int)sy, 0, 0, x, y, dw, dh);
+
+	if (mask)
+		pixman_image_unref(mask);
+	pixman_image_unref(src);
+	wlr_buffer_end_data_ptr_access(buf);
+}
+
+static void
+flat_draw_node(pixman_image_t *dst, struct wlr_scene_node *node, int ox, int oy)
+{
+	int x = ox + node->x, y = oy + node->y;
+
+	if (!node->enabled)
+		return;
+
+	if (node->type == WLR_SCENE_NODE_TREE) {
+		struct wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
+		struct wlr_scene_node *child;
+
+		wl_list_for_each(child, &tree->children, link)
+			flat_draw_node(dst, child, x, y);
+	} else if (node->type == WLR_SCENE_NODE_RECT) {
+		struct wlr_scene_rect *r = wlr_scene_rect_from_node(node);
+		pixman_image_t *solid = flat_solid(r->color, 1.0f);
+
+		pixman_image_composite32(PIXMAN_OP_OVER, solid, NULL, dst,
+				0, 0, 0, 0, x, y, r->width, r->height);
+		pixman_image_unref(solid);
+	} else if (node->type == WLR_SCENE_NODE_BUFFER) {
+		struct wlr_scene_buffer *sb = wlr_scene_buffer_from_node(node);
+
+		if (sb->buffer)
+			flat_draw_buffer(dst, sb, x, y);
+	}
+}
+
+static struct wlr_buffer *
+flat_buffer_create(int width, int height)
+{
+	struct PixmanBuffer *buf;
+	int stride = width * 4;
+	void *data = ecalloc(height, stride);
+
+	buf = ecalloc(1, sizeof(*buf));
+	buf->image = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8,
+			width, height, data, stride);
+	if (!buf->image) {
+		free(data);
+		free(buf);
+		return NULL;
+	}
+	buf->data = data;
+	buf->drm_format = DRM_FORMAT_ARGB8888;
+	buf->stride = stride;
+	buf->owns_data = 1;
+	wlr_buffer_init(&buf->base, &pixman_buffer_impl, width, height);
+	return &buf->base;
+}
+
+static void
+flat_drop_buffers(StatusBar *bar)
+{
+	for (int i = 0; i < 2; i++) {
+		if (bar->flat_buf[i])
+			wlr_buffer_drop(bar->flat_buf[i]);
+		bar->flat_buf[i] = NULL;
+	}
+	pixman_region32_clear(&bar->flat_prev_damage);
+}
+
+/* ── mode switch ─────────────────────────────────────────────────── */
+
+static void
+flat_enter(Monitor *m)
+{
+	StatusBar *bar = &m->statusbar;
+	StatusModule *mods[STATUSBAR_FLAT_MAX];
+
+	if (!(bar->flat_src = wlr_scene_tree_create(bar->tree)))
+		return;
+	if (!(bar->flat = wlr_scene_buffer_create(bar->tree, NULL))) {
+		wlr_scene_node_destroy(&bar->flat_src->node);
+		bar->flat_src = NULL;
+		return;
+	}
+	/* Below the popups and the tray menu, like the module trees were. */
+	wlr_scene_node_lower_to_bottom(&bar->flat->node);
+	wlr_scene_node_set_enabled(&bar->flat_src->node, 0);
+
+	flat_modules(m, mods);
+	flat_adopt(m, mods);
+	memset(bar->flat_box, 0, sizeof(bar->flat_box));
+	pixman_region32_init(&bar->flat_prev_damage);
+	flat_live++;
+}
+
+static void
+flat_leave(Monitor *m)
+{
+	StatusBar *bar = &m->statusbar;
+	StatusModule *mods[STATUSBAR_FLAT_MAX];
+
+	flat_modules(m, mods);
+	for (int i = STATUSBAR_FLAT_MAX - 1; i >= 0; i--) {
+		if (!mods[i])
+			continue;
+		wlr_scene_node_reparent(&mods[i]->tree->node, bar->tree);
+		wlr_scene_node_lower_to_bottom(&mods[i]->tree->node);
+	}
+	flat_drop_buffers(bar);
+	pixman_region32_fini(&bar->flat_prev_damage);
+	wlr_scene_node_destroy(&bar->flat->node);
+	wlr_scene_node_destroy(&bar->flat_src->node);
+	bar->flat = NULL;
+	bar->flat_src = NULL;
+	flat_live--;
+}
+
+/* ── update ──────────────────────────────────────────────────────── */
+
+static void
+flat_update(Monitor *m)
+{
+	StatusBar *bar = &m->statusbar;
+	StatusModule *mods[STATUSBAR_FLAT_MAX];
+	pixman_region32_t damage, repaint;
+	struct wlr_buffer *back;
+	struct PixmanBuffer *pb;
+	pixman_image_t *dst;
+	int width = bar->area.width, height = bar->area.height;
+	int full = 0;
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	flat_modules(m, mods);
+	flat_adopt(m, mods);
+
+	if (!bar->flat_buf[0] || bar->flat_buf[0]->width != width
+			|| bar->flat_buf[0]->height != height) {
+		flat_drop_buffers(bar);
+		bar->flat_buf[0] = flat_buffer_create(width, height);
+		bar->flat_buf[1] = flat_buffer_create(width, height);
+		if (!bar->flat_buf[0] || !bar->flat_buf[1]) {
+			flat_drop_buffers(bar);
+			return;
+		}
+		full = 1;
+	}
+
+	pixman_region32_init(&damage);
+	for (int i = 0; i < STATUSBAR_FLAT_MAX; i++) {
+		struct wlr_scene_node *node;
+		pixman_box32_t ext = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+		uint64_t sig = 1469598103934665603ULL;
+
+		if (!mods[i]) {
+			/* module gone: clear what it left on screen */
+			if (bar->flat_box[i].x2 > bar->flat_box[i].x1)
+				pixman_region32_union_rect(&damage, &damage,
+						bar->flat_box[i].x1, bar->flat_box[i].y1,
+						bar->flat_box[i].x2 - bar->flat_box[i].x1,
+						bar->flat_box[i].y2 - bar->flat_box[i].y1);
+			bar->flat_box[i] = (pixman_box32_t){ 0 };
+			bar->flat_sig[i] = 0;
+			continue;
+		}
+		node = &mods[i]->tree->node;
+		flat_sig_node(node, 0, 0, &sig, &ext);
+		if (sig == bar->flat_sig[i] && !full)
+			continue;
+		bar->flat_sig[i] = sig;
+		/* Old box (what is on screen now) plus new box. */
+		if (bar->flat_box[i].x2 > bar->flat_box[i].x1)
+			pixman_region32_union_rect(&damage, &damage,
+					bar->flat_box[i].x1, bar->flat_box[i].y1,
+					bar->flat_box[i].x2 - bar->flat_box[i].x1,
+					bar->flat_box[i].y2 - bar->flat_box[i].y1);
+		if (!node->enabled || ext.x2 <= ext.x1)
+			ext = (pixman_box32_t){ 0 };
+		else
+			pixman_region32_union_rect(&damage, &damage, ext.x1, ext.y1,
+					ext.x2 - ext.x1, ext.y2 - ext.y1);
+		bar->flat_box[i] = ext;
+	}
+	if (full)
+		pixman_region32_union_rect(&damage, &damage, 0, 0, width, height);
+	pixman_region32_intersect_rect(&damage, &damage, 0, 0, width, height);
+
+	if (!pixman_region32_not_empty(&damage)) {
+		pixman_region32_fini(&damage);
+		return;
+	}
+
+	/* The back buffer last showed the frame before the previous one. */
+	pixman_region32_init(&repaint);
+	pixman_region32_union(&repaint, &damage, &bar->flat_prev_damage);
+	pixman_region32_copy(&bar->flat_prev_damage, &damage);
+
+	back = bar->flat_buf[bar->flat_cur ^ 1];
+	pb = wl_container_of(back, pb, base);
+	dst = pb->image;
+	pixman_image_set_clip_region32(dst, &repaint);
+	pixman_image_fill_rectangles(PIXMAN_OP_CLEAR, dst, &(pixman_color_t){ 0 },
+			1, &(pixman_rectangle16_t){ 0, 0, width, height });
+	for (int i = 0; i < STATUSBAR_FLAT_MAX; i++) {
+		if (mods[i] && pixman_region32_contains_rectangle(&repaint, &bar->flat_box[i])
+				!= PIXMAN_REGION_OUT)
+			flat_draw_node(dst, &mods[i]->tree->node, 0, 0);
+	}
+	pixman_image_set_clip_region32(dst, NULL);
+	pixman_region32_fini(&repaint);
+
+	wlr_scene_buffer_set_buffer_with_damage(bar->flat, back, &damage);
+	bar->flat_cur ^= 1;
+	pixman_region32_fini(&damage);
+}
+
+static void
+flat_idle_cb(void *data)
+{
+	Monitor *m;
+
+	(void)data;
+	flat_idle = NULL;
+
+	wl_list_for_each(m, &mons, link) {
+		if (!m->statusbar.tree)
+			continue;
+		if (statusbar_flat_enabled && !m->statusbar.flat)
+			flat_enter(m);
+		else if (!statusbar_flat_enabled && m->statusbar.flat)
+			flat_leave(m);
+		if (m->statusbar.flat)
+			flat_update(m);
+	}
+}
+
+void
+statusbar_flat_schedule(void)
+{
+	if (flat_idle || (!statusbar_flat_enabled && !flat_live) || !event_loop)
+		return;
+	flat_idle = wl_event_loop_add_idle(event_loop, flat_idle_cb, NULL);
+}
+
+/* The scene nodes go with m->statusbar.tree; only the buffers and the
+ * region are ours to free. */
+void
+statusbar_flat_cleanup(Monitor *m)
+{
+	if (!m || !m->statusbar.flat)
+		return;
+	flat_drop_buffers(&m->statusbar);
+	pixman_region32_fini(&m->statusbar.flat_prev_damage);
+	m->statusbar.flat = NULL;
+	m->statusbar.flat_src = NULL;
+	flat_live--;
+}
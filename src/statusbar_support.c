@@ -72,21 +72,14 @@ char net_prev_iface[64] = {0};
 int net_is_wireless;
 int net_available;
 char net_icon_path[PATH_MAX] = "images/svg/no_connection.svg";
-char net_icon_loaded_path[PATH_MAX];
 char cpu_icon_path[PATH_MAX] = "images/svg/cpu.svg";
-char cpu_icon_loaded_path[PATH_MAX];
 const uint32_t cpu_popup_refresh_interval_ms = 2000;
 const uint32_t ram_popup_refresh_interval_ms = 2000;
 char light_icon_path[PATH_MAX] = "images/svg/light.svg";
-char light_icon_loaded_path[PATH_MAX];
 char ram_icon_path[PATH_MAX] = "images/svg/ram.svg";
-char ram_icon_loaded_path[PATH_MAX];
 char battery_icon_path[PATH_MAX] = "images/svg/battery-100.svg";
-char battery_icon_loaded_path[PATH_MAX];
 char mic_icon_path[PATH_MAX] = "images/svg/microphone.svg";
-char mic_icon_loaded_path[PATH_MAX];
 char volume_icon_path[PATH_MAX] = "images/svg/speaker_100.svg";
-char volume_icon_loaded_path[PATH_MAX];
 const char net_icon_no_conn[] = "images/svg/no_connection.svg";
 const char net_icon_eth[] = "images/svg/ethernet.svg";
 const char net_icon_wifi_100[] = "images/svg/wifi_100.svg";
@@ -112,39 +105,6 @@ char net_icon_wifi_25_resolved[PATH_MAX];
 char net_icon_eth_resolved[PATH_MAX];
 char net_icon_no_conn_resolved[PATH_MAX];
 char clock_icon_path[PATH_MAX] = "images/svg/clock.svg";
-char clock_icon_loaded_path[PATH_MAX];
-int net_icon_loaded_h;
-int net_icon_w;
-int net_icon_h;
-struct wlr_buffer *net_icon_buf;
-int clock_icon_loaded_h;
-int clock_icon_w;
-int clock_icon_h;
-struct wlr_buffer *clock_icon_buf;
-int cpu_icon_loaded_h;
-int cpu_icon_w;
-int cpu_icon_h;
-struct wlr_buffer *cpu_icon_buf;
-int light_icon_loaded_h;
-int light_icon_w;
-int light_icon_h;
-struct wlr_buffer *light_icon_buf;
-int ram_icon_loaded_h;
-int ram_icon_w;
-int ram_icon_h;
-struct wlr_buffer *ram_icon_buf;
-int battery_icon_loaded_h;
-int battery_icon_w;
-int battery_icon_h;
-struct wlr_buffer *battery_icon_buf;
-int mic_icon_loaded_h;
-int mic_icon_w;
-int mic_icon_h;
-struct wlr_buffer *mic_icon_buf;
-int volume_icon_loaded_h;
-int volume_icon_w;
-int volume_icon_h;
-struct wlr_buffer *volume_icon_buf;
 unsigned long long net_prev_rx;
 unsigned long long net_prev_tx;
 struct timespec net_prev_ts;
@@ -249,71 +209,27 @@ drawroundedrect(struct wlr_scene_tree *parent, int x, int y,
 	}
 }
 
-/* ── icon/font buffer + asset-path helpers ───────────────────────── */
-struct wlr_buffer *
-statusbar_buffer_from_glyph(const struct fcft_glyph *glyph)
+/* Count the scene nodes under node (itself included) and the buffer
+ * nodes among them that carry a buffer — each of those is one texture
+ * the renderer uploads and one more damage source. */
+void
+scene_count(struct wlr_scene_node *node, int *nodes, int *textures)
 {
-	pixman_image_t *dst, *solid = NULL;
-	struct PixmanBuffer *buf;
-	pixman_color_t col;
-	uint32_t *data;
-	int width, height, stride, force_color;
-
-	if (!glyph || !glyph->pix)
-		return NULL;
-
-	width = glyph->width;
-	height = glyph->height;
-	if (width <= 0 || height <= 0)
-		return NULL;
-
-	stride = width * 4;
-	data = ecalloc(height, stride);
-	if (!data)
-		return NULL;
+	struct wlr_scene_node *child;
 
-	dst = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, width, height,
-			data, stride);
-	if (!dst) {
-		free(data);
-		return NULL;
-	}
-
-	force_color = statusbar_font_force_color || pixman_image_get_format(glyph->pix) == PIXMAN_a8;
-	if (force_color) {
-		const float *fg = statusbar_fg_override ? statusbar_fg_override : statusbar_fg;
-		col.alpha = (uint16_t)lroundf(fg[3] * 65535.0f);
-		col.red = (uint16_t)lroundf(fg[0] * 65535.0f);
-		col.green = (uint16_t)lroundf(fg[1] * 65535.0f);
-		col.blue = (uint16_t)lroundf(fg[2] * 65535.0f);
-		solid = pixman_image_create_solid_fill(&col);
-		pixman_image_composite32(PIXMAN_OP_SRC, solid, glyph->pix, dst,
-				0, 0, 0, 0, 0, 0, width, height);
-	} else {
-		pixman_image_composite32(PIXMAN_OP_SRC, glyph->pix, NULL, dst,
-				0, 0, 0, 0, 0, 0, width, height);
-	}
-
-	if (solid)
-		pixman_image_unref(solid);
-
-	buf = ecalloc(1, sizeof(*buf));
-	if (!buf) {
-		pixman_image_unref(dst);
-		free(data);
-		return NULL;
+	if (!node)
+		return;
+	(*nodes)++;
+	if (node->type == WLR_SCENE_NODE_BUFFER) {
+		if (wlr_scene_buffer_from_node(node)->buffer)
+			(*textures)++;
+	} else if (node->type == WLR_SCENE_NODE_TREE) {
+		wl_list_for_each(child, &wlr_scene_tree_from_node(node)->children, link)
+			scene_count(child, nodes, textures);
 	}
-
-	buf->image = dst;
-	buf->data = data;
-	buf->drm_format = DRM_FORMAT_ARGB8888;
-	buf->stride = stride;
-	buf->owns_data = 1;
-	wlr_buffer_init(&buf->base, &pixman_buffer_impl, width, height);
-
-	return &buf->base;
 }
 
+/* ── icon/font buffer + asset-path helpers ───────────────────────── */
 int
 pathisdir(const char *path)
 {
@@ -431,34 +347,6 @@ strip_symbolic_suffix(const char *name, char *out, size_t outlen)
 	return 0;
 }
 
-void
-add_icon_root_paths(const char *base, const char *themes[], size_t theme_count,
-		char pathbufs[][PATH_MAX], size_t *pathcount, size_t max_paths)
-{
-	if (!base || !*base || !themes || !pathbufs || !pathcount)
-		return;
-
-	/* Most XDG_DATA_DIRS entries have no icons/ subdir.  Skip those so
-	 * they don't burn the (bounded) pathbufs slots before we reach the
-	 * dirs that actually hold icon themes. */
-	if (!pathisdir(base))
-		return;
-
-	for (size_t i = 0; i < theme_count && *pathcount < max_paths; i++) {
-		char themed[PATH_MAX];
-		snprintf(themed, sizeof(themed), "%s/%s", base, themes[i]);
-		if (!pathisdir(themed))
-			continue;
-		snprintf(pathbufs[*pathcount], PATH_MAX, "%s", themed);
-		(*pathcount)++;
-	}
-
-	if (*pathcount < max_paths) {
-		snprintf(pathbufs[*pathcount], PATH_MAX, "%s", base);
-		(*pathcount)++;
-	}
-}
-
 GdkPixbuf *
 pixbuf_from_cairo_surface(cairo_surface_t *surface, int width, int height)
 {
@@ -538,15 +426,16 @@ tray_consider_icon(const char *path, int size_hint, int desired_h,
 	}
 }
 
-struct wlr_buffer *
-statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h)
+/* Scale `pixbuf` down to `target_h` (if taller) and convert it to
+ * premultiplied native-endian ARGB8888.  Consumes the pixbuf.  Touches no
+ * compositor state, so the icon cache calls it from its worker thread. */
+uint32_t *
+statusbar_argb32_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h)
 {
 	GdkPixbuf *scaled = NULL;
 	guchar *pixels;
-	int w, h, nchan, stride;
-	uint8_t *argb = NULL;
-	size_t bufsize;
-	struct wlr_buffer *buf = NULL;
+	int w, h, nchan, stride, has_alpha;
+	uint32_t *argb = NULL;
 
 	if (!pixbuf)
 		return NULL;
@@ -576,9 +465,9 @@ statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *o
 	pixels = gdk_pixbuf_get_pixels(pixbuf);
 	if (!pixels)
 		goto out;
+	has_alpha = nchan >= 4 && gdk_pixbuf_get_has_alpha(pixbuf);
 
-	bufsize = (size_t)w * (size_t)h * 4;
-	argb = calloc(1, bufsize);
+	argb = malloc((size_t)w * (size_t)h * 4);
 	if (!argb)
 		goto out;
 
@@ -586,29 +475,47 @@ statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *o
 		const guchar *row = pixels + (size_t)y * (size_t)stride;
 		for (int x = 0; x < w; x++) {
 			const guchar *p = row + (size_t)x * (size_t)nchan;
-			uint8_t r = p[0];
-			uint8_t g = p[1];
-			uint8_t b = p[2];
-			uint8_t a = (nchan >= 4 && gdk_pixbuf_get_has_alpha(pixbuf)) ? p[3] : 255;
-			size_t idx = ((size_t)y * (size_t)w + (size_t)x) * 4;
-			argb[idx] = a;
-			argb[idx + 1] = r;
-			argb[idx + 2] = g;
-			argb[idx + 3] = b;
+			uint32_t a = has_alpha ? p[3] : 255;
+			uint32_t r = p[0], g = p[1], b = p[2];
+
+			/* Premultiply for pixman/wlroots */
+			if (a != 255) {
+				r = (r * a + 127) / 255;
+				g = (g * a + 127) / 255;
+				b = (b * a + 127) / 255;
+			}
+			argb[(size_t)y * (size_t)w + (size_t)x] =
+				(a << 24) | (r << 16) | (g << 8) | b;
 		}
 	}
 
-	buf = statusbar_buffer_from_argb32((const uint32_t *)argb, w, h);
+	if (out_w)
+		*out_w = w;
+	if (out_h)
+		*out_h = h;
+
+out:
+	g_object_unref(pixbuf);
+	return argb;
+}
+
+struct wlr_buffer *
+statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h)
+{
+	struct wlr_buffer *buf;
+	uint32_t *argb;
+	int w = 0, h = 0;
+
+	if (!(argb = statusbar_argb32_from_pixbuf(pixbuf, target_h, &w, &h)))
+		return NULL;
+	buf = statusbar_buffer_from_argb32_raw(argb, w, h);
+	free(argb);
 	if (buf) {
 		if (out_w)
 			*out_w = w;
 		if (out_h)
 			*out_h = h;
 	}
-
-out:
-	free(argb);
-	g_object_unref(pixbuf);
 	return buf;
 }
 
@@ -855,39 +762,12 @@ out:
 void
 fix_tray_argb32(uint32_t *pixels, size_t count, int use_rgba_order)
 {
-	size_t i;
-
-	if (!pixels || count == 0)
-		return;
-
-	for (i = 0; i < count; i++) {
-		/* IconPixmap spec: ARGB32, bytes in big-endian order A,R,G,B */
-		const uint8_t *p8 = (const uint8_t *)&pixels[i];
-		uint8_t a, r, g, b;
-
-		if (use_rgba_order || statusbar_tray_force_rgba) {
-			/* Fallback for apps that provide RGBA bytes */
-			r = p8[0];
-			g = p8[1];
-			b = p8[2];
-			a = p8[3];
-		} else {
-			a = p8[0];
-			r = p8[1];
-			g = p8[2];
-			b = p8[3];
-		}
-
-		/* Premultiply for pixman/wlroots */
-		if (a != 0 && a != 255) {
-			r = (uint8_t)((r * a + 127) / 255);
-			g = (uint8_t)((g * a + 127) / 255);
-			b = (uint8_t)((b * a + 127) / 255);
-		}
-
-		pixels[i] = ((uint32_t)a << 24) | ((uint32_t)r << 16) |
-			((uint32_t)g << 8) | (uint32_t)b;
-	}
+	/* IconPixmap spec: ARGB32, bytes in big-endian order A,R,G,B;
+	 * RGBA is the fallback for apps that get it wrong.  Premultiplied
+	 * for pixman/wlroots. */
+	if (pixels && count)
+		tray_pixmap_convert(pixels, pixels, count,
+				use_rgba_order || statusbar_tray_force_rgba);
 }
 
 void
@@ -1141,6 +1021,7 @@ loadstatusfont(void)
 void
 freestatusfont(void)
 {
+	label_cache_flush();
 	if (statusfont.font)
 		fcft_destroy(statusfont.font);
 	statusfont.font = NULL;
@@ -1448,11 +1329,14 @@ audio:
 
 		/* Synchronous: the async fork()+wpctl form returns before the
 		 * change lands, so the read-back below would see stale state. */
-		run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SINK@ 0");
-		snprintf(cmd, sizeof(cmd),
-			"wpctl set-volume @DEFAULT_AUDIO_SINK@ %.2f",
-			speaker_default / 100.0);
-		run_wpctl_sync(cmd);
+		if (pw_audio_set_mute(0, 0) != 0)
+			run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SINK@ 0");
+		if (pw_audio_set_volume(0, speaker_default) != 0) {
+			snprintf(cmd, sizeof(cmd),
+				"wpctl set-volume @DEFAULT_AUDIO_SINK@ %.2f",
+				speaker_default / 100.0);
+			run_wpctl_sync(cmd);
+		}
 
 		volume_invalidate_cache(0);
 		volume_invalidate_cache(1);
@@ -1473,11 +1357,14 @@ audio:
 	{
 		mic_last_read_ms = 0;
 		if (pipewire_mic_volume_percent() >= 0.0) {
-			run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SOURCE@ 0");
-			snprintf(cmd, sizeof(cmd),
-				"wpctl set-volume @DEFAULT_AUDIO_SOURCE@ %.2f",
-				mic_default / 100.0);
-			run_wpctl_sync(cmd);
+			if (pw_audio_set_mute(1, 0) != 0)
+				run_wpctl_sync("wpctl set-mute @DEFAULT_AUDIO_SOURCE@ 0");
+			if (pw_audio_set_volume(1, mic_default) != 0) {
+				snprintf(cmd, sizeof(cmd),
+					"wpctl set-volume @DEFAULT_AUDIO_SOURCE@ %.2f",
+					mic_default / 100.0);
+				run_wpctl_sync(cmd);
+			}
 
 			mic_last_read_ms = 0;
 			{
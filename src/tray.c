@@ -107,6 +107,8 @@ tray_load_icon_file(TrayItem *it, const char *path, int desired_h)
 	it->icon_buf = buf;
 	it->icon_w = w;
 	it->icon_h = h;
+	it->icon_hash = 0;
+	it->pixmap_gen = 0; /* a queued pixmap must not replace this */
 	tray_measure_icon_insets(it);
 	return 0;
 }
@@ -264,46 +266,11 @@ int
 tray_find_icon_path(const char *name, const char *theme_path, int desired_h,
 		char *out, size_t outlen)
 {
-	const char *xdg_data_dirs;
 	char best_path[PATH_MAX] = {0};
-	/* static: 256 * PATH_MAX is too large for the stack, and icon lookup
-	 * runs single-threaded on the compositor event loop. */
-	static char pathbufs[256][PATH_MAX];
-	size_t pathcount = 0;
+	char indexed[PATH_MAX];
 	int found = 0;
 	int best_diff = INT_MAX;
-	const char *themes[16] = {0};
-	size_t theme_count = 0;
-	char theme_env[256] = {0};
-	const char *default_themes[] = {
-		"Papirus", "Papirus-Dark", "Papirus-Light", "Adwaita", "hicolor"
-	};
-
-#define ADD_PATH(P) do { \
-	const char *p_ = (P); \
-	if (p_ && *p_ && pathcount < LENGTH(pathbufs)) { \
-		snprintf(pathbufs[pathcount], sizeof(pathbufs[pathcount]), "%s", p_); \
-		pathcount++; \
-	} \
-} while (0)
-
-	if (getenv("STATUSBAR_ICON_THEMES")) {
-		snprintf(theme_env, sizeof(theme_env), "%s", getenv("STATUSBAR_ICON_THEMES"));
-		for (char *tok = theme_env; tok && *tok && theme_count < LENGTH(themes); ) {
-			char *sep = strchr(tok, ':');
-			if (sep)
-				*sep = '\0';
-			if (*tok)
-				themes[theme_count++] = tok;
-			if (!sep)
-				break;
-			tok = sep + 1;
-		}
-	}
-	if (theme_count == 0) {
-		for (size_t i = 0; i < LENGTH(default_themes) && theme_count < LENGTH(themes); i++)
-			themes[theme_count++] = default_themes[i];
-	}
+	int diff = INT_MAX;
 
 	if (!name || !*name || !out || outlen == 0)
 		return -1;
@@ -313,279 +280,407 @@ tray_find_icon_path(const char *name, const char *theme_path, int desired_h,
 		return 0;
 	}
 
-	if (theme_path && *theme_path && pathcount < LENGTH(pathbufs)) {
-		ADD_PATH(theme_path);
-	}
+	/* An item's own IconThemePath is small and private to it; probe it
+	 * directly rather than indexing every app's directory. */
+	if (theme_path && *theme_path)
+		tray_lookup_icon_in_root(theme_path, name, desired_h, best_path, &best_diff, &found);
 
-	{
-		const char *xdg_home = getenv("XDG_DATA_HOME");
-		const char *home = getenv("HOME");
-		if (xdg_home && *xdg_home && pathcount < LENGTH(pathbufs)) {
-			char path[PATH_MAX];
-			snprintf(path, sizeof(path), "%s/icons", xdg_home);
-			add_icon_root_paths(path, themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-		} else if (home && *home && pathcount < LENGTH(pathbufs)) {
-			char path[PATH_MAX];
-			snprintf(path, sizeof(path), "%s/.local/share/icons", home);
-			add_icon_root_paths(path, themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-		}
-		if (home && *home && pathcount < LENGTH(pathbufs)) {
-			char path[PATH_MAX];
-			snprintf(path, sizeof(path), "%s/.icons", home);
-			add_icon_root_paths(path, themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-		}
+	if ((!found || best_diff > 0)
+			&& icon_theme_lookup(name, desired_h, indexed, sizeof(indexed), &diff) == 0
+			&& (!found || diff < best_diff)) {
+		snprintf(best_path, sizeof(best_path), "%s", indexed);
+		found = 1;
 	}
 
-	xdg_data_dirs = getenv("XDG_DATA_DIRS");
-	if (!xdg_data_dirs || !*xdg_data_dirs)
-		xdg_data_dirs = "/usr/local/share:/usr/share";
-	while (*xdg_data_dirs && pathcount < LENGTH(pathbufs)) {
-		const char *end = strchrnul(xdg_data_dirs, ':');
-		size_t len = (size_t)(end - xdg_data_dirs);
-		if (len > 0 && len < sizeof(pathbufs[0]) - 7) {
-			char path[PATH_MAX];
-			snprintf(path, sizeof(path), "%.*s/icons",
-					(int)len, xdg_data_dirs);
-			add_icon_root_paths(path, themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-		}
-		if (*end == '\0')
-			break;
-		xdg_data_dirs = end + 1;
-	}
+	if (!found)
+		return -1;
 
-	{
-		const char *nix_profiles = getenv("NIX_PROFILES");
-		while (nix_profiles && *nix_profiles && pathcount < LENGTH(pathbufs)) {
-			const char *end = strchrnul(nix_profiles, ' ');
-			size_t len = (size_t)(end - nix_profiles);
-			if (len > 0 && len < sizeof(pathbufs[0]) - 14 && pathcount < LENGTH(pathbufs)) {
-				char path[PATH_MAX];
-				snprintf(path, sizeof(path),
-						"%.*s/share/icons", (int)len, nix_profiles);
-				add_icon_root_paths(path, themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-			}
-			if (len > 0 && len < sizeof(pathbufs[0]) - 16 && pathcount < LENGTH(pathbufs)) {
-				char path[PATH_MAX];
-				snprintf(path, sizeof(path),
-						"%.*s/share/pixmaps", (int)len, nix_profiles);
-				ADD_PATH(path);
-			}
-			if (*end == '\0')
-				break;
-			nix_profiles = end + 1;
-		}
-	}
+	snprintf(out, outlen, "%s", best_path);
+	return 0;
+}
 
-	if (pathcount < LENGTH(pathbufs)) {
-		add_icon_root_paths("/run/current-system/sw/share/icons", themes, theme_count, pathbufs, &pathcount, LENGTH(pathbufs));
-	}
-	if (pathcount < LENGTH(pathbufs)) {
-		ADD_PATH("/run/current-system/sw/share/pixmaps");
-	}
+/* Per-item D-Bus traffic is asynchronous: the object path is found with
+ * Introspect calls and the properties arrive in one GetAll, each call
+ * bounded by its own timeout.  A hung tray app (Electron, Wine's systray
+ * bridge) only ever delays its own icon, never a frame; replies are
+ * dispatched by tray_bus_event and repaint the tray when they land. */
+#define TRAY_CALL_TIMEOUT_USEC (2 * 1000 * 1000)
+#define TRAY_PROBE_MAX         32
+#define TRAY_ICON_RETRY_MS     10000
+
+static const char *tray_sni_ifaces[] = {
+	"org.kde.StatusNotifierItem",
+	"org.freedesktop.StatusNotifierItem",
+};
+
+/* Breadth-first object path search for an item's SNI object */
+struct TrayProbe {
+	char path[TRAY_PROBE_MAX][128];
+	int depth[TRAY_PROBE_MAX];
+	int head, n;
+};
+
+typedef struct {
+	const void *data;          /* points into the reply message */
+	int w, h;
+	int score;
+	size_t area;
+} TrayPixmap;
+
+static struct wl_event_source *tray_timeout_event;
 
-	if (pathcount < LENGTH(pathbufs)) {
-		ADD_PATH("/usr/share/pixmaps");
-	}
+static int
+tray_bus_timeout(void *data)
+{
+	(void)data;
+	if (tray_bus && tray_event)
+		tray_bus_event(-1, 0, tray_bus);
+	return 0;
+}
 
-#undef ADD_PATH
+/* sd-bus expires async calls only from sd_bus_process(), and queues
+ * writes it could not flush: keep a timer on the earliest reply deadline
+ * and the fd mask in step with the write queue. */
+static void
+tray_bus_rearm(void)
+{
+	struct timespec ts;
+	uint64_t until = UINT64_MAX, now;
+	uint32_t mask = 0;
+	int events;
 
-	for (size_t i = 0; i < pathcount; i++) {
-		tray_lookup_icon_in_root(pathbufs[i], name, desired_h, best_path, &best_diff, &found);
-		if (found && best_diff == 0)
-			break;
-	}
+	if (!tray_bus || !tray_event)
+		return;
 
-	if (!found)
-		return -1;
+	events = sd_bus_get_events(tray_bus);
+	if (events & SD_BUS_EVENT_READABLE)
+		mask |= WL_EVENT_READABLE;
+	if (events & SD_BUS_EVENT_WRITABLE)
+		mask |= WL_EVENT_WRITABLE;
+	wl_event_source_fd_update(tray_event, mask ? mask : WL_EVENT_READABLE);
 
-	snprintf(out, outlen, "%s", best_path);
-	return 0;
+	if (sd_bus_get_timeout(tray_bus, &until) < 0 || until == UINT64_MAX) {
+		if (tray_timeout_event)
+			wl_event_source_timer_update(tray_timeout_event, 0);
+		return;
+	}
+	if (!tray_timeout_event)
+		tray_timeout_event = wl_event_loop_add_timer(event_loop, tray_bus_timeout, NULL);
+	if (!tray_timeout_event)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+	wl_event_source_timer_update(tray_timeout_event,
+			until > now ? (int)MIN((until - now) / 1000 + 1, (uint64_t)INT_MAX) : 1);
 }
 
-int
-tray_get_string_property(TrayItem *it, const char *prop, char *out, size_t outlen)
+static int
+tray_item_call(TrayItem *it, const char *path, const char *iface, const char *member,
+		const char *arg, sd_bus_message_handler_t cb)
 {
-	const char *ifaces[] = {
-		"org.kde.StatusNotifierItem",
-		"org.freedesktop.StatusNotifierItem",
-	};
-	sd_bus_message *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
-	const char *val = NULL;
-	int r = -1;
+	sd_bus_message *msg = NULL;
+	int r;
 
-	if (!tray_bus || !it || !prop)
-		return -1;
+	it->slot = sd_bus_slot_unref(it->slot);
+	r = sd_bus_message_new_method_call(tray_bus, &msg, it->service, path, iface, member);
+	if (r >= 0 && arg)
+		r = sd_bus_message_append(msg, "s", arg);
+	if (r >= 0)
+		r = sd_bus_call_async(tray_bus, &it->slot, msg, cb, it, TRAY_CALL_TIMEOUT_USEC);
+	sd_bus_message_unref(msg);
+	tray_bus_rearm();
+	return r;
+}
 
-	for (size_t iface_idx = 0; iface_idx < LENGTH(ifaces); iface_idx++) {
-		sd_bus_error_free(&err);
-		sd_bus_message_unref(reply);
-		reply = NULL;
+/* Reads an a(iiay) (the variant already entered) and keeps the pixmap
+ * closest to desired_h, or the largest when there is no target. */
+static void
+tray_pick_pixmap(sd_bus_message *msg, int desired_h, TrayPixmap *best)
+{
+	if (sd_bus_message_enter_container(msg, 'a', "(iiay)") < 0)
+		return;
 
-		r = sd_bus_call_method(tray_bus, it->service, it->path,
-				"org.freedesktop.DBus.Properties", "Get",
-				&err, &reply, "ss", ifaces[iface_idx], prop);
-		if (r >= 0)
+	while (sd_bus_message_enter_container(msg, 'r', "iiay") > 0) {
+		int w = 0, h = 0;
+		const void *pix = NULL;
+		size_t len = 0;
+		if (sd_bus_message_read(msg, "ii", &w, &h) < 0) {
+			sd_bus_message_exit_container(msg); /* struct */
+			break;
+		}
+		if (sd_bus_message_read_array(msg, 'y', &pix, &len) < 0) {
+			sd_bus_message_exit_container(msg); /* struct */
 			break;
+		}
+		if (w > 0 && h > 0 && len >= (size_t)w * (size_t)h * 4) {
+			int diff = desired_h > 0 ? abs(h - desired_h) : INT_MAX;
+			size_t area = (size_t)w * (size_t)h;
+			if ((desired_h > 0 && (diff < best->score ||
+					(diff == best->score && h < best->h))) ||
+					(desired_h <= 0 && area > best->area)) {
+				best->score = diff;
+				best->area = area;
+				best->w = w;
+				best->h = h;
+				best->data = pix;
+			}
+		}
+		sd_bus_message_exit_container(msg); /* struct */
 	}
-	if (r < 0 || !reply)
-		goto out;
-	if (sd_bus_message_enter_container(reply, 'v', "s") < 0)
-		goto out;
-	if (sd_bus_message_read(reply, "s", &val) < 0)
-		goto out;
-	if (val && *val && out && outlen > 0)
-		snprintf(out, outlen, "%s", val);
 
-out:
-	sd_bus_error_free(&err);
-	sd_bus_message_unref(reply);
-	return (val && *val) ? 0 : -1;
+	sd_bus_message_exit_container(msg);
 }
 
-int
-tray_item_load_icon(TrayItem *it)
+/* Decoding runs on the tray_pixmap.c worker; the pixmap lands in
+ * tray_item_pixmap_ready().  Returns -1 if the item sent no usable one. */
+static int
+tray_item_queue_pixmap(TrayItem *it, sd_bus_message *m, const TrayPixmap *icon,
+		const TrayPixmap *attention, int desired_h)
 {
-	sd_bus_message *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
-	const void *best_data = NULL;
-	size_t best_len = 0;
-	int desired_h = statusbar_height > 0 ? MAX(12, (int)statusbar_height - 4) : 24;
-	int best_score = INT_MAX;
-	int best_w = 0, best_h = 0;
-	int r;
-	const char *ifaces[] = {
-		"org.kde.StatusNotifierItem",
-		"org.freedesktop.StatusNotifierItem",
-	};
-	const char *props[] = { "IconPixmap", "AttentionIconPixmap" };
-	int prop_idx;
+	const TrayPixmap *px = icon->data ? icon : attention;
 
-	if (!tray_bus || !it)
-		return -1;
-	if (it->icon_tried && it->icon_failed)
-		return -1;
-	it->icon_tried = 1;
+	return px->data ? tray_pixmap_decode(it, m, px->data, px->w, px->h, desired_h) : -1;
+}
 
-	/* Prefer themed icons first so the user's icon theme takes effect */
-	{
-		char icon_theme_path[PATH_MAX] = {0};
-		char icon_path[PATH_MAX] = {0};
-		char icon_name[128] = {0};
+void
+tray_item_pixmap_ready(TrayItem *it, struct wlr_buffer *buf, uint64_t hash)
+{
+	if (!buf) {
+		it->icon_failed = 1;
+		it->icon_retry_not_before_ms = monotonic_msec() + TRAY_ICON_RETRY_MS;
+		tray_update_icons_text();
+		return;
+	}
+	if (it->icon_buf)
+		wlr_buffer_drop(it->icon_buf);
+	it->icon_buf = buf;
+	it->icon_w = buf->width;
+	it->icon_h = buf->height;
+	it->icon_hash = hash;
+	it->icon_failed = 0;
+	tray_measure_icon_insets(it);
+	tray_update_icons_text();
+}
 
-		tray_get_string_property(it, "IconThemePath", icon_theme_path,
-				sizeof(icon_theme_path));
+static int
+tray_item_set_named_icon(TrayItem *it, const char *name, const char *theme_path,
+		int desired_h)
+{
+	char icon_path[PATH_MAX] = {0};
 
-		if (tray_get_string_property(it, "AttentionIconName", icon_name, sizeof(icon_name)) == 0 &&
-				tray_find_icon_path(icon_name, icon_theme_path, desired_h,
-					icon_path, sizeof(icon_path)) == 0 &&
-				tray_load_icon_file(it, icon_path, desired_h) == 0) {
-			it->icon_failed = 0;
-			return 0;
-		}
+	return name[0]
+		&& tray_find_icon_path(name, theme_path, desired_h,
+			icon_path, sizeof(icon_path)) == 0
+		&& tray_load_icon_file(it, icon_path, desired_h) == 0 ? 0 : -1;
+}
 
-		memset(icon_name, 0, sizeof(icon_name));
-		memset(icon_path, 0, sizeof(icon_path));
-		if (tray_get_string_property(it, "IconName", icon_name, sizeof(icon_name)) == 0 &&
-				tray_find_icon_path(icon_name, icon_theme_path, desired_h,
-					icon_path, sizeof(icon_path)) == 0 &&
-				tray_load_icon_file(it, icon_path, desired_h) == 0) {
-			it->icon_failed = 0;
-			return 0;
+/* One app, one icon: Steam registers the same indicator from two bus
+ * connections (bootstrap and client both export
+ * /org/ayatana/NotificationItem/steam), giving two identical tray
+ * icons.  An existing item with the same SNI Id — or the same
+ * app-specific object path when Id is unavailable — is the same
+ * application re-registering: the newest registration wins.  Runs once
+ * the item's properties are in; returns 1 if it was the stale one and
+ * is gone. */
+static int
+tray_item_dedup(TrayItem *it)
+{
+	TrayItem *other, *tmp;
+	char service[sizeof(it->service)];
+
+	wl_list_for_each_safe(other, tmp, &tray_items, link) {
+		int same_id, same_path;
+		if (other == it || other->probe)
+			continue;
+		same_id = it->sni_id[0] && other->sni_id[0] &&
+			strcmp(it->sni_id, other->sni_id) == 0;
+		same_path = strcmp(it->path, other->path) == 0 &&
+			strcmp(it->path, "/StatusNotifierItem") != 0;
+		if (!same_id && !same_path)
+			continue;
+		if (other->seq > it->seq) {
+			wlr_log(WLR_INFO, "tray: dropping duplicate %s%s (replaced by %s)",
+					it->service, it->path, other->service);
+			snprintf(service, sizeof(service), "%s", it->service);
+			tray_remove_item(service);
+			return 1;
 		}
+		wlr_log(WLR_INFO, "tray: dropping duplicate %s%s (replaced by %s)",
+				other->service, other->path, it->service);
+		tray_remove_item(other->service);
 	}
+	return 0;
+}
 
-	for (prop_idx = 0; prop_idx < (int)LENGTH(props); prop_idx++) {
-		best_data = NULL;
-		best_len = 0;
-		best_score = INT_MAX;
-		best_w = best_h = 0;
+static int tray_item_fetch(TrayItem *it, int icon);
+static void tray_item_menu_model(TrayItem *it);
 
-		for (size_t iface_idx = 0; iface_idx < LENGTH(ifaces); iface_idx++) {
-			sd_bus_error_free(&err);
-			sd_bus_message_unref(reply);
-			reply = NULL;
+static int
+tray_item_props_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	TrayItem *it = userdata;
+	char icon_name[128] = {0}, attention_name[128] = {0};
+	char theme_path[PATH_MAX] = {0};
+	char status[32] = {0}, id[64] = {0}, menu[128] = {0};
+	TrayPixmap icon = { .score = INT_MAX }, attention = { .score = INT_MAX };
+	int desired_h = statusbar_height > 0 ? MAX(12, (int)statusbar_height - 4) : 24;
+	int want_icon = it->fetch_icon || !it->icon_buf;
+	int known = 0;
 
-			r = sd_bus_call_method(tray_bus, it->service, it->path,
-					"org.freedesktop.DBus.Properties", "Get",
-					&err, &reply, "ss", ifaces[iface_idx], props[prop_idx]);
-			if (r >= 0)
-				break;
+	(void)ret_error;
+	it->slot = sd_bus_slot_unref(it->slot);
+
+	if (sd_bus_message_is_method_error(m, NULL)) {
+		const sd_bus_error *e = sd_bus_message_get_error(m);
+		/* A missing interface answers at once, so try the other name;
+		 * a timeout means the app is stuck — don't pay it twice. */
+		if (!sd_bus_message_is_method_error(m, "org.freedesktop.DBus.Error.NoReply")
+				&& it->fetch_iface + 1 < (int)LENGTH(tray_sni_ifaces)) {
+			it->fetch_iface++;
+			if (tray_item_call(it, it->path, "org.freedesktop.DBus.Properties", "GetAll",
+					tray_sni_ifaces[it->fetch_iface], tray_item_props_reply) >= 0)
+				return 0;
 		}
-		if (r < 0)
-			continue;
-
-		if (sd_bus_message_enter_container(reply, 'v', "a(iiay)") < 0)
-			continue;
-		if (sd_bus_message_enter_container(reply, 'a', "(iiay)") < 0)
-			continue;
-
-		while (sd_bus_message_enter_container(reply, 'r', "iiay") > 0) {
-			int w = 0, h = 0;
-			const void *pix = NULL;
-			size_t len = 0;
-			if (sd_bus_message_read(reply, "ii", &w, &h) < 0) {
-				sd_bus_message_exit_container(reply); /* struct */
-				break;
-			}
-			if (sd_bus_message_read_array(reply, 'y', &pix, &len) < 0) {
-				sd_bus_message_exit_container(reply); /* struct */
-				break;
+		wlr_log(WLR_ERROR, "tray: GetAll on %s%s failed: %s", it->service, it->path,
+				e && e->message ? e->message : "no reply");
+		it->fetch_iface = 0;
+		goto failed;
+	}
+
+	if (sd_bus_message_enter_container(m, 'a', "{sv}") < 0)
+		goto failed;
+	while (sd_bus_message_enter_container(m, 'e', "sv") > 0) {
+		const char *key = NULL, *contents = NULL, *val = NULL;
+		char *dst = NULL;
+		size_t dstlen = 0;
+		char type;
+
+		if (sd_bus_message_read_basic(m, 's', &key) < 0 || !key
+				|| sd_bus_message_peek_type(m, &type, &contents) < 0 || !contents)
+			break;
+		if (strcmp(key, "IconName") == 0)
+			dst = icon_name, dstlen = sizeof(icon_name);
+		else if (strcmp(key, "AttentionIconName") == 0)
+			dst = attention_name, dstlen = sizeof(attention_name);
+		else if (strcmp(key, "IconThemePath") == 0)
+			dst = theme_path, dstlen = sizeof(theme_path);
+		else if (strcmp(key, "Status") == 0)
+			dst = status, dstlen = sizeof(status);
+		else if (strcmp(key, "Id") == 0)
+			dst = id, dstlen = sizeof(id);
+		else if (strcmp(key, "Menu") == 0)
+			dst = menu, dstlen = sizeof(menu);
+
+		if (dst && (strcmp(contents, "s") == 0 || strcmp(contents, "o") == 0)) {
+			if (sd_bus_message_enter_container(m, 'v', contents) >= 0) {
+				if (sd_bus_message_read_basic(m, contents[0], &val) >= 0 && val)
+					snprintf(dst, dstlen, "%s", val);
+				sd_bus_message_exit_container(m);
 			}
-			if (w > 0 && h > 0 && len >= (size_t)w * (size_t)h * 4) {
-				int diff = desired_h > 0 ? abs(h - desired_h) : INT_MAX;
-				size_t area = (size_t)w * (size_t)h;
-				if ((desired_h > 0 && (diff < best_score ||
-						(diff == best_score && h < best_h))) ||
-						(desired_h <= 0 && area > best_len)) {
-					best_score = diff;
-					best_len = area;
-					best_w = w;
-					best_h = h;
-					best_data = pix;
-				}
+			known++;
+		} else if (strcmp(contents, "a(iiay)") == 0 && (strcmp(key, "IconPixmap") == 0
+				|| strcmp(key, "AttentionIconPixmap") == 0)) {
+			if (want_icon && sd_bus_message_enter_container(m, 'v', contents) >= 0) {
+				tray_pick_pixmap(m, desired_h, key[0] == 'I' ? &icon : &attention);
+				sd_bus_message_exit_container(m);
+			} else {
+				sd_bus_message_skip(m, "v");
 			}
-			sd_bus_message_exit_container(reply); /* struct */
+			known++;
+		} else {
+			sd_bus_message_skip(m, "v");
 		}
+		sd_bus_message_exit_container(m); /* dict entry */
+	}
+	sd_bus_message_exit_container(m);
 
-		sd_bus_message_exit_container(reply);
-		sd_bus_message_exit_container(reply);
+	/* Some items answer GetAll on an interface they don't implement with
+	 * an empty dict instead of an error. */
+	if (!known && it->fetch_iface + 1 < (int)LENGTH(tray_sni_ifaces)) {
+		it->fetch_iface++;
+		if (tray_item_call(it, it->path, "org.freedesktop.DBus.Properties", "GetAll",
+				tray_sni_ifaces[it->fetch_iface], tray_item_props_reply) >= 0)
+			return 0;
+	}
 
-		if (best_data && best_w > 0 && best_h > 0)
-			break;
+	/* SNI Status: "Passive" means the item asks to be hidden ("Active"
+	 * and "NeedsAttention" are both shown).  Items that don't implement
+	 * the property are treated as active. */
+	it->passive = strcmp(status, "Passive") == 0;
+	snprintf(it->sni_id, sizeof(it->sni_id), "%s", id);
+	if (menu[0] && strcmp(menu, "/") != 0) {
+		snprintf(it->menu, sizeof(it->menu), "%s", menu);
+		it->has_menu = 1;
+		tray_item_menu_model(it);
 	}
 
-	if (best_data && best_w > 0 && best_h > 0) {
-		int target_h = (desired_h > 0) ? desired_h : best_h;
-		struct wlr_buffer *buf = NULL;
+	/* Prefer themed icons first so the user's icon theme takes effect */
+	if (want_icon) {
+		if (tray_item_set_named_icon(it, attention_name, theme_path, desired_h) != 0
+				&& tray_item_set_named_icon(it, icon_name, theme_path, desired_h) != 0
+				&& tray_item_queue_pixmap(it, m, &icon, &attention, desired_h) != 0)
+			goto failed;
+		it->icon_failed = 0;
+	}
+	goto done;
+
+failed:
+	if (want_icon) {
+		it->icon_failed = 1;
+		it->icon_retry_not_before_ms = monotonic_msec() + TRAY_ICON_RETRY_MS;
+	}
+done:
+	it->fetch_icon = 0;
+	if (tray_item_dedup(it))
+		return 0;
+	if (it->refetch) {
+		it->refetch = 0;
+		tray_item_fetch(it, it->refetch_icon);
+		it->refetch_icon = 0;
+	}
+	tray_update_icons_text();
+	return 0;
+}
 
-		if (best_h > target_h && target_h > 0)
-			buf = statusbar_scaled_buffer_from_argb32(best_data, best_w, best_h, target_h);
-		else
-			buf = statusbar_buffer_from_argb32(best_data, best_w, best_h);
-		if (buf) {
-			if (it->icon_buf)
-				wlr_buffer_drop(it->icon_buf);
-			it->icon_buf = buf;
-			if (target_h > 0 && best_h > target_h) {
-				it->icon_w = (int)lround(((double)best_w * (double)target_h) / (double)best_h);
-				it->icon_h = target_h;
-			} else {
-				it->icon_w = best_w;
-				it->icon_h = best_h;
-			}
-			tray_measure_icon_insets(it);
-			sd_bus_message_unref(reply);
-			sd_bus_error_free(&err);
-			it->icon_failed = 0;
-			return 0;
-		}
+/* Queue a property refresh; icon != 0 also reloads the icon.  A fetch
+ * already in flight may predate the change, so it is re-issued once that
+ * reply is in.  Returns -1 only if nothing could be sent. */
+static int
+tray_item_fetch(TrayItem *it, int icon)
+{
+	if (!tray_bus || !it)
+		return -1;
+	if (it->probe) {
+		/* the probe ends in a full fetch */
+		return 0;
+	}
+	if (it->slot) {
+		it->refetch = 1;
+		it->refetch_icon |= icon;
+		return 0;
 	}
+	it->fetch_icon = icon;
+	if (tray_item_call(it, it->path, "org.freedesktop.DBus.Properties", "GetAll",
+			tray_sni_ifaces[it->fetch_iface], tray_item_props_reply) < 0) {
+		it->fetch_icon = 0;
+		return -1;
+	}
+	return 0;
+}
 
-	sd_bus_message_unref(reply);
-	sd_bus_error_free(&err);
-	it->icon_failed = 1;
-	return -1;
+int
+tray_item_load_icon(TrayItem *it)
+{
+	if (!tray_bus || !it)
+		return -1;
+	if (it->icon_tried && it->icon_failed)
+		return -1;
+	it->icon_tried = 1;
+	if (tray_item_fetch(it, 1) != 0) {
+		it->icon_failed = 1;
+		return -1;
+	}
+	return 0;
 }
 
 void
@@ -601,100 +696,98 @@ tray_emit_host_registered(void)
 			"StatusNotifierHostRegistered", "");
 }
 
-int
-tray_search_item_path(const char *service, const char *start_path,
-		char *out, size_t outlen, int depth)
+static int tray_item_probe_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error);
+
+static void
+tray_item_probe_push(struct TrayProbe *p, const char *path, int depth)
 {
-	sd_bus_message *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
-	const char *xml;
-	const char *p;
-	int r = -1;
+	if (p->n >= TRAY_PROBE_MAX || !path[0] || strlen(path) >= sizeof(p->path[0]))
+		return;
+	for (int i = 0; i < p->n; i++)
+		if (strcmp(p->path[i], path) == 0)
+			return;
+	snprintf(p->path[p->n], sizeof(p->path[p->n]), "%s", path);
+	p->depth[p->n++] = depth;
+}
 
-	if (!tray_bus || !service || !start_path || !out || outlen == 0 || depth <= 0)
-		return -EINVAL;
+/* path == NULL: nothing answered, keep the registered path */
+static void
+tray_item_probe_done(TrayItem *it, const char *path)
+{
+	if (path)
+		snprintf(it->path, sizeof(it->path), "%s", path);
+	free(it->probe);
+	it->probe = NULL;
+	if (tray_item_fetch(it, 1) != 0) {
+		it->icon_failed = 1;
+		it->icon_retry_not_before_ms = monotonic_msec() + TRAY_ICON_RETRY_MS;
+	}
+}
 
-	r = sd_bus_call_method(tray_bus, service, start_path,
-			"org.freedesktop.DBus.Introspectable", "Introspect",
-			&err, &reply, "");
-	if (r < 0)
-		goto out;
+static void
+tray_item_probe_next(TrayItem *it)
+{
+	struct TrayProbe *p = it->probe;
 
-	if (sd_bus_message_read(reply, "s", &xml) < 0 || !xml) {
-		r = -EINVAL;
-		goto out;
+	for (; p->head < p->n; p->head++) {
+		if (tray_item_call(it, p->path[p->head], "org.freedesktop.DBus.Introspectable",
+				"Introspect", NULL, tray_item_probe_reply) >= 0)
+			return;
 	}
+	tray_item_probe_done(it, NULL);
+}
 
-	if (strstr(xml, "org.kde.StatusNotifierItem")
-			|| strstr(xml, "org.freedesktop.StatusNotifierItem")) {
-		snprintf(out, outlen, "%s", start_path);
-		r = 0;
-		goto out;
+static int
+tray_item_probe_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+	TrayItem *it = userdata;
+	struct TrayProbe *p = it->probe;
+	const char *xml = NULL;
+	const char *s;
+
+	(void)ret_error;
+	it->slot = sd_bus_slot_unref(it->slot);
+	if (!p)
+		return 0;
+
+	if (sd_bus_message_is_method_error(m, "org.freedesktop.DBus.Error.NoReply")) {
+		/* Stuck app: don't walk its object tree one timeout at a time. */
+		tray_item_probe_done(it, NULL);
+		return 0;
 	}
+	if (sd_bus_message_is_method_error(m, NULL)
+			|| sd_bus_message_read(m, "s", &xml) < 0 || !xml)
+		goto next;
 
-	if (depth <= 1) {
-		r = 1;
-		goto out;
+	if (strstr(xml, "org.kde.StatusNotifierItem")
+			|| strstr(xml, "org.freedesktop.StatusNotifierItem")) {
+		tray_item_probe_done(it, p->path[p->head]);
+		return 0;
 	}
 
-	p = xml;
-	while ((p = strstr(p, "<node name=\""))) {
-		char name[128];
+	for (s = xml; p->depth[p->head] > 1 && (s = strstr(s, "<node name=\"")); ) {
+		const char *start = p->path[p->head];
 		char child[256];
 		const char *end;
 		size_t nlen;
 
-		p += strlen("<node name=\"");
-		end = strchr(p, '"');
+		s += strlen("<node name=\"");
+		end = strchr(s, '"');
 		if (!end)
 			break;
-		nlen = (size_t)(end - p);
-		if (nlen == 0 || nlen >= sizeof(name)) {
-			p = end ? end + 1 : p + 1;
-			continue;
-		}
-		memcpy(name, p, nlen);
-		name[nlen] = '\0';
-
-		if (strcmp(start_path, "/") == 0)
-			snprintf(child, sizeof(child), "/%s", name);
-		else
-			snprintf(child, sizeof(child), "%s/%s", start_path, name);
-
-		if (tray_search_item_path(service, child, out, outlen, depth - 1) == 0) {
-			r = 0;
-			goto out;
+		nlen = (size_t)(end - s);
+		if (nlen > 0 && nlen < 128) {
+			snprintf(child, sizeof(child), "%s/%.*s",
+					strcmp(start, "/") == 0 ? "" : start, (int)nlen, s);
+			tray_item_probe_push(p, child, p->depth[p->head] - 1);
 		}
-		p = end + 1;
-	}
-
-out:
-	sd_bus_error_free(&err);
-	sd_bus_message_unref(reply);
-	return r;
-}
-
-int
-tray_find_item_path(const char *service, char *path, size_t pathlen)
-{
-	static const char *candidates[] = {
-		"/StatusNotifierItem",
-		"/org/ayatana/NotificationItem",
-	};
-
-	if (!service || !path || pathlen == 0)
-		return -EINVAL;
-
-	for (size_t i = 0; i < LENGTH(candidates); i++) {
-		if (tray_search_item_path(service, candidates[i], path, pathlen, 1) == 0)
-			return 0;
+		s = end + 1;
 	}
 
-	if (tray_search_item_path(service, "/", path, pathlen, 6) == 0)
-		return 0;
-
-	snprintf(path, pathlen, "%s", "/StatusNotifierItem");
-	return -1;
+next:
+	p->head++;
+	tray_item_probe_next(it);
+	return 0;
 }
 
 void
@@ -732,19 +825,63 @@ tray_sanitize_label(const char *src, char *dst, size_t len)
 	dst[di] = '\0';
 }
 
-void
-tray_menu_clear(TrayMenu *menu)
+/* dbusmenu layouts are cached per item and kept current from the menu's
+ * LayoutUpdated / ItemsPropertiesUpdated signals.  The layout is fetched
+ * asynchronously when the pointer first hovers the icon, with each row's
+ * label shaped once on arrival, so a click opens the menu in the same
+ * frame instead of waiting on two blocking round trips. */
+#define TRAY_MENU_MAX_DEPTH 3
+
+struct TrayMenuModel {
+	char path[128];
+	uint32_t revision;
+	int valid;                 /* entries hold a complete layout */
+	int stale;                 /* layout changed since the last GetLayout */
+	int font_h;                /* statusfont.height the rows were shaped at */
+	struct wl_list entries;    /* TrayMenuEntry, text_buf locked */
+	sd_bus_slot *layout_slot;  /* in-flight GetLayout, or NULL */
+	sd_bus_slot *layout_updated_slot;
+	sd_bus_slot *props_updated_slot;
+	Monitor *open_mon;         /* open on arrival of the layout */
+	int open_icon_x;
+};
+
+/* One dbusmenu item's properties, as far as the menu uses them */
+typedef struct {
+	int enabled, visible;
+	int is_separator, has_submenu;
+	int toggle_type, toggle_state;
+	char label[256];
+} TrayMenuProps;
+
+static const TrayMenuProps tray_menu_props_default = {
+	.enabled = 1,
+	.visible = 1,
+};
+
+static void tray_menu_fetch(TrayItem *it);
+
+static void
+tray_menu_entries_free(struct wl_list *entries)
 {
 	TrayMenuEntry *e, *tmp;
 
-	if (!menu)
-		return;
-
-	wl_list_for_each_safe(e, tmp, &menu->entries, link) {
+	wl_list_for_each_safe(e, tmp, entries, link) {
 		wl_list_remove(&e->link);
+		if (e->text_buf)
+			wlr_buffer_unlock(e->text_buf);
 		free(e);
 	}
-	wl_list_init(&menu->entries);
+	wl_list_init(entries);
+}
+
+void
+tray_menu_clear(TrayMenu *menu)
+{
+	if (!menu)
+		return;
+
+	tray_menu_entries_free(&menu->entries);
 
 	menu->width = menu->height = 0;
 	menu->x = menu->y = 0;
@@ -776,68 +913,99 @@ tray_menu_hide_all(void)
 		tray_menu_hide(m);
 }
 
-int
-tray_item_get_menu_path(TrayItem *it)
+/* Reads the variant of one dbusmenu item property into p.  Unknown keys
+ * and values of an unexpected type are skipped. */
+static void
+tray_menu_read_prop(sd_bus_message *msg, const char *key, TrayMenuProps *p)
 {
-	static const char *ifaces[] = {
-		"org.kde.StatusNotifierItem",
-		"org.freedesktop.StatusNotifierItem",
-	};
-	const char *item_path;
-	sd_bus_message *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
-	const char *path = NULL;
-	int r = -1;
-
-	if (!tray_bus || !it)
-		return -EINVAL;
-
-	it->has_menu = 0;
-	it->menu[0] = '\0';
-	item_path = it->path[0] ? it->path : "/StatusNotifierItem";
+	const char *val = NULL;
+	int v = 1;
+	int32_t state = 0;
 
-	for (size_t i = 0; i < LENGTH(ifaces); i++) {
-		sd_bus_error_free(&err);
-		reply = NULL;
-		r = sd_bus_call_method(tray_bus, it->service,
-				item_path,
-				"org.freedesktop.DBus.Properties", "Get",
-				&err, &reply, "ss", ifaces[i], "Menu");
-		if (r < 0)
-			continue;
-		if (sd_bus_message_enter_container(reply, 'v', "o") < 0) {
-			sd_bus_message_unref(reply);
-			continue;
+	if (key && strcmp(key, "label") == 0) {
+		if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
+			if (sd_bus_message_read(msg, "s", &val) >= 0 && val)
+				tray_sanitize_label(val, p->label, sizeof(p->label));
+			sd_bus_message_exit_container(msg);
+			return;
 		}
-		if (sd_bus_message_read(reply, "o", &path) < 0) {
-			sd_bus_message_exit_container(reply);
-			sd_bus_message_unref(reply);
-			continue;
+	} else if (key && (strcmp(key, "enabled") == 0 || strcmp(key, "visible") == 0)) {
+		if (sd_bus_message_enter_container(msg, 'v', "b") >= 0) {
+			sd_bus_message_read(msg, "b", &v);
+			if (key[0] == 'e')
+				p->enabled = v;
+			else
+				p->visible = v;
+			sd_bus_message_exit_container(msg);
+			return;
 		}
-		sd_bus_message_exit_container(reply);
-		if (path && path[0] && strcmp(path, "/") != 0) {
-			snprintf(it->menu, sizeof(it->menu), "%s", path);
-			it->has_menu = 1;
-			sd_bus_message_unref(reply);
-			sd_bus_error_free(&err);
-			return 0;
+	} else if (key && strcmp(key, "type") == 0) {
+		if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
+			if (sd_bus_message_read(msg, "s", &val) >= 0 && val)
+				p->is_separator = strcmp(val, "separator") == 0;
+			sd_bus_message_exit_container(msg);
+			return;
+		}
+	} else if (key && strcmp(key, "toggle-type") == 0) {
+		if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
+			if (sd_bus_message_read(msg, "s", &val) >= 0 && val) {
+				if (strcmp(val, "checkmark") == 0)
+					p->toggle_type = 1;
+				else if (strcmp(val, "radio") == 0)
+					p->toggle_type = 2;
+				else
+					p->toggle_type = 0;
+			}
+			sd_bus_message_exit_container(msg);
+			return;
+		}
+	} else if (key && strcmp(key, "toggle-state") == 0) {
+		if (sd_bus_message_enter_container(msg, 'v', "i") >= 0) {
+			sd_bus_message_read(msg, "i", &state);
+			p->toggle_state = state < 0 ? 0 : state;
+			sd_bus_message_exit_container(msg);
+			return;
+		}
+	} else if (key && strcmp(key, "children-display") == 0) {
+		if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
+			if (sd_bus_message_read(msg, "s", &val) >= 0 && val)
+				p->has_submenu = strcmp(val, "submenu") == 0;
+			sd_bus_message_exit_container(msg);
+			return;
 		}
-		wlr_log(WLR_ERROR, "tray: service %s Menu property empty/invalid", it->service);
-		sd_bus_message_unref(reply);
 	}
+	sd_bus_message_skip(msg, "v");
+}
 
-	sd_bus_error_free(&err);
-	wlr_log(WLR_ERROR, "tray: failed to get Menu property for %s: %s",
-			it->service, strerror(-r));
-	return -1;
+/* ItemsPropertiesUpdated lists removed properties by name: they fall
+ * back to their dbusmenu defaults. */
+static void
+tray_menu_reset_prop(const char *key, TrayMenuProps *p)
+{
+	const TrayMenuProps *d = &tray_menu_props_default;
+
+	if (strcmp(key, "label") == 0)
+		p->label[0] = '\0';
+	else if (strcmp(key, "enabled") == 0)
+		p->enabled = d->enabled;
+	else if (strcmp(key, "visible") == 0)
+		p->visible = d->visible;
+	else if (strcmp(key, "type") == 0)
+		p->is_separator = d->is_separator;
+	else if (strcmp(key, "toggle-type") == 0)
+		p->toggle_type = d->toggle_type;
+	else if (strcmp(key, "toggle-state") == 0)
+		p->toggle_state = d->toggle_state;
+	else if (strcmp(key, "children-display") == 0)
+		p->has_submenu = d->has_submenu;
 }
 
 int
-tray_menu_parse_node(sd_bus_message *msg, TrayMenu *menu, int depth, int max_depth)
+tray_menu_parse_node(sd_bus_message *msg, struct wl_list *entries, int depth, int max_depth)
 {
 	int r;
 
-	if (!msg || !menu)
+	if (!msg || !entries)
 		return -EINVAL;
 
 	r = sd_bus_message_enter_container(msg, 'r', "ia{sv}av");
@@ -848,23 +1016,20 @@ tray_menu_parse_node(sd_bus_message *msg, TrayMenu *menu, int depth, int max_dep
 	if (depth < 0 || depth > max_depth + 4) /* sanity */
 		return -EINVAL;
 
-	r = tray_menu_parse_node_body(msg, menu, depth, max_depth);
+	r = tray_menu_parse_node_body(msg, entries, depth, max_depth);
 	sd_bus_message_exit_container(msg);
 	return r;
 }
 
 int
-tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int max_depth)
+tray_menu_parse_node_body(sd_bus_message *msg, struct wl_list *entries, int depth, int max_depth)
 {
 	TrayMenuEntry *entry = NULL;
+	TrayMenuProps props = tray_menu_props_default;
 	int id = 0, r = 0;
-	int enabled = 1, visible = 1;
-	int is_separator = 0, has_submenu = 0;
-	int toggle_type = 0, toggle_state = 0;
 	int child_count = 0;
-	char label[256] = {0};
 
-	if (!msg || !menu)
+	if (!msg || !entries)
 		return -EINVAL;
 	if (depth > max_depth + 4)
 		return -EINVAL;
@@ -882,80 +1047,7 @@ tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int ma
 			r = -EINVAL;
 			break;
 		}
-		if (key && strcmp(key, "label") == 0) {
-			const char *val = NULL;
-			if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
-				if (sd_bus_message_read(msg, "s", &val) >= 0 && val)
-					tray_sanitize_label(val, label, sizeof(label));
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "enabled") == 0) {
-			int v = 1;
-			if (sd_bus_message_enter_container(msg, 'v', "b") >= 0) {
-				sd_bus_message_read(msg, "b", &v);
-				enabled = v;
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "visible") == 0) {
-			int v = 1;
-			if (sd_bus_message_enter_container(msg, 'v', "b") >= 0) {
-				sd_bus_message_read(msg, "b", &v);
-				visible = v;
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "type") == 0) {
-			const char *val = NULL;
-			if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
-				if (sd_bus_message_read(msg, "s", &val) >= 0 && val
-						&& strcmp(val, "separator") == 0)
-					is_separator = 1;
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "toggle-type") == 0) {
-			const char *val = NULL;
-			if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
-				if (sd_bus_message_read(msg, "s", &val) >= 0 && val) {
-					if (strcmp(val, "checkmark") == 0)
-						toggle_type = 1;
-					else if (strcmp(val, "radio") == 0)
-						toggle_type = 2;
-				}
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "toggle-state") == 0) {
-			int32_t state = 0;
-			if (sd_bus_message_enter_container(msg, 'v', "i") >= 0) {
-				sd_bus_message_read(msg, "i", &state);
-				if (state < 0)
-					state = 0;
-				toggle_state = state;
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else if (key && strcmp(key, "children-display") == 0) {
-			const char *val = NULL;
-			if (sd_bus_message_enter_container(msg, 'v', "s") >= 0) {
-				if (sd_bus_message_read(msg, "s", &val) >= 0 && val
-						&& strcmp(val, "submenu") == 0)
-					has_submenu = 1;
-				sd_bus_message_exit_container(msg);
-			} else {
-				sd_bus_message_skip(msg, "v");
-			}
-		} else {
-			sd_bus_message_skip(msg, "v");
-		}
+		tray_menu_read_prop(msg, key, &props);
 		sd_bus_message_exit_container(msg);
 	}
 	sd_bus_message_exit_container(msg);
@@ -963,7 +1055,7 @@ tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int ma
 		return r;
 
 	/* Invisible nodes take their whole subtree with them. */
-	if (!visible) {
+	if (!props.visible) {
 		if (sd_bus_message_skip(msg, "av") < 0)
 			return -EINVAL;
 		return 0;
@@ -974,14 +1066,14 @@ tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int ma
 	if (depth > 0 && depth <= max_depth) {
 		entry = ecalloc(1, sizeof(*entry));
 		entry->id = id;
-		entry->enabled = enabled;
-		entry->is_separator = is_separator;
+		entry->enabled = props.enabled;
+		entry->is_separator = props.is_separator;
 		entry->depth = depth - 1;
-		entry->toggle_type = toggle_type;
-		entry->toggle_state = toggle_state;
-		if (label[0])
-			snprintf(entry->label, sizeof(entry->label), "%s", label);
-		wl_list_insert(menu->entries.prev, &entry->link);
+		entry->toggle_type = props.toggle_type;
+		entry->toggle_state = props.toggle_state;
+		if (props.label[0])
+			snprintf(entry->label, sizeof(entry->label), "%s", props.label);
+		wl_list_insert(entries->prev, &entry->link);
 	}
 
 	/* Children: dbusmenu wraps each child node in a variant ("av"). */
@@ -992,7 +1084,7 @@ tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int ma
 		while ((r = sd_bus_message_enter_container(msg, 'v', "(ia{sv}av)")) > 0) {
 			child_count++;
 			if (depth < max_depth) {
-				int cr = tray_menu_parse_node(msg, menu, depth + 1, max_depth);
+				int cr = tray_menu_parse_node(msg, entries, depth + 1, max_depth);
 				if (cr < 0) {
 					sd_bus_message_exit_container(msg);
 					r = cr;
@@ -1013,129 +1105,104 @@ tray_menu_parse_node_body(sd_bus_message *msg, TrayMenu *menu, int depth, int ma
 	}
 
 	if (entry)
-		entry->has_submenu = has_submenu || child_count > 0;
+		entry->has_submenu = props.has_submenu || child_count > 0;
 	return 0;
 }
 
+static void
+tray_menu_place_text(struct wlr_scene_tree *tree, struct wlr_buffer *buffer, int left,
+		int x, int y, int row_h, int max_w)
+{
+	struct wlr_scene_buffer *scene_buf;
+	int w;
+
+	if (!(scene_buf = wlr_scene_buffer_create(tree, NULL)))
+		return;
+
+	wlr_scene_buffer_set_buffer(scene_buf, buffer);
+	wlr_scene_node_set_position(&scene_buf->node, x + left,
+			y + (row_h - buffer->height) / 2);
+
+	/* Clip to the menu's max width — crop the run rather than let it
+	 * overflow the popup panel. */
+	w = buffer->width;
+	if (max_w > 0 && left + w > max_w) {
+		w = max_w - left;
+		if (w <= 0) {
+			wlr_scene_node_destroy(&scene_buf->node);
+			return;
+		}
+		wlr_scene_buffer_set_source_box(scene_buf, &(struct wlr_fbox){
+				.width = w, .height = buffer->height });
+		wlr_scene_buffer_set_dest_size(scene_buf, w, buffer->height);
+	}
+}
+
 void
 tray_menu_draw_text(struct wlr_scene_tree *tree, const char *text, int x, int y, int row_h,
 		int max_w)
 {
-	tll(struct GlyphRun) glyphs = tll_init();
-	const struct fcft_glyph *glyph;
-	struct wlr_scene_buffer *scene_buf;
+	const float *fg = statusbar_fg_override ? statusbar_fg_override : statusbar_fg;
 	struct wlr_buffer *buffer;
-	uint32_t prev_cp = 0;
-	int pen_x = 0;
-	int min_y = INT_MAX, max_y = INT_MIN;
+	int left, top, advance;
 
 	if (!tree || !text || !*text || row_h <= 0)
 		return;
 	if (!statusfont.font)
 		return;
 
-	for (size_t i = 0; text[i]; ) {
-		long kern_x = 0, kern_y = 0;
-		uint32_t cp;
-		unsigned char ch = (unsigned char)text[i];
-
-		/* Decode UTF-8 to Unicode codepoint (same walk as
-		 * status_text_width — never step past NUL on a truncated
-		 * multibyte tail). */
-		if ((ch & 0x80) == 0) {
-			cp = ch;
-			i += 1;
-		} else if ((ch & 0xE0) == 0xC0) {
-			cp = (ch & 0x1F) << 6;
-			i += 1;
-			if (text[i]) {
-				cp |= ((unsigned char)text[i] & 0x3F);
-				i += 1;
-			}
-		} else if ((ch & 0xF0) == 0xE0) {
-			cp = (ch & 0x0F) << 12;
-			i += 1;
-			if (text[i]) {
-				cp |= ((unsigned char)text[i] & 0x3F) << 6;
-				i += 1;
-				if (text[i]) {
-					cp |= ((unsigned char)text[i] & 0x3F);
-					i += 1;
-				}
-			}
-		} else if ((ch & 0xF8) == 0xF0) {
-			cp = (ch & 0x07) << 18;
-			i += 1;
-			if (text[i]) {
-				cp |= ((unsigned char)text[i] & 0x3F) << 12;
-				i += 1;
-				if (text[i]) {
-					cp |= ((unsigned char)text[i] & 0x3F) << 6;
-					i += 1;
-					if (text[i]) {
-						cp |= ((unsigned char)text[i] & 0x3F);
-						i += 1;
-					}
-				}
-			}
-		} else {
-			i += 1;
-			continue;
-		}
-
-		if (prev_cp)
-			fcft_kerning(statusfont.font, prev_cp, cp, &kern_x, &kern_y);
-		pen_x += (int)kern_x;
-
-		glyph = fcft_rasterize_char_utf32(statusfont.font, cp, statusbar_font_subpixel);
-		if (glyph && glyph->pix) {
-			/* Clip to the menu's max width — drop glyphs that would
-			 * overflow the popup panel. */
-			if (max_w > 0 && pen_x + glyph->advance.x > max_w)
-				break;
-			tll_push_back(glyphs, ((struct GlyphRun){
-				.glyph = glyph,
-				.pen_x = pen_x,
-				.codepoint = cp,
-			}));
-			if (-glyph->y < min_y)
-				min_y = -glyph->y;
-			if (-glyph->y + glyph->height > max_y)
-				max_y = -glyph->y + glyph->height;
-			pen_x += glyph->advance.x;
-			if (text[i])
-				pen_x += statusbar_font_spacing;
-		}
-		prev_cp = cp;
-	}
-
-	if (tll_length(glyphs) == 0) {
-		tll_free(glyphs);
-		return;
-	}
+	buffer = statusbar_label_buffer(text, fg, &left, &top, &advance);
+	if (buffer)
+		tray_menu_place_text(tree, buffer, left, x, y, row_h, max_w);
+}
 
-	{
-		int text_height = max_y - min_y;
-		int origin_y = y + (row_h - text_height) / 2 - min_y;
+static void
+tray_menu_entry_text(const TrayMenuEntry *entry, char *text, size_t len)
+{
+	if (entry->toggle_type == 1) {
+		snprintf(text, len, "%s%s%s",
+				entry->toggle_state ? "[x] " : "[ ] ",
+				entry->label[0] ? entry->label : "",
+				entry->has_submenu ? "  >" : "");
+	} else if (entry->toggle_type == 2) {
+		snprintf(text, len, "%s%s%s",
+				entry->toggle_state ? "(o) " : "( ) ",
+				entry->label[0] ? entry->label : "",
+				entry->has_submenu ? "  >" : "");
+	} else {
+		snprintf(text, len, "%s%s",
+				entry->label[0] ? entry->label : " ",
+				entry->has_submenu ? "  >" : "");
+	}
+}
 
-		tll_foreach(glyphs, it) {
-			glyph = it->item.glyph;
-			buffer = statusbar_buffer_from_glyph(glyph);
-			if (!buffer)
-				continue;
+/* Shapes a row once, when its layout or properties arrive; opening and
+ * re-rendering the menu then only places buffers.  The buffer is locked
+ * since the label cache may evict it in the meantime. */
+static void
+tray_menu_entry_prerender(TrayMenuEntry *entry)
+{
+	const float *fg = statusbar_fg_override ? statusbar_fg_override : statusbar_fg;
+	struct wlr_buffer *buffer;
+	char text[512];
+	int left = 0, top = 0, advance = 0;
+
+	if (entry->text_buf)
+		wlr_buffer_unlock(entry->text_buf);
+	entry->text_buf = NULL;
+	entry->text_left = 0;
+	entry->text_w = 0;
+	if (entry->is_separator || !statusfont.font)
+		return;
 
-			scene_buf = wlr_scene_buffer_create(tree, NULL);
-			if (scene_buf) {
-				wlr_scene_buffer_set_buffer(scene_buf, buffer);
-				wlr_scene_node_set_position(&scene_buf->node,
-						x + it->item.pen_x + glyph->x,
-						origin_y - glyph->y);
-			}
-			wlr_buffer_drop(buffer);
-		}
+	entry->text_w = status_text_width(entry->label[0] ? entry->label : " ");
+	tray_menu_entry_text(entry, text, sizeof(text));
+	buffer = statusbar_label_buffer(text, entry->enabled ? fg : tray_menu_fg_disabled,
+			&left, &top, &advance);
+	if (buffer) {
+		entry->text_buf = wlr_buffer_lock(buffer);
+		entry->text_left = left;
 	}
-
-	tll_free(glyphs);
 }
 
 void
@@ -1178,9 +1245,10 @@ tray_menu_render(Monitor *m)
 	total_height = padding * 2;
 
 	wl_list_for_each(entry, &menu->entries, link) {
-		int text_w = entry->is_separator ? 0 : status_text_width(
-				entry->label[0] ? entry->label : " ");
-		int row_width = text_w + 2 * padding + indent_w * entry->depth;
+		int row_width;
+		if (!entry->is_separator && !entry->text_buf)
+			tray_menu_entry_prerender(entry);
+		row_width = entry->text_w + 2 * padding + indent_w * entry->depth;
 		if (entry->toggle_type)
 			row_width += row_h;
 		if (entry->has_submenu)
@@ -1220,7 +1288,6 @@ tray_menu_render(Monitor *m)
 	{
 		int y = padding;
 		wl_list_for_each(entry, &menu->entries, link) {
-			char text[512];
 			int row = entry->is_separator ? line_spacing : row_h;
 			int x = padding + indent_w * entry->depth;
 
@@ -1241,126 +1308,71 @@ tray_menu_render(Monitor *m)
 				wlr_scene_node_set_enabled(&menu->hover_rect->node, 1);
 			}
 
-			text[0] = '\0';
-			if (entry->toggle_type == 1) {
-				snprintf(text, sizeof(text), "%s%s%s",
-						entry->toggle_state ? "[x] " : "[ ] ",
-						entry->label[0] ? entry->label : "",
-						entry->has_submenu ? "  >" : "");
-			} else if (entry->toggle_type == 2) {
-				snprintf(text, sizeof(text), "%s%s%s",
-						entry->toggle_state ? "(o) " : "( ) ",
-						entry->label[0] ? entry->label : "",
-						entry->has_submenu ? "  >" : "");
-			} else {
-				snprintf(text, sizeof(text), "%s%s",
-						entry->label[0] ? entry->label : " ",
-						entry->has_submenu ? "  >" : "");
-			}
-
-			{
-				int text_max_w = menu->width - x - padding;
-				if (entry->enabled) {
-					tray_menu_draw_text(menu->tree, text, x, y, row,
-							text_max_w);
-				} else {
-					const float *prev_fg = statusbar_fg_override;
-					statusbar_fg_override = tray_menu_fg_disabled;
-					tray_menu_draw_text(menu->tree, text, x, y, row,
-							text_max_w);
-					statusbar_fg_override = prev_fg;
-				}
-			}
+			if (entry->text_buf)
+				tray_menu_place_text(menu->tree, entry->text_buf,
+						entry->text_left, x, y, row,
+						menu->width - x - padding);
 			y += row;
 		}
 	}
 }
 
-__attribute__((unused)) int
-tray_menu_open_at(Monitor *m, TrayItem *it, int icon_x)
+static void
+tray_menu_model_free(struct TrayMenuModel *model)
 {
-	sd_bus_message *req = NULL, *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
-	char *props[] = {"label", "enabled", "type", "children-display",
-		"toggle-type", "toggle-state", "visible", NULL};
-	int r;
-	int max_depth = 3; /* limited depth for safety; can be raised if needed */
-	TrayMenu *menu;
-	int desired_x, max_x;
-	const char *sig;
-
-	if (!m || !m->showbar || !m->statusbar.tray_menu.tree || !it || !tray_bus)
-		return 0;
-	if (!m->statusbar.area.width || !m->statusbar.area.height)
-		return 0;
-
-	if (tray_item_get_menu_path(it) != 0 || !it->has_menu)
-		return 0;
-
-	menu = &m->statusbar.tray_menu;
-	tray_menu_hide_all();
-	tray_menu_clear(menu);
-	wl_list_init(&menu->entries);
-	if (!menu->tree) {
-		return 0;
-	}
-	if (max_depth < 1)
-		max_depth = 1;
-
-	/* Let the app refresh its menu before we fetch the layout
-	 * (waybar/libdbusmenu do the same); result is advisory. */
-	sd_bus_call_method(tray_bus, it->service, it->menu,
-			"com.canonical.dbusmenu", "AboutToShow", NULL, NULL, "i", 0);
-
-	r = sd_bus_message_new_method_call(tray_bus, &req, it->service, it->menu,
-			"com.canonical.dbusmenu", "GetLayout");
-	if (r < 0)
-		goto fail;
+	if (!model)
+		return;
+	sd_bus_slot_unref(model->layout_slot);
+	sd_bus_slot_unref(model->layout_updated_slot);
+	sd_bus_slot_unref(model->props_updated_slot);
+	tray_menu_entries_free(&model->entries);
+	free(model);
+}
 
-	/* "as" cannot be appended from a char** via the varargs form —
-	 * that reads the pointer as an element count and fails with
-	 * -EINVAL, which made GetLayout fail for every item. */
-	r = sd_bus_message_append(req, "ii", 0, max_depth);
-	if (r < 0)
-		goto fail;
-	r = sd_bus_message_append_strv(req, props);
-	if (r < 0)
-		goto fail;
+/* Copies the cached layout into m's menu and shows it centred under
+ * icon_x; icon_x < 0 keeps the current position (live update of an open
+ * menu).  The copies share the model's shaped rows. */
+static int
+tray_menu_show(Monitor *m, TrayItem *it, int icon_x)
+{
+	struct TrayMenuModel *model = it->menu_model;
+	TrayMenu *menu = &m->statusbar.tray_menu;
+	TrayMenuEntry *e, *copy;
+	int desired_x, max_x;
 
-	r = sd_bus_call(tray_bus, req, 2 * 1000 * 1000, &err, &reply);
-	if (r < 0)
-		goto fail;
+	desired_x = icon_x >= 0 ? icon_x : menu->x;
+	if (icon_x >= 0)
+		tray_menu_hide_all();
+	else
+		tray_menu_clear(menu);
 
-	sig = sd_bus_message_get_signature(reply, 0);
-	if (!sig || !strstr(sig, "(ia{sv}av)")) {
-		r = -EINVAL;
-		goto fail;
+	/* Rows were shaped for another font (config reload). */
+	if (model->font_h != statusfont.height) {
+		wl_list_for_each(e, &model->entries, link)
+			tray_menu_entry_prerender(e);
+		model->font_h = statusfont.height;
 	}
-
-	{
-		uint32_t revision = 0;
-		if ((r = sd_bus_message_read(reply, "u", &revision)) < 0)
-			goto fail;
-		(void)revision;
-		if ((r = tray_menu_parse_node(reply, menu, 0, max_depth)) < 0)
-			goto fail;
+	wl_list_for_each(e, &model->entries, link) {
+		copy = ecalloc(1, sizeof(*copy));
+		*copy = *e;
+		if (copy->text_buf)
+			wlr_buffer_lock(copy->text_buf);
+		wl_list_insert(menu->entries.prev, &copy->link);
 	}
-
-	sd_bus_message_unref(req);
-	sd_bus_message_unref(reply);
-	sd_bus_error_free(&err);
-
 	if (wl_list_empty(&menu->entries))
-		goto fail;
+		return 0;
 
 	snprintf(menu->service, sizeof(menu->service), "%s", it->service);
-	snprintf(menu->menu_path, sizeof(menu->menu_path), "%s", it->menu);
+	snprintf(menu->menu_path, sizeof(menu->menu_path), "%s", model->path);
 
 	tray_menu_render(m);
-	if (menu->width <= 0 || menu->height <= 0)
-		goto fail;
+	if (menu->width <= 0 || menu->height <= 0) {
+		tray_menu_clear(menu);
+		return 0;
+	}
 
-	desired_x = icon_x - menu->width / 2;
+	if (icon_x >= 0)
+		desired_x -= menu->width / 2;
 	if (desired_x < 0)
 		desired_x = 0;
 	max_x = m->statusbar.area.width - menu->width;
@@ -1375,19 +1387,364 @@ tray_menu_open_at(Monitor *m, TrayItem *it, int icon_x)
 	wlr_scene_node_set_enabled(&menu->tree->node, 1);
 	menu->visible = 1;
 	return 1;
+}
+
+/* Re-shows menus of this item that are open, after the model changed. */
+static void
+tray_menu_refresh_open(TrayItem *it)
+{
+	Monitor *m;
+
+	wl_list_for_each(m, &mons, link) {
+		TrayMenu *menu = &m->statusbar.tray_menu;
+		if (menu->visible && strcmp(menu->service, it->service) == 0
+				&& strcmp(menu->menu_path, it->menu_model->path) == 0)
+			tray_menu_show(m, it, -1);
+	}
+}
+
+static int
+tray_menu_layout_reply(sd_bus_message *reply, void *userdata, sd_bus_error *ret_error)
+{
+	TrayItem *it = userdata;
+	struct TrayMenuModel *model = it->menu_model;
+	const sd_bus_error *err = NULL;
+	struct wl_list entries;
+	TrayMenuEntry *e;
+	Monitor *m, *open_mon = NULL;
+	uint32_t revision = 0;
+	const char *sig;
+	int r = -EIO;
+
+	(void)ret_error;
+	model->layout_slot = sd_bus_slot_unref(model->layout_slot);
+	wl_list_init(&entries);
+	/* The monitor a pending open was for may be gone by now. */
+	wl_list_for_each(m, &mons, link) {
+		if (m == model->open_mon)
+			open_mon = m;
+	}
+	model->open_mon = NULL;
+
+	if (sd_bus_message_is_method_error(reply, NULL)) {
+		err = sd_bus_message_get_error(reply);
+		goto fail;
+	}
+	sig = sd_bus_message_get_signature(reply, 0);
+	if (!sig || !strstr(sig, "(ia{sv}av)")) {
+		r = -EINVAL;
+		goto fail;
+	}
+	if ((r = sd_bus_message_read(reply, "u", &revision)) < 0)
+		goto fail;
+	if ((r = tray_menu_parse_node(reply, &entries, 0, TRAY_MENU_MAX_DEPTH)) < 0)
+		goto fail;
+
+	tray_menu_entries_free(&model->entries);
+	wl_list_insert_list(&model->entries, &entries);
+	wl_list_for_each(e, &model->entries, link)
+		tray_menu_entry_prerender(e);
+	model->font_h = statusfont.height;
+	model->revision = revision;
+	model->valid = 1;
+
+	if (open_mon && open_mon->showbar)
+		tray_menu_show(open_mon, it, model->open_icon_x);
+	else
+		tray_menu_refresh_open(it);
+	/* Changed again while this reply was in flight */
+	if (model->stale)
+		tray_menu_fetch(it);
+	return 0;
 
 fail:
 	wlr_log(WLR_ERROR, "tray: GetLayout failed for %s%s: %s",
-			it->service, it->menu, err.message ? err.message : strerror(-r));
-	if (req)
-		sd_bus_message_unref(req);
-	if (reply)
-		sd_bus_message_unref(reply);
-	sd_bus_error_free(&err);
-	tray_menu_hide_all();
+			it->service, model->path,
+			err && err->message ? err->message : strerror(-r));
+	tray_menu_entries_free(&entries);
+	return 0;
+}
+
+static void
+tray_menu_fetch(TrayItem *it)
+{
+	static char *props[] = {"label", "enabled", "type", "children-display",
+		"toggle-type", "toggle-state", "visible", NULL};
+	struct TrayMenuModel *model = it->menu_model;
+	sd_bus_message *req = NULL;
+	int r;
+
+	if (!tray_bus || !model || model->layout_slot)
+		return;
+
+	r = sd_bus_message_new_method_call(tray_bus, &req, it->service, model->path,
+			"com.canonical.dbusmenu", "GetLayout");
+	/* "as" cannot be appended from a char** via the varargs form —
+	 * that reads the pointer as an element count and fails with
+	 * -EINVAL, which made GetLayout fail for every item. */
+	if (r >= 0)
+		r = sd_bus_message_append(req, "ii", 0, TRAY_MENU_MAX_DEPTH);
+	if (r >= 0)
+		r = sd_bus_message_append_strv(req, props);
+	if (r >= 0)
+		r = sd_bus_call_async(tray_bus, &model->layout_slot, req,
+				tray_menu_layout_reply, it, TRAY_CALL_TIMEOUT_USEC);
+	sd_bus_message_unref(req);
+	if (r < 0) {
+		wlr_log(WLR_ERROR, "tray: GetLayout failed for %s%s: %s",
+				it->service, model->path, strerror(-r));
+		model->open_mon = NULL;
+		return;
+	}
+	model->stale = 0;
+	tray_bus_rearm();
+}
+
+/* Is the subtree under parent part of the cached layout? */
+static int
+tray_menu_model_covers(struct TrayMenuModel *model, int parent)
+{
+	TrayMenuEntry *e;
+
+	if (parent == 0)
+		return 1;
+	wl_list_for_each(e, &model->entries, link)
+		if (e->id == parent)
+			return 1;
+	return 0;
+}
+
+/* LayoutUpdated (u revision, i parent).  A revision the cache already
+ * holds (our GetLayout raced the signal, or the app re-announces) is
+ * not refetched.  Revision 0 is what apps that do not count send, so it
+ * always refetches. */
+static int
+tray_menu_layout_updated(sd_bus_message *msg, void *userdata, sd_bus_error *ret_error)
+{
+	TrayItem *it = userdata;
+	struct TrayMenuModel *model = it->menu_model;
+	uint32_t revision = 0;
+	int32_t parent = 0;
+
+	(void)ret_error;
+	if (!model)
+		return 0;
+	if (sd_bus_message_read(msg, "ui", &revision, &parent) >= 0
+			&& model->valid && !model->stale && revision
+			&& revision <= model->revision
+			&& tray_menu_model_covers(model, parent))
+		return 0;
+	it->menu_model->stale = 1;
+	/* Only menus that have been looked at are kept current eagerly;
+	 * the rest refetch on the next hover. */
+	if (it->menu_model->valid)
+		tray_menu_fetch(it);
+	return 0;
+}
+
+/* Applies updated properties to a cached row.  Returns 1 when the
+ * change alters the menu's structure and needs a fresh layout. */
+static int
+tray_menu_entry_apply(TrayMenuEntry *e, const TrayMenuProps *p)
+{
+	if (!e)
+		return p->visible;
+	if (!p->visible || p->is_separator != e->is_separator
+			|| (p->has_submenu && !e->has_submenu))
+		return 1;
+	if (p->enabled == e->enabled && p->toggle_type == e->toggle_type
+			&& p->toggle_state == e->toggle_state
+			&& strcmp(p->label, e->label) == 0)
+		return 0;
+	e->enabled = p->enabled;
+	e->toggle_type = p->toggle_type;
+	e->toggle_state = p->toggle_state;
+	snprintf(e->label, sizeof(e->label), "%s", p->label);
+	tray_menu_entry_prerender(e);
+	return 0;
+}
+
+static TrayMenuEntry *
+tray_menu_model_entry(struct TrayMenuModel *model, int id, TrayMenuProps *p)
+{
+	TrayMenuEntry *e;
+
+	wl_list_for_each(e, &model->entries, link) {
+		if (e->id != id)
+			continue;
+		*p = tray_menu_props_default;
+		p->enabled = e->enabled;
+		p->is_separator = e->is_separator;
+		p->has_submenu = e->has_submenu;
+		p->toggle_type = e->toggle_type;
+		p->toggle_state = e->toggle_state;
+		snprintf(p->label, sizeof(p->label), "%s", e->label);
+		return e;
+	}
+	/* Not in the cached layout: hidden, or deeper than we fetch */
+	*p = tray_menu_props_default;
+	p->visible = 0;
+	return NULL;
+}
+
+/* ItemsPropertiesUpdated (a(ia{sv}) updated, a(ias) removed): label,
+ * enabled and toggle changes are patched into the cached rows; anything
+ * that moves rows around falls back to a fresh GetLayout. */
+static int
+tray_menu_props_updated(sd_bus_message *msg, void *userdata, sd_bus_error *ret_error)
+{
+	TrayItem *it = userdata;
+	struct TrayMenuModel *model = it->menu_model;
+	TrayMenuEntry *e;
+	TrayMenuProps p;
+	const char *key;
+	int id, relayout = 0;
+
+	(void)ret_error;
+	if (!model || !model->valid || model->stale)
+		return 0;
+
+	if (sd_bus_message_enter_container(msg, 'a', "(ia{sv})") < 0)
+		return 0;
+	while (!relayout && sd_bus_message_enter_container(msg, 'r', "ia{sv}") > 0) {
+		id = 0;
+		if (sd_bus_message_read(msg, "i", &id) < 0
+				|| sd_bus_message_enter_container(msg, 'a', "{sv}") < 0) {
+			relayout = 1;
+			break;
+		}
+		e = tray_menu_model_entry(model, id, &p);
+		while (sd_bus_message_enter_container(msg, 'e', "sv") > 0) {
+			key = NULL;
+			if (sd_bus_message_read(msg, "s", &key) >= 0)
+				tray_menu_read_prop(msg, key, &p);
+			sd_bus_message_exit_container(msg);
+		}
+		sd_bus_message_exit_container(msg);
+		sd_bus_message_exit_container(msg);
+		relayout = tray_menu_entry_apply(e, &p);
+	}
+	sd_bus_message_exit_container(msg);
+
+	if (!relayout && sd_bus_message_enter_container(msg, 'a', "(ias)") > 0) {
+		while (!relayout && sd_bus_message_enter_container(msg, 'r', "ias") > 0) {
+			id = 0;
+			if (sd_bus_message_read(msg, "i", &id) < 0
+					|| sd_bus_message_enter_container(msg, 'a', "s") < 0) {
+				relayout = 1;
+				break;
+			}
+			e = tray_menu_model_entry(model, id, &p);
+			while (sd_bus_message_read_basic(msg, 's', &key) > 0)
+				tray_menu_reset_prop(key, &p);
+			sd_bus_message_exit_container(msg);
+			sd_bus_message_exit_container(msg);
+			relayout = tray_menu_entry_apply(e, &p);
+		}
+		sd_bus_message_exit_container(msg);
+	}
+
+	if (relayout) {
+		model->stale = 1;
+		tray_menu_fetch(it);
+	} else {
+		tray_menu_refresh_open(it);
+	}
 	return 0;
 }
 
+/* Sets up the layout cache for the item's Menu object (again, if the
+ * path changed) and subscribes to its change signals. */
+static void
+tray_item_menu_model(TrayItem *it)
+{
+	struct TrayMenuModel *model = it->menu_model;
+	char match[512];
+
+	if (!tray_bus || (model && strcmp(model->path, it->menu) == 0))
+		return;
+
+	tray_menu_model_free(model);
+	it->menu_model = model = ecalloc(1, sizeof(*model));
+	snprintf(model->path, sizeof(model->path), "%s", it->menu);
+	wl_list_init(&model->entries);
+	model->stale = 1;
+
+	snprintf(match, sizeof(match),
+			"type='signal',sender='%s',path='%s',"
+			"interface='com.canonical.dbusmenu',member='LayoutUpdated'",
+			it->service, model->path);
+	if (sd_bus_add_match_async(tray_bus, &model->layout_updated_slot, match,
+			tray_menu_layout_updated, NULL, it) < 0)
+		wlr_log(WLR_ERROR, "tray: failed to watch menu layout of %s", it->service);
+	snprintf(match, sizeof(match),
+			"type='signal',sender='%s',path='%s',"
+			"interface='com.canonical.dbusmenu',member='ItemsPropertiesUpdated'",
+			it->service, model->path);
+	if (sd_bus_add_match_async(tray_bus, &model->props_updated_slot, match,
+			tray_menu_props_updated, NULL, it) < 0)
+		wlr_log(WLR_ERROR, "tray: failed to watch menu items of %s", it->service);
+	tray_bus_rearm();
+}
+
+__attribute__((unused)) int
+tray_menu_open_at(Monitor *m, TrayItem *it, int icon_x)
+{
+	struct TrayMenuModel *model;
+
+	if (!m || !m->showbar || !m->statusbar.tray_menu.tree || !it || !tray_bus)
+		return 0;
+	if (!m->statusbar.area.width || !m->statusbar.area.height)
+		return 0;
+	if (!it->has_menu || !(model = it->menu_model))
+		return 0;
+
+	/* Let the app refresh its menu (waybar/libdbusmenu do the same).
+	 * The result is advisory: an app that rebuilds the menu emits
+	 * LayoutUpdated and the open menu follows the refetch. */
+	sd_bus_call_method_async(tray_bus, NULL, it->service, model->path,
+			"com.canonical.dbusmenu", "AboutToShow", NULL, NULL, "i", 0);
+
+	if (model->valid) {
+		if (model->stale)
+			tray_menu_fetch(it);
+		return tray_menu_show(m, it, icon_x);
+	}
+
+	/* Clicked before a hover prefetch landed: show on arrival. */
+	tray_menu_hide_all();
+	model->open_mon = m;
+	model->open_icon_x = icon_x;
+	tray_menu_fetch(it);
+	return model->layout_slot != NULL;
+}
+
+/* Hovering a tray icon fetches its menu layout ahead of the click. */
+void
+tray_menu_prefetch_at(Monitor *m, double cx, double cy)
+{
+	StatusModule *tray;
+	TrayItem *it;
+	int lx, ly;
+
+	if (!m || !m->showbar || !tray_bus)
+		return;
+	tray = &m->statusbar.traylabel;
+	lx = (int)floor(cx) - m->statusbar.area.x - tray->x;
+	ly = (int)floor(cy) - m->statusbar.area.y;
+	if (tray->width <= 0 || lx < 0 || lx >= tray->width
+			|| ly < 0 || ly >= m->statusbar.area.height)
+		return;
+
+	wl_list_for_each(it, &tray_items, link) {
+		if (it->w <= 0 || lx < it->x || lx >= it->x + it->w)
+			continue;
+		if (it->menu_model && (!it->menu_model->valid || it->menu_model->stale))
+			tray_menu_fetch(it);
+		return;
+	}
+}
+
 /* Hover highlight tracking (waybar-style row highlight under cursor). */
 void
 tray_menu_update_hover(Monitor *m, double cx, double cy)
@@ -1441,11 +1798,30 @@ tray_menu_entry_at(Monitor *m, int lx, int ly)
 	return NULL;
 }
 
+static int
+tray_menu_event_reply(sd_bus_message *reply, void *userdata, sd_bus_error *ret_error)
+{
+	const sd_bus_error *err;
+	const char *sender;
+
+	(void)userdata;
+	(void)ret_error;
+	if (sd_bus_message_is_method_error(reply, NULL)) {
+		err = sd_bus_message_get_error(reply);
+		sender = sd_bus_message_get_sender(reply);
+		wlr_log(WLR_ERROR, "tray: menu Event failed for %s: %s",
+				sender ? sender : "?",
+				err && err->message ? err->message : "error");
+	}
+	return 0;
+}
+
+/* Fire-and-forget like the rest of the tray's calls: the app acts on the
+ * click on its own time, and any menu change comes back as a signal. */
 int
 tray_menu_send_event(TrayMenu *menu, TrayMenuEntry *entry, uint32_t time_msec)
 {
-	sd_bus_message *msg = NULL, *reply = NULL;
-	sd_bus_error err = SD_BUS_ERROR_NULL;
+	sd_bus_message *msg = NULL;
 	int r;
 
 	if (!tray_bus || !menu || !entry || !menu->service[0] || !menu->menu_path[0])
@@ -1474,33 +1850,20 @@ tray_menu_send_event(TrayMenu *menu, TrayMenuEntry *entry, uint32_t time_msec)
 	if (r < 0)
 		goto out;
 
-	r = sd_bus_call(tray_bus, msg, 2 * 1000 * 1000, &err, &reply);
+	r = sd_bus_call_async(tray_bus, NULL, msg, tray_menu_event_reply, NULL,
+			TRAY_CALL_TIMEOUT_USEC);
+	tray_bus_rearm();
 
 out:
 	if (msg)
 		sd_bus_message_unref(msg);
-	if (reply)
-		sd_bus_message_unref(reply);
-	sd_bus_error_free(&err);
 	return r < 0 ? r : 0;
 }
 
-/* SNI Status: "Passive" means the item asks to be hidden ("Active" and
- * "NeedsAttention" are both shown).  Items that don't implement the
- * property are treated as active. */
-static void
-tray_item_query_status(TrayItem *it)
-{
-	char status[32] = {0};
-
-	it->passive = 0;
-	if (tray_get_string_property(it, "Status", status, sizeof(status)) == 0)
-		it->passive = strcmp(status, "Passive") == 0;
-}
-
 void
 tray_add_item(const char *service, const char *path, int emit_signals)
 {
+	static uint64_t seq;
 	const char *base;
 	TrayItem *it;
 
@@ -1514,37 +1877,21 @@ tray_add_item(const char *service, const char *path, int emit_signals)
 	base = strrchr(service, '.');
 	base = base ? base + 1 : service;
 	snprintf(it->label, sizeof(it->label), "%s", base);
-	it->icon_tried = 0;
+	it->seq = ++seq;
+	/* Stays invisible (no icon) until the probe's GetAll comes back. */
+	it->icon_tried = 1;
 	it->icon_failed = 0;
-	tray_item_query_status(it);
-	if (tray_get_string_property(it, "Id", it->sni_id, sizeof(it->sni_id)) != 0)
-		it->sni_id[0] = '\0';
-
-	/* One app, one icon: Steam registers the same indicator from two bus
-	 * connections (bootstrap and client both export
-	 * /org/ayatana/NotificationItem/steam), giving two identical tray
-	 * icons.  An existing item with the same SNI Id — or the same
-	 * app-specific object path when Id is unavailable — is the same
-	 * application re-registering: the newest registration wins. */
-	{
-		TrayItem *other, *tmp;
-		wl_list_for_each_safe(other, tmp, &tray_items, link) {
-			int same_id = it->sni_id[0] && other->sni_id[0] &&
-				strcmp(it->sni_id, other->sni_id) == 0;
-			int same_path = strcmp(it->path, other->path) == 0 &&
-				strcmp(it->path, "/StatusNotifierItem") != 0;
-			if (same_id || same_path) {
-				wlr_log(WLR_INFO, "tray: dropping duplicate %s%s (replaced by %s)",
-						other->service, other->path, service);
-				tray_remove_item(other->service);
-			}
-		}
-	}
 	wl_list_insert(&tray_items, &it->link);
-	wlr_log(WLR_INFO, "tray: registered %s%s%s", service, path,
-			it->passive ? " (passive)" : "");
+	wlr_log(WLR_INFO, "tray: registered %s%s", service, path);
 
-	tray_update_icons_text();
+	if (tray_bus) {
+		it->probe = ecalloc(1, sizeof(*it->probe));
+		tray_item_probe_push(it->probe, path, 1);
+		tray_item_probe_push(it->probe, "/StatusNotifierItem", 1);
+		tray_item_probe_push(it->probe, "/org/ayatana/NotificationItem", 1);
+		tray_item_probe_push(it->probe, "/", 6);
+		tray_item_probe_next(it);
+	}
 
 	if (!emit_signals || !tray_bus)
 		return;
@@ -1586,10 +1933,6 @@ tray_method_register_item(sd_bus_message *m, void *userdata, sd_bus_error *ret_e
 		snprintf(path, sizeof(path), "/StatusNotifierItem");
 	}
 
-	if (tray_find_item_path(service, path, sizeof(path)) == 0) {
-		/* path updated by helper */
-	}
-
 	tray_add_item(service, path, 1);
 	tray_emit_host_registered();
 	return sd_bus_reply_method_return(m, "");
@@ -1624,12 +1967,8 @@ tray_scan_existing_items(void)
 	while (sd_bus_message_read_basic(reply, 's', &name) > 0) {
 		if (!name)
 			continue;
-		if (strstr(name, "StatusNotifierItem") || strstr(name, "NotificationItem")) {
-			char path[128];
-			if (tray_find_item_path(name, path, sizeof(path)) != 0)
-				snprintf(path, sizeof(path), "%s", "/StatusNotifierItem");
-			tray_add_item(name, path, 1);
-		}
+		if (strstr(name, "StatusNotifierItem") || strstr(name, "NotificationItem"))
+			tray_add_item(name, "/StatusNotifierItem", 1);
 	}
 
 	sd_bus_message_exit_container(reply);
@@ -1687,10 +2026,7 @@ tray_name_owner_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_err
 		return 0;
 	if (name && new_owner && *new_owner &&
 			(strstr(name, "StatusNotifierItem") || strstr(name, "NotificationItem"))) {
-		char path[128];
-		if (tray_find_item_path(name, path, sizeof(path)) != 0)
-			snprintf(path, sizeof(path), "%s", "/StatusNotifierItem");
-		tray_add_item(name, path, 1);
+		tray_add_item(name, "/StatusNotifierItem", 1);
 		return 0;
 	}
 	if (name && old_owner && *old_owner && (!new_owner || !*new_owner))
@@ -1699,40 +2035,31 @@ tray_name_owner_changed(sd_bus_message *m, void *userdata, sd_bus_error *ret_err
 }
 
 /* An item published a new icon (or its icon became available after the
- * initial registration race).  Drop the cached buffer, clear the failure
- * latch so tray_item_load_icon retries, and repaint the tray. */
+ * initial registration race).  Clear the failure latch and refetch; the
+ * old buffer stays up until the new one arrives. */
 static int
 tray_item_new_icon(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
 {
 	const char *sender = sd_bus_message_get_sender(m);
 	TrayItem *it;
-	int matched = 0;
 
 	(void)userdata;
 	(void)ret_error;
 
 	wl_list_for_each(it, &tray_items, link) {
 		if (sender && it->service[0] && strcmp(it->service, sender) == 0) {
-			if (it->icon_buf) {
-				wlr_buffer_drop(it->icon_buf);
-				it->icon_buf = NULL;
-			}
-			it->icon_tried = 0;
+			it->icon_tried = 1;
 			it->icon_failed = 0;
-			it->icon_w = it->icon_h = 0;
-			matched = 1;
+			tray_item_fetch(it, 1);
 		}
 	}
-
-	if (matched)
-		tray_update_icons_text();
 	return 0;
 }
 
 /* An item changed its SNI Status (Active/Passive/NeedsAttention).  The
  * signal carries the new value; sender is the unique bus name, so items
- * registered under a well-known name won't strcmp-match — re-query those
- * via the Status property instead. */
+ * registered under a well-known name won't strcmp-match — refetch those;
+ * the reply updates Status and repaints. */
 static int
 tray_item_new_status(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
 {
@@ -1753,18 +2080,15 @@ tray_item_new_status(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
 			if (status)
 				it->passive = strcmp(status, "Passive") == 0;
 			else
-				tray_item_query_status(it);
+				tray_item_fetch(it, 0);
 			changed |= it->passive != passive;
 			matched = 1;
 		}
 	}
 
 	if (!matched) {
-		wl_list_for_each(it, &tray_items, link) {
-			int passive = it->passive;
-			tray_item_query_status(it);
-			changed |= it->passive != passive;
-		}
+		wl_list_for_each(it, &tray_items, link)
+			tray_item_fetch(it, 0);
 	}
 
 	if (changed)
@@ -1777,8 +2101,6 @@ tray_bus_event(int fd, uint32_t mask, void *data)
 {
 	sd_bus *bus = data;
 	int r;
-	int events;
-	uint32_t newmask;
 
 	(void)fd;
 	if (!bus)
@@ -1800,15 +2122,7 @@ tray_bus_event(int fd, uint32_t mask, void *data)
 	while ((r = sd_bus_process(bus, NULL)) > 0)
 		;
 
-	events = sd_bus_get_events(bus);
-	newmask = 0;
-	if (events & SD_BUS_EVENT_READABLE)
-		newmask |= WL_EVENT_READABLE;
-	if (events & SD_BUS_EVENT_WRITABLE)
-		newmask |= WL_EVENT_WRITABLE;
-	if (tray_event)
-		wl_event_source_fd_update(tray_event, newmask ? newmask : WL_EVENT_READABLE);
-
+	tray_bus_rearm();
 	return 0;
 }
 
@@ -1840,7 +2154,7 @@ tray_init(void)
 		return;
 	}
 
-	/* Keep icon/property queries from stalling the compositor for too long */
+	/* Bounds the calls still made synchronously (Activate, menus) */
 	sd_bus_set_method_call_timeout(tray_bus, 2 * 1000 * 1000); /* 2s */
 
 	r = sd_bus_request_name(tray_bus, "org.kde.StatusNotifierWatcher", name_flags);
@@ -1932,6 +2246,9 @@ tray_remove_item(const char *service)
 	wl_list_for_each_safe(it, tmp, &tray_items, link) {
 		if (strcmp(it->service, service) == 0) {
 			wl_list_remove(&it->link);
+			sd_bus_slot_unref(it->slot);
+			free(it->probe);
+			tray_menu_model_free(it->menu_model);
 			if (it->icon_buf)
 				wlr_buffer_drop(it->icon_buf);
 			free(it);
@@ -0,0 +1,653 @@
+/*
+ * tray_pixmap.c — SNI IconPixmap decoding off the compositor thread.
+ *
+ * IconPixmap data is big-endian ARGB (some apps send RGBA) and usually
+ * far larger than the bar: Discord and Steam send 256px pixmaps and
+ * resend them with every NewIcon.  Converting to premultiplied native
+ * ARGB8888 and scaling down used to run per pixel on the compositor
+ * thread for each of those signals.
+ *
+ * Decoding now happens on a worker.  The reply message is referenced
+ * rather than copied, so queueing costs the compositor nothing but a
+ * list insert.  The worker hashes the chosen pixmap first and drops the
+ * job when it matches what the item already shows, so a NewIcon that
+ * resends the same image does no conversion at all.  Conversion and the
+ * k×k box reduction that takes large pixmaps close to bar height use
+ * SSE2, or AVX2 when the CPU has it, with a scalar fallback elsewhere.
+ * The scalar kernels are always built: they are the reference that
+ * tests/tray_pixmap_test holds the vector ones to, bit for bit.
+ * pixman's bilinear filter only does the last, less than 2×, step.
+ */
+#include "nixlytile.h"
+
+#include <sys/eventfd.h>
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#include <immintrin.h>
+#define TRAY_PIXMAP_X86 1
+#endif
+
+typedef struct PixmapJob {
+	struct PixmapJob *next;
+	uint64_t item_seq;         /* TrayItem.seq; the item may be gone */
+	uint64_t gen;              /* matches TrayItem.pixmap_gen while current */
+	sd_bus_message *msg;       /* keeps data alive; ref'd on the main thread */
+	const void *data;
+	int src_w, src_h;
+	int target_h;
+	int force_rgba;
+	uint64_t prev_hash;        /* hash of the pixmap the item shows now */
+	int cancelled;             /* superseded by a newer job for the item */
+	/* results */
+	uint64_t hash;
+	int unchanged;
+	uint32_t *pixels;
+	int w, h;
+} PixmapJob;
+
+static pthread_t tp_thread;
+static int tp_thread_running;
+static int tp_thread_stop;
+static pthread_mutex_t tp_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tp_cond = PTHREAD_COND_INITIALIZER;
+static PixmapJob *tp_todo, *tp_done;
+static int tp_wake_fd = -1;
+static struct wl_event_source *tp_wake_src;
+static uint64_t tp_gen;
+
+static pthread_once_t tp_cpu_once = PTHREAD_ONCE_INIT;
+static int tp_best = TRAY_PIXMAP_SCALAR; /* best kernels this CPU runs */
+static int tp_isa = -1;                  /* kernels in use; -1 = tp_best */
+
+static void
+tp_cpu_init(void)
+{
+#ifdef TRAY_PIXMAP_X86
+	__builtin_cpu_init();
+	tp_best = __builtin_cpu_supports("avx2") ? TRAY_PIXMAP_AVX2 : TRAY_PIXMAP_SSE2;
+#endif
+	if (tp_isa < 0)
+		tp_isa = tp_best;
+}
+
+/* Selects the kernels tray_pixmap_convert() and the box reduction run:
+ * TRAY_PIXMAP_AUTO for the best the CPU has, or a specific one, capped
+ * at what the CPU supports.  Returns the one now in use. */
+int
+tray_pixmap_set_isa(int isa)
+{
+	pthread_once(&tp_cpu_once, tp_cpu_init);
+	tp_isa = isa < 0 || isa > tp_best ? tp_best : isa;
+	return tp_isa;
+}
+
+/* Premultiplying is round(c * a / 255) per channel, computed exactly as
+ * ((t + (t >> 8)) >> 8) with t = c * a + 128 so every path below
+ * produces identical pixels. */
+static uint32_t
+tp_convert_scalar(uint32_t *dst, const uint32_t *src, size_t n, int rgba)
+{
+	uint32_t alpha = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		const uint8_t *p8 = (const uint8_t *)&src[i];
+		uint32_t a, r, g, b, t;
+
+		if (rgba) {
+			r = p8[0];
+			g = p8[1];
+			b = p8[2];
+			a = p8[3];
+		} else {
+			a = p8[0];
+			r = p8[1];
+			g = p8[2];
+			b = p8[3];
+		}
+		t = r * a + 128;
+		r = (t + (t >> 8)) >> 8;
+		t = g * a + 128;
+		g = (t + (t >> 8)) >> 8;
+		t = b * a + 128;
+		b = (t + (t >> 8)) >> 8;
+
+		dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+		alpha |= a;
+	}
+	return alpha;
+}
+
+#ifdef TRAY_PIXMAP_X86
+/* Pixels widened to 16-bit lanes, one pixel per 64-bit half, in source
+ * byte order.  Reorder to B,G,R,A (native ARGB8888 in memory) and
+ * premultiply; the alpha lane is multiplied by 255, i.e. kept. */
+#define TP_SWIZZLE_ARGB _MM_SHUFFLE(0, 1, 2, 3)
+#define TP_SWIZZLE_RGBA _MM_SHUFFLE(3, 0, 1, 2)
+#define TP_ALPHA        _MM_SHUFFLE(3, 3, 3, 3)
+
+static inline __m128i
+tp_premul_sse2(__m128i x, __m128i rgb_mask, __m128i alpha_lane)
+{
+	__m128i a, t;
+
+	a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, TP_ALPHA), TP_ALPHA);
+	a = _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_lane);
+	t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static uint32_t
+tp_convert_sse2(uint32_t *dst, const uint32_t *src, size_t n, int rgba)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_lane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	__m128i acc = zero;
+	uint32_t alpha[4];
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+		if (rgba) {
+			lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, TP_SWIZZLE_RGBA), TP_SWIZZLE_RGBA);
+			hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, TP_SWIZZLE_RGBA), TP_SWIZZLE_RGBA);
+		} else {
+			lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, TP_SWIZZLE_ARGB), TP_SWIZZLE_ARGB);
+			hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, TP_SWIZZLE_ARGB), TP_SWIZZLE_ARGB);
+		}
+		v = _mm_packus_epi16(tp_premul_sse2(lo, rgb_mask, alpha_lane),
+				tp_premul_sse2(hi, rgb_mask, alpha_lane));
+		_mm_storeu_si128((__m128i *)(dst + i), v);
+		acc = _mm_or_si128(acc, v);
+	}
+	_mm_storeu_si128((__m128i *)alpha, acc);
+	return ((alpha[0] | alpha[1] | alpha[2] | alpha[3]) >> 24)
+		| tp_convert_scalar(dst + i, src + i, n - i, rgba);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+tp_premul_avx2(__m256i x, __m256i rgb_mask, __m256i alpha_lane)
+{
+	__m256i a, t;
+
+	a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, TP_ALPHA), TP_ALPHA);
+	a = _mm256_or_si256(_mm256_and_si256(a, rgb_mask), alpha_lane);
+	t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+/* Same as the SSE2 path, eight pixels at a time: unpack, shuffle and
+ * pack all work within 128-bit lanes, so pixel order is preserved. */
+__attribute__((target("avx2"))) static uint32_t
+tp_convert_avx2(uint32_t *dst, const uint32_t *src, size_t n, int rgba)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+			0, -1, -1, -1, 0, -1, -1, -1);
+	const __m256i alpha_lane = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+			255, 0, 0, 0, 255, 0, 0, 0);
+	__m256i acc = zero;
+	uint32_t alpha[8], any = 0;
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i lo = _mm256_unpacklo_epi8(v, zero);
+		__m256i hi = _mm256_unpackhi_epi8(v, zero);
+
+		if (rgba) {
+			lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, TP_SWIZZLE_RGBA), TP_SWIZZLE_RGBA);
+			hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, TP_SWIZZLE_RGBA), TP_SWIZZLE_RGBA);
+		} else {
+			lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, TP_SWIZZLE_ARGB), TP_SWIZZLE_ARGB);
+			hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, TP_SWIZZLE_ARGB), TP_SWIZZLE_ARGB);
+		}
+		v = _mm256_packus_epi16(tp_premul_avx2(lo, rgb_mask, alpha_lane),
+				tp_premul_avx2(hi, rgb_mask, alpha_lane));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+		acc = _mm256_or_si256(acc, v);
+	}
+	_mm256_storeu_si256((__m256i *)alpha, acc);
+	for (int k = 0; k < 8; k++)
+		any |= alpha[k];
+	return (any >> 24) | tp_convert_sse2(dst + i, src + i, n - i, rgba);
+}
+#endif
+
+/* Converts n IconPixmap pixels (big-endian ARGB, or RGBA bytes) to
+ * premultiplied native ARGB8888.  dst may equal src.  Returns nonzero
+ * if any pixel has alpha, which callers use to spot RGBA senders. */
+uint32_t
+tray_pixmap_convert(uint32_t *dst, const uint32_t *src, size_t n, int rgba)
+{
+	pthread_once(&tp_cpu_once, tp_cpu_init);
+	switch (tp_isa) {
+#ifdef TRAY_PIXMAP_X86
+	case TRAY_PIXMAP_AVX2:
+		return tp_convert_avx2(dst, src, n, rgba);
+	case TRAY_PIXMAP_SSE2:
+		return tp_convert_sse2(dst, src, n, rgba);
+#endif
+	default:
+		return tp_convert_scalar(dst, src, n, rgba);
+	}
+}
+
+static uint32_t
+tp_box_pack(const uint32_t sum[4], uint32_t count)
+{
+	uint32_t half = count / 2;
+
+	return ((sum[3] + half) / count) << 24 | ((sum[2] + half) / count) << 16
+		| ((sum[1] + half) / count) << 8 | ((sum[0] + half) / count);
+}
+
+/* One output row of a k×k box reduction; src is the first source row
+ * of the band, kh its height.  The last column and row average the
+ * partial block that is left. */
+static void
+tp_box_row_scalar(const uint32_t *src, int w, int stride, int k, int kh,
+		uint32_t *dst, int ow)
+{
+	for (int x = 0; x < ow; x++) {
+		int kw = MIN(k, w - x * k);
+		uint32_t sum[4] = {0};
+
+		for (int y = 0; y < kh; y++) {
+			const uint32_t *p = src + (size_t)y * stride + (size_t)x * k;
+			for (int i = 0; i < kw; i++) {
+				sum[0] += p[i] & 0xff;
+				sum[1] += (p[i] >> 8) & 0xff;
+				sum[2] += (p[i] >> 16) & 0xff;
+				sum[3] += p[i] >> 24;
+			}
+		}
+		dst[x] = tp_box_pack(sum, (uint32_t)(kw * kh));
+	}
+}
+
+#ifdef TRAY_PIXMAP_X86
+/* As tp_box_row_scalar, with the channel sums in 32-bit lanes. */
+static void
+tp_box_row_sse2(const uint32_t *src, int w, int stride, int k, int kh,
+		uint32_t *dst, int ow)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int x = 0; x < ow; x++) {
+		int kw = MIN(k, w - x * k);
+		__m128i acc = zero;
+		uint32_t sum[4];
+
+		for (int y = 0; y < kh; y++) {
+			const uint32_t *p = src + (size_t)y * stride + (size_t)x * k;
+			int i = 0;
+			for (; i + 2 <= kw; i += 2) {
+				__m128i v = _mm_unpacklo_epi8(
+						_mm_loadl_epi64((const __m128i *)(p + i)), zero);
+				acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+				acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+			}
+			if (i < kw) {
+				__m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p[i]), zero);
+				acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+			}
+		}
+		_mm_storeu_si128((__m128i *)sum, acc);
+		dst[x] = tp_box_pack(sum, (uint32_t)(kw * kh));
+	}
+}
+
+__attribute__((target("avx2"))) static void
+tp_box_row_avx2(const uint32_t *src, int w, int stride, int k, int kh,
+		uint32_t *dst, int ow)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for (int x = 0; x < ow; x++) {
+		int kw = MIN(k, w - x * k);
+		__m256i acc = _mm256_setzero_si256();
+		__m128i tail = zero;
+		uint32_t sum[4];
+
+		for (int y = 0; y < kh; y++) {
+			const uint32_t *p = src + (size_t)y * stride + (size_t)x * k;
+			int i = 0;
+			for (; i + 4 <= kw; i += 4) {
+				__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+				acc = _mm256_add_epi32(acc, _mm256_cvtepu8_epi32(v));
+				acc = _mm256_add_epi32(acc,
+						_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(v, v)));
+			}
+			for (; i < kw; i++) {
+				__m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p[i]), zero);
+				tail = _mm_add_epi32(tail, _mm_unpacklo_epi16(v, zero));
+			}
+		}
+		tail = _mm_add_epi32(tail, _mm_add_epi32(_mm256_castsi256_si128(acc),
+				_mm256_extracti128_si256(acc, 1)));
+		_mm_storeu_si128((__m128i *)sum, tail);
+		dst[x] = tp_box_pack(sum, (uint32_t)(kw * kh));
+	}
+}
+#endif
+
+/* Averages k×k blocks of premultiplied pixels (box filter); the result
+ * is ceil(w / k) × ceil(h / k), malloc'd. */
+uint32_t *
+tray_pixmap_box_reduce(const uint32_t *src, int w, int h, int k,
+		int *out_w, int *out_h)
+{
+	int ow = (w + k - 1) / k, oh = (h + k - 1) / k;
+	uint32_t *dst = malloc((size_t)ow * (size_t)oh * sizeof(*dst));
+
+	if (!dst)
+		return NULL;
+	pthread_once(&tp_cpu_once, tp_cpu_init);
+	for (int y = 0; y < oh; y++) {
+		const uint32_t *band = src + (size_t)y * k * w;
+		int kh = MIN(k, h - y * k);
+
+		switch (tp_isa) {
+#ifdef TRAY_PIXMAP_X86
+		case TRAY_PIXMAP_AVX2:
+			tp_box_row_avx2(band, w, w, k, kh, dst + (size_t)y * ow, ow);
+			break;
+		case TRAY_PIXMAP_SSE2:
+			tp_box_row_sse2(band, w, w, k, kh, dst + (size_t)y * ow, ow);
+			break;
+#endif
+		default:
+			tp_box_row_scalar(band, w, w, k, kh, dst + (size_t)y * ow, ow);
+		}
+	}
+	*out_w = ow;
+	*out_h = oh;
+	return dst;
+}
+
+static uint32_t *
+tp_scale(const uint32_t *src, int w, int h, int tw, int th)
+{
+	pixman_image_t *s, *d;
+	pixman_transform_t transform;
+	uint32_t *dst = calloc((size_t)tw * (size_t)th, sizeof(*dst));
+
+	if (!dst)
+		return NULL;
+	s = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, w, h,
+			(uint32_t *)src, w * 4);
+	d = pixman_image_create_bits_no_clear(PIXMAN_a8r8g8b8, tw, th, dst, tw * 4);
+	if (!s || !d) {
+		if (s)
+			pixman_image_unref(s);
+		if (d)
+			pixman_image_unref(d);
+		free(dst);
+		return NULL;
+	}
+
+	pixman_transform_init_identity(&transform);
+	pixman_transform_scale(&transform, NULL,
+			pixman_double_to_fixed((double)w / (double)tw),
+			pixman_double_to_fixed((double)h / (double)th));
+	pixman_image_set_transform(s, &transform);
+	pixman_image_set_filter(s, PIXMAN_FILTER_BILINEAR, NULL, 0);
+	pixman_image_composite32(PIXMAN_OP_SRC, s, NULL, d,
+			0, 0, 0, 0, 0, 0, tw, th);
+	pixman_image_unref(s);
+	pixman_image_unref(d);
+	return dst;
+}
+
+/* FNV-1a over 64-bit words (with a fold so high bits reach the low
+ * ones); identical pixmaps hash identically, which is all dedup needs. */
+static uint64_t
+tp_hash(const PixmapJob *job)
+{
+	const unsigned char *p = job->data;
+	size_t len = (size_t)job->src_w * (size_t)job->src_h * 4;
+	int params[4] = { job->src_w, job->src_h, job->target_h, job->force_rgba };
+	uint64_t h = 0xcbf29ce484222325ULL, v;
+	size_t i;
+
+	for (i = 0; i < sizeof(params); i++) {
+		h ^= ((const unsigned char *)params)[i];
+		h *= 0x100000001b3ULL;
+	}
+	for (i = 0; i + 8 <= len; i += 8) {
+		memcpy(&v, p + i, sizeof(v));
+		h ^= v;
+		h *= 0x100000001b3ULL;
+		h ^= h >> 32;
+	}
+	for (; i < len; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h ? h : 1;
+}
+
+static void
+tp_decode(PixmapJob *job)
+{
+	uint32_t *px, *next;
+	int w = job->src_w, h = job->src_h, th, tw, k;
+
+	job->hash = tp_hash(job);
+	if (job->hash == job->prev_hash) {
+		job->unchanged = 1;
+		return;
+	}
+
+	px = malloc((size_t)w * (size_t)h * sizeof(*px));
+	if (!px)
+		return;
+	/* Fully transparent as ARGB: the app sends RGBA bytes. */
+	if (!tray_pixmap_convert(px, job->data, (size_t)w * (size_t)h, job->force_rgba)
+			&& !job->force_rgba)
+		tray_pixmap_convert(px, job->data, (size_t)w * (size_t)h, 1);
+
+	th = job->target_h > 0 ? job->target_h : h;
+	if (h > th) {
+		tw = MAX(1, (int)lround(((double)w * (double)th) / (double)h));
+		if ((k = h / th) >= 2) {
+			next = tray_pixmap_box_reduce(px, w, h, k, &w, &h);
+			free(px);
+			if (!(px = next))
+				return;
+		}
+		if (w != tw || h != th) {
+			next = tp_scale(px, w, h, tw, th);
+			free(px);
+			if (!(px = next))
+				return;
+			w = tw;
+			h = th;
+		}
+	}
+	job->pixels = px;
+	job->w = w;
+	job->h = h;
+}
+
+static void *
+tp_worker(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&tp_lock);
+	for (;;) {
+		PixmapJob *job, **tail;
+		uint64_t one = 1;
+
+		while (!tp_todo && !tp_thread_stop)
+			pthread_cond_wait(&tp_cond, &tp_lock);
+		if (tp_thread_stop)
+			break;
+		job = tp_todo;
+		tp_todo = job->next;
+		if (!job->cancelled) {
+			pthread_mutex_unlock(&tp_lock);
+			tp_decode(job);
+			pthread_mutex_lock(&tp_lock);
+		}
+
+		/* Keep completion order so the newest job lands last. */
+		job->next = NULL;
+		for (tail = &tp_done; *tail; tail = &(*tail)->next)
+			;
+		*tail = job;
+		if (write(tp_wake_fd, &one, sizeof(one)) < 0) {
+			/* counter saturated: the main loop is already woken */
+		}
+	}
+	pthread_mutex_unlock(&tp_lock);
+	return NULL;
+}
+
+static void
+tp_finish(PixmapJob *job)
+{
+	TrayItem *it;
+
+	wl_list_for_each(it, &tray_items, link) {
+		if (it->seq != job->item_seq)
+			continue;
+		if (it->pixmap_gen == job->gen) {
+			it->pixmap_gen = 0;
+			if (!job->unchanged)
+				tray_item_pixmap_ready(it, job->pixels ?
+						statusbar_buffer_from_argb32_raw(job->pixels,
+							job->w, job->h) : NULL, job->hash);
+		}
+		break;
+	}
+	sd_bus_message_unref(job->msg);
+	free(job->pixels);
+	free(job);
+}
+
+static int
+tp_wake_cb(int fd, uint32_t mask, void *data)
+{
+	PixmapJob *done, *next;
+	uint64_t count;
+
+	(void)mask;
+	(void)data;
+
+	if (read(fd, &count, sizeof(count)) < 0) {
+		/* spurious wakeup; drain whatever is queued anyway */
+	}
+
+	pthread_mutex_lock(&tp_lock);
+	done = tp_done;
+	tp_done = NULL;
+	pthread_mutex_unlock(&tp_lock);
+
+	for (; done; done = next) {
+		next = done->next;
+		tp_finish(done);
+	}
+	return 0;
+}
+
+static int
+tp_start_worker(void)
+{
+	if (tp_thread_running)
+		return 0;
+	if (tp_wake_fd < 0) {
+		tp_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (tp_wake_fd < 0)
+			return -1;
+	}
+	if (!tp_wake_src)
+		tp_wake_src = wl_event_loop_add_fd(event_loop, tp_wake_fd,
+				WL_EVENT_READABLE, tp_wake_cb, NULL);
+	if (!tp_wake_src)
+		return -1;
+	tp_thread_stop = 0;
+	if (pthread_create(&tp_thread, NULL, tp_worker, NULL) != 0)
+		return -1;
+	tp_thread_running = 1;
+	return 0;
+}
+
+/* Queue the w×h IconPixmap at data (inside msg) for it, scaled to
+ * target_h.  The result reaches tray_item_pixmap_ready() unless a newer
+ * pixmap or a named icon replaces it first. */
+int
+tray_pixmap_decode(TrayItem *it, sd_bus_message *msg, const void *data,
+		int w, int h, int target_h)
+{
+	PixmapJob *job, **tail;
+
+	if (!it || !msg || !data || w <= 0 || h <= 0)
+		return -1;
+
+	job = ecalloc(1, sizeof(*job));
+	job->item_seq = it->seq;
+	job->gen = ++tp_gen;
+	job->data = data;
+	job->src_w = w;
+	job->src_h = h;
+	job->target_h = target_h;
+	job->force_rgba = statusbar_tray_force_rgba;
+	job->prev_hash = it->icon_buf ? it->icon_hash : 0;
+	job->msg = sd_bus_message_ref(msg);
+	it->pixmap_gen = job->gen;
+
+	if (tp_start_worker() != 0) {
+		/* No worker: decode inline rather than lose the icon. */
+		tp_decode(job);
+		tp_finish(job);
+		return 0;
+	}
+
+	pthread_mutex_lock(&tp_lock);
+	for (tail = &tp_todo; *tail; tail = &(*tail)->next)
+		if ((*tail)->item_seq == job->item_seq)
+			(*tail)->cancelled = 1;
+	*tail = job;
+	pthread_cond_signal(&tp_cond);
+	pthread_mutex_unlock(&tp_lock);
+	return 0;
+}
+
+void
+tray_pixmap_cleanup(void)
+{
+	PixmapJob *job, *next;
+
+	if (tp_thread_running) {
+		pthread_mutex_lock(&tp_lock);
+		tp_thread_stop = 1;
+		pthread_cond_signal(&tp_cond);
+		pthread_mutex_unlock(&tp_lock);
+		pthread_join(tp_thread, NULL);
+		tp_thread_running = 0;
+	}
+	for (job = tp_todo; job; job = next) {
+		next = job->next;
+		sd_bus_message_unref(job->msg);
+		free(job);
+	}
+	for (job = tp_done; job; job = next) {
+		next = job->next;
+		sd_bus_message_unref(job->msg);
+		free(job->pixels);
+		free(job);
+	}
+	tp_todo = tp_done = NULL;
+
+	if (tp_wake_src)
+		wl_event_source_remove(tp_wake_src);
+	tp_wake_src = NULL;
+	if (tp_wake_fd >= 0)
+		close(tp_wake_fd);
+	tp_wake_fd = -1;
+}
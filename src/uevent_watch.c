@@ -0,0 +1,404 @@
+/*
+ * uevent_watch.c — kernel uevents for the battery and backlight modules,
+ * plus a coalesced brightness writer.
+ *
+ * The battery and light modules used to re-read sysfs on every 45s
+ * refresh (and the light module could fall back to popen'ing
+ * brightnessctl/light).  One NETLINK_KOBJECT_UEVENT socket on the event
+ * loop now keeps both values cached and re-arms the matching refresh
+ * only when the kernel reports a power_supply or backlight change.
+ * power_supply uevents carry POWER_SUPPLY_CAPACITY, so a battery tick
+ * costs no file read at all; backlight uevents (also emitted for sysfs
+ * writes, SOURCE=sysfs) cost two small reads.  Hotplug (add/remove)
+ * drops the cached sysfs paths so the next read re-probes.
+ *
+ * Some ACPI firmware only notifies on charge-state changes, so a slow
+ * backstop timer re-reads both files and refreshes if they drifted.
+ *
+ * Brightness changes from scroll/keys go through backlight_queue_percent:
+ * the target is cached immediately (so consecutive notches accumulate)
+ * and written at most once per frame, straight to the sysfs brightness
+ * file when it is writable, else via logind's Session.SetBrightness,
+ * else via the brightnessctl/light fork in set_backlight_percent.
+ */
+#include "nixlytile.h"
+
+#include <linux/netlink.h>
+
+#define UEVENT_BUF               8192
+#define UEVENT_BACKSTOP_MS       300000
+#define UEVENT_BACKLIGHT_FRAME_MS 16
+
+static int ue_fd = -1;
+static struct wl_event_source *ue_src;
+static struct wl_event_source *ue_backstop_timer;
+static struct wl_event_source *ue_flush_timer;
+
+static double ue_battery = -1.0;
+static double ue_backlight = -1.0;
+static unsigned long long ue_backlight_max;
+
+static double ue_pending = -1.0;
+static uint64_t ue_last_write_ms;
+static sd_bus *ue_system_bus;
+
+static void
+ue_close(void)
+{
+	if (ue_src)
+		wl_event_source_remove(ue_src);
+	if (ue_backstop_timer)
+		wl_event_source_remove(ue_backstop_timer);
+	ue_src = ue_backstop_timer = NULL;
+	if (ue_fd >= 0)
+		close(ue_fd);
+	ue_fd = -1;
+	ue_battery = ue_backlight = -1.0;
+}
+
+/* ── cached reads ─────────────────────────────────────────────────── */
+
+static double
+ue_read_battery(void)
+{
+	unsigned long long cur;
+
+	if (!battery_path_initialized) {
+		battery_available = findbatterydevice(battery_capacity_path,
+				sizeof(battery_capacity_path));
+		battery_path_initialized = 1;
+	}
+	if (!battery_available || readulong(battery_capacity_path, &cur) != 0)
+		return -1.0;
+	return (double)MIN(cur, 100ULL);
+}
+
+static double
+ue_read_backlight(void)
+{
+	unsigned long long cur, max;
+
+	if (!backlight_paths_initialized) {
+		backlight_available = findbacklightdevice(backlight_brightness_path,
+				sizeof(backlight_brightness_path),
+				backlight_max_path, sizeof(backlight_max_path));
+		if (!backlight_available)
+			backlight_writable = 0;
+		backlight_paths_initialized = 1;
+	}
+	if (!backlight_available
+			|| readulong(backlight_brightness_path, &cur) != 0
+			|| readulong(backlight_max_path, &max) != 0 || max == 0)
+		return -1.0;
+	ue_backlight_max = max;
+	return ((double)MIN(cur, max) * 100.0) / (double)max;
+}
+
+static void
+ue_update_battery(double v)
+{
+	if (v == ue_battery)
+		return;
+	ue_battery = v;
+	set_status_task_due(refreshstatusbattery, monotonic_msec());
+}
+
+static void
+ue_update_backlight(double v)
+{
+	/* Our own writes come back as SOURCE=sysfs uevents; don't redraw
+	 * for a value the bar already shows or one still being written. */
+	if (v == ue_backlight || ue_pending >= 0.0)
+		return;
+	ue_backlight = v;
+	if (v >= 0.0)
+		light_cached_percent = v;
+	set_status_task_due(refreshstatuslight, monotonic_msec());
+}
+
+/* Does the uevent's DEVPATH name the power supply we read capacity from? */
+static int
+ue_is_our_battery(const char *devpath)
+{
+	const char *name = strrchr(devpath, '/');
+	size_t len;
+	char want[PATH_MAX];
+
+	if (!name || !battery_available)
+		return 0;
+	name++;
+	if (snprintf(want, sizeof(want), "/%s/capacity", name) >= (int)sizeof(want))
+		return 0;
+	len = strlen(battery_capacity_path);
+	return len >= strlen(want)
+		&& !strcmp(battery_capacity_path + len - strlen(want), want);
+}
+
+static void
+ue_handle(char *buf, size_t len)
+{
+	const char *action = NULL, *subsystem = NULL, *devpath = NULL;
+	const char *ps_type = NULL, *ps_capacity = NULL;
+	char *p = buf, *end = buf + len;
+
+	/* Kernel messages start with "ACTION@DEVPATH"; anything else is a
+	 * udev-daemon broadcast that wandered onto the group. */
+	if (!memchr(buf, '@', strnlen(buf, len)))
+		return;
+
+	for (; p < end; p += strnlen(p, (size_t)(end - p)) + 1) {
+		if (!strncmp(p, "ACTION=", 7))
+			action = p + 7;
+		else if (!strncmp(p, "SUBSYSTEM=", 10))
+			subsystem = p + 10;
+		else if (!strncmp(p, "DEVPATH=", 8))
+			devpath = p + 8;
+		else if (!strncmp(p, "POWER_SUPPLY_TYPE=", 18))
+			ps_type = p + 18;
+		else if (!strncmp(p, "POWER_SUPPLY_CAPACITY=", 22))
+			ps_capacity = p + 22;
+	}
+	if (!action || !subsystem)
+		return;
+
+	if (!strcmp(subsystem, "power_supply")) {
+		if (strcmp(action, "change") != 0) {
+			battery_path_initialized = 0;
+			ue_update_battery(ue_read_battery());
+			return;
+		}
+		if (ps_type && strcmp(ps_type, "Battery") != 0)
+			return;
+		if (ps_capacity && devpath && ue_is_our_battery(devpath)) {
+			char *e;
+			long v = strtol(ps_capacity, &e, 10);
+			if (e != ps_capacity && v >= 0) {
+				ue_update_battery((double)MIN(v, 100L));
+				return;
+			}
+		}
+		ue_update_battery(ue_read_battery());
+	} else if (!strcmp(subsystem, "backlight")) {
+		if (strcmp(action, "change") != 0)
+			backlight_paths_initialized = 0;
+		ue_update_backlight(ue_read_backlight());
+	}
+}
+
+static int
+ue_readable(int fd, uint32_t mask, void *data)
+{
+	char buf[UEVENT_BUF];
+	ssize_t n;
+
+	(void)data;
+
+	if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+		wlr_log(WLR_ERROR, "uevent_watch: socket error, falling back to polling");
+		ue_close();
+		return 0;
+	}
+
+	while ((n = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+		buf[n] = '\0';
+		ue_handle(buf, (size_t)n);
+	}
+	return 0;
+}
+
+static int
+ue_backstop(void *data)
+{
+	(void)data;
+
+	ue_update_battery(ue_read_battery());
+	ue_update_backlight(ue_read_backlight());
+	wl_event_source_timer_update(ue_backstop_timer, UEVENT_BACKSTOP_MS);
+	return 0;
+}
+
+/* ── coalesced brightness writes ──────────────────────────────────── */
+
+static int
+ue_write_sysfs(unsigned long long value)
+{
+	char num[32];
+	int fd, len, ok;
+
+	fd = open(backlight_brightness_path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	len = snprintf(num, sizeof(num), "%llu", value);
+	ok = write(fd, num, (size_t)len) == len;
+	close(fd);
+	return ok ? 0 : -1;
+}
+
+static int
+ue_write_logind(unsigned long long value)
+{
+	sd_bus_message *msg = NULL;
+	char dev[PATH_MAX];
+	char *slash;
+	int r;
+
+	/* backlight_brightness_path is /sys/class/backlight/<dev>/brightness */
+	snprintf(dev, sizeof(dev), "%s", backlight_brightness_path);
+	if (!(slash = strrchr(dev, '/')))
+		return -1;
+	*slash = '\0';
+	if (!(slash = strrchr(dev, '/')))
+		return -1;
+
+	if (!ue_system_bus && sd_bus_open_system(&ue_system_bus) < 0) {
+		ue_system_bus = NULL;
+		return -1;
+	}
+
+	r = sd_bus_message_new_method_call(ue_system_bus, &msg,
+			"org.freedesktop.login1", "/org/freedesktop/login1/session/auto",
+			"org.freedesktop.login1.Session", "SetBrightness");
+	if (r >= 0)
+		r = sd_bus_message_append(msg, "ssu", "backlight", slash + 1,
+				(uint32_t)MIN(value, (unsigned long long)UINT32_MAX));
+	/* Fire and forget: waiting for the reply would put a system-bus
+	 * round trip on every scroll frame. */
+	if (r >= 0)
+		r = sd_bus_message_set_expect_reply(msg, 0);
+	if (r >= 0)
+		r = sd_bus_send(ue_system_bus, msg, NULL);
+	sd_bus_message_unref(msg);
+	if (r >= 0)
+		r = sd_bus_flush(ue_system_bus);
+	/* Nothing subscribed; just drop NameAcquired and friends. */
+	while (r >= 0 && sd_bus_process(ue_system_bus, NULL) > 0)
+		;
+	return r < 0 ? -1 : 0;
+}
+
+static int
+ue_flush(void *data)
+{
+	double percent = ue_pending;
+	unsigned long long value;
+
+	(void)data;
+
+	if (percent < 0.0)
+		return 0;
+	ue_pending = -1.0;
+	ue_last_write_ms = monotonic_msec();
+
+	if (!ue_backlight_max && ue_read_backlight() < 0.0) {
+		set_backlight_percent(percent);
+		return 0;
+	}
+	value = (unsigned long long)lround(percent / 100.0 * (double)ue_backlight_max);
+
+	if (backlight_writable && ue_write_sysfs(value) == 0)
+		return 0;
+	if (ue_write_logind(value) == 0)
+		return 0;
+	set_backlight_percent(percent);
+	return 0;
+}
+
+/* Queue a brightness change; consecutive calls within a frame collapse
+ * into one write of the last target.  Returns -1 if there is no
+ * backlight to write to. */
+int
+backlight_queue_percent(double percent)
+{
+	uint64_t now, since;
+
+	if (!backlight_available)
+		return -1;
+	if (!ue_flush_timer) {
+		ue_flush_timer = wl_event_loop_add_timer(event_loop, ue_flush, NULL);
+		if (!ue_flush_timer)
+			return -1;
+	}
+
+	percent = MAX(0.0, MIN(percent, 100.0));
+	ue_pending = percent;
+	ue_backlight = percent;
+	light_cached_percent = percent;
+
+	now = monotonic_msec();
+	since = now - ue_last_write_ms;
+	wl_event_source_timer_update(ue_flush_timer,
+			since >= UEVENT_BACKLIGHT_FRAME_MS
+			? 1 : (int)(UEVENT_BACKLIGHT_FRAME_MS - since));
+	return 0;
+}
+
+/* ── public ───────────────────────────────────────────────────────── */
+
+int
+uevent_watch_active(void)
+{
+	return ue_src != NULL;
+}
+
+int
+uevent_watch_battery(double *percent)
+{
+	if (!ue_src || ue_battery < 0.0)
+		return -1;
+	*percent = ue_battery;
+	return 0;
+}
+
+int
+uevent_watch_backlight(double *percent)
+{
+	if (!ue_src || ue_backlight < 0.0)
+		return -1;
+	*percent = ue_backlight;
+	return 0;
+}
+
+void
+uevent_watch_setup(void)
+{
+	struct sockaddr_nl sa = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = 1, /* kernel uevent broadcast */
+	};
+	int rcvbuf = 256 * 1024;
+
+	ue_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+			NETLINK_KOBJECT_UEVENT);
+	if (ue_fd < 0 || bind(ue_fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+		wlr_log(WLR_ERROR, "uevent_watch: netlink unavailable, polling sysfs");
+		ue_close();
+		return;
+	}
+	/* Boot and dock storms can queue hundreds of uevents. */
+	setsockopt(ue_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	ue_src = wl_event_loop_add_fd(event_loop, ue_fd, WL_EVENT_READABLE,
+			ue_readable, NULL);
+	ue_backstop_timer = wl_event_loop_add_timer(event_loop, ue_backstop, NULL);
+	if (!ue_src || !ue_backstop_timer) {
+		ue_close();
+		return;
+	}
+	wl_event_source_timer_update(ue_backstop_timer, UEVENT_BACKSTOP_MS);
+
+	ue_battery = ue_read_battery();
+	ue_backlight = ue_read_backlight();
+}
+
+void
+uevent_watch_cleanup(void)
+{
+	ue_close();
+	if (ue_flush_timer) {
+		ue_flush(NULL);
+		wl_event_source_remove(ue_flush_timer);
+		ue_flush_timer = NULL;
+	}
+	if (ue_system_bus)
+		ue_system_bus = sd_bus_flush_close_unref(ue_system_bus);
+}
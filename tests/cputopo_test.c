@@ -0,0 +1,208 @@
+/*
+ * cputopo_test.c — cputopo_load() against synthetic sysfs trees of the
+ * parts the placement policies were written for, checking the model it
+ * builds (domains, dom_of, core_of, capacity, P/E split) and what the
+ * game / compositor / background policies make of it:
+ *
+ *   x3d       Ryzen 9 7950X3D: two CCDs, only the first with V-cache
+ *   dualccd   Ryzen 9 7950X: two identical CCDs, cpu31 offline
+ *   hybrid    Core i9-13900K: SMT P-cores 0-15, E-cores 16-31 from the
+ *             cpu_core / cpu_atom PMU lists, with cpu_capacity
+ *   biglittle capacity-only asymmetry (no PMU lists), no SMT
+ */
+#include "nixlytile.h"
+#include "testlib.h"
+
+static CpuTopo topo;
+
+/* One CPU's topology, L3 and (cap > 0) cpu_capacity files. */
+static void
+topo_cpu(const char *root, int cpu, const char *siblings, const char *l3,
+		const char *l3_size, int cap)
+{
+	char rel[128];
+
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+	fx_write(root, rel, "%s\n", siblings);
+	/* index0-2 are L1d/L1i/L2: the loader must skip to the level-3 one */
+	for (int idx = 0; idx < 3; idx++) {
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index%d/level", cpu, idx);
+		fx_write(root, rel, "%d\n", idx ? idx : 1);
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, idx);
+		fx_write(root, rel, "%s\n", siblings);
+	}
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index3/level", cpu);
+	fx_write(root, rel, "3\n");
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index3/shared_cpu_list", cpu);
+	fx_write(root, rel, "%s\n", l3);
+	snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cache/index3/size", cpu);
+	fx_write(root, rel, "%s\n", l3_size);
+	if (cap > 0) {
+		snprintf(rel, sizeof(rel), "devices/system/cpu/cpu%d/cpu_capacity", cpu);
+		fx_write(root, rel, "%d\n", cap);
+	}
+}
+
+/* 16 SMT cores, thread n + 16 beside n, L3 split by CCD (cores 0-7 / 8-15) */
+static void
+topo_ryzen16(const char *root, const char *online, const char *ccd0_l3,
+		const char *ccd1_l3)
+{
+	char sib[16];
+
+	fx_write(root, "devices/system/cpu/online", "%s\n", online);
+	for (int cpu = 0; cpu < 32; cpu++) {
+		int core = cpu % 16;
+
+		snprintf(sib, sizeof(sib), "%d,%d", core, core + 16);
+		if (core < 8)
+			topo_cpu(root, cpu, sib, "0-7,16-23", ccd0_l3, 0);
+		else
+			topo_cpu(root, cpu, sib, "8-15,24-31", ccd1_l3, 0);
+	}
+}
+
+static void
+topo_hybrid(const char *root)
+{
+	char sib[16];
+
+	fx_write(root, "devices/system/cpu/online", "0-31\n");
+	fx_write(root, "devices/cpu_core/cpus", "0-15\n");
+	fx_write(root, "devices/cpu_atom/cpus", "16-31\n");
+	for (int cpu = 0; cpu < 32; cpu++) {
+		if (cpu < 16)
+			snprintf(sib, sizeof(sib), "%d-%d", cpu & ~1, (cpu & ~1) + 1);
+		else
+			snprintf(sib, sizeof(sib), "%d", cpu);
+		topo_cpu(root, cpu, sib, "0-31", "36864K", cpu < 16 ? 1024 : 642);
+	}
+}
+
+static void
+topo_biglittle(const char *root)
+{
+	char sib[16];
+
+	fx_write(root, "devices/system/cpu/online", "0-7\n");
+	for (int cpu = 0; cpu < 8; cpu++) {
+		snprintf(sib, sizeof(sib), "%d", cpu);
+		topo_cpu(root, cpu, sib, "0-7", "4096K", cpu < 4 ? 446 : 1024);
+	}
+}
+
+static int
+set_is(const cpu_set_t *set, const char *list)
+{
+	char buf[128];
+
+	cputopo_format(set, buf, sizeof(buf));
+	if (strcmp(buf, list) == 0)
+		return 1;
+	fprintf(stderr, "  got %s, want %s\n", buf, list);
+	return 0;
+}
+
+static void
+test_x3d(const char *root)
+{
+	cpu_set_t game, comp, bg;
+
+	topo_ryzen16(root, "0-31", "98304K", "32768K");
+	CHECK(cputopo_load(&topo, root) == 0);
+	CHECK(topo.ncpus == 32);
+	CHECK(topo.ndomains == 2);
+	CHECK(set_is(&topo.dom[0].cpus, "0-7,16-23") && topo.dom[0].l3_kb == 98304);
+	CHECK(set_is(&topo.dom[1].cpus, "8-15,24-31") && topo.dom[1].l3_kb == 32768);
+	CHECK(topo.dom_of[0] == 0 && topo.dom_of[7] == 0 && topo.dom_of[16] == 0);
+	CHECK(topo.dom_of[8] == 1 && topo.dom_of[24] == 1 && topo.dom_of[31] == 1);
+	CHECK(topo.core_of[16] == 0 && topo.core_of[31] == 15 && topo.core_of[5] == 5);
+	CHECK(topo.capacity[0] == 1024 && topo.capacity[31] == 1024);
+	CHECK(!CPU_COUNT(&topo.pcores) && !CPU_COUNT(&topo.ecores));
+
+	/* the V-cache CCD for the game, the other one for everything else */
+	CHECK(cputopo_game_set(&topo, &game) == 1 && set_is(&game, "0-7,16-23"));
+	CHECK(cputopo_compositor_set(&topo, &game, &comp) && set_is(&comp, "8,24"));
+	CHECK(cputopo_background_set(&topo, &game, &bg) && set_is(&bg, "8-15,24-31"));
+}
+
+static void
+test_dualccd(const char *root)
+{
+	cpu_set_t game, comp, bg;
+
+	topo_ryzen16(root, "0-30", "32768K", "32768K");
+	CHECK(cputopo_load(&topo, root) == 0);
+	CHECK(topo.ncpus == 31 && CPU_COUNT(&topo.online) == 31);
+	CHECK(topo.ndomains == 2);
+	CHECK(set_is(&topo.dom[1].cpus, "8-15,24-30"));
+	CHECK(topo.dom_of[31] == -1 && topo.core_of[31] == -1);
+	CHECK(topo.dom_of[15] == 1 && topo.core_of[30] == 14);
+
+	/* symmetric: the game keeps both CCDs, the compositor takes core 0 */
+	CHECK(cputopo_game_set(&topo, &game) == 0);
+	CHECK(cputopo_compositor_set(&topo, NULL, &comp) && set_is(&comp, "0,16"));
+	CHECK(cputopo_background_set(&topo, NULL, &bg) == 0);
+}
+
+static void
+test_hybrid(const char *root)
+{
+	cpu_set_t game, comp, bg;
+
+	topo_hybrid(root);
+	CHECK(cputopo_load(&topo, root) == 0);
+	CHECK(topo.ncpus == 32 && topo.ndomains == 1);
+	CHECK(topo.dom[0].l3_kb == 36864 && topo.dom[0].capacity == 1024);
+	CHECK(topo.core_of[0] == 0 && topo.core_of[1] == 0 && topo.core_of[15] == 14);
+	CHECK(topo.core_of[16] == 16 && topo.core_of[31] == 31);
+	CHECK(topo.capacity[3] == 1024 && topo.capacity[20] == 642);
+	CHECK(set_is(&topo.pcores, "0-15") && set_is(&topo.ecores, "16-31"));
+
+	CHECK(cputopo_game_set(&topo, &game) == 1 && set_is(&game, "0-15"));
+	CHECK(cputopo_compositor_set(&topo, &game, &comp) && set_is(&comp, "0-1"));
+	CHECK(cputopo_background_set(&topo, &game, &bg) && set_is(&bg, "16-31"));
+}
+
+static void
+test_biglittle(const char *root)
+{
+	cpu_set_t game, comp;
+
+	topo_biglittle(root);
+	CHECK(cputopo_load(&topo, root) == 0);
+	CHECK(topo.ncpus == 8 && topo.ndomains == 1);
+	CHECK(topo.capacity[0] == 446 && topo.capacity[7] == 1024);
+	CHECK(topo.dom[0].capacity == 1024);
+	/* no PMU lists: the split comes from cpu_capacity alone */
+	CHECK(set_is(&topo.pcores, "4-7") && set_is(&topo.ecores, "0-3"));
+	CHECK(cputopo_game_set(&topo, &game) == 1 && set_is(&game, "4-7"));
+	/* no SMT: a one-thread core is topped up to two CPUs */
+	CHECK(cputopo_compositor_set(&topo, &game, &comp) && set_is(&comp, "0-1"));
+}
+
+int
+main(void)
+{
+	static const struct {
+		const char *name;
+		void (*run)(const char *root);
+	} cases[] = {
+		{ "x3d", test_x3d },
+		{ "dualccd", test_dualccd },
+		{ "hybrid", test_hybrid },
+		{ "biglittle", test_biglittle },
+	};
+
+	for (size_t i = 0; i < LENGTH(cases); i++) {
+		char *root = fx_mktemp(cases[i].name);
+		int before = test_failures;
+
+		cases[i].run(root);
+		if (test_failures != before)
+			fprintf(stderr, "cputopo_test: %s failed\n", cases[i].name);
+		fx_rmtree(root);
+		free(root);
+	}
+	return test_done("cputopo_test");
+}
@@ -0,0 +1,214 @@
+/*
+ * gpuclients_test.c — gpuclients_scan() over a fixture proc tree with
+ * the fdinfo formats of the three drivers it reads:
+ *
+ *   100 game     amdgpu: drm-engine-gfx ns, drm-memory-vram; fd 9 is a
+ *                dup of fd 5 (same drm-client-id) and must count once
+ *   200 obs      i915: two clients, drm-engine-render / -video with
+ *                drm-engine-capacity-video: 2, drm-resident-local0
+ *   300 browser  xe: drm-cycles-rcs against drm-total-cycles-rcs,
+ *                drm-resident-vram0
+ *   400 shell    no DRM fd
+ *   500 other    another user's process, never read
+ *
+ * The clock is pinned, so every rate is exact.  Later passes reopen the
+ * game's device on the same fd number (new client, counters from zero)
+ * and hand pid 300 to a new process; neither may turn the old counters
+ * into a rate.
+ */
+#include "nixlytile.h"
+#include "testlib.h"
+
+#define GC_TEST_STEP_NS (100ull * 1000000)
+
+static ProcInfo gc_test_procs[] = {
+	{ .pid = 1, .start = 1, .comm = "systemd" },
+	{ .pid = 100, .start = 5000, .comm = "game" },
+	{ .pid = 200, .start = 5100, .comm = "obs" },
+	{ .pid = 300, .start = 5200, .comm = "browser" },
+	{ .pid = 400, .start = 5300, .comm = "shell" },
+	{ .pid = 500, .start = 5400, .comm = "other" },
+};
+
+int
+proctable_snapshot(ProcInfo **out)
+{
+	size_t n = LENGTH(gc_test_procs);
+
+	*out = ecalloc(n, sizeof(**out));
+	for (size_t i = 0; i < n; i++) {
+		(*out)[i] = gc_test_procs[i];
+		(*out)[i].uid = gc_test_procs[i].pid == 500 ? getuid() + 1 : getuid();
+	}
+	return (int)n;
+}
+
+/* /proc/<pid>/fd/<fd> → target, as a dangling symlink */
+static void
+gc_fd(const char *root, int pid, int fd, const char *target)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%d", root, pid);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/%d/fd", root, pid);
+	mkdir(path, 0755);
+	snprintf(path, sizeof(path), "%s/%d/fd/%d", root, pid, fd);
+	unlink(path);
+	if (symlink(target, path) != 0)
+		die("gc_fd: %s:", path);
+}
+
+static void
+gc_close(const char *root, int pid, int fd)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%d/fd/%d", root, pid, fd);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/%d/fdinfo/%d", root, pid, fd);
+	unlink(path);
+}
+
+static void
+gc_amdgpu(const char *root, int fd, int client, unsigned long long gfx_ns)
+{
+	char rel[64];
+
+	snprintf(rel, sizeof(rel), "100/fdinfo/%d", fd);
+	fx_write(root, rel, "pos:\t0\nflags:\t02100002\nmnt_id:\t25\n"
+			"drm-driver:\tamdgpu\ndrm-pdev:\t0000:03:00.0\n"
+			"drm-client-id:\t%d\n"
+			"drm-memory-vram:\t2097152 KiB\ndrm-memory-gtt:\t8192 KiB\n"
+			"drm-engine-gfx:\t%llu ns\ndrm-engine-compute:\t0 ns\n",
+			client, gfx_ns);
+}
+
+static void
+gc_i915(const char *root, int fd, int client, unsigned long long render_ns,
+		unsigned long long video_ns)
+{
+	char rel[64];
+
+	snprintf(rel, sizeof(rel), "200/fdinfo/%d", fd);
+	fx_write(root, rel, "pos:\t0\nflags:\t02100002\n"
+			"drm-driver:\ti915\ndrm-client-id:\t%d\n"
+			"drm-engine-render:\t%llu ns\ndrm-engine-copy:\t0 ns\n"
+			"drm-engine-video:\t%llu ns\ndrm-engine-capacity-video:\t2\n"
+			"drm-resident-local0:\t256 KiB\n",
+			client, render_ns, video_ns);
+}
+
+static void
+gc_xe(const char *root, unsigned long long cycles, unsigned long long total)
+{
+	fx_write(root, "300/fdinfo/4", "pos:\t0\nflags:\t02100002\n"
+			"drm-driver:\txe\ndrm-client-id:\t40\n"
+			"drm-resident-vram0:\t1 MiB\n"
+			"drm-cycles-rcs:\t%llu\ndrm-total-cycles-rcs:\t%llu\n"
+			"drm-cycles-bcs:\t0\ndrm-total-cycles-bcs:\t%llu\n",
+			cycles, total, total);
+}
+
+static void
+gc_fixture(const char *root)
+{
+	fx_write(root, "100/fdinfo/0", "pos:\t0\nflags:\t02\n");
+	gc_fd(root, 100, 0, "/dev/null");
+	gc_amdgpu(root, 5, 7, 1000000000ull);
+	gc_fd(root, 100, 5, "/dev/dri/renderD128");
+	gc_amdgpu(root, 9, 7, 1000000000ull);
+	gc_fd(root, 100, 9, "/dev/dri/renderD128");
+
+	gc_i915(root, 4, 20, 500000000ull, 0);
+	gc_fd(root, 200, 4, "/dev/dri/renderD129");
+	gc_i915(root, 6, 21, 100000000ull, 0);
+	gc_fd(root, 200, 6, "/dev/dri/card1");
+
+	gc_xe(root, 10000, 100000);
+	gc_fd(root, 300, 4, "/dev/dri/renderD130");
+
+	fx_write(root, "400/fdinfo/1", "pos:\t0\nflags:\t02\n");
+	gc_fd(root, 400, 1, "/dev/pts/0");
+
+	fx_write(root, "500/fdinfo/3", "drm-driver:\tamdgpu\ndrm-client-id:\t99\n"
+			"drm-engine-gfx:\t1 ns\n");
+	gc_fd(root, 500, 3, "/dev/dri/renderD128");
+}
+
+static const GpuClient *
+gc_find(const GpuClient *top, int n, pid_t pid)
+{
+	for (int i = 0; i < n; i++)
+		if (top[i].pid == pid)
+			return &top[i];
+	return NULL;
+}
+
+int
+main(void)
+{
+	char *root = fx_mktemp("gpuclients");
+	GpuClient top[8];
+	const GpuClient *c;
+	int n;
+
+	gc_fixture(root);
+	test_now_ns = 1000000000ull;
+
+	/* first pass: clients found, no interval yet */
+	CHECK(gpuclients_scan(root) == 3);
+	CHECK(gpuclients_busy(100) == -1 && gpuclients_busy(400) == -1);
+	CHECK(gpuclients_busy(500) == -1);
+
+	/* 100 ms later: game gfx +60 ms (the dup fd too, same client);
+	 * obs video +100 ms over two engines, render +10 ms over both
+	 * clients; browser 300 of 1000 rcs cycles */
+	test_now_ns += GC_TEST_STEP_NS;
+	gc_amdgpu(root, 5, 7, 1060000000ull);
+	gc_amdgpu(root, 9, 7, 1060000000ull);
+	gc_i915(root, 4, 20, 505000000ull, 100000000ull);
+	gc_i915(root, 6, 21, 105000000ull, 0);
+	gc_xe(root, 10300, 101000);
+	CHECK(gpuclients_scan(root) == 3);
+
+	n = gpuclients_top(top, LENGTH(top));
+	CHECK(n == 3 && top[0].pid == 100 && top[1].pid == 200 && top[2].pid == 300);
+	CHECK((c = gc_find(top, n, 100)) && c->busy == 60 && !strcmp(c->engine, "gfx"));
+	CHECK(c && c->vram_kib == 2097152 && !strcmp(c->comm, "game"));
+	CHECK((c = gc_find(top, n, 200)) && c->busy == 50 && !strcmp(c->engine, "video"));
+	CHECK(c && c->vram_kib == 512);
+	CHECK((c = gc_find(top, n, 300)) && c->busy == 30 && !strcmp(c->engine, "rcs"));
+	CHECK(c && c->vram_kib == 1024);
+	CHECK(gpuclients_busy(100) == 60 && gpuclients_busy(400) == -1);
+
+	/* the game closes the dup and reopens its device on fd 5: a new
+	 * client whose gfx counter starts below the old one reads as idle
+	 * for a pass, not as a wrapped counter */
+	test_now_ns += GC_TEST_STEP_NS;
+	gc_close(root, 100, 9);
+	gc_amdgpu(root, 5, 8, 20000000ull);
+	/* pid 300 exits and a new process gets its pid */
+	gc_test_procs[3].start = 9999;
+	snprintf(gc_test_procs[3].comm, sizeof(gc_test_procs[3].comm), "%s", "encoder");
+	gc_xe(root, 90000, 200000);
+	CHECK(gpuclients_scan(root) == 3);
+	CHECK(gpuclients_busy(100) == 0);
+	CHECK(gpuclients_busy(300) == -1);
+
+	/* and from there on both are tracked normally */
+	test_now_ns += GC_TEST_STEP_NS;
+	gc_amdgpu(root, 5, 8, 45000000ull);
+	gc_xe(root, 90500, 201000);
+	CHECK(gpuclients_scan(root) == 3);
+	CHECK(gpuclients_busy(100) == 25);
+	CHECK(gpuclients_busy(300) == 50);
+	n = gpuclients_top(top, LENGTH(top));
+	CHECK((c = gc_find(top, n, 300)) && !strcmp(c->comm, "encoder"));
+
+	gpuclients_cleanup();
+	CHECK(gpuclients_busy(100) == -1);
+	fx_rmtree(root);
+	free(root);
+	return test_done("gpuclients_test");
+}
@@ -0,0 +1,179 @@
+/*
+ * gpustat_test.c — gpustat_open() / gpustat_sample() against a synthetic
+ * sysfs tree with one card per driver:
+ *
+ *   card0  i915    gt/gt0 rps_act_freq_mhz + rc6_residency_ms
+ *   card1  amdgpu  busy files, pp_dpm_* levels, hwmon power1_average and
+ *                  temp1_input, runtime PM status
+ *   card2  xe      tile0/gt0 act_freq + gtidle residency, hwmon
+ *                  energy1_input and temp2_input
+ *
+ * The clock is pinned (test_now_ns) so the residency- and energy-based
+ * figures are exact.  Then the worker is started on the amdgpu card
+ * through NIXLY_GPUSTAT_ROOT and its snapshot read with gpustat_get().
+ */
+#include "nixlytile.h"
+#include "testlib.h"
+
+#define GS_TEST_STEP_NS (200ull * 1000000) /* one sampling interval */
+
+/* What gpustat.o reaches for outside sysfs */
+int game_mode_active = 1;
+int discrete_gpu_idx = -1;
+int integrated_gpu_idx = -1;
+GpuInfo detected_gpus[1];
+
+int
+nvml_open(const char *pci_slot)
+{
+	return -1;
+}
+
+int
+nvml_telemetry(NvmlTelemetry *t)
+{
+	return -1;
+}
+
+int
+gpuclients_scan(const char *proc_root)
+{
+	return 0;
+}
+
+static void
+gs_fixture(const char *root)
+{
+	fx_write(root, "class/drm/card0/gt/gt0/rps_act_freq_mhz", "1300\n");
+	fx_write(root, "class/drm/card0/gt/gt0/rc6_residency_ms", "1000\n");
+
+	fx_write(root, "class/drm/card1/device/gpu_busy_percent", "87\n");
+	fx_write(root, "class/drm/card1/device/mem_busy_percent", "41\n");
+	fx_write(root, "class/drm/card1/device/pp_dpm_sclk",
+			"0: 500Mhz\n1: 1800Mhz\n2: 2500Mhz *\n");
+	fx_write(root, "class/drm/card1/device/pp_dpm_mclk",
+			"0: 96Mhz\n1: 1000Mhz *\n");
+	fx_write(root, "class/drm/card1/device/power/runtime_status", "active\n");
+	fx_write(root, "class/drm/card1/device/hwmon/hwmon3/power1_average", "215000000\n");
+	fx_write(root, "class/drm/card1/device/hwmon/hwmon3/temp1_input", "71000\n");
+
+	fx_write(root, "class/drm/card2/device/tile0/gt0/freq0/act_freq", "2050\n");
+	fx_write(root, "class/drm/card2/device/tile0/gt0/gtidle/idle_residency_ms", "500\n");
+	fx_write(root, "class/drm/card2/device/hwmon/hwmon5/energy1_input", "1000000\n");
+	fx_write(root, "class/drm/card2/device/hwmon/hwmon5/temp2_input", "55000\n");
+}
+
+static void
+test_amdgpu(const char *root, const GpuInfo *gpu)
+{
+	GpuStat s;
+
+	CHECK(gpustat_open(root, gpu) == 0);
+	CHECK(gpustat_sample(&s) == 0);
+	CHECK(s.vendor == GPU_VENDOR_AMD && !s.suspended);
+	CHECK(s.busy == 87 && s.mem_busy == 41);
+	CHECK(s.gfx_mhz == 2500 && s.mem_mhz == 1000);
+	CHECK(s.temp_c == 71 && s.power_mw == 215000);
+
+	/* a runtime-suspended card is reported, not read (and woken) */
+	fx_write(root, "class/drm/card1/device/power/runtime_status", "suspended\n");
+	CHECK(gpustat_sample(&s) == 0);
+	CHECK(s.suspended && s.busy == 0 && s.gfx_mhz == 0 && s.temp_c == -1);
+	fx_write(root, "class/drm/card1/device/power/runtime_status", "active\n");
+	CHECK(gpustat_sample(&s) == 0 && !s.suspended && s.busy == 87);
+}
+
+static void
+test_i915(const char *root, const GpuInfo *gpu)
+{
+	GpuStat s;
+
+	CHECK(gpustat_open(root, gpu) == 0);
+	CHECK(gpustat_sample(&s) == 0);
+	CHECK(s.gfx_mhz == 1300 && s.temp_c == -1);
+	CHECK(s.busy == -1);    /* no interval yet */
+
+	/* 50 ms of the 200 in RC6: 75% busy */
+	test_now_ns += GS_TEST_STEP_NS;
+	fx_write(root, "class/drm/card0/gt/gt0/rc6_residency_ms", "1050\n");
+	CHECK(gpustat_sample(&s) == 0 && s.busy == 75);
+
+	/* idle the whole interval, and then some (counter granularity) */
+	test_now_ns += GS_TEST_STEP_NS;
+	fx_write(root, "class/drm/card0/gt/gt0/rc6_residency_ms", "1260\n");
+	CHECK(gpustat_sample(&s) == 0 && s.busy == 0);
+
+	/* counter went backwards (GT reset): no figure, then resume */
+	test_now_ns += GS_TEST_STEP_NS;
+	fx_write(root, "class/drm/card0/gt/gt0/rc6_residency_ms", "10\n");
+	CHECK(gpustat_sample(&s) == 0 && s.busy == -1);
+	test_now_ns += GS_TEST_STEP_NS;
+	fx_write(root, "class/drm/card0/gt/gt0/rc6_residency_ms", "110\n");
+	CHECK(gpustat_sample(&s) == 0 && s.busy == 50);
+}
+
+static void
+test_xe(const char *root, const GpuInfo *gpu)
+{
+	GpuStat s;
+
+	CHECK(gpustat_open(root, gpu) == 0);
+	CHECK(gpustat_sample(&s) == 0);
+	CHECK(s.gfx_mhz == 2050 && s.temp_c == 55);
+	CHECK(s.busy == -1 && s.power_mw == 0);
+
+	/* 100 ms idle and 30 J over 200 ms: 50% busy at 150 W */
+	test_now_ns += GS_TEST_STEP_NS;
+	fx_write(root, "class/drm/card2/device/tile0/gt0/gtidle/idle_residency_ms", "600\n");
+	fx_write(root, "class/drm/card2/device/hwmon/hwmon5/energy1_input", "31000000\n");
+	CHECK(gpustat_sample(&s) == 0);
+	CHECK(s.busy == 50 && s.power_mw == 150000);
+}
+
+static void
+test_worker(const char *root, const GpuInfo *gpu)
+{
+	GpuStat s;
+
+	test_now_ns = 0;
+	detected_gpus[0] = *gpu;
+	discrete_gpu_idx = 0;
+	setenv("NIXLY_GPUSTAT_ROOT", root, 1);
+	gpustat_set_interval(20);
+	gpustat_setup();
+	for (int i = 0; i < 100 && gpustat_get(&s) != 0; i++)
+		usleep(10 * 1000);
+	CHECK(gpustat_get(&s) == 0 && s.busy == 87 && s.gfx_mhz == 2500);
+	CHECK(strcmp(gpustat_bound(s.busy), "mixed") == 0);
+	CHECK(strcmp(gpustat_bound(95), "gpu") == 0);
+	CHECK(strcmp(gpustat_bound(20), "cpu") == 0);
+	CHECK(strcmp(gpustat_bound(-1), "unknown") == 0);
+
+	/* sampling off: the snapshot is withheld rather than served stale */
+	gpustat_set_interval(0);
+	CHECK(gpustat_get(&s) == -1);
+	gpustat_cleanup();
+}
+
+int
+main(void)
+{
+	char *root = fx_mktemp("gpustat");
+	GpuInfo i915 = { .vendor = GPU_VENDOR_INTEL, .card_index = 0, .driver = "i915" };
+	GpuInfo amd = { .vendor = GPU_VENDOR_AMD, .card_index = 1, .driver = "amdgpu" };
+	GpuInfo xe = { .vendor = GPU_VENDOR_INTEL, .card_index = 2, .driver = "xe" };
+	GpuInfo missing = { .vendor = GPU_VENDOR_AMD, .card_index = 7 };
+
+	gs_fixture(root);
+	test_now_ns = 1000000000ull;
+
+	CHECK(gpustat_open(root, &missing) == -1);
+	test_amdgpu(root, &amd);
+	test_i915(root, &i915);
+	test_xe(root, &xe);
+	test_worker(root, &amd);
+
+	fx_rmtree(root);
+	free(root);
+	return test_done("gpustat_test");
+}
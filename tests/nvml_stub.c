@@ -0,0 +1,186 @@
+/*
+ * nvml_stub.c — a stand-in libnvidia-ml for tests/nvml_test, loaded by
+ * nvml.c through NIXLY_NVML_LIB.  See nvml_stub.h.  Return codes are
+ * NVML's: 0 success, 2 invalid argument, 6 not found.
+ */
+#include <string.h>
+
+#include "nvml_stub.h"
+
+typedef struct nvmlDevice_st *nvmlDevice_t;
+
+static int stub_device;
+#define STUB_DEV ((nvmlDevice_t)&stub_device)
+
+NvmlStub nvml_stub = {
+	.gpu_util = 87, .mem_util = 41,
+	.temp_c = 66,
+	.gfx_mhz = 1800, .mem_mhz = 9501, .max_gfx_mhz = 2100, .max_mem_mhz = 10501,
+	.power_mw = 183456, .limit_mw = 220000,
+	.limit_min_mw = 100000, .limit_max_mw = 300000,
+	.pstate = 0,
+	.compute_mode = -1,
+};
+
+int
+nvmlInit_v2(void)
+{
+	nvml_stub.inits++;
+	return 0;
+}
+
+int
+nvmlShutdown(void)
+{
+	nvml_stub.shutdowns++;
+	return 0;
+}
+
+int
+nvmlDeviceGetHandleByPciBusId_v2(const char *bus_id, nvmlDevice_t *dev)
+{
+	if (!bus_id || strcmp(bus_id, NVML_STUB_BUS_ID) != 0)
+		return 6;
+	*dev = STUB_DEV;
+	return 0;
+}
+
+int
+nvmlDeviceGetIndex(nvmlDevice_t dev, unsigned *index)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*index = NVML_STUB_INDEX;
+	return 0;
+}
+
+int
+nvmlDeviceGetUtilizationRates(nvmlDevice_t dev, unsigned *util)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	util[0] = nvml_stub.gpu_util;
+	util[1] = nvml_stub.mem_util;
+	return 0;
+}
+
+int
+nvmlDeviceGetTemperature(nvmlDevice_t dev, int sensor, unsigned *temp)
+{
+	if (dev != STUB_DEV || sensor != 0)
+		return 2;
+	*temp = nvml_stub.temp_c;
+	return 0;
+}
+
+/* clock type 0 graphics, 2 memory */
+int
+nvmlDeviceGetClockInfo(nvmlDevice_t dev, int type, unsigned *mhz)
+{
+	if (dev != STUB_DEV || (type != 0 && type != 2))
+		return 2;
+	*mhz = type == 0 ? nvml_stub.gfx_mhz : nvml_stub.mem_mhz;
+	return 0;
+}
+
+int
+nvmlDeviceGetMaxClockInfo(nvmlDevice_t dev, int type, unsigned *mhz)
+{
+	if (dev != STUB_DEV || (type != 0 && type != 2))
+		return 2;
+	*mhz = type == 0 ? nvml_stub.max_gfx_mhz : nvml_stub.max_mem_mhz;
+	return 0;
+}
+
+int
+nvmlDeviceGetPowerUsage(nvmlDevice_t dev, unsigned *mw)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*mw = nvml_stub.power_mw;
+	return 0;
+}
+
+int
+nvmlDeviceGetPerformanceState(nvmlDevice_t dev, int *pstate)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*pstate = nvml_stub.pstate;
+	return 0;
+}
+
+int
+nvmlDeviceGetPowerManagementLimit(nvmlDevice_t dev, unsigned *mw)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*mw = nvml_stub.limit_mw;
+	return 0;
+}
+
+int
+nvmlDeviceGetPowerManagementLimitConstraints(nvmlDevice_t dev, unsigned *min_mw,
+		unsigned *max_mw)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*min_mw = nvml_stub.limit_min_mw;
+	*max_mw = nvml_stub.limit_max_mw;
+	return 0;
+}
+
+int
+nvmlDeviceSetPowerManagementLimit(nvmlDevice_t dev, unsigned mw)
+{
+	if (dev != STUB_DEV || mw < nvml_stub.limit_min_mw || mw > nvml_stub.limit_max_mw)
+		return 2;
+	nvml_stub.limit_mw = mw;
+	return 0;
+}
+
+int
+nvmlDeviceGetPersistenceMode(nvmlDevice_t dev, int *on)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	*on = nvml_stub.persistence;
+	return 0;
+}
+
+int
+nvmlDeviceSetPersistenceMode(nvmlDevice_t dev, int on)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	nvml_stub.persistence = on;
+	return 0;
+}
+
+int
+nvmlDeviceSetGpuLockedClocks(nvmlDevice_t dev, unsigned min_mhz, unsigned max_mhz)
+{
+	if (dev != STUB_DEV || min_mhz > max_mhz || max_mhz > nvml_stub.max_gfx_mhz)
+		return 2;
+	nvml_stub.locked_gfx_min = min_mhz;
+	nvml_stub.locked_gfx_max = max_mhz;
+	return 0;
+}
+
+int
+nvmlDeviceResetGpuLockedClocks(nvmlDevice_t dev)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	nvml_stub.locked_gfx_min = nvml_stub.locked_gfx_max = 0;
+	return 0;
+}
+
+int
+nvmlDeviceSetComputeMode(nvmlDevice_t dev, int mode)
+{
+	if (dev != STUB_DEV)
+		return 2;
+	nvml_stub.compute_mode = mode;
+	return 0;
+}
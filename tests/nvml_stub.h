@@ -0,0 +1,33 @@
+/*
+ * nvml_stub.h — what tests/libnvidia-ml-stub.so answers and what it
+ * records.  The stub knows one GPU; every getter returns the current
+ * field of nvml_stub, which the test may rewrite between calls, and
+ * every setter stores into it.
+ *
+ * nvmlDeviceSetMemoryLockedClocks / ResetMemoryLockedClocks are left
+ * out on purpose, as on drivers that predate them.
+ */
+#ifndef NIXLY_NVML_STUB_H
+#define NIXLY_NVML_STUB_H
+
+#define NVML_STUB_BUS_ID "0000:01:00.0"
+#define NVML_STUB_INDEX  1
+#define NVML_STUB_LIB    "libnvidia-ml-stub.so"
+
+typedef struct {
+	/* answers */
+	unsigned gpu_util, mem_util;
+	unsigned temp_c;
+	unsigned gfx_mhz, mem_mhz, max_gfx_mhz, max_mem_mhz;
+	unsigned power_mw, limit_mw, limit_min_mw, limit_max_mw;
+	int pstate;
+	int persistence;
+	/* record */
+	int inits, shutdowns;
+	unsigned locked_gfx_min, locked_gfx_max;  /* 0 when unlocked */
+	int compute_mode;                         /* -1 until set */
+} NvmlStub;
+
+extern NvmlStub nvml_stub;
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * nvml_test.c — nvml.c against tests/libnvidia-ml-stub.so (see
+ * nvml_stub.h): open by PCI slot, telemetry, then the game-mode power
+ * path step by step as apply_nvidia_gpu_power_nvml() and
+ * restore_nvidia_gpu_power() take it, including the memory clock lock
+ * the stub does not implement.
+ */
+#include "nixlytile.h"
+#include <dlfcn.h>
+#include <libgen.h>
+
+#include "nvml_stub.h"
+#include "testlib.h"
+
+#define NVML_TEST_READS 10000
+
+/* The stub next to this binary unless NIXLY_NVML_LIB says otherwise */
+static const char *
+nvml_test_lib(void)
+{
+	static char path[PATH_MAX];
+	char exe[PATH_MAX];
+	ssize_t n;
+
+	if (getenv("NIXLY_NVML_LIB"))
+		return getenv("NIXLY_NVML_LIB");
+	if ((n = readlink("/proc/self/exe", exe, sizeof(exe) - 1)) <= 0)
+		return NVML_STUB_LIB;
+	exe[n] = '\0';
+	snprintf(path, sizeof(path), "%s/%s", dirname(exe), NVML_STUB_LIB);
+	setenv("NIXLY_NVML_LIB", path, 1);
+	return path;
+}
+
+int
+main(void)
+{
+	const char *lib = nvml_test_lib();
+	NvmlTelemetry t;
+	NvmlStub *stub;
+	void *handle;
+	unsigned cur_mw, max_mw, gfx_mhz, mem_mhz, saved_mw;
+	uint64_t t0, read_ns;
+	int on;
+
+	/* nothing works before the device is open */
+	CHECK(nvml_index() == -1);
+	CHECK(nvml_telemetry(&t) == -1);
+	CHECK(nvml_set_power_limit(250000) == -1);
+
+	CHECK(nvml_open(NVML_STUB_BUS_ID) == 0);
+	/* nvml.c holds the library: reach the stub's state through it */
+	handle = dlopen(lib, RTLD_NOW | RTLD_NOLOAD);
+	CHECK(handle != NULL);
+	stub = handle ? dlsym(handle, "nvml_stub") : NULL;
+	if (!stub) {
+		fprintf(stderr, "nvml_test: %s not loaded\n", lib);
+		return 1;
+	}
+	CHECK(nvml_index() == NVML_STUB_INDEX);
+	CHECK(stub->inits == 1);
+	/* tried once: a second open reports, it does not re-init */
+	CHECK(nvml_open(NVML_STUB_BUS_ID) == 0 && stub->inits == 1);
+
+	/* telemetry */
+	CHECK(nvml_telemetry(&t) == 0);
+	CHECK(t.gpu_util == 87 && t.mem_util == 41 && t.temp_c == 66);
+	CHECK(t.gfx_mhz == 1800 && t.mem_mhz == 9501);
+	CHECK(t.power_mw == 183456 && t.limit_mw == 220000 && t.pstate == 0);
+	stub->gpu_util = 3;
+	stub->pstate = 32;      /* NVML_PSTATE_UNKNOWN */
+	CHECK(nvml_telemetry(&t) == 0 && t.gpu_util == 3 && t.pstate == -1);
+	t0 = get_time_ns();
+	for (int i = 0; i < NVML_TEST_READS; i++)
+		nvml_telemetry(&t);
+	read_ns = (get_time_ns() - t0) / NVML_TEST_READS;
+
+	/* apply: persistence on, limit to max, clocks locked at max */
+	CHECK(nvml_persistence(&on) == 0 && on == 0);
+	CHECK(nvml_set_persistence(1) == 0 && stub->persistence == 1);
+	CHECK(nvml_power_limit(&cur_mw, &max_mw) == 0);
+	CHECK(cur_mw == 220000 && max_mw == 300000);
+	saved_mw = cur_mw;
+	CHECK(nvml_set_power_limit(max_mw) == 0 && stub->limit_mw == 300000);
+	CHECK(nvml_set_power_limit(400000) == -1 && stub->limit_mw == 300000);
+	CHECK(nvml_max_clocks(&gfx_mhz, &mem_mhz) == 0);
+	CHECK(gfx_mhz == 2100 && mem_mhz == 10501);
+	CHECK(nvml_lock_gpu_clocks(gfx_mhz) == 0);
+	CHECK(stub->locked_gfx_min == 2100 && stub->locked_gfx_max == 2100);
+	/* missing entry point: -1, and the caller keeps its smi fallback */
+	CHECK(nvml_lock_mem_clocks(mem_mhz) == -1);
+	CHECK(nvml_compute_mode_default() == 0 && stub->compute_mode == 0);
+
+	/* restore */
+	CHECK(nvml_lock_gpu_clocks(0) == 0 && stub->locked_gfx_max == 0);
+	CHECK(nvml_lock_mem_clocks(0) == -1);
+	CHECK(nvml_set_power_limit(saved_mw) == 0 && stub->limit_mw == 220000);
+	CHECK(nvml_set_persistence(0) == 0 && stub->persistence == 0);
+
+	nvml_close();
+	CHECK(stub->shutdowns == 1);
+	CHECK(nvml_index() == -1 && nvml_telemetry(&t) == -1);
+
+	printf("nvml: telemetry read %llu ns\n", (unsigned long long)read_ns);
+	dlclose(handle);
+	return test_done("nvml_test");
+}
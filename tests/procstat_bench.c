@@ -0,0 +1,115 @@
+/*
+ * procstat_bench.c — time procstat_sample() + procstat_top() against a
+ * synthetic /proc with PROCSTAT_BENCH_PROCS processes, the size of a busy
+ * desktop with a browser, a game under Proton and a build running.
+ *
+ * Reports the cold sample (every stat file opened for the first time)
+ * and the warm incremental one (pread on cached fds), then checks the
+ * answers: the process given the most ticks between samples must head
+ * the CPU list, the largest RSS the RAM list, and a comm with spaces and
+ * parentheses must come through intact.
+ */
+#include "nixlytile.h"
+#include "testlib.h"
+
+#define PROCSTAT_BENCH_PROCS  5000
+#define PROCSTAT_BENCH_ROUNDS 8
+#define PROCSTAT_BENCH_TOPK   10 /* rows in the CPU popup */
+#define PROCSTAT_BENCH_FIRST  300
+#define PROCSTAT_BENCH_HOG    (PROCSTAT_BENCH_FIRST + 1234)
+#define PROCSTAT_BENCH_FAT    (PROCSTAT_BENCH_FIRST + 4321)
+
+static const char *bench_names[] = {
+	"systemd", "kworker/0:1", "bash", "Web Content", "a) b", "wine64-preloader",
+	"steam", "rustc", "cc1", "pipewire", "Xwayland", "foot",
+};
+
+static void
+bench_write_stat(const char *root, int pid, unsigned long long ticks)
+{
+	char rel[32];
+	const char *comm;
+	long rss;
+
+	comm = pid == PROCSTAT_BENCH_HOG ? "hog"
+		: bench_names[pid % LENGTH(bench_names)];
+	rss = pid == PROCSTAT_BENCH_FAT ? 4L << 20 : 100 + pid % 977;
+	snprintf(rel, sizeof(rel), "%d/stat", pid);
+	/* pid (comm) state ppid pgrp session tty tpgid flags minflt cminflt
+	 * majflt cmajflt utime stime cutime cstime prio nice threads itreal
+	 * starttime vsize rss ... */
+	fx_write(root, rel, "%d (%s) S 1 %d %d 0 -1 4194560 120 0 0 0 "
+			"%llu %llu 0 0 20 0 1 0 %d 1048576 %ld 18446744073709551615\n",
+			pid, comm, pid, pid, ticks / 2, ticks - ticks / 2,
+			1000 + pid, rss);
+}
+
+static double
+bench_ms(uint64_t start)
+{
+	return (double)(get_time_ns() - start) / 1e6;
+}
+
+int
+main(void)
+{
+	ProcGroup top[16];
+	char *root = fx_mktemp("procstat");
+	unsigned long long hog_ticks = 0;
+	double cold_ms, warm_ms = 0.0, warm_max = 0.0;
+	uint64_t t0;
+	int n, found_parens = 0;
+
+	for (int pid = PROCSTAT_BENCH_FIRST;
+			pid < PROCSTAT_BENCH_FIRST + PROCSTAT_BENCH_PROCS; pid++)
+		bench_write_stat(root, pid, (unsigned long long)pid);
+	/* non-pid entries must be skipped */
+	fx_write(root, "self/stat", "garbage\n");
+	fx_write(root, "sys/kernel/pid_max", "4194304\n");
+	setenv("NIXLY_PROC_ROOT", root, 1);
+
+	t0 = get_time_ns();
+	procstat_sample();
+	n = procstat_top(top, PROCSTAT_BENCH_TOPK, 0, NULL);
+	cold_ms = bench_ms(t0);
+	CHECK(n == PROCSTAT_BENCH_TOPK);
+
+	for (int round = 0; round < PROCSTAT_BENCH_ROUNDS; round++) {
+		double ms;
+
+		/* Outside the timed region: advance the hog well past
+		 * everyone else and let the min interval elapse. */
+		hog_ticks += 50;
+		bench_write_stat(root, PROCSTAT_BENCH_HOG,
+				PROCSTAT_BENCH_HOG + hog_ticks);
+		usleep(250 * 1000);
+
+		t0 = get_time_ns();
+		CHECK(procstat_sample() == 1);
+		n = procstat_top(top, PROCSTAT_BENCH_TOPK, 0, NULL);
+		ms = bench_ms(t0);
+		warm_ms += ms;
+		warm_max = MAX(warm_max, ms);
+	}
+
+	CHECK(n > 0 && strcmp(top[0].name, "hog") == 0);
+	CHECK(n > 0 && top[0].pid == PROCSTAT_BENCH_HOG);
+	CHECK(n > 0 && top[0].cpu > 0.0);
+	n = procstat_top(top, PROCSTAT_BENCH_TOPK, 1, NULL);
+	CHECK(n > 0 && top[0].pid == PROCSTAT_BENCH_FAT);
+	/* every group fits: the odd comm must be among them */
+	n = procstat_top(top, LENGTH(top), 1, NULL);
+	for (int i = 0; i < n; i++)
+		found_parens |= strcmp(top[i].name, "a) b") == 0;
+	CHECK(found_parens);
+
+	printf("procstat: %d processes, cold %.2f ms, warm %.2f ms avg / %.2f ms max over %d rounds\n",
+			PROCSTAT_BENCH_PROCS, cold_ms,
+			warm_ms / PROCSTAT_BENCH_ROUNDS, warm_max,
+			PROCSTAT_BENCH_ROUNDS);
+
+	procstat_cleanup();
+	fx_rmtree(root);
+	free(root);
+	return test_done("procstat_bench");
+}
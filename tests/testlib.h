@@ -0,0 +1,32 @@
+/*
+ * testlib.h — shared bits for the fixture-driven tests and benchmarks
+ * under tests/: a CHECK macro that counts failures instead of aborting,
+ * and helpers to build throwaway sysfs / procfs trees.
+ */
+#ifndef NIXLY_TESTLIB_H
+#define NIXLY_TESTLIB_H
+
+extern int test_failures;
+/* When nonzero, get_time_ns() and monotonic_msec() return this instead of
+ * the clock, so rates over a test's own "interval" come out exact. */
+extern uint64_t test_now_ns;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: CHECK failed: %s\n", \
+				__FILE__, __LINE__, #cond); \
+		test_failures++; \
+	} \
+} while (0)
+
+/* mkdtemp() under $TMPDIR; dies on failure.  Caller frees. */
+char *fx_mktemp(const char *tag);
+/* Write a file below root, creating parent directories as needed.
+ * Truncates in place, so fds held on the file see the new contents. */
+int fx_write(const char *root, const char *rel, const char *fmt, ...)
+	__attribute__((format(printf, 3, 4)));
+void fx_rmtree(const char *path);
+/* Print the verdict and return the process exit status. */
+int test_done(const char *name);
+
+#endif
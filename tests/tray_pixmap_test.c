@@ -0,0 +1,165 @@
+/*
+ * tray_pixmap_test.c — the SSE2 and AVX2 IconPixmap kernels against the
+ * scalar ones, which are the reference.  Every kernel the CPU runs gets
+ * the same pseudo-random pixmaps and must give identical pixels:
+ *
+ *   convert  ARGB and RGBA byte order, lengths 0..40 (every vector tail)
+ *            and 256×256, into a separate buffer and in place, plus the
+ *            "any alpha" result used to spot RGBA senders
+ *   reduce   k×k box reduction for k = 2..9 over sizes that leave
+ *            partial blocks in the last row and column
+ *
+ * A few premultiplied values are checked outright, so the scalar path
+ * cannot drift along with the others.
+ */
+#include "nixlytile.h"
+#include "testlib.h"
+
+/* What tray_pixmap.o reaches for besides the kernels: the decode
+ * worker's hand-off to the tray, which this test never queues to. */
+struct wl_event_loop *event_loop;
+struct wl_list tray_items;
+int statusbar_tray_force_rgba;
+
+void
+tray_item_pixmap_ready(TrayItem *it, struct wlr_buffer *buf, uint64_t hash)
+{
+}
+
+struct wlr_buffer *
+statusbar_buffer_from_argb32_raw(const uint32_t *data, int width, int height)
+{
+	return NULL;
+}
+
+static const char *tp_test_names[] = { "scalar", "sse2", "avx2" };
+static uint64_t tp_test_seed = 0x9e3779b97f4a7c15ULL;
+
+/* xorshift64*; a third of the pixels get alpha 0 or 255 so both ends of
+ * the premultiply are covered. */
+static uint32_t
+tp_test_rand(void)
+{
+	tp_test_seed ^= tp_test_seed >> 12;
+	tp_test_seed ^= tp_test_seed << 25;
+	tp_test_seed ^= tp_test_seed >> 27;
+	return (uint32_t)((tp_test_seed * 0x2545f4914f6cdd1dULL) >> 32);
+}
+
+static void
+tp_test_fill(uint32_t *px, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		uint32_t v = tp_test_rand();
+
+		switch (v % 6) {
+		case 0: v &= 0xffffff00u; break;  /* alpha 0, RGBA order */
+		case 1: v &= 0x00ffffffu; break;  /* alpha 0, ARGB order */
+		case 2: v |= 0xff000000u; break;
+		}
+		px[i] = v;
+	}
+}
+
+/* Convert with isa and with the scalar kernels; both must agree. */
+static void
+tp_test_convert(int isa, const uint32_t *src, size_t n, int rgba)
+{
+	uint32_t *ref = calloc(n + 1, sizeof(*ref));
+	uint32_t *out = calloc(n + 1, sizeof(*out));
+	uint32_t *inplace = calloc(n + 1, sizeof(*inplace));
+	uint32_t ref_a, out_a, inplace_a;
+
+	memcpy(inplace, src, n * sizeof(*src));
+	tray_pixmap_set_isa(TRAY_PIXMAP_SCALAR);
+	ref_a = tray_pixmap_convert(ref, src, n, rgba);
+	tray_pixmap_set_isa(isa);
+	out_a = tray_pixmap_convert(out, src, n, rgba);
+	inplace_a = tray_pixmap_convert(inplace, inplace, n, rgba);
+
+	CHECK(memcmp(ref, out, n * sizeof(*ref)) == 0);
+	CHECK(memcmp(ref, inplace, n * sizeof(*ref)) == 0);
+	CHECK(!ref_a == !out_a && !ref_a == !inplace_a);
+	if (memcmp(ref, out, n * sizeof(*ref)) != 0)
+		fprintf(stderr, "  convert %s n=%zu rgba=%d\n", tp_test_names[isa], n, rgba);
+	free(ref);
+	free(out);
+	free(inplace);
+}
+
+static void
+tp_test_reduce(int isa, const uint32_t *src, int w, int h, int k)
+{
+	uint32_t *ref, *out;
+	int rw, rh, ow, oh;
+
+	tray_pixmap_set_isa(TRAY_PIXMAP_SCALAR);
+	ref = tray_pixmap_box_reduce(src, w, h, k, &rw, &rh);
+	tray_pixmap_set_isa(isa);
+	out = tray_pixmap_box_reduce(src, w, h, k, &ow, &oh);
+
+	CHECK(ref && out);
+	CHECK(rw == (w + k - 1) / k && rh == (h + k - 1) / k);
+	CHECK(ow == rw && oh == rh);
+	if (ref && out && ow == rw && oh == rh) {
+		CHECK(memcmp(ref, out, (size_t)rw * rh * sizeof(*ref)) == 0);
+		if (memcmp(ref, out, (size_t)rw * rh * sizeof(*ref)) != 0)
+			fprintf(stderr, "  reduce %s %dx%d k=%d\n", tp_test_names[isa], w, h, k);
+	}
+	free(ref);
+	free(out);
+}
+
+int
+main(void)
+{
+	static const int sizes[][2] = {
+		{ 2, 2 }, { 7, 5 }, { 16, 16 }, { 22, 22 }, { 33, 17 },
+		{ 64, 64 }, { 100, 37 }, { 256, 256 },
+	};
+	uint32_t px[4], out[4];
+	uint32_t *src;
+	size_t big = 256 * 256;
+	int best;
+
+	/* premultiply is round(c * a / 255); big-endian ARGB in, native
+	 * ARGB8888 out */
+	tray_pixmap_set_isa(TRAY_PIXMAP_SCALAR);
+	memcpy(px, (const uint8_t[16]){
+		0x80, 0xff, 0x80, 0x01,   /* a=128 r=255 g=128 b=1 */
+		0xff, 0x12, 0x34, 0x56,   /* opaque */
+		0x00, 0xff, 0xff, 0xff,   /* transparent */
+		0x01, 0xff, 0x7f, 0x80,   /* a=1 */
+	}, sizeof(px));
+	CHECK(tray_pixmap_convert(out, px, 4, 0) != 0);
+	CHECK(out[0] == 0x80804001u);
+	CHECK(out[1] == 0xff123456u);
+	CHECK(out[2] == 0x00000000u);
+	CHECK(out[3] == 0x01010001u);
+	/* the first pixel's bytes read as RGBA: a=1 r=128 g=255 b=128 */
+	CHECK(tray_pixmap_convert(out, px, 1, 1) != 0);
+	CHECK(out[0] == 0x01010101u);
+
+	src = malloc(big * sizeof(*src));
+	tp_test_fill(src, big);
+
+	best = tray_pixmap_set_isa(TRAY_PIXMAP_AUTO);
+	for (int isa = TRAY_PIXMAP_SSE2; isa <= best; isa++) {
+		for (int rgba = 0; rgba <= 1; rgba++) {
+			for (size_t n = 0; n <= 40; n++)
+				tp_test_convert(isa, src + n, n, rgba);
+			tp_test_convert(isa, src, big, rgba);
+		}
+		for (size_t i = 0; i < LENGTH(sizes); i++)
+			for (int k = 2; k <= 9; k++)
+				if (k <= sizes[i][0] && k <= sizes[i][1])
+					tp_test_reduce(isa, src, sizes[i][0], sizes[i][1], k);
+		printf("tray_pixmap_test: %s checked against scalar\n", tp_test_names[isa]);
+	}
+	if (best == TRAY_PIXMAP_SCALAR)
+		printf("tray_pixmap_test: no vector kernels on this CPU\n");
+
+	free(src);
+	tray_pixmap_cleanup();
+	return test_done("tray_pixmap_test");
+}
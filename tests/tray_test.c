@@ -0,0 +1,283 @@
+/*
+ * tray_test.c — run the StatusNotifierWatcher in tray.c against two fake
+ * items on a private session bus (`make check` starts one per test with
+ * dbus-run-session):
+ *
+ *   slow  registers through RegisterStatusNotifierItem and takes
+ *         TRAY_TEST_SLOW_MS to answer GetAll;
+ *   hung  is picked up from its StatusNotifierItem-* bus name and never
+ *         answers GetAll at all.
+ *
+ * No single wl_event_loop_dispatch may take longer than
+ * TRAY_TEST_BUDGET_MS while those calls are outstanding.  The slow item's
+ * properties must still land and repaint the tray; the hung one must give
+ * up on its own timeout and be marked failed.
+ */
+#include "nixlytile.h"
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "testlib.h"
+
+#define TRAY_TEST_SLOW_MS    1500
+#define TRAY_TEST_HUNG_MS    30000
+#define TRAY_TEST_BUDGET_MS  250
+#define TRAY_TEST_DEADLINE_MS 8000
+#define TRAY_TEST_HUNG_NAME  "org.nixly.StatusNotifierItem-hung"
+
+/* What tray.o reaches for besides the bus: the bar's globals and the
+ * render / icon lookup side, none of which this test exercises. */
+struct wl_event_loop *event_loop;
+struct wl_list mons;
+struct StatusFont statusfont;
+unsigned int statusbar_height = 26;
+unsigned int statusbar_module_padding = 8;
+int statusbar_font_spacing;
+float statusbar_fg[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+float statusbar_tag_active_bg[4] = {0.08f, 0.4f, 0.75f, 1.0f};
+const float *statusbar_fg_override;
+sd_bus *tray_bus;
+struct wl_event_source *tray_event;
+sd_bus_slot *tray_vtable_slot;
+sd_bus_slot *tray_fdo_vtable_slot;
+sd_bus_slot *tray_name_slot;
+int tray_host_registered;
+struct wl_list tray_items;
+int tray_anchor_x = -1;
+int tray_anchor_y = -1;
+uint64_t tray_anchor_time_ms;
+
+static int tray_test_repaints;
+
+void
+refreshstatusicons(void)
+{
+	tray_test_repaints++;
+}
+
+void
+drawrect(struct wlr_scene_tree *parent, int x, int y,
+		int width, int height, const float color[static 4])
+{
+}
+
+int
+status_text_width(const char *text)
+{
+	return 0;
+}
+
+struct wlr_buffer *
+statusbar_label_buffer(const char *text, const float color[static 4],
+		int *left, int *top, int *advance)
+{
+	return NULL;
+}
+
+struct wlr_buffer *
+statusbar_buffer_from_pixbuf(GdkPixbuf *pixbuf, int target_h, int *out_w, int *out_h)
+{
+	return NULL;
+}
+
+int
+tray_load_svg_pixbuf(const char *path, int desired_h, GdkPixbuf **out_pixbuf)
+{
+	return -1;
+}
+
+int
+has_svg_extension(const char *path)
+{
+	return 0;
+}
+
+int
+pathisdir(const char *path)
+{
+	return 0;
+}
+
+int
+strip_symbolic_suffix(const char *name, char *out, size_t outlen)
+{
+	return 0;
+}
+
+void
+tray_consider_icon(const char *path, int size_hint, int desired_h,
+	char *best_path, int *best_diff, int *found)
+{
+}
+
+int
+tray_pixmap_decode(TrayItem *it, sd_bus_message *msg, const void *data,
+		int w, int h, int target_h)
+{
+	return -1;
+}
+
+int
+icon_theme_lookup(const char *name, int desired_h, char *out, size_t outlen,
+		int *diff)
+{
+	return -1;
+}
+
+/* ── the fake items (child processes with their own connection) ───── */
+
+typedef struct {
+	const char *id;
+	int delay_ms;
+} FakeItem;
+
+static int
+fake_prop(sd_bus *bus, const char *path, const char *interface,
+		const char *property, sd_bus_message *reply, void *userdata,
+		sd_bus_error *ret_error)
+{
+	FakeItem *fi = userdata;
+
+	/* GetAll reads Id first: stall the whole reply there */
+	if (strcmp(property, "Id") == 0) {
+		usleep((useconds_t)fi->delay_ms * 1000);
+		return sd_bus_message_append(reply, "s", fi->id);
+	}
+	if (strcmp(property, "Status") == 0)
+		return sd_bus_message_append(reply, "s", "Active");
+	return sd_bus_message_append(reply, "s", "nixly-test");
+}
+
+static const sd_bus_vtable fake_vtable[] = {
+	SD_BUS_VTABLE_START(0),
+	SD_BUS_PROPERTY("Id", "s", fake_prop, 0, 0),
+	SD_BUS_PROPERTY("Status", "s", fake_prop, 0, 0),
+	SD_BUS_PROPERTY("IconName", "s", fake_prop, 0, 0),
+	SD_BUS_VTABLE_END
+};
+
+static int
+fake_wait_watcher(sd_bus *bus)
+{
+	for (int i = 0; i < 500; i++) {
+		sd_bus_message *reply = NULL;
+		int has = 0;
+
+		if (sd_bus_call_method(bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+				"org.freedesktop.DBus", "NameHasOwner", NULL, &reply,
+				"s", "org.kde.StatusNotifierWatcher") >= 0)
+			sd_bus_message_read(reply, "b", &has);
+		sd_bus_message_unref(reply);
+		if (has)
+			return 0;
+		usleep(10 * 1000);
+	}
+	return -1;
+}
+
+static pid_t
+fake_item_spawn(const char *name, const char *id, int delay_ms)
+{
+	FakeItem fi = { .id = id, .delay_ms = delay_ms };
+	sd_bus *bus = NULL;
+	pid_t pid = fork();
+
+	if (pid != 0)
+		return pid;
+
+	if (sd_bus_open_user(&bus) < 0
+			|| sd_bus_add_object_vtable(bus, NULL, "/StatusNotifierItem",
+				"org.kde.StatusNotifierItem", fake_vtable, &fi) < 0)
+		_exit(1);
+	if (name) {
+		if (sd_bus_request_name(bus, name, 0) < 0)
+			_exit(1);
+	} else if (fake_wait_watcher(bus) < 0
+			|| sd_bus_call_method(bus, "org.kde.StatusNotifierWatcher",
+				"/StatusNotifierWatcher", "org.kde.StatusNotifierWatcher",
+				"RegisterStatusNotifierItem", NULL, NULL,
+				"s", "/StatusNotifierItem") < 0) {
+		_exit(1);
+	}
+	for (;;) {
+		int r = sd_bus_process(bus, NULL);
+
+		if (r < 0)
+			_exit(0);
+		if (r == 0 && sd_bus_wait(bus, UINT64_MAX) < 0)
+			_exit(0);
+	}
+}
+
+static TrayItem *
+tray_test_find(const char *service, const char *id)
+{
+	TrayItem *it;
+
+	wl_list_for_each(it, &tray_items, link) {
+		if (service && strcmp(it->service, service) == 0)
+			return it;
+		if (id && strcmp(it->sni_id, id) == 0)
+			return it;
+	}
+	return NULL;
+}
+
+int
+main(void)
+{
+	uint64_t start, worst = 0, slow_at = 0, hung_at = 0;
+	pid_t slow, hung;
+	TrayItem *it;
+
+	if (!getenv("DBUS_SESSION_BUS_ADDRESS")) {
+		fprintf(stderr, "tray_test: no session bus; run under dbus-run-session\n");
+		return 1;
+	}
+
+	wl_list_init(&mons);
+	wl_list_init(&tray_items);
+	event_loop = wl_event_loop_create();
+	slow = fake_item_spawn(NULL, "slow-item", TRAY_TEST_SLOW_MS);
+	hung = fake_item_spawn(TRAY_TEST_HUNG_NAME, "hung-item", TRAY_TEST_HUNG_MS);
+
+	start = monotonic_msec();
+	tray_init();
+	CHECK(tray_bus && tray_event);
+	CHECK(monotonic_msec() - start < TRAY_TEST_BUDGET_MS);
+
+	while (tray_bus && monotonic_msec() - start < TRAY_TEST_DEADLINE_MS
+			&& (!slow_at || !hung_at)) {
+		uint64_t t0 = monotonic_msec();
+
+		wl_event_loop_dispatch(event_loop, 20);
+		worst = MAX(worst, monotonic_msec() - t0);
+
+		if (!slow_at && tray_test_find(NULL, "slow-item"))
+			slow_at = monotonic_msec() - start;
+		it = tray_test_find(TRAY_TEST_HUNG_NAME, NULL);
+		if (!hung_at && it && it->icon_failed && !it->slot)
+			hung_at = monotonic_msec() - start;
+	}
+
+	CHECK(worst < TRAY_TEST_BUDGET_MS);
+	/* the slow reply did arrive, and no sooner than the item allowed */
+	CHECK(slow_at >= TRAY_TEST_SLOW_MS);
+	it = tray_test_find(NULL, "slow-item");
+	CHECK(it && !it->passive);
+	CHECK(tray_test_repaints > 0);
+	/* the hung item gave up on its own, without an Id */
+	CHECK(hung_at > 0);
+	it = tray_test_find(TRAY_TEST_HUNG_NAME, NULL);
+	CHECK(it && it->icon_failed && !it->sni_id[0]);
+
+	printf("tray: worst dispatch %llu ms, slow item in %llu ms, hung item dropped in %llu ms\n",
+			(unsigned long long)worst, (unsigned long long)slow_at,
+			(unsigned long long)hung_at);
+
+	kill(slow, SIGKILL);
+	kill(hung, SIGKILL);
+	waitpid(slow, NULL, 0);
+	waitpid(hung, NULL, 0);
+	return test_done("tray_test");
+}